@@ -0,0 +1,94 @@
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*****************************************************************************/
+
+// Blocos em lista, na ordem em que são usados; depois de um reset os seguintes são reaproveitados
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    alignas(max_align_t) unsigned char data[];
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Passa para um bloco com pelo menos `size` bytes livres (o seguinte, se couber, ou um novo).
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int next_chunk(struct arena *arena, size_t size);
+
+/*****************************************************************************/
+
+void *arena_alloc(struct arena *arena, const size_t size) {
+    const size_t align = alignof(max_align_t);
+    const size_t offset = (arena->used + align - 1) & ~(align - 1);
+    if (!arena->current || offset + size > arena->current->size) {
+        if (next_chunk(arena, size) != 0) return NULL;
+        arena->used = size;
+        return arena->current->data;
+    }
+    arena->used = offset + size;
+    return arena->current->data + offset;
+}
+
+char *arena_strndup(struct arena *arena, const char *str, const size_t len) {
+    char *copy = arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+struct arena_mark arena_mark(const struct arena *arena) {
+    return (struct arena_mark) {.chunk = arena->current, .used = arena->used};
+}
+
+void arena_rewind(struct arena *arena, const struct arena_mark mark) {
+    if (!mark.chunk) {
+        arena_reset(arena);
+        return;
+    }
+    arena->current = mark.chunk;
+    arena->used = mark.used;
+}
+
+void arena_reset(struct arena *arena) {
+    arena->current = arena->first;
+    arena->used = 0;
+}
+
+void arena_free(struct arena *arena) {
+    struct arena_chunk *chunk = arena->first;
+    while (chunk) {
+        struct arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    *arena = (struct arena) {0};
+}
+
+/*****************************************************************************/
+
+static int next_chunk(struct arena *arena, const size_t size) {
+    struct arena_chunk *next = arena->current ? arena->current->next : arena->first;
+    if (next && size <= next->size) {
+        arena->current = next;
+        return 0;
+    }
+
+    // Bloco novo entre o atual e o seguinte (um seguinte pequeno demais continua na lista)
+    const size_t chunk_size = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+    struct arena_chunk *chunk = malloc(sizeof(struct arena_chunk) + chunk_size);
+    if (!chunk) return -1;
+    chunk->size = chunk_size;
+    chunk->next = next;
+    if (arena->current) arena->current->next = chunk;
+    else arena->first = chunk;
+    arena->current = chunk;
+    arena->reserved += chunk_size;
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Arena de alocação em blocos: alocar é avançar um ponteiro, e tudo é descartado de uma vez.
+//
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Tamanho mínimo de cada bloco (alocações maiores ganham um bloco do seu tamanho)
+#define ARENA_CHUNK (64 * 1024)
+
+struct arena_chunk;
+
+/**
+ * @brief Arena zerada (`{0}`) está pronta para uso.
+ *
+ * `arena_reset` volta ao primeiro bloco sem liberar nada: a memória dos blocos
+ * é reaproveitada pelas próximas alocações.
+ */
+struct arena {
+    struct arena_chunk *first;
+    struct arena_chunk *current;   // Bloco das próximas alocações
+    size_t used;                   // Bytes usados em `current`
+    size_t reserved;               // Soma do tamanho dos blocos
+};
+
+/**
+ * @brief Posição da arena, para desfazer as alocações feitas depois dela (`arena_rewind`).
+ */
+struct arena_mark {
+    struct arena_chunk *chunk;
+    size_t used;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Aloca `size` bytes alinhados para qualquer tipo.
+ * @return A memória (não zerada), ou NULL em caso de erro de alocação.
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * @brief Copia `len` bytes de `str` para a arena, terminando em '\0'.
+ * @return A cópia, ou NULL em caso de erro de alocação.
+ */
+char *arena_strndup(struct arena *arena, const char *str, size_t len);
+
+/**
+ * @brief Posição atual da arena.
+ */
+struct arena_mark arena_mark(const struct arena *arena);
+
+/**
+ * @brief Descarta as alocações feitas depois de `mark` (os blocos continuam reservados).
+ */
+void arena_rewind(struct arena *arena, struct arena_mark mark);
+
+/**
+ * @brief Descarta todas as alocações, mantendo os blocos para as próximas.
+ */
+void arena_reset(struct arena *arena);
+
+/**
+ * @brief Libera os blocos (a arena volta a ficar zerada).
+ */
+void arena_free(struct arena *arena);
+
+#endif //ARENA_H
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+#
+# Compara dois resultados do shell_bench (ex.: antes e depois de uma mudança).
+#
+# Uso: compare_bench.py ANTIGO.json NOVO.json [LIMITE_%]
+#
+# Mostra a variação do p50 de cada benchmark e sai com 1 se algum ficou mais
+# lento que o limite (padrão: 10%).
+#
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {(r["name"], r["fixture"]): r for r in data["results"]}
+
+
+def main():
+    if len(sys.argv) < 3:
+        print("uso: compare_bench.py ANTIGO.json NOVO.json [LIMITE_%]", file=sys.stderr)
+        return 2
+    old, new = load(sys.argv[1]), load(sys.argv[2])
+    limit = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+
+    regressions = 0
+    for key, result in new.items():
+        if key not in old:
+            print(f"{key[0]:<24} {key[1]:<12} {'(novo)':>14}")
+            continue
+        before, after = old[key]["p50_ns"], result["p50_ns"]
+        change = (after - before) / before * 100 if before else 0.0
+        mark = ""
+        if change > limit:
+            mark = "  <- mais lento"
+            regressions += 1
+        print(f"{key[0]:<24} {key[1]:<12} {before:>14.1f} -> {after:>14.1f} ns  {change:+7.1f}%{mark}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
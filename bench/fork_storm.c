@@ -0,0 +1,124 @@
+//
+// Gerador de rajadas de processos para o `tree --watch`: cadeias curtas de fork (e exec) em vários workers.
+//
+// Uso: fork_storm [-a ATRASO] [-s SEG] [-w WORKERS] [-p PROFUNDIDADE] [-e]
+//
+// Depois de ATRASO segundos (para o observador se ligar ao PID mostrado), cada
+// worker repete até o fim do prazo: cria uma cadeia de PROFUNDIDADE processos
+// (cada um filho do anterior), a folha termina (ou faz exec de /bin/true com
+// -e) e cada nível espera o seu filho. No fim mostra quantos processos foram
+// criados e a taxa de eventos fork + exit (+ exec) gerada.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*****************************************************************************/
+
+/**
+ * @brief Tempo monotônico em segundos.
+ */
+static double now(void);
+
+/**
+ * @brief Cria uma cadeia de `depth` processos abaixo do atual e espera por ela.
+ * @param depth Níveis ainda a criar.
+ * @param exec Se true, a folha faz exec de /bin/true.
+ * @return 0 se a cadeia inteira terminou bem.
+ */
+static int chain(int depth, int exec);
+
+/**
+ * @brief Repete cadeias até `deadline` e escreve a quantidade de processos criados em `out`.
+ */
+static void worker(double deadline, int depth, int exec, int out);
+
+/*****************************************************************************/
+
+int main(const int argc, char **argv) {
+    double delay = 1, seconds = 5;
+    int workers = 4, depth = 3, exec = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-e") == 0) exec = 1;
+        else if (i + 1 < argc && strcmp(argv[i], "-a") == 0) delay = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) seconds = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-w") == 0) workers = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-p") == 0) depth = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "uso: fork_storm [-a ATRASO] [-s SEG] [-w WORKERS] [-p PROFUNDIDADE] [-e]\n");
+            return 2;
+        }
+    }
+    if (workers < 1) workers = 1;
+    if (depth < 1) depth = 1;
+
+    fprintf(stderr, "fork_storm: PID %d, %d workers, cadeias de %d, %.1f s após %.1f s\n",
+            getpid(), workers, depth, seconds, delay);
+    const struct timespec pause = {.tv_sec = (time_t) delay, .tv_nsec = (long) ((delay - (double) (time_t) delay) * 1e9)};
+    nanosleep(&pause, NULL);
+
+    int pipes[2];
+    if (pipe(pipes) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    const double start = now();
+    const double deadline = start + seconds;
+    for (int w = 0; w < workers; w++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(pipes[0]);
+            worker(deadline, depth, exec, pipes[1]);
+            _exit(0);
+        }
+        if (pid < 0) perror("fork");
+    }
+    close(pipes[1]);
+
+    unsigned long total = 0, count;
+    while (read(pipes[0], &count, sizeof(count)) == (ssize_t) sizeof(count)) total += count;
+    while (wait(NULL) > 0) {}
+    const double elapsed = now() - start;
+
+    // Cada processo gera um fork e um exit (e um exec com -e)
+    const double events = (double) total * (exec ? 3 : 2);
+    printf("fork_storm: %lu processos em %.2f s | %.0f processos/s | %.0f eventos/s\n", total, elapsed,
+           (double) total / elapsed, events / elapsed);
+    return 0;
+}
+
+/*****************************************************************************/
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static int chain(const int depth, const int exec) {
+    const pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        if (depth > 1) _exit(chain(depth - 1, exec) == 0 ? 0 : 1);
+        if (exec) {
+            execl("/bin/true", "true", (char *) NULL);
+            _exit(127);
+        }
+        _exit(0);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) != pid) return -1;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+static void worker(const double deadline, const int depth, const int exec, const int out) {
+    unsigned long created = 0;
+    while (now() < deadline) {
+        if (chain(depth, exec) == 0) created += (unsigned long) depth;
+    }
+    if (write(out, &created, sizeof(created)) != (ssize_t) sizeof(created)) _exit(1);
+}
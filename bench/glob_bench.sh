@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Expansão de `**/*.c` no shell contra o `globstar` do bash, em uma árvore
+# gerada com FILES arquivos (.c, .h e .o misturados, 100 por diretório, dois
+# níveis de diretórios). Mostra o melhor de RUNS execuções de cada um e confere
+# que os dois expandem para a mesma lista.
+#
+# Uso: glob_bench.sh SHELL [FILES] [RUNS] [DIR]
+#
+# A expansão inteira não cabe no ARG_MAX de um programa externo, então os dois
+# lados a passam para um comando interno que ignora os argumentos: `help` no
+# shell, `:` no bash. A comparação das listas usa um subdiretório, com printf.
+# Sem DIR a árvore vai para um diretório temporário.
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+FILES=${2:-500000}
+RUNS=${3:-5}
+
+if [ $# -ge 4 ]; then
+    WORK=$4
+    mkdir -p "$WORK"
+else
+    WORK=$(mktemp -d)
+    trap 'rm -rf "$WORK"' EXIT
+fi
+TREE="$WORK/tree"
+
+if [ ! -e "$TREE/.complete-$FILES" ]; then
+    echo "gerando $FILES arquivos em $TREE" >&2
+    rm -rf "$TREE"
+    mkdir -p "$TREE"
+    awk -v files="$FILES" -v tree="$TREE" 'BEGIN {
+        split("c c h o", ext, " ")
+        for (k = 0; k < files; k++) {
+            d = int(k / 100)
+            dir = tree "/mod" int(d / 50) "/pkg" d % 50
+            if (k % 100 == 0) system("mkdir -p \"" dir "\"")
+            f = dir "/file" k "." ext[k % 4 + 1]
+            printf "" > f
+            close(f)
+        }
+    }'
+    : > "$TREE/.complete-$FILES"
+fi
+
+# Melhor de RUNS (cache quente depois da primeira)
+best() {
+    best_time=
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        start=$(date +%s.%N)
+        "$@" > /dev/null
+        end=$(date +%s.%N)
+        best_time=$(awk -v s="$start" -v e="$end" -v b="$best_time" 'BEGIN {
+            t = e - s; if (b == "" || t < b) b = t; printf "%.4f", b
+        }')
+        i=$((i + 1))
+    done
+    echo "$best_time"
+}
+
+cd "$TREE"
+bash_list=$(bash -O globstar -c 'printf "%s\n" mod0/**/*.c' | md5sum)
+shell_list=$("$SHELL_BIN" -c 'printf "%s\n" mod0/**/*.c' | md5sum)
+same=igual
+[ "$bash_list" = "$shell_list" ] || same=DIFERENTE
+
+matches=$(bash -O globstar -c 'set -- **/*.c; echo $#')
+bash_time=$(best bash -O globstar -c ': **/*.c')
+shell_time=$(best "$SHELL_BIN" -c 'help **/*.c')
+empty_time=$(best "$SHELL_BIN" -c 'help')
+awk -v n="$matches" -v f="$FILES" -v same="$same" -v b="$bash_time" -v s="$shell_time" -v e="$empty_time" 'BEGIN {
+    printf "**/*.c: %d de %d arquivos (lista %s)\n", n, f, same
+    printf "  bash -O globstar  %8.3f s\n", b
+    printf "  shell             %8.3f s  (%.2fx; %.3f s sem o padrão)\n", s, b / s, e
+}'
@@ -0,0 +1,82 @@
+#!/bin/sh
+#
+# Rajada de jobs em segundo plano: um script lança JOBS jobs (`true &`,
+# `false &` e `sleep 0 &` alternados) e depois os recolhe de duas formas:
+# com `wait` e, numa segunda rajada, só com o `jobs`. Confere que a tabela
+# fica vazia e que o shell não guarda nenhum filho (zumbi) em
+# /proc/PID/task/PID/children, e mostra jobs por segundo de cada fase.
+#
+# Uso: jobs_bench.sh SHELL [JOBS]
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+JOBS=${2:-5000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# burst ARQUIVO: JOBS linhas de jobs em segundo plano
+burst() {
+    awk -v n="$JOBS" 'BEGIN {
+        for (i = 0; i < n; i++) {
+            m = i % 3
+            if (m == 0) print "true &"
+            else if (m == 1) print "false &"
+            else print "sleep 0 &"
+        }
+    }' >> "$1"
+}
+
+# Os filhos são lidos por um estágio só de redirecionamento (bomba no shell, sem processo novo)
+
+# Fase 1: `wait` sem argumentos espera todos
+burst "$WORK/wait.sh"
+cat >> "$WORK/wait.sh" << SCRIPT
+wait
+jobs > $WORK/wait.jobs
+< /proc/\$\$/task/\$\$/children | > $WORK/wait.children
+SCRIPT
+
+# Fase 2: sem `wait`; o `jobs` recolhe os que terminaram até a tabela esvaziar
+burst "$WORK/jobs.sh"
+cat >> "$WORK/jobs.sh" << SCRIPT
+sleep 0.5
+jobs > /dev/null
+jobs > $WORK/jobs.jobs
+< /proc/\$\$/task/\$\$/children | > $WORK/jobs.children
+SCRIPT
+
+failures=0
+
+# run FASE: roda o script e confere tabela e filhos
+run() {
+    start=$(date +%s.%N)
+    timeout 120 "$SHELL_BIN" "$WORK/$1.sh" < /dev/null > /dev/null 2>&1 || {
+        echo "FALHA: $1: o shell não terminou (status $?)" >&2
+        failures=$((failures + 1))
+        return
+    }
+    end=$(date +%s.%N)
+    if [ -s "$WORK/$1.jobs" ]; then
+        echo "FALHA: $1: $(wc -l < "$WORK/$1.jobs") jobs ainda na tabela" >&2
+        failures=$((failures + 1))
+    fi
+    if [ -n "$(tr -d ' \n' < "$WORK/$1.children")" ]; then
+        echo "FALHA: $1: filhos não recolhidos: $(cat "$WORK/$1.children")" >&2
+        failures=$((failures + 1))
+    fi
+    awk -v label="$1" -v n="$JOBS" -v s="$start" -v e="$end" 'BEGIN {
+        t = e - s
+        printf "  %-5s %d jobs em %.3f s: %.0f jobs/s\n", label, n, t, n / t
+    }'
+}
+
+run wait
+run jobs
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "rajada de jobs: todos recolhidos"
@@ -0,0 +1,200 @@
+//
+// Bench e fuzz do analisador de linha (`parse_line`/`parse_expand`).
+//
+// Uso: parser_bench [bench | fuzz [ITERAÇÕES] [SEMENTE]]
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../arena.h"
+#include "../parser.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief Tempo monotônico em segundos.
+ */
+static double now(void);
+
+/**
+ * @brief Monta uma linha `cmd palavra0 palavra1 ...` com pelo menos `size` bytes.
+ * @param quoted Se true, metade das palavras vem entre aspas duplas.
+ * @return A linha (malloc), com o tamanho em `len`.
+ */
+static char *make_line(size_t size, bool quoted, size_t *len, size_t *words);
+
+/**
+ * @brief Separa linhas longas de tamanhos crescentes e mostra MB/s (deve ficar constante: tempo linear).
+ */
+static int run_bench(void);
+
+/**
+ * @brief Separa linhas aleatórias (aspas, operadores, variáveis) e confere o resultado.
+ * @return 0 se nenhuma lista inválida apareceu.
+ */
+static int run_fuzz(unsigned long iterations, unsigned seed);
+
+/**
+ * @brief Confere uma lista: argv terminado em NULL, redirecionamentos com arquivo, texto e origem presentes.
+ * @return true se a lista é válida.
+ */
+static bool check_list(const struct command_list *list);
+
+/*****************************************************************************/
+
+int main(const int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "fuzz") == 0) {
+        const unsigned long iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+        const unsigned seed = argc > 3 ? (unsigned) strtoul(argv[3], NULL, 10) : (unsigned) time(NULL);
+        return run_fuzz(iterations, seed);
+    }
+    return run_bench();
+}
+
+/*****************************************************************************/
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static char *make_line(const size_t size, const bool quoted, size_t *len, size_t *words) {
+    char *line = malloc(size + 64);
+    if (!line) return NULL;
+    size_t used = (size_t) sprintf(line, "cmd");
+    *words = 1;
+    while (used < size) {
+        used += (size_t) sprintf(line + used, quoted && *words % 2 ? " \"arg %zu\"" : " arg%zu", *words);
+        (*words)++;
+    }
+    *len = used;
+    return line;
+}
+
+static int run_bench(void) {
+    struct arena arena = {0};
+    printf("%-10s %-8s %10s %12s %10s\n", "linha", "aspas", "palavras", "tempo (ms)", "MB/s");
+
+    for (size_t size = 256 * 1024; size <= 8 * 1024 * 1024; size *= 2) {
+        for (int quoted = 0; quoted <= 1; quoted++) {
+            size_t len, words;
+            char *line = make_line(size, quoted, &len, &words);
+            if (!line) return 1;
+
+            // Melhor de 5 rodadas, com a arena reiniciada (não liberada) entre elas
+            double best = 1e9;
+            for (int round = 0; round < 5; round++) {
+                arena_reset(&arena);
+                const double start = now();
+                const struct command_list *list = parse_line(&arena, line, len);
+                const double elapsed = now() - start;
+                if (!list || list->count != 1 || (size_t) list->items[0].pipeline.commands[0].argc != words) {
+                    fprintf(stderr, "Resultado inesperado para a linha de %zu bytes\n", len);
+                    return 1;
+                }
+                if (elapsed < best) best = elapsed;
+            }
+            printf("%-10zu %-8s %10zu %12.2f %10.1f\n", len, quoted ? "sim" : "não", words, best * 1e3,
+                   (double) len / best / 1e6);
+            free(line);
+        }
+    }
+
+    // Linha curta típica, muitas vezes (custo fixo por linha)
+    const char *typical = "lf -l /tmp | grep \"txt\" > lista.txt 2>&1 && echo ok; cd ..";
+    const size_t typical_len = strlen(typical);
+    const size_t rounds = 1000000;
+    const double start = now();
+    for (size_t i = 0; i < rounds; i++) {
+        arena_reset(&arena);
+        if (!parse_line(&arena, typical, typical_len)) return 1;
+    }
+    const double elapsed = now() - start;
+    printf("\nLinha típica (%zu bytes): %.0f ns por linha\n", typical_len, elapsed / (double) rounds * 1e9);
+
+    arena_free(&arena);
+    return 0;
+}
+
+static int run_fuzz(const unsigned long iterations, const unsigned seed) {
+    // Fragmentos que exercitam cada caminho do lexer
+    static const char *const pieces[] = {
+        " ", "\t", "\n", "a", "lf", "-l", "'", "\"", "\\", "$", "$HOME", "${HOME}", "${", "}", "$?", "$$",
+        "|", "||", "&", "&&", ";", "<", ">", ">>", "2>", "2>&1", ">&", "<&0", "#", "12", "x y", "''", "\"\"",
+    };
+    const size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+
+    // Erros de sintaxe são esperados: as mensagens não interessam aqui
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+
+    struct arena arena = {0};
+    struct arena scratch = {0};
+    char line[512];
+    srand(seed);
+    unsigned long parsed = 0;
+    unsigned long expanded = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        size_t len = 0;
+        const int count = rand() % 24;
+        for (int j = 0; j < count; j++) {
+            const char *piece = pieces[rand() % piece_count];
+            const size_t piece_len = strlen(piece);
+            if (len + piece_len >= sizeof(line)) break;
+            memcpy(line + len, piece, piece_len);
+            len += piece_len;
+        }
+        // Às vezes um byte qualquer
+        if (len > 0 && rand() % 4 == 0) line[rand() % len] = (char) (rand() % 256);
+
+        arena_reset(&arena);
+        const struct command_list *list = parse_line(&arena, line, len);
+        if (!list) continue;
+        parsed++;
+        if (!check_list(list)) {
+            printf("Lista inválida (semente %u, iteração %lu): %.*s\n", seed, i, (int) len, line);
+            return 1;
+        }
+
+        for (size_t k = 0; k < list->count; k++) {
+            if (!list->items[k].expand) continue;
+            arena_reset(&scratch);
+            struct pipeline pipeline;
+            if (parse_expand(&scratch, &list->items[k], 0, &pipeline) == 0) expanded++;
+        }
+    }
+
+    printf("%lu linhas, %lu separadas sem erro, %lu pipelines com variáveis (semente %u)\n", iterations, parsed,
+           expanded, seed);
+    arena_free(&arena);
+    arena_free(&scratch);
+    return 0;
+}
+
+static bool check_list(const struct command_list *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        const struct list_item *item = &list->items[i];
+        const struct pipeline *pipeline = &item->pipeline;
+        if (pipeline->count == 0 || pipeline->count > EXEC_MAX_COMMANDS || !pipeline->text) return false;
+        if (item->source != pipeline->text) return false;
+        for (size_t j = 0; j < pipeline->count; j++) {
+            const struct command *cmd = &pipeline->commands[j];
+            if (cmd->argc == 0 && cmd->redirect_count == 0) return false;
+            if (cmd->argv[cmd->argc] != NULL) return false;
+            for (int k = 0; k < cmd->argc; k++) {
+                if (!cmd->argv[k]) return false;
+                (void) strlen(cmd->argv[k]);
+            }
+            for (size_t k = 0; k < cmd->redirect_count; k++) {
+                const struct redirect *redirect = &cmd->redirects[k];
+                if ((redirect->kind == REDIRECT_DUP) != (redirect->path == NULL)) return false;
+            }
+        }
+    }
+    return true;
+}
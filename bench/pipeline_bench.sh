@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Vazão de pipelines no shell contra o bash, sobre um arquivo de MB megabytes:
+# o mesmo texto de pipeline roda nos dois (`cat big | wc -c` e uma cadeia de
+# quatro estágios), mais o estágio só de redirecionamento do shell
+# (`< big | wc -c`, bombeado com splice) contra o `cat big | wc -c` do bash.
+# Mostra o melhor de RUNS execuções em MB/s e confere as contagens.
+#
+# Uso: pipeline_bench.sh SHELL [MB] [RUNS]
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+MB=${2:-1024}
+RUNS=${3:-5}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+BIG="$WORK/big"
+
+echo "gerando $MB MB em $BIG" >&2
+head -c $((MB * 1024 * 1024)) /dev/urandom > "$BIG"
+EXPECTED=$((MB * 1024 * 1024))
+
+# Melhor tempo de RUNS execuções de `$1 -c "$2"`, conferindo a contagem do wc
+best() {
+    best_time=
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        start=$(date +%s.%N)
+        count=$("$1" -c "$2")
+        end=$(date +%s.%N)
+        if [ "$count" -ne "$EXPECTED" ]; then
+            echo "contagem errada em '$2' ($1): $count, esperado $EXPECTED" >&2
+            exit 1
+        fi
+        best_time=$(awk -v s="$start" -v e="$end" -v b="$best_time" 'BEGIN {
+            t = e - s; if (b == "" || t < b) b = t; printf "%.4f", b
+        }')
+        i=$((i + 1))
+    done
+    echo "$best_time"
+}
+
+# Linha da tabela: rótulo, tempo do bash, tempo do shell
+row() {
+    awk -v label="$1" -v b="$2" -v s="$3" -v mb="$MB" 'BEGIN {
+        printf "  %-28s bash %8.0f MB/s   shell %8.0f MB/s  (%.2fx)\n", label, mb / b, mb / s, b / s
+    }'
+}
+
+row "cat | wc -c" "$(best bash "cat $BIG | wc -c")" "$(best "$SHELL_BIN" "cat $BIG | wc -c")"
+row "cat | cat | cat | wc -c" "$(best bash "cat $BIG | cat | cat | wc -c")" \
+    "$(best "$SHELL_BIN" "cat $BIG | cat | cat | wc -c")"
+row "arquivo -> pipe (< big | wc)" "$(best bash "cat $BIG | wc -c")" "$(best "$SHELL_BIN" "< $BIG | wc -c")"
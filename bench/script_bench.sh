@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# Vazão do modo script: roda um script de LINES linhas de comandos internos (`cd`, `lf`)
+# e mostra linhas por segundo.
+#
+# Uso: script_bench.sh SHELL [LINES]
+#
+
+set -eu
+
+SHELL_BIN=$1
+LINES=${2:-1000000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Diretório pequeno listado pelo script
+mkdir -p "$WORK/dir/sub"
+for name in a b c d e f g h; do : > "$WORK/dir/$name.txt"; done
+
+# Laço desenrolado: 4 linhas distintas repetidas (o cache de linhas separa cada uma só uma vez)
+awk -v n="$LINES" -v dir="$WORK/dir" 'BEGIN {
+    for (i = 0; i < n; i++) {
+        m = i % 4
+        if (m == 0) print "cd " dir
+        else if (m == 1) print "lf"
+        else if (m == 2) print "cd sub"
+        else print "lf -a " dir
+    }
+}' > "$WORK/script.sh"
+
+start=$(date +%s.%N)
+"$SHELL_BIN" "$WORK/script.sh" > /dev/null
+end=$(date +%s.%N)
+
+awk -v n="$LINES" -v s="$start" -v e="$end" 'BEGIN {
+    t = e - s
+    printf "%d linhas em %.3f s: %.0f linhas/s\n", n, t, n / t
+}'
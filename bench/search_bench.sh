@@ -0,0 +1,101 @@
+#!/bin/sh
+#
+# `search` (varredura paralela + casamento SIMD) contra `grep -rnF` em uma
+# árvore de código-fonte gerada: TOP diretórios com SUB subdiretórios de FILES
+# arquivos .c cada. Mostra o melhor de 3 execuções e confere que as duas saídas
+# têm as mesmas linhas.
+#
+# Uso: search_bench.sh SHELL [TOP] [SUB] [FILES] [DIR]
+#
+# O grep roda com `-n` (o `search` sempre mostra o número da linha) e `-I` (o
+# `search` também ignora os binários), para as saídas ficarem iguais. Sem DIR a
+# árvore vai para um diretório temporário.
+#
+
+set -eu
+
+SHELL_BIN=$1
+TOP=${2:-10}
+SUB=${3:-50}
+FILES=${4:-40}
+
+if [ $# -ge 5 ]; then
+    WORK=$5
+    mkdir -p "$WORK"
+else
+    WORK=$(mktemp -d)
+    trap 'rm -rf "$WORK"' EXIT
+fi
+TREE="$WORK/src"
+
+if [ ! -e "$TREE/.complete" ]; then
+    echo "gerando $TOP x $SUB diretórios x $FILES arquivos em $TREE" >&2
+    i=0
+    while [ "$i" -lt "$TOP" ]; do
+        j=0
+        while [ "$j" -lt "$SUB" ]; do
+            mkdir -p "$TREE/mod$i/pkg$j"
+            j=$((j + 1))
+        done
+        i=$((i + 1))
+    done
+    # Funções C de tamanho variado; o padrão raro aparece em ~1 a cada 50 arquivos,
+    # o comum ("return") em quase todas as funções. Alguns arquivos binários no meio.
+    awk -v top="$TOP" -v sub_="$SUB" -v files="$FILES" -v tree="$TREE" 'BEGIN {
+        srand(42)
+        for (i = 0; i < top; i++)
+            for (j = 0; j < sub_; j++)
+                for (k = 0; k < files; k++) {
+                    f = tree "/mod" i "/pkg" j "/file" k ".c"
+                    printf "#include <stdio.h>\n#include \"mod%d.h\"\n\n", i > f
+                    n = 5 + int(rand() * 60)
+                    for (m = 0; m < n; m++) {
+                        printf "static int handler_%d_%d(struct request *req, size_t len) {\n", k, m > f
+                        printf "    if (!req || len == 0) return -1;\n" > f
+                        printf "    for (size_t i = 0; i < len; i++) req->sum += req->data[i] * %d;\n", m > f
+                        if (rand() < 0.0004) printf "    log_event(\"needle_marker_xyz\", req->id);\n" > f
+                        printf "    return (int) req->sum;\n}\n\n" > f
+                    }
+                    close(f)
+                    if (k == 0) {
+                        b = tree "/mod" i "/pkg" j "/blob.bin"
+                        printf "BIN%c%cneedle_marker_xyz return", 0, 1 > b
+                        close(b)
+                    }
+                }
+    }'
+    : > "$TREE/.complete"
+fi
+
+# Melhor de 3 (cache quente depois da primeira). A saída vai para um arquivo:
+# com /dev/null o GNU grep para na primeira ocorrência, como com -q.
+best() {
+    best_time=
+    for _ in 1 2 3; do
+        start=$(date +%s.%N)
+        "$@" > "$WORK/out"
+        end=$(date +%s.%N)
+        best_time=$(awk -v s="$start" -v e="$end" -v b="$best_time" 'BEGIN {
+            t = e - s; if (b == "" || t < b) b = t; printf "%.4f", b
+        }')
+    done
+    echo "$best_time"
+}
+
+echo "árvore: $(find "$TREE" -type f | wc -l) arquivos, $(du -sh "$TREE" | cut -f1)"
+for pattern in needle_marker_xyz return; do
+    grep_lines=$(grep -rnF -I "$pattern" "$TREE" | sort | md5sum)
+    search_lines=$("$SHELL_BIN" -c "search $pattern $TREE" | sort | md5sum)
+    same=igual
+    [ "$grep_lines" = "$search_lines" ] || same=DIFERENTE
+
+    grep_time=$(best grep -rnF -I "$pattern" "$TREE")
+    one_time=$(best "$SHELL_BIN" -c "search -j 1 $pattern $TREE")
+    all_time=$(best "$SHELL_BIN" -c "search $pattern $TREE")
+    awk -v p="$pattern" -v same="$same" -v g="$grep_time" -v one="$one_time" -v all="$all_time" -v cpus="$(nproc)" 'BEGIN {
+        printf "\"%s\" (saída %s)\n", p, same
+        printf "  grep -rnF -I        %8.3f s\n", g
+        printf "  search -j 1         %8.3f s  (%.2fx)\n", one, g / one
+        printf "  search (%2d threads) %8.3f s  (%.2fx)\n", cpus, all, g / all
+    }'
+done
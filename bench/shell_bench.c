@@ -0,0 +1,1023 @@
+//
+// Microbenchmarks dos comandos internos sobre fixtures geradas, com resultado em JSON.
+//
+// Uso: shell_bench [--quick] [--dir DIR] [-o ARQUIVO]
+//
+// Fixtures: diretórios com 10k, 100k e 1M arquivos vazios (1M só sem --quick),
+// /procs falsos com PROC_FAKE_COUNT e MON_FAKE_COUNT processos e um histórico de HISTORY_FAKE_COUNT linhas. Com --dir elas ficam em DIR e
+// são reaproveitadas nas próximas execuções (gerar 1M arquivos leva tempo);
+// sem ele vão para um diretório temporário apagado no fim.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "../arena.h"
+#include "../builtins.h"
+#include "../dir_tools.h"
+#include "../exec.h"
+#include "../history.h"
+#include "../jobs.h"
+#include "../mon.h"
+#include "../parser.h"
+#include "../proc_tools.h"
+#include "../search.h"
+#include "../term_out.h"
+
+// Processos do /proc falso
+#define PROC_FAKE_COUNT 10000
+
+// Processos do /proc falso do `mon` (host grande) e tela simulada
+#define MON_FAKE_COUNT 30000
+#define MON_ROWS 50
+#define MON_COLS 160
+
+// Linhas do histórico falso (busca do Ctrl-R)
+#define HISTORY_FAKE_COUNT 1000000
+
+// Tempo mínimo de medida por benchmark
+#define BENCH_MIN_NS 300000000ull
+
+// Buffer de getdents64 da referência `lf_details_lstat` (o mesmo do readdir da glibc)
+#define BENCH_READDIR_BUF 32768
+
+// Capacidade pedida para o pipe dos casos `_pipe` e bloco lido pela thread leitora
+#define BENCH_PIPE_SIZE (1024 * 1024)
+
+// Limite de amostras guardadas por benchmark (percentis)
+#define BENCH_MAX_SAMPLES 100000
+
+#define BENCH_MAX_RESULTS 64
+
+/**
+ * @brief Operação medida: `batch` repetições por chamada.
+ */
+typedef void (*bench_fn)(void *ctx, size_t batch);
+
+struct bench_result {
+    const char *name;
+    const char *fixture;
+    size_t iterations;     // Operações medidas (chamadas × batch)
+    double ns_per_op;
+    double p50_ns;
+    double p99_ns;
+    double getdents_per_op;  // Syscalls de diretório por operação (`dir_counters`)
+    double stats_per_op;
+    size_t bytes_per_op;     // Saída por operação nos casos com pipe (0 = não se aplica)
+};
+
+struct lf_ctx {
+    char path[4096 + 16];
+    bool details;
+    bool cached;
+};
+
+/**
+ * @brief Pipe de verdade no lugar da saída padrão, esvaziado por uma thread leitora.
+ */
+struct pipe_sink {
+    int read_fd;
+    int saved_stdout;
+    pthread_t reader;
+    atomic_size_t bytes;  // Bytes lidos pela thread
+};
+
+struct pipe_ctx {
+    struct lf_ctx *lf;
+    const char *data;     // Bytes escritos direto no pipe (`pipe_write`)
+    size_t len;
+};
+
+struct tree_ctx {
+    struct process_snapshot snap;
+    long root;
+    struct process_totals *totals;  // Um por processo do snapshot
+};
+
+struct find_ctx {
+    struct search_matcher matcher;
+    const char *text;
+    size_t len;
+};
+
+struct history_ctx {
+    const char *query;
+};
+
+struct parse_ctx {
+    struct arena arena;
+    const char *line;
+    size_t len;
+};
+
+static struct bench_result results[BENCH_MAX_RESULTS];
+static size_t result_count = 0;
+static struct term_out_capture capture = {0};
+
+// Bytes de saída por operação do próximo `bench_run` (lido e zerado por ele)
+static size_t next_bytes_per_op = 0;
+
+// Destino dos resultados descartados (impede o compilador de remover a operação)
+static volatile uintptr_t bench_sink;
+
+/*****************************************************************************/
+
+/**
+ * @brief Tempo monotônico em nanossegundos.
+ */
+static uint64_t now_ns(void);
+
+/**
+ * @brief CPU consumida pela thread atual, em nanossegundos.
+ */
+static uint64_t thread_cpu_ns(void);
+
+/**
+ * @brief Mede o ciclo do `mon` (amostra + top-N + quadro) sobre o /proc atual e mostra a CPU por ciclo de 1 s.
+ * @param fixture Nome da fixture no resultado.
+ * @param processes Processos da fixture (0 = contar os do /proc atual).
+ */
+static void bench_mon(const char *fixture, size_t processes);
+
+/**
+ * @brief Mede `fn` até somar BENCH_MIN_NS e `min_calls` chamadas, e guarda o resultado.
+ * @param name Nome do benchmark.
+ * @param fixture Fixture usada ("-" se nenhuma).
+ * @param batch Operações por chamada (operações curtas demais para medir uma a uma).
+ * @param min_calls Chamadas mínimas.
+ */
+static void bench_run(const char *name, const char *fixture, bench_fn fn, void *ctx, size_t batch,
+                      size_t min_calls);
+
+/**
+ * @brief Cria (ou reaproveita) um diretório com `count` arquivos vazios.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int make_files_fixture(const char *path, size_t count);
+
+/**
+ * @brief Cria (ou reaproveita) um /proc falso: `<pid>/stat` com pais aleatórios e pid 1 como raiz.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int make_proc_fixture(const char *path, size_t count);
+
+/**
+ * @brief Cria (ou reaproveita) um arquivo de histórico com `count` linhas de comandos variados.
+ *
+ * A linha 1000 (das mais antigas) é a única com `deploy --canary release-7f3a`.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int make_history_fixture(const char *path, size_t count);
+
+/**
+ * @brief Apaga uma fixture de arquivos (ou de /proc, com `proc`).
+ */
+static void remove_fixture(const char *path, size_t count, bool proc);
+
+/**
+ * @brief Função de comparação para ordenação das amostras.
+ */
+static int compare_u64(const void *a, const void *b);
+
+/**
+ * @brief Troca a saída padrão por um pipe esvaziado por uma thread leitora.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int pipe_sink_start(struct pipe_sink *sink);
+
+/**
+ * @brief Devolve a saída padrão original e espera a thread leitora chegar ao fim do pipe.
+ */
+static void pipe_sink_stop(struct pipe_sink *sink);
+
+/**
+ * @brief Thread leitora: lê o pipe em blocos até o fim, só contando os bytes.
+ */
+static void *pipe_sink_drain(void *arg);
+
+/**
+ * @brief Compara dois nomes com `strcoll` (ordenação da referência `lf_details_lstat`).
+ */
+static int compare_names(const void *a, const void *b);
+
+/**
+ * @brief Escreve os resultados em JSON.
+ */
+static void write_json(FILE *out, bool quick);
+
+/**
+ * @brief Escreve uma string JSON com escapes.
+ */
+static void json_string(FILE *out, const char *str);
+
+static void bench_human_readable_size(void *ctx, size_t batch);
+static void bench_get_process_info(void *ctx, size_t batch);
+static void bench_get_process_info_stdio(void *ctx, size_t batch);
+static void bench_build_snapshot(void *ctx, size_t batch);
+static void bench_print_process_tree(void *ctx, size_t batch);
+static void bench_print_process_tree_totals(void *ctx, size_t batch);
+static void bench_print_process_tree_pipe(void *ctx, size_t batch);
+static void bench_lf(void *ctx, size_t batch);
+static void bench_lf_details_lstat(void *ctx, size_t batch);
+static void bench_lf_pipe(void *ctx, size_t batch);
+static void bench_pipe_write(void *ctx, size_t batch);
+static void bench_search_find(void *ctx, size_t batch);
+static void bench_parse_line(void *ctx, size_t batch);
+static void bench_mon_cycle(void *ctx, size_t batch);
+static void bench_history_search(void *ctx, size_t batch);
+static void bench_history_memmem(void *ctx, size_t batch);
+static void bench_history_typing(void *ctx, size_t batch);
+static void bench_spawn(void *ctx, size_t batch);
+static void bench_pipeline_run(void *ctx, size_t batch);
+
+/*****************************************************************************/
+
+int main(const int argc, char **argv) {
+    bool quick = false;
+    const char *output = NULL;
+    const char *dir = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) quick = true;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "uso: shell_bench [--quick] [--dir DIR] [-o ARQUIVO]\n");
+            return 2;
+        }
+    }
+
+    // Filhos do `pipeline_run` recolhidos pelo controle de jobs, como no shell (antes de qualquer thread)
+    if (jobs_init(false) != 0) {
+        perror("jobs_init");
+        return 1;
+    }
+
+    char root[4096];
+    if (dir) {
+        snprintf(root, sizeof(root), "%s", dir);
+        if (mkdir(root, 0755) != 0 && errno != EEXIST) {
+            perror(root);
+            return 1;
+        }
+    } else {
+        const char *tmp = getenv("TMPDIR");
+        snprintf(root, sizeof(root), "%s/shell_bench.XXXXXX", tmp ? tmp : "/tmp");
+        if (!mkdtemp(root)) {
+            perror("mkdtemp");
+            return 1;
+        }
+    }
+
+    static const struct {
+        const char *label;
+        size_t count;
+    } dirs[] = {{"files_10k", 10000}, {"files_100k", 100000}, {"files_1m", 1000000}};
+    const size_t dir_count = quick ? 2 : 3;
+
+    char proc_path[4096 + 16];
+    snprintf(proc_path, sizeof(proc_path), "%s/proc_10k", root);
+    fprintf(stderr, "shell_bench: gerando fixtures em %s\n", root);
+    if (make_proc_fixture(proc_path, PROC_FAKE_COUNT) != 0 || proc_set_root(proc_path) != 0) {
+        perror(proc_path);
+        return 1;
+    }
+
+    // Toda a saída dos comandos vai para a captura, esvaziada a cada operação
+    term_out_capture(&capture);
+
+    // human_readable_size
+    bench_run("human_readable_size", "-", bench_human_readable_size, NULL, 1024, 1);
+
+    // /proc falso: leitura de um stat, varredura completa e árvore
+    bench_run("get_process_info", "proc_10k", bench_get_process_info, NULL, 1000, 1);
+    // Referência: o leitor antigo (fopen + fgets + sscanf), extraindo os mesmos campos
+    bench_run("get_process_info_stdio", "proc_10k", bench_get_process_info_stdio, proc_path, 1000, 1);
+    struct tree_ctx tree = {0};
+    bench_run("build_process_snapshot", "proc_10k", bench_build_snapshot, &tree, 1, 5);
+    if (build_process_snapshot(&tree.snap, 0, 0) == 0) {
+        tree.root = find_process(&tree.snap, 1);
+        if (tree.root >= 0) bench_run("print_process_tree", "proc_10k", bench_print_process_tree, &tree, 1, 5);
+        struct pipe_sink sink;
+        if (tree.root >= 0 && pipe_sink_start(&sink) == 0) {
+            const struct tree_view view = {0};
+            capture.len = 0;
+            print_process_tree(&tree.snap, (size_t) tree.root, &view);
+            next_bytes_per_op = capture.len;
+            capture.len = 0;
+            bench_run("print_process_tree_pipe", "proc_10k", bench_print_process_tree_pipe, &tree, 1, 5);
+            pipe_sink_stop(&sink);
+        }
+        // Totais das subárvores (pós-ordem) + colunas + irmãos ordenados por CPU
+        tree.totals = malloc(tree.snap.count * sizeof(struct process_totals));
+        if (tree.root >= 0 && tree.totals) {
+            bench_run("print_process_tree_totals", "proc_10k", bench_print_process_tree_totals, &tree, 1, 5);
+        }
+        free(tree.totals);
+        free_process_snapshot(&tree.snap);
+    }
+
+    // `mon` em um host de 30k processos: o orçamento é 5% de uma CPU com o intervalo padrão de 1 s.
+    // No /proc falso nenhum processo usa CPU (regime = só os parados relidos a cada MON_IDLE_STRIDE ciclos) e o
+    // getdents do ext4 não vem em ordem de PID (um qsort a mais); o real mostra o custo do kernel para gerar cada stat.
+    char mon_path[4096 + 16];
+    snprintf(mon_path, sizeof(mon_path), "%s/proc_30k", root);
+    fprintf(stderr, "shell_bench: proc_30k\n");
+    if (make_proc_fixture(mon_path, MON_FAKE_COUNT) == 0 && proc_set_root(mon_path) == 0) {
+        bench_mon("proc_30k", MON_FAKE_COUNT);
+    } else {
+        perror(mon_path);
+    }
+    if (proc_set_root("/proc") == 0) bench_mon("proc", 0);
+    proc_set_root(proc_path);
+
+    // Listagens
+    for (size_t i = 0; i < dir_count; i++) {
+        struct lf_ctx lf = {0};
+        snprintf(lf.path, sizeof(lf.path), "%s/%s", root, dirs[i].label);
+        fprintf(stderr, "shell_bench: %s\n", dirs[i].label);
+        if (make_files_fixture(lf.path, dirs[i].count) != 0) {
+            perror(lf.path);
+            continue;
+        }
+        bench_run("print_lf_names", dirs[i].label, bench_lf, &lf, 1, 3);
+        lf.details = true;
+        bench_run("print_lf_details", dirs[i].label, bench_lf, &lf, 1, 3);
+        // Referência: as syscalls da listagem antiga (readdir, caminho completo e lstat por entrada),
+        // com uma saída reduzida, então só as contagens são comparáveis com `print_lf_details`
+        bench_run("lf_details_lstat", dirs[i].label, bench_lf_details_lstat, &lf, 1, 3);
+        // Repetição servida pelo cache de listagens (a primeira chamada, de aquecimento, o preenche)
+        lf.cached = true;
+        bench_run("print_lf_details_cached", dirs[i].label, bench_lf, &lf, 1, 3);
+
+        // Saída para um pipe de verdade (esvaziado por outra thread), ao lado de um write() dos
+        // mesmos bytes já prontos: o limite da banda do pipe
+        struct pipe_sink sink;
+        if (pipe_sink_start(&sink) == 0) {
+            capture.len = 0;
+            print_lf_details(lf.path, false, false, 1, true);
+            struct pipe_ctx pipe_ctx = {.lf = &lf, .data = capture.data, .len = capture.len};
+            next_bytes_per_op = capture.len;
+            capture.len = 0;
+            bench_run("print_lf_details_pipe", dirs[i].label, bench_lf_pipe, &pipe_ctx, 1, 3);
+            next_bytes_per_op = pipe_ctx.len;
+            bench_run("pipe_write", dirs[i].label, bench_pipe_write, &pipe_ctx, 1, 3);
+            capture.len = 0;
+            pipe_sink_stop(&sink);
+        }
+    }
+
+    // Casamento de `search`: 1 MB de código com o padrão só no fim, em cada implementação suportada
+    char *text = malloc((1 << 20) + 256);
+    if (text) {
+        size_t len = 0;
+        for (size_t i = 0; len < (1 << 20); i++) {
+            len += (size_t) sprintf(text + len, "    if (req->len > %zu) return handler_%zu(req);\n", i, i);
+        }
+        len += (size_t) sprintf(text + len, "needle_marker_xyz\n");
+        static const enum search_impl impls[] = {SEARCH_IMPL_SCALAR, SEARCH_IMPL_SSE2, SEARCH_IMPL_AVX2};
+        for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+            struct find_ctx find = {.text = text, .len = len};
+            if (search_matcher_init(&find.matcher, "needle_marker_xyz", 17, impls[i]) != 0) continue;
+            bench_run("search_find", search_impl_name(impls[i]), bench_search_find, &find, 1, 20);
+        }
+        free(text);
+    }
+
+    // Analisador: linha típica e linha de 1 MB
+    struct parse_ctx parse = {.line = "ls -l | grep \"foo bar\" > out.txt 2>&1 && echo $HOME; sleep 1 &"};
+    parse.len = strlen(parse.line);
+    bench_run("parse_line", "typical", bench_parse_line, &parse, 1000, 1);
+    char *big = malloc((1 << 20) + 16);
+    if (big) {
+        size_t len = 0;
+        while (len < (1 << 20)) len += (size_t) sprintf(big + len, " arg%zu", len);
+        parse.line = big;
+        parse.len = len;
+        bench_run("parse_line", "1mb", bench_parse_line, &parse, 1, 5);
+        free(big);
+    }
+    arena_free(&parse.arena);
+
+    // Ctrl-R sobre 1M linhas de histórico, com o índice de trigramas já construído
+    char history_path[4096 + 16];
+    snprintf(history_path, sizeof(history_path), "%s/history_1m", root);
+    fprintf(stderr, "shell_bench: history_1m\n");
+    if (make_history_fixture(history_path, HISTORY_FAKE_COUNT) != 0 || history_init(history_path) != 0) {
+        perror(history_path);
+    } else {
+        // O índice é montado em uma thread: medir só a busca indexada
+        struct history_stats stats = history_get_stats();
+        for (int i = 0; i < 3000 && stats.indexed < stats.entries; i++) {
+            nanosleep(&(struct timespec) {.tv_nsec = 10000000}, NULL);
+            stats = history_get_stats();
+        }
+        fprintf(stderr, "  %zu entradas, %zu indexadas, %zu postings, índice em %.1f ms\n", stats.entries,
+                stats.indexed, stats.postings, stats.index_ms);
+        // Mais nova (palavra comum), única e antiga, ausente; e a referência memmem em todas as entradas
+        struct history_ctx recent = {.query = "git"};
+        bench_run("history_search", "recent", bench_history_search, &recent, 1000, 1);
+        struct history_ctx rare = {.query = "release-7f3a"};
+        bench_run("history_search", "rare", bench_history_search, &rare, 1, 20);
+        bench_run("history_memmem", "rare", bench_history_memmem, &rare, 1, 5);
+        struct history_ctx missing = {.query = "kubectl rollout"};
+        bench_run("history_search", "missing", bench_history_search, &missing, 1, 20);
+        // Uma busca por tecla: "r", "re", ..., "release-7f3a" (as de 1 e 2 bytes percorrem sem índice)
+        bench_run("history_ctrl_r_typing", "rare", bench_history_typing, &rare, 1, 5);
+        history_free();
+    }
+
+    // Latência de criação de processo (posix_spawn + waitpid)
+    bench_run("exec_spawn", "/bin/true", bench_spawn, NULL, 1, 200);
+
+    // Vazão de comandos pelo caminho do shell (PATH em cache, job, wait4 pelo signalfd): 10k `true`
+    struct arena line_arena = {0};
+    const struct command_list *list = parse_line(&line_arena, "true", 4);
+    if (list && list->count == 1) {
+        bench_run("pipeline_run", "true", bench_pipeline_run, (void *) &list->items[0].pipeline, 1000, 10);
+        fprintf(stderr, "  %.0f comandos/s\n", 1e9 / results[result_count - 1].ns_per_op);
+    }
+    arena_free(&line_arena);
+
+    term_out_capture(NULL);
+    free(capture.data);
+
+    if (!dir) {
+        for (size_t i = 0; i < dir_count; i++) {
+            char path[4096 + 16];
+            snprintf(path, sizeof(path), "%s/%s", root, dirs[i].label);
+            remove_fixture(path, dirs[i].count, false);
+        }
+        remove_fixture(proc_path, PROC_FAKE_COUNT, true);
+        remove_fixture(mon_path, MON_FAKE_COUNT, true);
+        unlink(history_path);
+        rmdir(root);
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    write_json(out, quick);
+    if (output) {
+        fclose(out);
+        fprintf(stderr, "shell_bench: resultados em %s\n", output);
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void bench_mon(const char *fixture, size_t processes) {
+    struct mon_state *mon = mon_state_new(MON_ROWS, MON_COLS);
+    struct pipe_sink sink;
+    if (!mon || pipe_sink_start(&sink) != 0) {
+        mon_state_free(mon);
+        return;
+    }
+    // Primeiro ciclo fora da medida: abre os stat (keep_open) e guarda a amostra base
+    mon_cycle(mon, 0);
+
+    // Até os processos contarem como parados, todos são relidos: o pior caso (todos ativos)
+    uint64_t cpu_start = thread_cpu_ns();
+    for (int i = 0; i < MON_IDLE_CYCLES; i++) mon_cycle(mon, 1.0);
+    const double full_ms = (double) (thread_cpu_ns() - cpu_start) / MON_IDLE_CYCLES / 1e6;
+
+    // Regime: os parados são relidos a cada MON_IDLE_STRIDE ciclos
+    const size_t first = result_count;
+    cpu_start = thread_cpu_ns();
+    bench_run("mon_cycle", fixture, bench_mon_cycle, mon, 1, 10);
+    const uint64_t cpu = thread_cpu_ns() - cpu_start;
+    pipe_sink_stop(&sink);
+    mon_state_free(mon);
+    if (result_count == first) return;
+
+    // A CPU inclui a chamada de aquecimento do bench_run; a saída vai para o pipe, como para o terminal
+    const struct bench_result *result = &results[result_count - 1];
+    const double cycle_ms = (double) cpu / (double) (result->iterations + 1) / 1e6;
+    if (!processes) {
+        // /proc real: informa quantos processos a máquina tem (o orçamento é medido na fixture de 30k)
+        struct process_table table = {0};
+        if (scan_processes(&table, 1) == 0) processes = table.count;
+        free_process_table(&table);
+    }
+    // Orçamento: 5% de uma CPU com 30k processos e o intervalo padrão de 1 s
+    fprintf(stderr, "  %zu processos | CPU por ciclo: %.2f ms em regime (%.2f%% a 1 s), %.2f ms com todos relidos (%.2f%%)\n",
+            processes, cycle_ms, cycle_ms / 10, full_ms, full_ms / 10);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static int pipe_sink_start(struct pipe_sink *sink) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return -1;
+    fcntl(fds[1], F_SETPIPE_SZ, BENCH_PIPE_SIZE);
+    sink->read_fd = fds[0];
+    atomic_init(&sink->bytes, 0);
+    sink->saved_stdout = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+    if (sink->saved_stdout < 0 || dup2(fds[1], STDOUT_FILENO) < 0 ||
+        pthread_create(&sink->reader, NULL, pipe_sink_drain, sink) != 0) {
+        if (sink->saved_stdout >= 0) {
+            dup2(sink->saved_stdout, STDOUT_FILENO);
+            close(sink->saved_stdout);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    close(fds[1]);
+    return 0;
+}
+
+static void pipe_sink_stop(struct pipe_sink *sink) {
+    // Com a última ponta de escrita fechada a thread lê o fim do pipe
+    dup2(sink->saved_stdout, STDOUT_FILENO);
+    close(sink->saved_stdout);
+    pthread_join(sink->reader, NULL);
+    close(sink->read_fd);
+}
+
+static void *pipe_sink_drain(void *arg) {
+    struct pipe_sink *sink = arg;
+    char *buf = malloc(BENCH_PIPE_SIZE);
+    if (!buf) return NULL;
+    ssize_t len;
+    while ((len = read(sink->read_fd, buf, BENCH_PIPE_SIZE)) != 0) {
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        atomic_fetch_add_explicit(&sink->bytes, (size_t) len, memory_order_relaxed);
+    }
+    free(buf);
+    return NULL;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcoll(*(char *const *) a, *(char *const *) b);
+}
+
+static void bench_run(const char *name, const char *fixture, const bench_fn fn, void *ctx, const size_t batch,
+                      const size_t min_calls) {
+    if (result_count == BENCH_MAX_RESULTS) return;
+    uint64_t *samples = malloc(BENCH_MAX_SAMPLES * sizeof(uint64_t));
+    if (!samples) return;
+
+    // Uma chamada de aquecimento (caches de página, dentries, arena)
+    fn(ctx, batch);
+
+    const size_t getdents_before = atomic_load(&dir_counters.getdents);
+    const size_t stats_before = atomic_load(&dir_counters.stats);
+    size_t calls = 0;
+    uint64_t total = 0;
+    while ((total < BENCH_MIN_NS || calls < min_calls) && calls < BENCH_MAX_SAMPLES) {
+        const uint64_t start = now_ns();
+        fn(ctx, batch);
+        const uint64_t elapsed = now_ns() - start;
+        samples[calls++] = elapsed;
+        total += elapsed;
+    }
+    qsort(samples, calls, sizeof(uint64_t), compare_u64);
+
+    struct bench_result *result = &results[result_count++];
+    result->name = name;
+    result->fixture = fixture;
+    result->iterations = calls * batch;
+    result->ns_per_op = (double) total / (double) result->iterations;
+    result->p50_ns = (double) samples[calls / 2] / (double) batch;
+    result->p99_ns = (double) samples[calls * 99 / 100] / (double) batch;
+    result->getdents_per_op =
+        (double) (atomic_load(&dir_counters.getdents) - getdents_before) / (double) result->iterations;
+    result->stats_per_op = (double) (atomic_load(&dir_counters.stats) - stats_before) / (double) result->iterations;
+    result->bytes_per_op = next_bytes_per_op;
+    next_bytes_per_op = 0;
+    free(samples);
+
+    fprintf(stderr, "  %-24s %-12s %12.1f ns/op  p50 %12.1f  p99 %12.1f  (%zu)", name, fixture,
+            result->ns_per_op, result->p50_ns, result->p99_ns, result->iterations);
+    if (result->getdents_per_op > 0 || result->stats_per_op > 0) {
+        fprintf(stderr, "  getdents %.1f, stat %.1f", result->getdents_per_op, result->stats_per_op);
+    }
+    if (result->bytes_per_op) {
+        fprintf(stderr, "  %.1f MB/s", (double) result->bytes_per_op / result->ns_per_op * 1e3);
+    }
+    fputc('\n', stderr);
+}
+
+static int make_files_fixture(const char *path, const size_t count) {
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    const int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return -1;
+
+    // O marcador só é criado depois do último arquivo: uma geração interrompida é refeita
+    if (faccessat(dir_fd, ".complete", F_OK, 0) == 0) {
+        close(dir_fd);
+        return 0;
+    }
+    char name[32];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "f%07zu", i);
+        const int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            close(dir_fd);
+            return -1;
+        }
+        close(fd);
+    }
+    const int marker = openat(dir_fd, ".complete", O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (marker >= 0) close(marker);
+    close(dir_fd);
+    return 0;
+}
+
+static int make_proc_fixture(const char *path, const size_t count) {
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    const int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return -1;
+    if (faccessat(dir_fd, ".complete", F_OK, 0) == 0) {
+        close(dir_fd);
+        return 0;
+    }
+
+    // Semente fixa: a mesma árvore em todas as execuções
+    srand(42);
+    char name[32], stat[512];
+    for (size_t pid = 1; pid <= count; pid++) {
+        snprintf(name, sizeof(name), "%zu", pid);
+        if (mkdirat(dir_fd, name, 0755) != 0 && errno != EEXIST) break;
+        const size_t ppid = pid == 1 ? 0 : 1 + (size_t) rand() % (pid - 1);
+        const int len = snprintf(stat, sizeof(stat),
+                                 "%zu (worker %zu) S %zu %zu %zu 0 -1 4194560 %d 0 0 0 %d %d 0 0 20 0 %d 0 %zu "
+                                 "%d %d 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 "
+                                 "0 0\n",
+                                 pid, pid % 997, ppid, pid, pid, rand() % 5000, rand() % 1000, rand() % 100,
+                                 1 + rand() % 8, 1000 + pid, 10000000 + rand() % 100000000, rand() % 50000);
+        snprintf(name, sizeof(name), "%zu/stat", pid);
+        const int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0 || write(fd, stat, (size_t) len) != len) {
+            if (fd >= 0) close(fd);
+            close(dir_fd);
+            return -1;
+        }
+        close(fd);
+    }
+    const int marker = openat(dir_fd, ".complete", O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (marker >= 0) close(marker);
+    close(dir_fd);
+    return 0;
+}
+
+static int make_history_fixture(const char *path, const size_t count) {
+    if (access(path, F_OK) == 0) return 0;
+
+    // Gerado em um temporário e renomeado no fim: uma geração interrompida é refeita
+    char tmp[4096 + 32];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *out = fopen(tmp, "w");
+    if (!out) return -1;
+    static const char *const words[] = {"src", "build", "docs", "tests", "bench", "include", "scripts", "vendor"};
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const uint32_t r = seed >> 8;
+        const char *word = words[r % 8];
+        if (i == 1000) {
+            fprintf(out, "./deploy --canary release-7f3a --region sa-east-1\n");
+            continue;
+        }
+        switch (r % 6) {
+        case 0: fprintf(out, "git commit -m \"ajusta %s %u\"\n", word, r % 10000); break;
+        case 1: fprintf(out, "cd ~/projetos/app%u/%s\n", r % 500, word); break;
+        case 2: fprintf(out, "make -j%u -C %s\n", 1 + r % 32, word); break;
+        case 3: fprintf(out, "search -n TODO%u %s\n", r % 1000, word); break;
+        case 4: fprintf(out, "ssh deploy@host%u.exemplo.com.br\n", r % 2000); break;
+        default: fprintf(out, "lf -l %s/%u | grep .c\n", word, r % 100); break;
+        }
+    }
+    if (fclose(out) != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void remove_fixture(const char *path, const size_t count, const bool proc) {
+    const int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return;
+    char name[32];
+    for (size_t i = 0; i < count; i++) {
+        if (proc) {
+            snprintf(name, sizeof(name), "%zu/stat", i + 1);
+            unlinkat(dir_fd, name, 0);
+            snprintf(name, sizeof(name), "%zu", i + 1);
+            unlinkat(dir_fd, name, AT_REMOVEDIR);
+        } else {
+            snprintf(name, sizeof(name), "f%07zu", i);
+            unlinkat(dir_fd, name, 0);
+        }
+    }
+    unlinkat(dir_fd, ".complete", 0);
+    close(dir_fd);
+    rmdir(path);
+}
+
+static void json_string(FILE *out, const char *str) {
+    fputc('"', out);
+    for (; *str; str++) {
+        const unsigned char c = (unsigned char) *str;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void write_json(FILE *out, const bool quick) {
+    fprintf(out, "{\n  \"version\": 1,\n  \"timestamp\": %lld,\n  \"cpus\": %ld,\n  \"quick\": %s,\n",
+            (long long) time(NULL), sysconf(_SC_NPROCESSORS_ONLN), quick ? "true" : "false");
+    fprintf(out, "  \"compiler\": ");
+    json_string(out, __VERSION__);
+    fprintf(out, ",\n  \"results\": [\n");
+    for (size_t i = 0; i < result_count; i++) {
+        const struct bench_result *r = &results[i];
+        fprintf(out, "    {\"name\": ");
+        json_string(out, r->name);
+        fprintf(out, ", \"fixture\": ");
+        json_string(out, r->fixture);
+        fprintf(out, ", \"iterations\": %zu, \"ns_per_op\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, "
+                     "\"ops_per_s\": %.1f",
+                r->iterations, r->ns_per_op, r->p50_ns, r->p99_ns, 1e9 / r->ns_per_op);
+        if (r->getdents_per_op > 0 || r->stats_per_op > 0) {
+            fprintf(out, ", \"getdents_per_op\": %.1f, \"stats_per_op\": %.1f", r->getdents_per_op,
+                    r->stats_per_op);
+        }
+        if (r->bytes_per_op) {
+            fprintf(out, ", \"bytes_per_op\": %zu, \"mb_per_s\": %.1f", r->bytes_per_op,
+                    (double) r->bytes_per_op / r->ns_per_op * 1e3);
+        }
+        fprintf(out, "}%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+/*****************************************************************************/
+
+static void bench_human_readable_size(void *ctx, const size_t batch) {
+    (void) ctx;
+    long bytes = 1;
+    for (size_t i = 0; i < batch; i++) {
+        bench_sink = (unsigned char) human_readable_size(bytes)[0];
+        bytes = bytes * 7 + 3;
+        if (bytes < 0) bytes = 1;
+    }
+}
+
+static void bench_get_process_info(void *ctx, const size_t batch) {
+    (void) ctx;
+    static size_t next = 0;
+    for (size_t i = 0; i < batch; i++) {
+        bench_sink = (uintptr_t) get_process_info((pid_t) (1 + next)).ppid;
+        next = (next + 7919) % PROC_FAKE_COUNT;
+    }
+}
+
+static void bench_get_process_info_stdio(void *ctx, const size_t batch) {
+    const char *root = ctx;
+    static size_t next = 0;
+    char path[4096 + 64], line[1024];
+    for (size_t i = 0; i < batch; i++) {
+        struct process_info info = {0};
+        snprintf(path, sizeof(path), "%s/%zu/stat", root, 1 + next);
+        next = (next + 7919) % PROC_FAKE_COUNT;
+
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        const bool read_ok = fgets(line, sizeof(line), f) != NULL;
+        fclose(f);
+        char *start = strchr(line, '(');
+        char *end = strrchr(line, ')');
+        if (!read_ok || !start || !end) continue;
+
+        *end = '\0';
+        info.pid = atoi(line);
+        snprintf(info.name, sizeof(info.name), "%s", start + 1);
+        sscanf(end + 2, "%c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %*d %*d %*d %*d %ld %*d %llu %*u %ld",
+               &info.state, &info.ppid, &info.utime, &info.stime, &info.num_threads, &info.starttime, &info.rss);
+        bench_sink = (uintptr_t) info.ppid;
+    }
+}
+
+static void bench_build_snapshot(void *ctx, const size_t batch) {
+    struct tree_ctx *tree = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        if (build_process_snapshot(&tree->snap, 0, 0) == 0) free_process_snapshot(&tree->snap);
+    }
+}
+
+static void bench_print_process_tree(void *ctx, const size_t batch) {
+    const struct tree_ctx *tree = ctx;
+    const struct tree_view view = {0};
+    for (size_t i = 0; i < batch; i++) {
+        print_process_tree(&tree->snap, (size_t) tree->root, &view);
+        capture.len = 0;
+    }
+}
+
+static void bench_print_process_tree_totals(void *ctx, const size_t batch) {
+    const struct tree_ctx *tree = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        if (process_subtree_totals(&tree->snap, (size_t) tree->root, tree->totals) != 0) continue;
+        const struct tree_view view = {.columns = TREE_SHOW_RSS | TREE_SHOW_CPU | TREE_SHOW_THREADS,
+                                       .sort = TREE_KEY_CPU, .totals = tree->totals};
+        print_process_tree(&tree->snap, (size_t) tree->root, &view);
+        capture.len = 0;
+    }
+}
+
+static void bench_print_process_tree_pipe(void *ctx, const size_t batch) {
+    const struct tree_ctx *tree = ctx;
+    const struct tree_view view = {0};
+    struct term_out_capture *previous = term_out_capture(NULL);
+    for (size_t i = 0; i < batch; i++) {
+        print_process_tree(&tree->snap, (size_t) tree->root, &view);
+        term_out_flush();
+    }
+    term_out_capture(previous);
+}
+
+static void bench_lf(void *ctx, const size_t batch) {
+    const struct lf_ctx *lf = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        if (lf->details) print_lf_details(lf->path, false, false, 1, lf->cached);
+        else print_lf_names(lf->path, false, false, lf->cached);
+        capture.len = 0;
+    }
+}
+
+static void bench_lf_details_lstat(void *ctx, const size_t batch) {
+    const struct lf_ctx *lf = ctx;
+    char *buf = malloc(BENCH_READDIR_BUF);
+    if (!buf) return;
+    for (size_t i = 0; i < batch; i++) {
+        const int fd = open(lf->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) break;
+        char **names = NULL;
+        size_t count = 0, capacity = 0;
+        ssize_t len;
+        while ((len = getdents64(fd, buf, BENCH_READDIR_BUF)) > 0) {
+            atomic_fetch_add(&dir_counters.getdents, 1);
+            for (ssize_t pos = 0; pos < len;) {
+                const struct dirent64 *entry = (const struct dirent64 *) (buf + pos);
+                pos += entry->d_reclen;
+                if (entry->d_name[0] == '.') continue;
+                if (count == capacity) {
+                    capacity = capacity ? capacity * 2 : 1024;
+                    char **grown = realloc(names, capacity * sizeof(char *));
+                    if (!grown) break;
+                    names = grown;
+                }
+                if (count < capacity) names[count++] = strdup(entry->d_name);
+            }
+        }
+        atomic_fetch_add(&dir_counters.getdents, 1);
+        close(fd);
+        qsort(names, count, sizeof(char *), compare_names);
+
+        char full_path[4096 + 256];
+        for (size_t k = 0; k < count; k++) {
+            snprintf(full_path, sizeof(full_path), "%s/%s", lf->path, names[k]);
+            struct stat st;
+            atomic_fetch_add(&dir_counters.stats, 1);
+            if (lstat(full_path, &st) == 0) {
+                term_out_printf("%o %ld %ld %s\n", st.st_mode, (long) st.st_size, (long) st.st_mtime, names[k]);
+            }
+            free(names[k]);
+        }
+        free(names);
+        capture.len = 0;
+    }
+    free(buf);
+}
+
+static void bench_lf_pipe(void *ctx, const size_t batch) {
+    const struct pipe_ctx *pipe_ctx = ctx;
+    // A captura é desligada só durante a operação: a saída vai para o buffer compartilhado e dele para o pipe
+    struct term_out_capture *previous = term_out_capture(NULL);
+    for (size_t i = 0; i < batch; i++) {
+        print_lf_details(pipe_ctx->lf->path, false, false, 1, true);
+        term_out_flush();
+    }
+    term_out_capture(previous);
+}
+
+static void bench_pipe_write(void *ctx, const size_t batch) {
+    const struct pipe_ctx *pipe_ctx = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        for (size_t done = 0; done < pipe_ctx->len;) {
+            const size_t chunk = pipe_ctx->len - done < TERM_OUT_BUF_SIZE ? pipe_ctx->len - done : TERM_OUT_BUF_SIZE;
+            const ssize_t written = write(STDOUT_FILENO, pipe_ctx->data + done, chunk);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) break;
+            done += (size_t) written;
+        }
+    }
+}
+
+static void bench_search_find(void *ctx, const size_t batch) {
+    const struct find_ctx *find = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        bench_sink = (uintptr_t) search_find(&find->matcher, find->text, find->len);
+    }
+}
+
+static void bench_parse_line(void *ctx, const size_t batch) {
+    struct parse_ctx *parse = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        bench_sink = (uintptr_t) parse_line(&parse->arena, parse->line, parse->len);
+        arena_reset(&parse->arena);
+    }
+}
+
+static void bench_mon_cycle(void *ctx, const size_t batch) {
+    struct mon_state *mon = ctx;
+    for (size_t i = 0; i < batch; i++) mon_cycle(mon, 1.0);
+}
+
+static void bench_history_search(void *ctx, const size_t batch) {
+    const struct history_ctx *history = ctx;
+    for (size_t i = 0; i < batch; i++) {
+        size_t index = 0;
+        bench_sink = history_search(history->query, history_count(), &index) ? index : SIZE_MAX;
+    }
+}
+
+static void bench_history_memmem(void *ctx, const size_t batch) {
+    const struct history_ctx *history = ctx;
+    const size_t query_len = strlen(history->query);
+    for (size_t i = 0; i < batch; i++) {
+        size_t index = history_count();
+        while (index > 0) {
+            size_t len;
+            const char *text = history_get(--index, &len);
+            if (memmem(text, len, history->query, query_len)) break;
+        }
+        bench_sink = index;
+    }
+}
+
+static void bench_history_typing(void *ctx, const size_t batch) {
+    const struct history_ctx *history = ctx;
+    const size_t query_len = strlen(history->query);
+    char query[256];
+    for (size_t i = 0; i < batch; i++) {
+        for (size_t typed = 1; typed <= query_len && typed < sizeof(query); typed++) {
+            memcpy(query, history->query, typed);
+            query[typed] = '\0';
+            size_t index = 0;
+            bench_sink = history_search(query, history_count(), &index) ? index : SIZE_MAX;
+        }
+    }
+}
+
+static void bench_pipeline_run(void *ctx, const size_t batch) {
+    const struct pipeline *pipeline = ctx;
+    for (size_t i = 0; i < batch; i++) bench_sink = (uintptr_t) pipeline_run(pipeline, BUILTINS, NULL);
+}
+
+static void bench_spawn(void *ctx, const size_t batch) {
+    (void) ctx;
+    static int null_fd = -1;
+    if (null_fd < 0) null_fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    char *argv[] = {"/bin/true", NULL};
+    for (size_t i = 0; i < batch; i++) {
+        pid_t pid;
+        if (exec_spawn(argv, null_fd, null_fd, null_fd, &pid) != 0) continue;
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR) {}
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Arquivo que encolhe durante a leitura: biblioteca para LD_PRELOAD que trunca arquivos pela metade no mmap.
+//
+// Uso: SHRINK_MMAP_NAME=.log LD_PRELOAD=libshrink_mmap.so T1_Shell -c "search TEXTO DIR"
+//
+// Antes de mapear um arquivo cujo nome termina em SHRINK_MMAP_NAME, o tamanho
+// é reduzido à metade (pelo /proc/self/fd, já que o descritor é só de
+// leitura): o mapeamento fica com o tamanho antigo e as páginas além do novo
+// fim dão SIGBUS, como quando outro processo trunca um log enquanto o shell o
+// varre. Só os testes usam a biblioteca; o shell não sabe dela.
+//
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef void *(*mmap_fn)(void *, size_t, int, int, int, off_t);
+
+/*****************************************************************************/
+
+/**
+ * @brief Reduz à metade o arquivo de `fd` se o nome dele terminar em SHRINK_MMAP_NAME.
+ */
+static void shrink(int fd);
+
+/*****************************************************************************/
+
+void *mmap(void *addr, const size_t length, const int prot, const int flags, const int fd, const off_t offset) {
+    static mmap_fn real;
+    if (!real) real = (mmap_fn) dlsym(RTLD_NEXT, "mmap");
+    if (fd >= 0) shrink(fd);
+    return real(addr, length, prot, flags, fd, offset);
+}
+
+/*****************************************************************************/
+
+static void shrink(const int fd) {
+    const char *suffix = getenv("SHRINK_MMAP_NAME");
+    struct stat st;
+    if (!suffix || !*suffix || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return;
+
+    char link[64], path[4096];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    const ssize_t len = readlink(link, path, sizeof(path) - 1);
+    const size_t suffix_len = strlen(suffix);
+    if (len < 0 || (size_t) len < suffix_len || memcmp(path + len - suffix_len, suffix, suffix_len) != 0) return;
+    if (truncate(link, st.st_size / 2) != 0) perror("shrink_mmap");
+}
@@ -0,0 +1,60 @@
+//
+// Sistema de arquivos lento simulado: biblioteca para LD_PRELOAD que atrasa cada statx/fstatat.
+//
+// Uso: SLOW_STAT_US=2000 LD_PRELOAD=libslow_stat.so T1_Shell -c "lf --no-cache -l -j 16 DIR"
+//
+// Cada chamada dorme SLOW_STAT_US microssegundos antes de ir ao kernel, como
+// a ida e volta de um stat no NFS ou no FUSE. Só os testes e benchmarks usam
+// a biblioteca; o shell não sabe dela.
+//
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef int (*statx_fn)(int, const char *, int, unsigned int, struct statx *);
+typedef int (*fstatat_fn)(int, const char *, struct stat *, int);
+
+/*****************************************************************************/
+
+/**
+ * @brief Dorme o atraso configurado em SLOW_STAT_US (lido uma vez).
+ */
+static void slow_down(void);
+
+/*****************************************************************************/
+
+int statx(const int dir_fd, const char *path, const int flags, const unsigned int mask, struct statx *buf) {
+    static statx_fn real;
+    if (!real) real = (statx_fn) dlsym(RTLD_NEXT, "statx");
+    slow_down();
+    return real(dir_fd, path, flags, mask, buf);
+}
+
+int fstatat(const int dir_fd, const char *path, struct stat *buf, const int flags) {
+    static fstatat_fn real;
+    if (!real) real = (fstatat_fn) dlsym(RTLD_NEXT, "fstatat");
+    slow_down();
+    return real(dir_fd, path, buf, flags);
+}
+
+int fstatat64(const int dir_fd, const char *path, struct stat64 *buf, const int flags) {
+    static fstatat_fn real;
+    if (!real) real = (fstatat_fn) dlsym(RTLD_NEXT, "fstatat64");
+    slow_down();
+    return real(dir_fd, path, (struct stat *) buf, flags);
+}
+
+/*****************************************************************************/
+
+static void slow_down(void) {
+    static long delay = -1;
+    if (delay < 0) {
+        const char *env = getenv("SLOW_STAT_US");
+        delay = env ? strtol(env, NULL, 10) : 0;
+        if (delay < 0) delay = 0;
+    }
+    if (delay) usleep((useconds_t) delay);
+}
@@ -0,0 +1,76 @@
+#!/bin/sh
+#
+# `usage` (varredura paralela) contra `du -s` em uma árvore gerada: TOP diretórios
+# com SUB subdiretórios de FILES arquivos cada. Mostra o melhor de 3 execuções.
+#
+# Uso: usage_bench.sh SHELL [TOP] [SUB] [FILES] [DIR]
+#
+# Sem DIR a árvore vai para um diretório temporário (use DIR no disco que
+# interessa, ex.: um NVMe, e rode com o cache frio para medir a E/S).
+#
+
+set -eu
+
+SHELL_BIN=$1
+TOP=${2:-20}
+SUB=${3:-100}
+FILES=${4:-100}
+
+if [ $# -ge 5 ]; then
+    WORK=$5
+    mkdir -p "$WORK"
+else
+    WORK=$(mktemp -d)
+    trap 'rm -rf "$WORK"' EXIT
+fi
+TREE="$WORK/tree"
+
+if [ ! -e "$TREE/.complete" ]; then
+    echo "gerando $TOP x $SUB diretórios x $FILES arquivos em $TREE" >&2
+    i=0
+    while [ "$i" -lt "$TOP" ]; do
+        j=0
+        while [ "$j" -lt "$SUB" ]; do
+            mkdir -p "$TREE/d$i/s$j"
+            j=$((j + 1))
+        done
+        i=$((i + 1))
+    done
+    # Um awk gera os nomes; o tamanho varia para os blocos não serem todos iguais
+    awk -v top="$TOP" -v sub_="$SUB" -v files="$FILES" -v tree="$TREE" 'BEGIN {
+        for (i = 0; i < top; i++)
+            for (j = 0; j < sub_; j++)
+                for (k = 0; k < files; k++) {
+                    f = tree "/d" i "/s" j "/f" k
+                    printf "%*s", (k % 7) * 700, "" > f
+                    close(f)
+                }
+    }'
+    : > "$TREE/.complete"
+fi
+
+# Melhor de 3 (cache quente depois da primeira)
+best() {
+    best_time=
+    for _ in 1 2 3; do
+        start=$(date +%s.%N)
+        "$@" > /dev/null
+        end=$(date +%s.%N)
+        best_time=$(awk -v s="$start" -v e="$end" -v b="$best_time" 'BEGIN {
+            t = e - s; if (b == "" || t < b) b = t; printf "%.4f", b
+        }')
+    done
+    echo "$best_time"
+}
+
+du_time=$(best du -s "$TREE")
+one_time=$(best "$SHELL_BIN" -c "usage -j 1 $TREE")
+all_time=$(best "$SHELL_BIN" -c "usage $TREE")
+
+echo "du -s:        $(du -sh "$TREE" | cut -f1)"
+echo "usage:        $("$SHELL_BIN" -c "usage $TREE" | sed 's/\x1b\[[0-9;]*m//g' | awk '{print $1}')"
+awk -v du="$du_time" -v one="$one_time" -v all="$all_time" -v cpus="$(nproc)" 'BEGIN {
+    printf "du -s               %8.3f s\n", du
+    printf "usage -j 1          %8.3f s  (%.2fx)\n", one, du / one
+    printf "usage (%2d threads)  %8.3f s  (%.2fx)\n", cpus, all, du / all
+}'
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# `tree --watch` sob uma rajada de processos do fork_storm: WORKERS workers
+# criando cadeias de 3 processos com exec durante SECONDS segundos. Mostra o
+# resumo do modo netlink (eventos, pico, ressincronizações, divergências na
+# verificação final e CPU do shell) e, para comparação, o da releitura do /proc
+# no mesmo intervalo.
+#
+# Uso: watch_bench.sh SHELL FORK_STORM [SECONDS] [WORKERS]
+#
+# Antes do Linux 6.6 o netlink exige CAP_NET_ADMIN; sem ela as duas execuções usam o /proc.
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+STORM_BIN=$(realpath "$2")
+SECONDS_RUN=${3:-5}
+WORKERS=${4:-4}
+
+# Um intervalo de meio segundo: a rajada começa 1 s depois e o watch vai além do fim dela
+CYCLES=$(awk -v s="$SECONDS_RUN" 'BEGIN { printf "%d", (s + 2) * 2 }')
+
+run() {
+    mode=$1
+    "$STORM_BIN" -a 1 -s "$SECONDS_RUN" -w "$WORKERS" -p 3 -e 2> /dev/null > "$WORK/storm" &
+    storm=$!
+    "$SHELL_BIN" -c "tree --watch -d 0.5 -c $CYCLES $mode $storm" < /dev/null 2>&1 | tail -n 2 |
+        sed 's/\x1b\[[0-9;?]*[a-zA-Z]//g' | grep 'tree --watch:' | tr '|' '\n' | sed 's/^ */  /; s/ *$//'
+    wait "$storm"
+    sed 's/^fork_storm: /  gerado: /' "$WORK/storm"
+}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+echo "netlink"
+run ""
+echo "/proc"
+run --proc
@@ -0,0 +1,1227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#include "builtins.h"
+#include "term_tools.h"
+#include "term_out.h"
+#include "proc_tools.h"
+#include "mon.h"
+#include "name_cache.h"
+#include "dir_tools.h"
+#include "path_cache.h"
+#include "jobs.h"
+#include "history.h"
+#include "par.h"
+#include "stats.h"
+#include "walk.h"
+#include "dir_cache.h"
+#include "search.h"
+#include "tree_watch.h"
+
+char CWD[2048];
+
+const struct builtin BUILTINS[] = {
+    {"help", builtin_help, true},
+    {"cd", builtin_cd, false},
+    {"lf", builtin_lf, true},
+    {"tree", builtin_tree, true},
+    {"idcache", builtin_idcache, false},
+    {"hash", builtin_hash, false},
+    {"mon", mon_run, false},
+    {"jobs", builtin_jobs, false},
+    {"fg", builtin_fg, false},
+    {"bg", builtin_bg, false},
+    {"wait", builtin_wait, false},
+    {"kill", builtin_kill, false},
+    {"history", builtin_history, false},
+    {"par", builtin_par, false},
+    {"stats", builtin_stats, false},
+    {"usage", builtin_usage, true},
+    {"search", builtin_search, true},
+    {NULL, NULL, false},
+};
+
+// Processo a desenhar em `print_process_tree`
+struct tree_frame {
+    size_t index;
+    size_t depth;
+    bool last;   // Último irmão exibido (`└──`)
+};
+
+// LC_NUMERIC do usuário para o `lf -l` (LC_GLOBAL_LOCALE até ser criado, ou se falhar)
+static locale_t numeric_locale = LC_GLOBAL_LOCALE;
+
+/*****************************************************************************/
+
+/**
+ * @brief Exibe a linha de um processo de `tree` (indentação, nome, PID, dono e colunas).
+ * @param snap Snapshot de processos.
+ * @param view Colunas e totais.
+ * @param frame Processo e posição na árvore.
+ * @param rails Por nível, se o ancestral daquele nível ainda tem irmãos abaixo (`│`).
+ */
+static void print_tree_line(const struct process_snapshot *snap, const struct tree_view *view,
+                            const struct tree_frame *frame, const bool *rails);
+
+/**
+ * @brief Exibe clock ticks como segundos com duas casas ("12.34s"), sem printf.
+ */
+static void print_tree_seconds(unsigned long long ticks, unsigned long long ticks_per_second);
+
+/**
+ * @brief Total de um recurso na subárvore, na unidade do snapshot (páginas, clock ticks, quantidade).
+ */
+static unsigned long long tree_key_total(const struct process_totals *totals, enum tree_key key);
+
+/**
+ * @brief Ordena índices de irmãos pelo total decrescente de `view->sort` (empate: PID).
+ */
+static int compare_tree_children(const void *a, const void *b, void *view);
+
+/**
+ * @brief Converte o nome de um recurso de `tree -s` ("rss", "cpu", "threads", "fds").
+ * @return false se o nome não for conhecido.
+ */
+static bool parse_tree_key(const char *name, enum tree_key *key);
+
+/**
+ * @brief Converte o limite de `tree --min`: número com sufixo K/M/G/T opcional (potências de 1024).
+ * @return false se o texto não for um número válido.
+ */
+static bool parse_tree_limit(const char *str, double *value);
+
+/**
+ * @brief Exibe uma entrada do cache do PATH (usada por `hash` sem argumentos).
+ * @param name Nome do comando.
+ * @param path Caminho resolvido.
+ * @param hits Vezes que a entrada foi usada.
+ * @param ctx Não usado.
+ */
+static void print_hash_entry(const char *name, const char *path, size_t hits, void *ctx);
+
+/**
+ * @brief Exibe uma entrada de `lf` (nome colorido pelo tipo).
+ *
+ * Quando o `d_type` do diretório já diz se é diretório ou não, nenhum stat é feito.
+ * @param dir_fd Descritor do diretório da entrada.
+ * @param name Nome da entrada.
+ * @param type `d_type` da entrada (DT_UNKNOWN força o stat).
+ */
+static void print_lf_name_entry(int dir_fd, const char *name, unsigned char type);
+
+/**
+ * @brief Exibe o cabeçalho das colunas de `lf -l`.
+ */
+static void print_lf_detail_header(void);
+
+/**
+ * @brief Locale do processo com LC_NUMERIC do usuário (criado uma vez), para `uselocale` na thread do `lf -l`.
+ *
+ * setlocale muda o processo inteiro e não pode rodar com o `par` listando em outras threads;
+ * o LC_NUMERIC global fica em "C" (strtod do `-d 0.5` e do `--min 2.5`).
+ * @return O locale, ou LC_GLOBAL_LOCALE se não puder ser criado.
+ */
+static locale_t lf_numeric_locale(void);
+
+/**
+ * @brief Cria o locale de `lf_numeric_locale` (pthread_once).
+ */
+static void lf_numeric_locale_init(void);
+
+/**
+ * @brief Exibe os contadores do cache de listagens (`lf --cache`) ou o limpa (`lf --cache-clear`).
+ */
+static void print_lf_cache(bool clear);
+
+/**
+ * @brief Exibe um diretório de `lf -R` e, em seguida, seus subdiretórios (em profundidade).
+ * @param dir Nó da varredura.
+ * @param long_format Se true, uma linha de `lf -l` por entrada.
+ */
+static void print_lf_walk_dir(const struct walk_dir *dir, bool long_format);
+
+/**
+ * @brief Exibe os subdiretórios de `usage` até `max_depth` (filhos antes do pai, como o `du`) e os erros.
+ * @param dir Nó da varredura.
+ * @param max_depth Profundidade máxima exibida (0 = só o diretório dado).
+ */
+static void print_usage_dir(const struct walk_dir *dir, unsigned max_depth);
+
+/**
+ * @brief Exibe o caminho de um nó da varredura.
+ */
+static void print_walk_path(const struct walk_dir *dir);
+
+/**
+ * @brief Lê os metadados de uma entrada e exibe sua linha de `lf -l`.
+ * @param dir_fd Descritor do diretório da entrada.
+ * @param name Nome da entrada.
+ */
+static void print_lf_detail_entry(int dir_fd, const char *name);
+
+/**
+ * @brief Exibe uma linha de `lf -l` a partir de metadados já lidos.
+ * @param name Nome da entrada.
+ * @param st Metadados da entrada.
+ */
+static void print_lf_detail_row(const char *name, const struct file_meta *st);
+
+/*****************************************************************************/
+
+int builtin_help(const int argc, char **argv) {
+    (void) argc;
+    (void) argv;
+    term_out_str("\n" TERM_CYAN_BOLD "Comandos disponíveis:" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "exit    " TERM_RESET "- " TERM_GREEN "Sair do shell" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "help    " TERM_RESET "- " TERM_GREEN "Mostrar ajuda" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "cd      " TERM_RESET "- " TERM_GREEN "Mudar diretório" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "lf      " TERM_RESET "- " TERM_GREEN "Listar diretório" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "tree    " TERM_RESET "- " TERM_GREEN "Árvore de processos" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "mon     " TERM_RESET "- " TERM_GREEN "Monitor de processos" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "idcache " TERM_RESET "- " TERM_GREEN "Cache de nomes de usuário/grupo" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "hash    " TERM_RESET "- " TERM_GREEN "Cache de comandos do PATH" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "history " TERM_RESET "- " TERM_GREEN "Histórico de comandos (Ctrl-R busca)" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "jobs    " TERM_RESET "- " TERM_GREEN "Listar jobs (" TERM_RESET "-l" TERM_GREEN " com PIDs)" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "fg, bg  " TERM_RESET "- " TERM_GREEN "Continuar um job em primeiro/segundo plano (" TERM_RESET "%N" TERM_GREEN ")" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "wait    " TERM_RESET "- " TERM_GREEN "Esperar jobs terminarem" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "kill    " TERM_RESET "- " TERM_GREEN "Enviar sinal a um job ou PID" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "stats   " TERM_RESET "- " TERM_GREEN "Tempo, CPU e memória por comando (" TERM_RESET "time CMD" TERM_GREEN " mede um só)" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "par     " TERM_RESET "- " TERM_GREEN "Executar um comando para várias entradas em paralelo" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "usage   " TERM_RESET "- " TERM_GREEN "Espaço ocupado por diretório (" TERM_RESET "-d N" TERM_GREEN " mostra subdiretórios)" TERM_RESET "\n"
+                 TERM_CYAN_BOLD "search  " TERM_RESET "- " TERM_GREEN "Procurar texto nos arquivos de um diretório (como " TERM_RESET "grep -rnF" TERM_GREEN ")" TERM_RESET "\n"
+                 "\n" TERM_WHITE "Use '" TERM_YELLOW_ITALIC "&" TERM_RESET "' no final para executar em segundo plano\n"
+                 TERM_WHITE "Pipelines e redirecionamentos: " TERM_YELLOW_ITALIC "lf -l | grep txt > lista 2>&1"
+                 TERM_RESET "\n"
+                 TERM_WHITE "Estágios só de redirecionamento copiam (como no zsh): " TERM_YELLOW_ITALIC
+                 "< arq | wc -c" TERM_RESET ", " TERM_YELLOW_ITALIC "cmd | > a > b | wc -l" TERM_RESET "\n"
+                 TERM_WHITE "Listas, aspas e variáveis: " TERM_YELLOW_ITALIC "cd \"$HOME/meus docs\" && lf; echo $?"
+                 TERM_RESET "\n");
+    return 0;
+}
+
+int builtin_cd(const int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : getenv("HOME");
+    if (!path || chdir(path) != 0) {
+        term_out_printf("%sErro ao mudar para %s%s\n", TERM_RED_BOLD, path ? path : "~", TERM_RESET);
+        return 1;
+    }
+    if (!getcwd(CWD, sizeof(CWD))) {
+        term_out_str(TERM_RED_BOLD "Erro ao obter diretório" TERM_RESET "\n");
+        return 1;
+    }
+    return 0;
+}
+
+int builtin_lf(const int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        // Ajuda
+        term_out_str(TERM_CYAN_BOLD "Uso: lf [OPÇÕES] [DIRETÓRIO]" TERM_RESET "\n"
+                     "Listar conteúdo do diretório\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -a\t\tMostrar arquivos ocultos\n"
+                     "  -l\t\tFormato detalhado\n"
+                     "  -U\t\tNão ordenar: imprimir à medida que lê (diretórios enormes)\n"
+                     "  -R\t\tListar os subdiretórios recursivamente (em paralelo)\n"
+                     "  --no-cache\tLer o diretório de novo, sem usar nem guardar no cache\n"
+                     "      \t\t(o cache, invalidado por inotify, é ligado por padrão só em discos\n"
+                     "      \t\tlocais; NFS, SMB/CIFS, FUSE e /proc são sempre lidos de novo)\n"
+                     "  --cache\tMostrar o cache de listagens (--cache-clear limpa)\n"
+                     "  -j N\t\tAté N stat simultâneos no formato detalhado (NFS/FUSE);\n"
+                     "      \t\tcom -R, threads da varredura (padrão: CPUs online)\n"
+                     "  --help\t\tExibir esta ajuda\n");
+        return 0;
+    }
+
+    bool long_format = false;
+    bool show_all = false;
+    bool streaming = false;
+    bool recursive = false;
+    bool use_cache = true;
+    unsigned jobs = 0;
+    const char *path = NULL;
+
+    // Processar flags (podem vir combinadas, ex.: -laU) e obter path se especificado
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            if (!path) path = argv[i];
+            continue;
+        }
+        if (strcmp(argv[i], "--no-cache") == 0) {
+            use_cache = false;
+            continue;
+        }
+        if (strcmp(argv[i], "--cache") == 0 || strcmp(argv[i], "--cache-clear") == 0) {
+            print_lf_cache(argv[i][7] == '-');
+            return 0;
+        }
+        for (const char *flag = argv[i] + 1; *flag; flag++) {
+            if (*flag == 'l') long_format = true;
+            else if (*flag == 'a') show_all = true;
+            else if (*flag == 'U') streaming = true;
+            else if (*flag == 'R') recursive = true;
+            else if (*flag == 'j' && i + 1 < argc && is_number(argv[i + 1])) {
+                jobs = (unsigned) atoi(argv[++i]);
+                if (jobs == 0) jobs = 1;
+                break;
+            }
+        }
+    }
+    if (!path) path = CWD;
+
+    // Tamanhos com a vírgula do locale só nesta thread: o `par` pode estar listando em outras
+    const locale_t previous = long_format ? uselocale(lf_numeric_locale()) : (locale_t) 0;
+    int result;
+    if (recursive) result = print_lf_recursive(path, show_all, long_format, jobs);
+    else if (long_format) result = print_lf_details(path, show_all, streaming, jobs ? jobs : 1, use_cache);
+    else result = print_lf_names(path, show_all, streaming, use_cache);
+    if (long_format) uselocale(previous);
+    if (result != 0) {
+        term_out_printf("%sErro ao abrir %s%s\n", TERM_RED_BOLD, path, TERM_RESET);
+        return 1;
+    }
+    return 0;
+}
+
+int builtin_tree(const int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        // Ajuda
+        term_out_str(TERM_CYAN_BOLD "Uso: tree [OPÇÕES] PID" TERM_RESET "\n"
+                     "Exibir a árvore de processos a partir de PID\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -j N\t\tThreads para ler o /proc (padrão: CPUs online)\n"
+                     "  -u\t\tMostrar o dono de cada processo\n"
+                     "  --rss\t\tMemória residente (do processo / da subárvore)\n"
+                     "  --cpu\t\tTempo de CPU (do processo / da subárvore)\n"
+                     "  --threads\tThreads (do processo / da subárvore)\n"
+                     "  --fds\t\tDescritores abertos (do processo / da subárvore)\n"
+                     "  -s RECURSO\tOrdenar irmãos pelo total da subárvore (rss, cpu, threads, fds)\n"
+                     "  --min LIMITE\tOmitir subárvores com total de -s abaixo de LIMITE (ex.: 100M, 2.5, 50)\n"
+                     "  -t\t\tMostrar o tempo de cada etapa\n"
+                     "  --watch\tAcompanhar a árvore ao vivo (eventos do kernel; tecla q sai)\n"
+                     "  -d SEG\t\tCom --watch: intervalo do status / das releituras do /proc (padrão: 1)\n"
+                     "  -c N\t\tCom --watch: sair após N intervalos\n"
+                     "  --proc\t\tCom --watch: reler o /proc a cada intervalo em vez de usar o netlink\n"
+                     "  --help\t\tExibir esta ajuda\n");
+        return 0;
+    }
+
+    struct tree_watch_options watch = {.interval = 1.0, .max_cycles = -1};
+    bool watching = false;
+    unsigned threads = 0;
+    unsigned scan_flags = 0;
+    bool show_timing = false;
+    struct tree_view view = {0};
+    const char *pid_str = NULL;
+    bool bad_option = false;
+
+    // Processar flags
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0) show_timing = true;
+        else if (strcmp(argv[i], "-u") == 0) scan_flags |= PROC_SCAN_OWNER;
+        else if (strcmp(argv[i], "--rss") == 0) view.columns |= TREE_SHOW_RSS;
+        else if (strcmp(argv[i], "--cpu") == 0) view.columns |= TREE_SHOW_CPU;
+        else if (strcmp(argv[i], "--threads") == 0) view.columns |= TREE_SHOW_THREADS;
+        else if (strcmp(argv[i], "--fds") == 0) view.columns |= TREE_SHOW_FDS;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc && parse_tree_key(argv[i + 1], &view.sort)) i++;
+        else if (strcmp(argv[i], "--min") == 0 && i + 1 < argc && parse_tree_limit(argv[i + 1], &view.min)) i++;
+        else if (strcmp(argv[i], "--watch") == 0) watching = true;
+        else if (strcmp(argv[i], "--proc") == 0) watch.force_proc = true;
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) watch.interval = strtod(argv[++i], NULL);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc && is_number(argv[i + 1])) {
+            watch.max_cycles = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc && is_number(argv[i + 1])) {
+            threads = (unsigned) atoi(argv[++i]);
+        } else if (argv[i][0] == '-') bad_option = true;
+        else pid_str = argv[i];
+    }
+
+    if (bad_option) {
+        term_out_str(TERM_RED_BOLD "Opção inválida (veja tree --help)" TERM_RESET "\n");
+        return 1;
+    }
+    if (view.min > 0 && view.sort == TREE_KEY_PID) {
+        term_out_str(TERM_RED_BOLD "--min precisa de -s RECURSO" TERM_RESET "\n");
+        return 1;
+    }
+    if (!pid_str) {
+        term_out_str(TERM_RED_BOLD "PID faltando" TERM_RESET "\n");
+        return 1;
+    }
+    if (!is_number(pid_str)) {
+        term_out_str(TERM_RED_BOLD "PID inválido" TERM_RESET "\n");
+        return 1;
+    }
+    if (watching) {
+        if (view.columns || view.sort != TREE_KEY_PID || scan_flags) {
+            term_out_str(TERM_RED_BOLD "--watch não aceita colunas, -s, --min nem -u" TERM_RESET "\n");
+            return 1;
+        }
+        watch.root = atoi(pid_str);
+        if (watch.interval < 0.05) watch.interval = 0.05;
+        return tree_watch_run(&watch);
+    }
+
+    // Os descritores custam uma listagem de /proc/<pid>/fd por processo: só quando pedidos
+    if ((view.columns & TREE_SHOW_FDS) || view.sort == TREE_KEY_FDS) scan_flags |= PROC_SCAN_FDS;
+
+    pid_t pid = atoi(pid_str);
+    struct process_snapshot snap;
+    if (build_process_snapshot(&snap, threads, scan_flags) != 0) {
+        term_out_str(TERM_RED_BOLD "Erro ao ler /proc" TERM_RESET "\n");
+        return 1;
+    }
+    const long index = find_process(&snap, pid);
+    if (index < 0) {
+        term_out_printf("%sProcesso %d não encontrado%s\n", TERM_RED_BOLD, pid, TERM_RESET);
+        free_process_snapshot(&snap);
+        return 1;
+    }
+
+    // Totais das subárvores: uma passada em pós-ordem sobre o snapshot já lido
+    struct timespec totals_start, totals_end;
+    clock_gettime(CLOCK_MONOTONIC, &totals_start);
+    struct process_totals *totals = NULL;
+    if (view.columns || view.sort != TREE_KEY_PID) {
+        totals = malloc((snap.count ? snap.count : 1) * sizeof(struct process_totals));
+        if (!totals || process_subtree_totals(&snap, (size_t) index, totals) != 0) {
+            term_out_str(TERM_RED_BOLD "Memória insuficiente" TERM_RESET "\n");
+            free(totals);
+            free_process_snapshot(&snap);
+            return 1;
+        }
+        view.totals = totals;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &totals_end);
+
+    struct timespec render_start, render_end;
+    clock_gettime(CLOCK_MONOTONIC, &render_start);
+    term_out_printf("Árvore de processos (PID %d)%s:\n", pid, view.columns ? " — processo / subárvore" : "");
+    const long omitted = print_process_tree(&snap, (size_t) index, &view);
+    clock_gettime(CLOCK_MONOTONIC, &render_end);
+    if (omitted > 0) term_out_printf("%s%ld processos abaixo do limite omitidos%s\n", TERM_ITALIC, omitted, TERM_RESET);
+
+    if (show_timing) {
+        const double totals_ms = (double) (totals_end.tv_sec - totals_start.tv_sec) * 1e3 +
+                                 (double) (totals_end.tv_nsec - totals_start.tv_nsec) / 1e6;
+        const double render_ms = (double) (render_end.tv_sec - render_start.tv_sec) * 1e3 +
+                                 (double) (render_end.tv_nsec - render_start.tv_nsec) / 1e6;
+        term_out_printf("%s%zu processos | leitura %.2f ms (%u threads) | índice %.2f ms | totais %.2f ms | "
+                        "desenho %.2f ms%s\n", TERM_CYANBRIGHT, snap.count, snap.scan_ms, snap.threads,
+                        snap.index_ms, totals_ms, render_ms, TERM_RESET);
+    }
+    free(totals);
+    free_process_snapshot(&snap);
+    if (omitted < 0) {
+        term_out_str(TERM_RED_BOLD "Memória insuficiente" TERM_RESET "\n");
+        return 1;
+    }
+    return 0;
+}
+
+int builtin_idcache(const int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        name_cache_clear();
+        term_out_str("Cache de nomes limpo\n");
+    } else {
+        const struct name_cache_stats stats = name_cache_get_stats();
+        const size_t lookups = stats.hits + stats.misses;
+        term_out_str(TERM_CYAN_BOLD "Cache de nomes (uid/gid):" TERM_RESET "\n");
+        term_out_printf("  Entradas   %zu (%zu sem nome)\n", stats.entries, stats.negative);
+        term_out_printf("  Acertos    %zu\n", stats.hits);
+        term_out_printf("  Falhas     %zu\n", stats.misses);
+        term_out_printf("  Taxa       %.1f%%\n", lookups ? 100.0 * (double) stats.hits / (double) lookups : 0.0);
+        term_out_printf("  Validade   %d s\n", NAME_CACHE_TTL);
+    }
+    return 0;
+}
+
+int builtin_hash(const int argc, char **argv) {
+    if (argc == 1) {
+        const struct path_cache_stats stats = path_cache_get_stats();
+        if (stats.entries == 0) {
+            term_out_str("hash: cache vazio\n");
+            return 0;
+        }
+        term_out_str(TERM_CYAN_BOLD "usos\tcomando" TERM_RESET "\n");
+        path_cache_foreach(print_hash_entry, NULL);
+        term_out_printf("%s%zu acertos, %zu buscas no PATH%s\n", TERM_CYANBRIGHT, stats.hits, stats.misses, TERM_RESET);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        term_out_str(TERM_CYAN_BOLD "Uso: hash [-r] [-d NOME] [-p CAMINHO NOME] [-t NOME] [NOME...]" TERM_RESET "\n"
+                     "Mostrar ou alterar o cache de comandos do PATH\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -r\t\tEsvaziar o cache\n"
+                     "  -d NOME\tRemover NOME do cache\n"
+                     "  -p CAMINHO NOME\tUsar CAMINHO para NOME\n"
+                     "  -t NOME\tMostrar o caminho de NOME\n"
+                     "  NOME...\tProcurar NOME no PATH e guardar\n");
+        return 0;
+    }
+    if (strcmp(argv[1], "-r") == 0) {
+        path_cache_clear();
+        return 0;
+    }
+    if (strcmp(argv[1], "-p") == 0) {
+        if (argc < 4) {
+            term_out_str(TERM_RED_BOLD "hash -p: faltam CAMINHO e NOME" TERM_RESET "\n");
+            return 1;
+        }
+        return path_cache_set(argv[3], argv[2]) == 0 ? 0 : 1;
+    }
+
+    int status = 0;
+    const bool remove = strcmp(argv[1], "-d") == 0;
+    const bool show = strcmp(argv[1], "-t") == 0;
+    for (int i = remove || show ? 2 : 1; i < argc; i++) {
+        const char *path = NULL;
+        if (remove) {
+            if (path_cache_remove(argv[i])) continue;
+        } else if (show) {
+            path = path_cache_lookup(argv[i]);
+            if (path) {
+                term_out_str(path);
+                term_out_char('\n');
+                continue;
+            }
+        } else if (path_cache_add(argv[i]) == 0) {
+            continue;
+        }
+        term_out_printf("%shash: %s: não encontrado%s\n", TERM_RED_BOLD, argv[i], TERM_RESET);
+        status = 1;
+    }
+    return status;
+}
+
+int builtin_history(const int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        term_out_str(TERM_CYAN_BOLD "Uso: history [-s] [-f TEXTO] [N]" TERM_RESET "\n"
+                     "Mostrar as N últimas linhas do histórico (padrão: todas)\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -s		Estatísticas do histórico e do índice de busca\n"
+                     "  -f TEXTO	Linhas que contêm TEXTO (mais novas primeiro)\n"
+                     "  --help	Exibir esta ajuda\n");
+        return 0;
+    }
+
+    const size_t count = history_count();
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        const struct history_stats stats = history_get_stats();
+        term_out_printf("%zu entradas, %zu no índice (%zu pares trigrama/bloco, %.1f ms para construir)\n",
+                        stats.entries, stats.indexed, stats.postings, stats.index_ms);
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+        size_t index = count;
+        int status = 1;
+        while (history_search(argv[2], index, &index)) {
+            size_t len;
+            const char *text = history_get(index, &len);
+            term_out_printf("%6zu  ", index + 1);
+            term_out_write(text, len);
+            term_out_char('\n');
+            status = 0;
+        }
+        return status;
+    }
+
+    size_t first = 0;
+    if (argc > 1) {
+        if (!is_number(argv[1])) {
+            term_out_str(TERM_RED_BOLD "Opção inválida (veja history --help)" TERM_RESET "\n");
+            return 1;
+        }
+        const size_t last = strtoul(argv[1], NULL, 10);
+        first = last < count ? count - last : 0;
+    }
+    for (size_t i = first; i < count; i++) {
+        size_t len;
+        const char *text = history_get(i, &len);
+        term_out_printf("%6zu  ", i + 1);
+        term_out_write(text, len);
+        term_out_char('\n');
+    }
+    return 0;
+}
+
+int builtin_par(const int argc, char **argv) {
+    return par_run(argc, argv, BUILTINS);
+}
+
+int builtin_usage(const int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        // Ajuda
+        term_out_str(TERM_CYAN_BOLD "Uso: usage [OPÇÕES] [DIRETÓRIO...]" TERM_RESET "\n"
+                     "Espaço ocupado por cada diretório e seus subdiretórios (como `du`)\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -b\t\tTamanho aparente (bytes dos arquivos) em vez de blocos alocados\n"
+                     "  -d N\t\tExibir subdiretórios até a profundidade N (padrão: 0, só o total)\n"
+                     "  -j N\t\tThreads da varredura (padrão: CPUs online)\n"
+                     "  -t\t\tMostrar contagens e o tempo da varredura\n"
+                     "  --help\t\tExibir esta ajuda\n");
+        return 0;
+    }
+
+    unsigned flags = WALK_SIZES | WALK_ALL;
+    unsigned max_depth = 0;
+    unsigned threads = 0;
+    bool show_timing = false;
+    const char *paths[argc];
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            paths[path_count++] = argv[i];
+            continue;
+        }
+        if (strcmp(argv[i], "-b") == 0) flags |= WALK_APPARENT;
+        else if (strcmp(argv[i], "-t") == 0) show_timing = true;
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc && is_number(argv[i + 1])) {
+            max_depth = (unsigned) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc && is_number(argv[i + 1])) {
+            threads = (unsigned) atoi(argv[++i]);
+        } else {
+            term_out_str(TERM_RED_BOLD "Opção inválida (veja usage --help)" TERM_RESET "\n");
+            return 1;
+        }
+    }
+
+    if (path_count == 0) paths[path_count++] = CWD;
+
+    int status = 0;
+    for (int i = 0; i < path_count; i++) {
+        const char *path = paths[i];
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        struct walk walk;
+        if (walk_run(&walk, path, flags, threads) != 0) {
+            term_out_printf("%sErro ao abrir %s: %s%s\n", TERM_RED_BOLD, path, strerror(errno), TERM_RESET);
+            status = 1;
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        print_usage_dir(walk.root, max_depth);
+        if (show_timing) {
+            const double ms = (double) (end.tv_sec - start.tv_sec) * 1e3 +
+                              (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+            term_out_printf("%s%" PRIu64 " arquivos | %" PRIu64 " diretórios | %zu hardlinks repetidos | "
+                            "%.2f ms (%u threads, %zu roubos)%s\n",
+                            TERM_CYANBRIGHT, walk.root->files, walk.root->dirs, atomic_load(&walk.hardlinks), ms,
+                            walk.threads, walk.steals, TERM_RESET);
+        }
+        if (atomic_load(&walk.errors)) status = 1;
+        walk_free(&walk);
+    }
+    return status;
+}
+
+int builtin_search(const int argc, char **argv) {
+    if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        // Ajuda
+        term_out_str(TERM_CYAN_BOLD "Uso: search [OPÇÕES] TEXTO [ARQUIVO|DIRETÓRIO...]" TERM_RESET "\n"
+                     "Procura TEXTO (sem expressões regulares) nos arquivos, recursivamente (como `grep -rnF`)\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  -a\t\tIncluir arquivos e diretórios iniciados por '.'\n"
+                     "  -l\t\tSó o caminho dos arquivos com ocorrência\n"
+                     "  -j N\t\tThreads da busca (padrão: CPUs online)\n"
+                     "  -t\t\tMostrar contagens, o tempo e a implementação usada\n"
+                     "  --help\t\tExibir esta ajuda\n");
+        return argc < 2 ? 2 : 0;
+    }
+
+    struct search_options options = {.color = isatty(STDOUT_FILENO)};
+    bool show_timing = false;
+    const char *pattern = NULL;
+    const char *paths[argc];
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || pattern) {
+            // Depois do texto, tudo são caminhos
+            if (!pattern) pattern = argv[i];
+            else paths[path_count++] = argv[i];
+            continue;
+        }
+        if (strcmp(argv[i], "-a") == 0) options.all = true;
+        else if (strcmp(argv[i], "-l") == 0) options.names_only = true;
+        else if (strcmp(argv[i], "-t") == 0) show_timing = true;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc && is_number(argv[i + 1])) {
+            options.threads = (unsigned) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        } else {
+            term_out_str(TERM_RED_BOLD "Opção inválida (veja search --help)" TERM_RESET "\n");
+            return 2;
+        }
+    }
+
+    struct search_matcher matcher;
+    if (!pattern || search_matcher_init(&matcher, pattern, strlen(pattern), SEARCH_IMPL_AUTO) != 0) {
+        term_out_str(TERM_RED_BOLD "Texto vazio (veja search --help)" TERM_RESET "\n");
+        return 2;
+    }
+    if (path_count == 0) paths[path_count++] = ".";
+
+    // Como o grep: 0 se houve ocorrência, 1 se não, 2 se algo não pôde ser lido
+    bool found = false;
+    bool failed = false;
+    for (int i = 0; i < path_count; i++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        struct search_stats stats;
+        if (search_run(paths[i], &matcher, &options, &stats) != 0) {
+            term_out_printf("%sErro ao abrir %s: %s%s\n", TERM_RED_BOLD, paths[i], strerror(errno), TERM_RESET);
+            failed = true;
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (stats.matched_files) found = true;
+        if (stats.errors) failed = true;
+        if (show_timing) {
+            const double ms = (double) (end.tv_sec - start.tv_sec) * 1e3 +
+                              (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+            term_out_printf("%s%zu linhas em %zu de %zu arquivos | %zu binários | %zu ilegíveis | %s | "
+                            "%.2f ms (%s, %u threads, %zu roubos)%s\n",
+                            TERM_CYANBRIGHT, stats.lines, stats.matched_files, stats.files, stats.binary,
+                            stats.errors, human_readable_size((long) stats.bytes), ms,
+                            search_impl_name(matcher.impl), stats.threads, stats.steals, TERM_RESET);
+        }
+    }
+    return failed ? 2 : found ? 0 : 1;
+}
+
+static void print_hash_entry(const char *name, const char *path, const size_t hits, void *ctx) {
+    (void) name;
+    (void) ctx;
+    term_out_uint(hits);
+    term_out_char('\t');
+    term_out_str(path);
+    term_out_char('\n');
+}
+
+long print_process_tree(const struct process_snapshot *snap, const size_t index, const struct tree_view *view) {
+    // Cada processo entra uma vez na pilha, e a profundidade não passa do total de processos
+    const size_t capacity = snap->count ? snap->count : 1;
+    struct tree_frame *stack = malloc(capacity * sizeof(struct tree_frame));
+    bool *rails = malloc(capacity * sizeof(bool));
+    size_t *visible = malloc(capacity * sizeof(size_t));
+    if (!stack || !rails || !visible) {
+        free(stack);
+        free(rails);
+        free(visible);
+        return -1;
+    }
+
+    // O limite vai para a unidade do snapshot uma vez, em vez de converter cada total
+    double min = view->min;
+    if (view->sort == TREE_KEY_RSS) min /= (double) sysconf(_SC_PAGESIZE);
+    else if (view->sort == TREE_KEY_CPU) min *= (double) sysconf(_SC_CLK_TCK);
+
+    long omitted = 0;
+    size_t top = 0;
+    stack[top++] = (struct tree_frame){.index = index, .depth = 0, .last = true};
+    while (top > 0) {
+        const struct tree_frame frame = stack[--top];
+        if (frame.depth > 0) rails[frame.depth - 1] = !frame.last;
+        print_tree_line(snap, view, &frame, rails);
+
+        // Filhos já estão indexados e ordenados por PID no snapshot
+        const size_t first = snap->child_start[frame.index];
+        const size_t count = snap->child_start[frame.index + 1] - first;
+        size_t shown = 0;
+        for (size_t i = 0; i < count; i++) {
+            const size_t child = snap->children[first + i];
+            if (view->min > 0 && (double) tree_key_total(&view->totals[child], view->sort) < min) {
+                omitted += (long) view->totals[child].procs;
+                continue;
+            }
+            visible[shown++] = child;
+        }
+        if (view->sort != TREE_KEY_PID && shown > 1) {
+            qsort_r(visible, shown, sizeof(size_t), compare_tree_children, (void *) view);
+        }
+
+        // Empilhados do último ao primeiro, para o primeiro ser desenhado antes
+        for (size_t i = shown; i-- > 0;) {
+            stack[top++] = (struct tree_frame){.index = visible[i], .depth = frame.depth + 1, .last = i == shown - 1};
+        }
+    }
+
+    free(stack);
+    free(rails);
+    free(visible);
+    return omitted;
+}
+
+int print_lf_names(const char *path, const bool show_all, const bool streaming, const bool use_cache) {
+    if (streaming) {
+        // Sem ordenação: um único buffer de getdents64 reaproveitado, nada acumulado
+        struct dir_reader reader;
+        if (dir_reader_open(&reader, path) != 0) return -1;
+
+        const struct dirent64 *entry;
+        while ((entry = dir_reader_next(&reader))) {
+            if (!show_all && entry->d_name[0] == '.') continue;
+            print_lf_name_entry(reader.fd, entry->d_name, entry->d_type);
+        }
+        dir_reader_close(&reader);
+        return 0;
+    }
+
+    if (use_cache) {
+        // A listagem guardada tem também os ocultos
+        struct dir_cache_entry *entry = dir_cache_acquire(path, false, 1);
+        if (!entry) return -1;
+        const struct dir_listing *listing = &entry->listing;
+        for (size_t i = 0; i < listing->count; i++) {
+            const char *name = dir_listing_name(listing, i);
+            if (!show_all && name[0] == '.') continue;
+            print_lf_name_entry(listing->fd, name, listing->entries[i].type);
+        }
+        dir_cache_release(entry);
+        return 0;
+    }
+
+    struct dir_listing listing;
+    if (dir_listing_read(&listing, path, show_all) != 0) return -1;
+    for (size_t i = 0; i < listing.count; i++) {
+        print_lf_name_entry(listing.fd, dir_listing_name(&listing, i), listing.entries[i].type);
+    }
+    dir_listing_free(&listing);
+    return 0;
+}
+
+int print_lf_details(const char *path, const bool show_all, const bool streaming, const unsigned jobs,
+                     const bool use_cache) {
+    if (use_cache && !streaming) {
+        struct dir_cache_entry *entry = dir_cache_acquire(path, true, jobs);
+        if (!entry) return -1;
+        const struct dir_listing *listing = &entry->listing;
+        print_lf_detail_header();
+        for (size_t i = 0; i < listing->count; i++) {
+            const char *name = dir_listing_name(listing, i);
+            if (!show_all && name[0] == '.') continue;
+            if (listing->meta[i].mode) print_lf_detail_row(name, &listing->meta[i]);
+        }
+        dir_cache_release(entry);
+        return 0;
+    }
+
+    struct dir_reader reader;
+    struct dir_listing listing;
+    if (streaming ? dir_reader_open(&reader, path) : dir_listing_read(&listing, path, show_all)) return -1;
+
+    print_lf_detail_header();
+
+    if (streaming) {
+        const struct dirent64 *entry;
+        while ((entry = dir_reader_next(&reader))) {
+            if (!show_all && entry->d_name[0] == '.') continue;
+            print_lf_detail_entry(reader.fd, entry->d_name);
+        }
+        dir_reader_close(&reader);
+    } else {
+        // Metadados buscados em paralelo e impressos na ordem da listagem
+        if (dir_listing_stat(&listing, DIR_DETAIL_STATX_MASK, AT_SYMLINK_NOFOLLOW, jobs) != 0) {
+            dir_listing_free(&listing);
+            return -1;
+        }
+        for (size_t i = 0; i < listing.count; i++) {
+            if (listing.meta[i].mode) print_lf_detail_row(dir_listing_name(&listing, i), &listing.meta[i]);
+        }
+        dir_listing_free(&listing);
+    }
+    return 0;
+}
+
+int print_lf_recursive(const char *path, const bool show_all, const bool long_format, const unsigned threads) {
+    struct walk walk;
+    const unsigned flags = (show_all ? WALK_ALL : 0) | (long_format ? WALK_DETAILS : WALK_ENTRIES);
+    if (walk_run(&walk, path, flags, threads) != 0) return -1;
+
+    print_lf_walk_dir(walk.root, long_format);
+    walk_free(&walk);
+    return 0;
+}
+
+static void print_lf_cache(const bool clear) {
+    if (clear) {
+        dir_cache_clear();
+        term_out_str("Cache de listagens limpo\n");
+        return;
+    }
+    const struct dir_cache_stats stats = dir_cache_get_stats();
+    const size_t lookups = stats.hits + stats.misses;
+    term_out_str(TERM_CYAN_BOLD "Cache de listagens (lf):" TERM_RESET "\n");
+    term_out_printf("  Diretórios   %zu de %d\n", stats.entries, DIR_CACHE_MAX_ENTRIES);
+    term_out_printf("  Memória      %s de ", human_readable_size((long) stats.bytes));
+    term_out_printf("%s\n", human_readable_size((long) DIR_CACHE_MAX_BYTES));
+    term_out_printf("  Acertos      %zu\n", stats.hits);
+    term_out_printf("  Falhas       %zu\n", stats.misses);
+    term_out_printf("  Taxa         %.1f%%\n", lookups ? 100.0 * (double) stats.hits / (double) lookups : 0.0);
+    term_out_printf("  Invalidadas  %zu (inotify)\n", stats.invalidations);
+    term_out_printf("  Descartadas  %zu (limite)\n", stats.evictions);
+    term_out_printf("  Sem cache    %zu (rede, FUSE, /proc)\n", stats.unwatchable);
+}
+
+static void print_lf_walk_dir(const struct walk_dir *dir, const bool long_format) {
+    if (dir->parent) term_out_char('\n');
+    term_out_str(TERM_CYAN_BOLD);
+    print_walk_path(dir);
+    term_out_str(":" TERM_RESET "\n");
+
+    if (dir->error) {
+        term_out_printf("%sErro ao abrir: %s%s\n", TERM_RED_BOLD, strerror(dir->error), TERM_RESET);
+    } else if (long_format) {
+        const struct dir_listing *listing = &dir->listing;
+        print_lf_detail_header();
+        for (size_t i = 0; i < listing->count; i++) {
+            if (listing->meta[i].mode) print_lf_detail_row(dir_listing_name(listing, i), &listing->meta[i]);
+        }
+    } else {
+        // O tipo já vem da varredura, sem seguir links (o descritor do diretório foi fechado)
+        const struct dir_listing *listing = &dir->listing;
+        for (size_t i = 0; i < listing->count; i++) {
+            const unsigned char type = listing->entries[i].type;
+            term_out_str(type == DT_DIR ? TERM_BLUE : type == DT_LNK ? TERM_CYAN : TERM_GREEN);
+            term_out_str(dir_listing_name(listing, i));
+            term_out_str(TERM_RESET "\n");
+        }
+    }
+
+    for (const struct walk_dir *child = dir->children; child; child = child->next) {
+        print_lf_walk_dir(child, long_format);
+    }
+}
+
+static void print_usage_dir(const struct walk_dir *dir, const unsigned max_depth) {
+    for (const struct walk_dir *child = dir->children; child; child = child->next) {
+        print_usage_dir(child, max_depth);
+    }
+
+    if (dir->error) {
+        term_out_str(TERM_RED_BOLD "Erro ao ler ");
+        print_walk_path(dir);
+        term_out_printf(": %s%s\n", strerror(dir->error), TERM_RESET);
+    }
+    if (dir->depth > max_depth) return;
+
+    term_out_str(TERM_GREEN);
+    term_out_field(human_readable_size((long) dir->bytes), 8, 8);
+    term_out_str(TERM_RESET "  " TERM_BLUE);
+    print_walk_path(dir);
+    term_out_str(TERM_RESET "\n");
+}
+
+static void print_walk_path(const struct walk_dir *dir) {
+    char local[4096];
+    const long len = walk_path(dir, local, sizeof(local));
+    if ((size_t) len < sizeof(local)) {
+        term_out_write(local, (size_t) len);
+        return;
+    }
+    char *path = malloc((size_t) len + 1);
+    if (!path) return;
+    walk_path(dir, path, (size_t) len + 1);
+    term_out_write(path, (size_t) len);
+    free(path);
+}
+
+static void print_lf_detail_header(void) {
+    term_out_printf("%s%-13.11s%-12s%-12s%9.8s %-13s%s%s\n",
+                    TERM_YELLOW, "Permissões", "Dono", "Grupo", "Tamanho",
+                    "Modificado", "Nome", TERM_RESET
+    );
+}
+
+static locale_t lf_numeric_locale(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, lf_numeric_locale_init);
+    return numeric_locale;
+}
+
+static void lf_numeric_locale_init(void) {
+    // Cópia do locale global (LC_COLLATE do usuário, para a ordenação) com o LC_NUMERIC do ambiente
+    const locale_t base = duplocale(LC_GLOBAL_LOCALE);
+    const locale_t numeric = base ? newlocale(LC_NUMERIC_MASK, "", base) : (locale_t) 0;
+    if (numeric) {
+        numeric_locale = numeric;
+    } else if (base) {
+        freelocale(base);
+    }
+}
+
+static void print_lf_name_entry(const int dir_fd, const char *name, const unsigned char type) {
+    // Links simbólicos são seguidos (um link para diretório sai em azul, um link quebrado é omitido)
+    bool is_dir = type == DT_DIR;
+    if (type == DT_UNKNOWN || type == DT_LNK) {
+        struct file_meta meta;
+        if (dir_stat_at(dir_fd, name, STATX_TYPE, 0, &meta) != 0) return;
+        is_dir = S_ISDIR(meta.mode);
+    }
+
+    term_out_str(is_dir ? TERM_BLUE : TERM_GREEN);
+    term_out_str(name);
+    term_out_str(TERM_RESET "\n");
+}
+
+static void print_lf_detail_entry(const int dir_fd, const char *name) {
+    struct file_meta st;
+    if (dir_stat_at(dir_fd, name, DIR_DETAIL_STATX_MASK, AT_SYMLINK_NOFOLLOW, &st) == 0) {
+        print_lf_detail_row(name, &st);
+    }
+}
+
+static void print_lf_detail_row(const char *name, const struct file_meta *st) {
+    // Permissões
+    char perms[11];
+    mode_to_str(st->mode, perms);
+
+    // Dono/Grupo (cache da sessão, sem uma consulta ao NSS por arquivo)
+    const char *owner = name_cache_user(st->uid);
+    const char *group = name_cache_group(st->gid);
+
+    // Tamanho formatado
+    char size_str[32];
+    strcpy(size_str, human_readable_size(st->size));
+
+    // Data (o formato só muda de minuto em minuto; arquivos vizinhos costumam repetir o valor)
+    static _Thread_local time_t date_minute = -1;
+    static _Thread_local char date[20];
+    if (st->mtime / 60 != date_minute) {
+        struct tm tm;
+        date_minute = st->mtime / 60;
+        strftime(date, sizeof(date), "%d %b %H:%M", localtime_r(&st->mtime, &tm));
+    }
+
+    // Cores
+    const char *file_color = TERM_WHITE;
+    if (S_ISDIR(st->mode)) file_color = TERM_BLUE_BOLD;
+    else if (st->mode & S_IXUSR) file_color = TERM_GREEN_BOLD;
+    else if (S_ISLNK(st->mode)) file_color = TERM_MAGENTA_BOLD;
+
+    const char *owner_color = TERM_WHITE;
+    if (owner && strcmp(owner, "root") == 0) owner_color = TERM_RED_BOLD;
+    else if (owner) owner_color = TERM_BLUE_BOLD;
+
+    const char *group_color = TERM_WHITE;
+    if (group && strcmp(group, "root") == 0) group_color = TERM_RED_BOLD;
+    else if (group) group_color = TERM_MAGENTA_BOLD;
+
+
+    // Mesmo layout de "%-12.11s%-12s%-12s%9.8s %-13s%s%s", montado sem printf
+    term_out_str(TERM_WHITE_BOLD);
+    term_out_field(perms, 11, -12);
+    term_out_str(owner_color);
+    term_out_field(owner ? owner : "?", SIZE_MAX, -12);
+    term_out_str(group_color);
+    term_out_field(group ? group : "?", SIZE_MAX, -12);
+    term_out_str(TERM_RESET);
+    term_out_field(size_str, 8, 9);
+    term_out_str(" " TERM_CYANBRIGHT);
+    term_out_field(date, SIZE_MAX, -13);
+    term_out_str(file_color);
+    term_out_str(name);
+    if (S_ISLNK(st->mode)) term_out_char('@');
+    term_out_str(TERM_RESET "\n");
+}
+
+static void print_tree_line(const struct process_snapshot *snap, const struct tree_view *view,
+                            const struct tree_frame *frame, const bool *rails) {
+    const struct process_info *info = &snap->procs[frame->index];
+
+    // Cores por nível
+    const char *colors[] = {TERM_CYAN, TERM_GREEN, TERM_MAGENTA, TERM_BLUE, TERM_YELLOW};
+    const char *color = colors[frame->depth % 5];
+
+    // Imprimir indentação
+    for (size_t i = 0; i < frame->depth; i++) {
+        if (i == frame->depth - 1) {
+            term_out_str(frame->last ? "└── " : "├── ");
+        } else {
+            term_out_str(rails[i] ? "│   " : "    ");
+        }
+    }
+
+    // Imprimir processo atual
+    term_out_str(color);
+    term_out_str(info->name);
+    term_out_str(" (PID: ");
+    term_out_int(info->pid);
+    term_out_str(")" TERM_RESET);
+    if (snap->flags & PROC_SCAN_OWNER) {
+        const char *owner = name_cache_user(info->uid);
+        term_out_str(" " TERM_ITALIC);
+        if (owner) term_out_str(owner);
+        else term_out_int((int) info->uid);
+        term_out_str(TERM_RESET);
+    }
+
+    // Colunas: o valor do processo e, se ele tem descendentes, o total da subárvore
+    if (view->columns) {
+        const struct process_totals *total = &view->totals[frame->index];
+        const bool subtree = total->procs > 1;
+        term_out_str(TERM_CYANBRIGHT);
+        if (view->columns & TREE_SHOW_RSS) {
+            const long page = sysconf(_SC_PAGESIZE);
+            term_out_str("  rss ");
+            term_out_str(human_readable_size(info->rss * page));
+            if (subtree) {
+                term_out_char('/');
+                term_out_str(human_readable_size((long) total->rss * page));
+            }
+        }
+        if (view->columns & TREE_SHOW_CPU) {
+            const unsigned long long ticks = (unsigned long long) sysconf(_SC_CLK_TCK);
+            term_out_str("  cpu ");
+            print_tree_seconds(info->utime + info->stime, ticks);
+            if (subtree) {
+                term_out_char('/');
+                print_tree_seconds(total->cpu, ticks);
+            }
+        }
+        if (view->columns & TREE_SHOW_THREADS) {
+            term_out_str("  thr ");
+            term_out_int((int) info->num_threads);
+            if (subtree) {
+                term_out_char('/');
+                term_out_uint(total->threads);
+            }
+        }
+        if (view->columns & TREE_SHOW_FDS) {
+            // -1: /proc/<pid>/fd de outro usuário (fica fora do total)
+            term_out_str("  fd ");
+            if (info->fds >= 0) term_out_int((int) info->fds);
+            else term_out_char('?');
+            if (subtree) {
+                term_out_char('/');
+                term_out_uint(total->fds);
+            }
+        }
+        term_out_str(TERM_RESET);
+    }
+    term_out_char('\n');
+}
+
+static void print_tree_seconds(const unsigned long long ticks, const unsigned long long ticks_per_second) {
+    const unsigned long long centis = ticks * 100 / (ticks_per_second ? ticks_per_second : 100);
+    term_out_uint(centis / 100);
+    term_out_char('.');
+    term_out_char((char) ('0' + centis / 10 % 10));
+    term_out_char((char) ('0' + centis % 10));
+    term_out_char('s');
+}
+
+static unsigned long long tree_key_total(const struct process_totals *totals, const enum tree_key key) {
+    switch (key) {
+        case TREE_KEY_RSS: return totals->rss;
+        case TREE_KEY_CPU: return totals->cpu;
+        case TREE_KEY_THREADS: return totals->threads;
+        case TREE_KEY_FDS: return totals->fds;
+        default: return 0;
+    }
+}
+
+static int compare_tree_children(const void *a, const void *b, void *view) {
+    const struct tree_view *v = view;
+    const size_t left = *(const size_t *) a;
+    const size_t right = *(const size_t *) b;
+    const unsigned long long left_total = tree_key_total(&v->totals[left], v->sort);
+    const unsigned long long right_total = tree_key_total(&v->totals[right], v->sort);
+    if (left_total != right_total) return left_total > right_total ? -1 : 1;
+    return left < right ? -1 : left > right;
+}
+
+static bool parse_tree_key(const char *name, enum tree_key *key) {
+    if (strcmp(name, "rss") == 0) *key = TREE_KEY_RSS;
+    else if (strcmp(name, "cpu") == 0) *key = TREE_KEY_CPU;
+    else if (strcmp(name, "threads") == 0) *key = TREE_KEY_THREADS;
+    else if (strcmp(name, "fds") == 0) *key = TREE_KEY_FDS;
+    else return false;
+    return true;
+}
+
+static bool parse_tree_limit(const char *str, double *value) {
+    char *end;
+    double result = strtod(str, &end);
+    if (end == str || result < 0) return false;
+    const char *units = "KMGT";
+    const char *unit = *end ? strchr(units, toupper((unsigned char) *end)) : NULL;
+    if (unit) {
+        for (const char *u = units; u <= unit; u++) result *= 1024;
+        end++;
+    }
+    if (*end != '\0') return false;
+    *value = result;
+    return true;
+}
+
+bool is_number(const char *str) {
+    for (size_t i = 0; str[i] != '\0'; ++i) {
+        if (!isdigit(str[i])) return false;
+    }
+    return true;
+}
+
+void strmode(mode_t mode, char *str) {
+    str[0] = S_ISDIR(mode) ? 'd' : S_ISLNK(mode) ? 'l' : '-';
+    for (int i = 0; i < 9; i++) {
+        const char *chars = "rwxrwxrwx";
+        str[i + 1] = (mode & (1 << (8 - i))) ? chars[i] : '-';
+    }
+    str[10] = '\0';
+}
+
+int compare_pids(const void *a, const void *b) {
+    return (*(pid_t *) a - *(pid_t *) b);
+}
+
+void mode_to_str(mode_t mode, char *str) {
+    str[0] = (mode & S_IFDIR) ? 'd' : (mode & S_IFLNK) ? 'l' : '-';
+    str[1] = (mode & S_IRUSR) ? 'r' : '-';
+    str[2] = (mode & S_IWUSR) ? 'w' : '-';
+    str[3] = (mode & S_IXUSR) ? 'x' : '-';
+    str[4] = (mode & S_IRGRP) ? 'r' : '-';
+    str[5] = (mode & S_IWGRP) ? 'w' : '-';
+    str[6] = (mode & S_IXGRP) ? 'x' : '-';
+    str[7] = (mode & S_IROTH) ? 'r' : '-';
+    str[8] = (mode & S_IWOTH) ? 'w' : '-';
+    str[9] = (mode & S_IXOTH) ? 'x' : '-';
+    str[10] = '\0';
+}
+
+char *human_readable_size(long bytes) {
+    static _Thread_local char buf[32];
+    char units[] = "BKMGTP";
+    int i = 0;
+    double size = bytes;
+
+    while (size >= 1024 && units[i + 1]) {
+        size /= 1024;
+        i++;
+    }
+
+    snprintf(buf, sizeof(buf), "%.1f%c", size, units[i]);
+    return buf;
+}
@@ -0,0 +1,150 @@
+//
+// Comandos internos do shell e as rotinas de listagem e de árvore de processos que eles usam.
+//
+
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "exec.h"
+#include "proc_tools.h"
+
+// Diretório atual (atualizado por `cd` e exibido no prompt)
+extern char CWD[2048];
+
+// Tabela de comandos internos, terminada por `{NULL, NULL}`
+extern const struct builtin BUILTINS[];
+
+// Colunas de `tree --rss --cpu --threads --fds` (valor do processo / total da subárvore)
+#define TREE_SHOW_RSS 0x1
+#define TREE_SHOW_CPU 0x2
+#define TREE_SHOW_THREADS 0x4
+#define TREE_SHOW_FDS 0x8
+
+/**
+ * @brief Recurso pelo qual `tree -s` ordena os irmãos e `tree --min` corta subárvores.
+ */
+enum tree_key {
+    TREE_KEY_PID,       // Ordem do snapshot (PID crescente)
+    TREE_KEY_RSS,
+    TREE_KEY_CPU,
+    TREE_KEY_THREADS,
+    TREE_KEY_FDS,
+};
+
+/**
+ * @brief Como `print_process_tree` desenha a árvore.
+ */
+struct tree_view {
+    unsigned columns;                     // TREE_SHOW_*
+    enum tree_key sort;                   // Irmãos em ordem decrescente do total da subárvore
+    double min;                           // Omitir subárvores com total de `sort` abaixo disso (bytes, segundos ou quantidade; 0 = nenhuma)
+    const struct process_totals *totals;  // De `process_subtree_totals` (obrigatório com colunas, `sort` ou `min`)
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Comandos internos (`help`, `cd`, `lf`, `tree`, `idcache`, `hash`, `history`, `par`, `usage`).
+ *
+ * Recebem argc/argv como um programa e retornam o código de saída, para
+ * poderem rodar como estágio de um pipeline (ver `pipeline_run`).
+ * @param argc Quantidade de argumentos.
+ * @param argv Argumentos (argv[0] é o nome do comando).
+ * @return 0 em caso de sucesso, diferente de 0 em caso de erro.
+ */
+int builtin_help(int argc, char **argv);
+int builtin_cd(int argc, char **argv);
+int builtin_lf(int argc, char **argv);
+int builtin_tree(int argc, char **argv);
+int builtin_idcache(int argc, char **argv);
+int builtin_hash(int argc, char **argv);
+int builtin_history(int argc, char **argv);
+int builtin_par(int argc, char **argv);
+int builtin_usage(int argc, char **argv);
+int builtin_search(int argc, char **argv);
+
+/**
+ * @brief Exibe a árvore de processos a partir do snapshot, estilo `pstree`.
+ *
+ * Percorre a árvore com uma pilha explícita e guarda as linhas verticais de
+ * cada nível em um vetor do tamanho do snapshot, então árvores profundas ou
+ * largas não têm limite nem recursão.
+ * @param snap Snapshot de processos.
+ * @param index Índice do processo inicial em `snap->procs`.
+ * @param view Colunas, ordenação e corte.
+ * @return Quantidade de processos omitidos por `view->min`, ou -1 em caso de erro de alocação.
+ */
+long print_process_tree(const struct process_snapshot *snap, size_t index, const struct tree_view *view);
+
+/**
+ * @brief Verifica se uma string representa um número válido.
+ * @param str A string a ser analisada.
+ * @return true se for um número, false caso contrário.
+ */
+bool is_number(const char *str);
+
+/**
+ * @brief Exibe os nomes do diretório, coloridos por tipo.
+ * @param path Caminho do diretório.
+ * @param show_all Se true, também exibe arquivos ocultos.
+ * @param streaming Se true, imprime na ordem do diretório à medida que lê (`lf -U`).
+ * @param use_cache Se true, usa (e guarda) a listagem no cache da sessão (ver `dir_cache_acquire`).
+ * @return 0 em caso de sucesso, -1 se o diretório não puder ser lido.
+ */
+int print_lf_names(const char *path, bool show_all, bool streaming, bool use_cache);
+
+/**
+ * @brief Exibe os detalhes de arquivos no estilo do comando `ls -l`.
+ * @param path Caminho do diretório ou arquivo.
+ * @param show_all Se true, também exibe arquivos ocultos.
+ * @param streaming Se true, imprime na ordem do diretório à medida que lê (`lf -U`).
+ * @param jobs Quantidade de stat simultâneos (útil em NFS/FUSE; ignorado com `streaming`).
+ * @param use_cache Se true, usa (e guarda) a listagem e os metadados no cache da sessão.
+ * @return 0 em caso de sucesso, -1 se o diretório não puder ser lido.
+ */
+int print_lf_details(const char *path, bool show_all, bool streaming, unsigned jobs, bool use_cache);
+
+/**
+ * @brief Exibe o diretório e todos os subdiretórios (`lf -R`), lidos em paralelo por `walk_run`.
+ * @param path Caminho do diretório.
+ * @param show_all Se true, também exibe (e percorre) arquivos ocultos.
+ * @param long_format Se true, uma linha de `lf -l` por entrada.
+ * @param threads Threads da varredura (0 usa as CPUs online).
+ * @return 0 em caso de sucesso, -1 se o diretório não puder ser lido.
+ */
+int print_lf_recursive(const char *path, bool show_all, bool long_format, unsigned threads);
+
+/**
+ * @brief Converte um modo de arquivo (bits de permissão) em string legível.
+ * @param mode Bits do modo do arquivo (mode_t).
+ * @param str String de saída onde será escrita a representação do modo.
+ */
+void strmode(mode_t mode, char *str);
+
+/**
+ * @brief Função de comparação para ordenação de PIDs.
+ * @param a Ponteiro para o primeiro PID.
+ * @param b Ponteiro para o segundo PID.
+ * @return Valor < 0 se a < b, 0 se iguais, > 0 se a > b.
+ */
+int compare_pids(const void *a, const void *b);
+
+/**
+ * @brief Converte o modo de arquivo para string no formato `-rwxr-xr--`.
+ * @param mode Modo do arquivo.
+ * @param str Buffer onde a string será armazenada.
+ */
+void mode_to_str(mode_t mode, char *str);
+
+/**
+ * @brief Converte um valor em bytes para uma string com tamanho legível.
+ * @param bytes Valor em bytes.
+ * @return String com o valor em formato como "1.2K", "3.4M", etc. (buffer por thread).
+ */
+char *human_readable_size(long bytes);
+
+#endif //BUILTINS_H
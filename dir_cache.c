@@ -0,0 +1,295 @@
+#include "dir_cache.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+
+// Eventos que mudam o que o `lf` mostra (entradas, tamanhos, datas, donos, permissões)
+#define DIR_CACHE_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | \
+                              IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+// Buffer de leitura dos eventos (vários por chamada)
+#define DIR_CACHE_EVENT_BUF 16384
+
+/*****************************************************************************/
+
+// Sistemas de arquivos (statfs f_type) cujas mudanças o inotify não vê: as feitas por outras
+// máquinas (rede), por outro processo atrás do FUSE ou pelo próprio kernel (/proc, /sys)
+static const unsigned long unwatchable_types[] = {
+    0x6969,       // NFS
+    0x517b,       // SMB
+    0xff534d42,   // CIFS
+    0xfe534d42,   // SMB2
+    0x65735546,   // FUSE (sshfs, rclone, ...)
+    0x00c36400,   // Ceph
+    0x01021997,   // 9p (v9fs)
+    0x5346414f,   // AFS
+    0x6b414653,   // kAFS
+    0x73757245,   // Coda
+    0x01161970,   // GFS2
+    0x7461636f,   // OCFS2
+    0x47504653,   // GPFS
+    0x0bd00bd0,   // Lustre
+    0x9fa0,       // procfs
+    0x62656572,   // sysfs
+    0x27e0eb,     // cgroup
+    0x63677270,   // cgroup2
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static int inotify_fd = -2;  // -2 = ainda não criado, -1 = indisponível
+static struct dir_cache_entry *lru_head = NULL;
+static struct dir_cache_entry *lru_tail = NULL;
+static struct dir_cache_stats stats = {0};
+
+/*****************************************************************************/
+
+/**
+ * @brief Lê os eventos pendentes do inotify e descarta as listagens afetadas (com a trava).
+ * @param keep_wd Watch que não deve ser removido (o da leitura em andamento; -1 = nenhum).
+ * @return true se algum evento veio de `keep_wd`.
+ */
+static bool drain_events(int keep_wd);
+
+/**
+ * @brief Indica se o inotify vê todas as mudanças do sistema de arquivos de `path` (não é de rede, FUSE nem /proc).
+ */
+static bool watchable(const char *path);
+
+/**
+ * @brief Procura a listagem de (dev, ino) na tabela (com a trava).
+ */
+static struct dir_cache_entry *find_entry(dev_t dev, ino_t ino);
+
+/**
+ * @brief Tira uma entrada da tabela; é liberada já ou ao fim da última referência (com a trava).
+ * @param remove_watch Se true, remove também o watch (false quando outra entrada herda o watch).
+ */
+static void detach(struct dir_cache_entry *entry, bool remove_watch);
+
+/**
+ * @brief Põe uma entrada no início da ordem de uso (com a trava).
+ */
+static void lru_push_front(struct dir_cache_entry *entry);
+
+/**
+ * @brief Tira uma entrada da ordem de uso (com a trava).
+ */
+static void lru_unlink(struct dir_cache_entry *entry);
+
+/**
+ * @brief Descarta as listagens menos usadas até caber no limite (com a trava).
+ */
+static void evict(void);
+
+/**
+ * @brief Memória ocupada por uma listagem.
+ */
+static size_t listing_bytes(const struct dir_listing *listing);
+
+/**
+ * @brief Libera uma entrada (fora da tabela e sem referências).
+ */
+static void free_entry(struct dir_cache_entry *entry);
+
+/*****************************************************************************/
+
+struct dir_cache_entry *dir_cache_acquire(const char *path, const bool details, const unsigned jobs) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) return NULL;
+
+    pthread_mutex_lock(&cache_lock);
+    if (inotify_fd == -2) inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    drain_events(-1);
+
+    struct dir_cache_entry *entry = find_entry(st.st_dev, st.st_ino);
+    if (entry && (entry->details || !details)) {
+        entry->refs++;
+        lru_unlink(entry);
+        lru_push_front(entry);
+        stats.hits++;
+        pthread_mutex_unlock(&cache_lock);
+        return entry;
+    }
+    stats.misses++;
+    const int notify = inotify_fd;
+    pthread_mutex_unlock(&cache_lock);
+
+    // NFS, SMB, FUSE: o watch seria aceito, mas não avisaria das mudanças feitas fora desta máquina
+    const bool remote = notify >= 0 && !watchable(path);
+    if (remote) {
+        pthread_mutex_lock(&cache_lock);
+        stats.unwatchable++;
+        pthread_mutex_unlock(&cache_lock);
+    }
+
+    // Watch antes da leitura: o que mudar enquanto lemos gera um evento e invalida a listagem
+    const int wd = notify >= 0 && !remote ? inotify_add_watch(notify, path, DIR_CACHE_WATCH_MASK) : -1;
+
+    entry = calloc(1, sizeof(struct dir_cache_entry));
+    if (!entry) return NULL;
+    entry->dev = st.st_dev;
+    entry->ino = st.st_ino;
+    entry->wd = -1;
+    entry->details = details;
+    entry->refs = 1;
+    if (dir_listing_read(&entry->listing, path, true) != 0 ||
+        (details && dir_listing_stat(&entry->listing, DIR_DETAIL_STATX_MASK, AT_SYMLINK_NOFOLLOW, jobs) != 0)) {
+        dir_listing_free(&entry->listing);
+        free(entry);
+        return NULL;
+    }
+    entry->bytes = sizeof(struct dir_cache_entry) + listing_bytes(&entry->listing);
+    if (wd < 0) return entry;
+
+    pthread_mutex_lock(&cache_lock);
+    // Uma mudança durante a leitura já está na fila de eventos: essa leitura é usada, mas não guardada
+    const bool changed = drain_events(wd);
+    struct dir_cache_entry *old = find_entry(st.st_dev, st.st_ino);
+    if (changed || entry->bytes > DIR_CACHE_MAX_BYTES) {
+        // O watch só fica se outra listagem do mesmo diretório ainda o usa
+        if (!old) inotify_rm_watch(notify, wd);
+        pthread_mutex_unlock(&cache_lock);
+        return entry;
+    }
+    if (old) detach(old, false);  // Mesmo inode, mesmo watch: a entrada nova herda o watch
+
+    entry->wd = wd;
+    entry->cached = true;
+    lru_push_front(entry);
+    stats.entries++;
+    stats.bytes += entry->bytes;
+    evict();
+    pthread_mutex_unlock(&cache_lock);
+    return entry;
+}
+
+void dir_cache_release(struct dir_cache_entry *entry) {
+    if (!entry) return;
+    pthread_mutex_lock(&cache_lock);
+    const bool release = --entry->refs == 0 && !entry->cached;
+    pthread_mutex_unlock(&cache_lock);
+    if (release) free_entry(entry);
+}
+
+struct dir_cache_stats dir_cache_get_stats(void) {
+    pthread_mutex_lock(&cache_lock);
+    drain_events(-1);
+    const struct dir_cache_stats result = stats;
+    pthread_mutex_unlock(&cache_lock);
+    return result;
+}
+
+void dir_cache_clear(void) {
+    pthread_mutex_lock(&cache_lock);
+    while (lru_head) detach(lru_head, true);
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&cache_lock);
+}
+
+/*****************************************************************************/
+
+static bool drain_events(const int keep_wd) {
+    if (inotify_fd < 0) return false;
+
+    bool seen = false;
+    alignas(struct inotify_event) char buf[DIR_CACHE_EVENT_BUF];
+    ssize_t len;
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            const struct inotify_event *event = (const struct inotify_event *) p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->wd == keep_wd && keep_wd >= 0) seen = true;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Eventos perdidos: nenhuma listagem é confiável
+                while (lru_head) {
+                    stats.invalidations++;
+                    detach(lru_head, lru_head->wd != keep_wd);
+                }
+                seen = true;
+                continue;
+            }
+            for (struct dir_cache_entry *entry = lru_head; entry; entry = entry->next) {
+                if (entry->wd != event->wd) continue;
+                stats.invalidations++;
+                // IN_IGNORED: o kernel já removeu o watch (diretório apagado ou desmontado)
+                detach(entry, !(event->mask & IN_IGNORED) && entry->wd != keep_wd);
+                break;
+            }
+        }
+    }
+    return seen;
+}
+
+static bool watchable(const char *path) {
+    struct statfs fs;
+    if (statfs(path, &fs) != 0) return false;
+    for (size_t i = 0; i < sizeof(unwatchable_types) / sizeof(unwatchable_types[0]); i++) {
+        if ((unsigned long) fs.f_type == unwatchable_types[i]) return false;
+    }
+    return true;
+}
+
+static struct dir_cache_entry *find_entry(const dev_t dev, const ino_t ino) {
+    for (struct dir_cache_entry *entry = lru_head; entry; entry = entry->next) {
+        if (entry->ino == ino && entry->dev == dev) return entry;
+    }
+    return NULL;
+}
+
+static void detach(struct dir_cache_entry *entry, const bool remove_watch) {
+    lru_unlink(entry);
+    if (remove_watch && entry->wd >= 0) inotify_rm_watch(inotify_fd, entry->wd);
+    entry->wd = -1;
+    entry->cached = false;
+    stats.entries--;
+    stats.bytes -= entry->bytes;
+    if (entry->refs == 0) free_entry(entry);
+}
+
+static void lru_push_front(struct dir_cache_entry *entry) {
+    entry->prev = NULL;
+    entry->next = lru_head;
+    if (lru_head) lru_head->prev = entry;
+    lru_head = entry;
+    if (!lru_tail) lru_tail = entry;
+}
+
+static void lru_unlink(struct dir_cache_entry *entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else lru_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else lru_tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void evict(void) {
+    struct dir_cache_entry *entry = lru_tail;
+    while (entry && (stats.bytes > DIR_CACHE_MAX_BYTES || stats.entries > DIR_CACHE_MAX_ENTRIES)) {
+        struct dir_cache_entry *prev = entry->prev;
+        // A entrada recém-inserida (no início) nunca sai aqui: ela cabe sozinha no limite
+        if (entry != lru_head) {
+            stats.evictions++;
+            detach(entry, true);
+        }
+        entry = prev;
+    }
+}
+
+static size_t listing_bytes(const struct dir_listing *listing) {
+    return listing->names_cap + listing->capacity * sizeof(struct dir_entry) +
+           (listing->meta ? listing->count * sizeof(struct file_meta) : 0);
+}
+
+static void free_entry(struct dir_cache_entry *entry) {
+    dir_listing_free(&entry->listing);
+    free(entry);
+}
@@ -0,0 +1,79 @@
+//
+// Cache de listagens do `lf` (nomes ordenados + metadados), invalidado por inotify.
+//
+
+#ifndef DIR_CACHE_H
+#define DIR_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "dir_tools.h"
+
+// Memória máxima das listagens guardadas (as menos usadas recentemente saem primeiro)
+#define DIR_CACHE_MAX_BYTES (256u * 1024 * 1024)
+
+// Máximo de diretórios guardados (cada um mantém um descritor e um watch do inotify)
+#define DIR_CACHE_MAX_ENTRIES 64
+
+/**
+ * @brief Listagem guardada de um diretório, identificado por (dispositivo, inode).
+ */
+struct dir_cache_entry {
+    dev_t dev;
+    ino_t ino;
+    int wd;                      // Watch do inotify (-1 = fora do cache)
+    bool details;                // `listing.meta` preenchido (campos de DIR_DETAIL_STATX_MASK)
+    bool cached;                 // Na tabela (false = descartada ao liberar a última referência)
+    unsigned refs;               // Usos em andamento (`lf` em várias threads do `par`)
+    size_t bytes;                // Memória contada no limite
+    struct dir_listing listing;  // Todas as entradas, inclusive ocultas; `listing.fd` aberto
+    struct dir_cache_entry *prev, *next;  // Ordem de uso (mais recente primeiro)
+};
+
+struct dir_cache_stats {
+    size_t hits;
+    size_t misses;
+    size_t invalidations;  // Listagens descartadas por eventos do inotify
+    size_t evictions;      // Listagens descartadas pelo limite de memória ou de entradas
+    size_t unwatchable;    // Leituras não guardadas: rede, FUSE ou /proc (o inotify não vê as mudanças)
+    size_t entries;
+    size_t bytes;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Listagem de `path` vinda do cache, ou lida agora (e guardada).
+ *
+ * O watch do inotify é criado antes da leitura, então uma mudança durante a
+ * leitura também invalida a listagem. Os eventos pendentes são consumidos a
+ * cada consulta (sem thread nem sinal). Sem inotify (limite de watches) ou em
+ * sistemas de arquivos cujas mudanças ele não vê (NFS, SMB/CIFS, FUSE, /proc,
+ * pelo `f_type` do statfs), a listagem é lida normalmente e não fica guardada.
+ * @param path Caminho do diretório.
+ * @param details Se true, também os metadados de cada entrada.
+ * @param jobs Quantidade de stat simultâneos ao ler os metadados.
+ * @return Entrada (liberar com `dir_cache_release`), ou NULL se o diretório não puder ser lido.
+ */
+struct dir_cache_entry *dir_cache_acquire(const char *path, bool details, unsigned jobs);
+
+/**
+ * @brief Devolve uma entrada obtida com `dir_cache_acquire`.
+ * @param entry Entrada.
+ */
+void dir_cache_release(struct dir_cache_entry *entry);
+
+/**
+ * @brief Contadores do cache.
+ * @return Estatísticas acumuladas desde o início da sessão (ou do último `dir_cache_clear`).
+ */
+struct dir_cache_stats dir_cache_get_stats(void);
+
+/**
+ * @brief Descarta todas as listagens (e os watches) e zera os contadores.
+ */
+void dir_cache_clear(void);
+
+#endif //DIR_CACHE_H
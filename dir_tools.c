@@ -0,0 +1,229 @@
+#include "dir_tools.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+// Entradas entregues a cada thread de `dir_listing_stat` (pequeno: cada stat pode ser lento)
+#define DIR_STAT_CHUNK 16
+
+/*****************************************************************************/
+
+struct dir_counters dir_counters;
+
+struct stat_job {
+    struct dir_listing *listing;
+    unsigned int mask;
+    int flags;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Acrescenta um nome à arena e uma entrada ao índice.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int listing_add(struct dir_listing *listing, const char *name, unsigned char type);
+
+/**
+ * @brief Lê os metadados de um bloco da listagem (executado por `parallel_for`).
+ */
+static void stat_chunk(size_t begin, size_t end, unsigned worker, void *ctx);
+
+/**
+ * @brief Compara duas entradas pelo nome com `strcoll` (contexto: a arena de nomes).
+ */
+static int compare_entries_by_name(const void *a, const void *b, void *names);
+
+/*****************************************************************************/
+
+int dir_reader_open(struct dir_reader *reader, const char *path) {
+    const int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        memset(reader, 0, sizeof(*reader));
+        reader->fd = -1;
+        return -1;
+    }
+    return dir_reader_open_fd(reader, fd);
+}
+
+int dir_reader_open_fd(struct dir_reader *reader, const int fd) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = fd;
+    reader->buf = malloc(DIR_READ_BUF_SIZE);
+    if (!reader->buf) {
+        close(reader->fd);
+        reader->fd = -1;
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+const struct dirent64 *dir_reader_next(struct dir_reader *reader) {
+    if (reader->pos >= reader->len) {
+        ssize_t len;
+        do {
+            len = getdents64(reader->fd, reader->buf, DIR_READ_BUF_SIZE);
+            atomic_fetch_add_explicit(&dir_counters.getdents, 1, memory_order_relaxed);
+        } while (len < 0 && errno == EINTR);
+
+        if (len <= 0) {
+            reader->error = len < 0 ? errno : 0;
+            return NULL;
+        }
+        reader->len = (size_t) len;
+        reader->pos = 0;
+    }
+
+    const struct dirent64 *entry = (const struct dirent64 *) (reader->buf + reader->pos);
+    reader->pos += entry->d_reclen;
+    return entry;
+}
+
+void dir_reader_close(struct dir_reader *reader) {
+    if (reader->fd >= 0) close(reader->fd);
+    free(reader->buf);
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+int dir_stat_at(const int dir_fd, const char *name, const unsigned int mask, const int flags,
+                struct file_meta *meta) {
+    static atomic_bool has_statx = true;
+    atomic_fetch_add_explicit(&dir_counters.stats, 1, memory_order_relaxed);
+
+    if (has_statx) {
+        struct statx stx;
+        if (statx(dir_fd, name, flags | AT_NO_AUTOMOUNT, mask, &stx) == 0) {
+            meta->mode = stx.stx_mode;
+            meta->uid = stx.stx_uid;
+            meta->gid = stx.stx_gid;
+            meta->size = (off_t) stx.stx_size;
+            meta->mtime = stx.stx_mtime.tv_sec;
+            return 0;
+        }
+        if (errno != ENOSYS) return -1;
+        has_statx = false;
+    }
+
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, flags) != 0) return -1;
+    meta->mode = st.st_mode;
+    meta->uid = st.st_uid;
+    meta->gid = st.st_gid;
+    meta->size = st.st_size;
+    meta->mtime = st.st_mtime;
+    return 0;
+}
+
+int dir_listing_read(struct dir_listing *listing, const char *path, const bool show_all) {
+    const int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        memset(listing, 0, sizeof(*listing));
+        listing->fd = -1;
+        return -1;
+    }
+    return dir_listing_read_fd(listing, fd, show_all);
+}
+
+int dir_listing_read_fd(struct dir_listing *listing, const int fd, const bool show_all) {
+    memset(listing, 0, sizeof(*listing));
+    listing->fd = -1;
+
+    struct dir_reader reader;
+    if (dir_reader_open_fd(&reader, fd) != 0) return -1;
+
+    const struct dirent64 *entry;
+    while ((entry = dir_reader_next(&reader))) {
+        if (!show_all && entry->d_name[0] == '.') continue;
+        if (listing_add(listing, entry->d_name, entry->d_type) != 0) {
+            dir_reader_close(&reader);
+            dir_listing_free(listing);
+            return -1;
+        }
+    }
+    const int error = reader.error;
+
+    // O descritor passa para a listagem
+    listing->fd = reader.fd;
+    reader.fd = -1;
+    dir_reader_close(&reader);
+    if (error) {
+        dir_listing_free(listing);
+        errno = error;
+        return -1;
+    }
+
+    if (listing->count > 1) {
+        qsort_r(listing->entries, listing->count, sizeof(struct dir_entry), compare_entries_by_name, listing->names);
+    }
+    return 0;
+}
+
+int dir_listing_stat(struct dir_listing *listing, const unsigned int mask, const int flags, const unsigned threads) {
+    struct file_meta *meta = realloc(listing->meta, (listing->count ? listing->count : 1) * sizeof(struct file_meta));
+    if (!meta) return -1;
+    listing->meta = meta;
+
+    struct stat_job job = {.listing = listing, .mask = mask, .flags = flags};
+    parallel_for(listing->count, DIR_STAT_CHUNK, threads ? threads : 1, stat_chunk, &job);
+    return 0;
+}
+
+void dir_listing_free(struct dir_listing *listing) {
+    if (listing->fd >= 0) close(listing->fd);
+    free(listing->names);
+    free(listing->entries);
+    free(listing->meta);
+    memset(listing, 0, sizeof(*listing));
+    listing->fd = -1;
+}
+
+/*****************************************************************************/
+
+static int listing_add(struct dir_listing *listing, const char *name, const unsigned char type) {
+    const size_t len = strlen(name) + 1;
+
+    if (listing->names_len + len > listing->names_cap) {
+        size_t capacity = listing->names_cap ? listing->names_cap : 16 * 1024;
+        while (capacity < listing->names_len + len) capacity *= 2;
+        char *grown = realloc(listing->names, capacity);
+        if (!grown) return -1;
+        listing->names = grown;
+        listing->names_cap = capacity;
+    }
+    if (listing->count == listing->capacity) {
+        const size_t capacity = listing->capacity ? listing->capacity * 2 : 1024;
+        struct dir_entry *grown = realloc(listing->entries, capacity * sizeof(struct dir_entry));
+        if (!grown) return -1;
+        listing->entries = grown;
+        listing->capacity = capacity;
+    }
+
+    memcpy(listing->names + listing->names_len, name, len);
+    listing->entries[listing->count++] = (struct dir_entry){.name = listing->names_len, .type = type};
+    listing->names_len += len;
+    return 0;
+}
+
+static void stat_chunk(const size_t begin, const size_t end, const unsigned worker, void *ctx) {
+    (void) worker;
+    const struct stat_job *job = ctx;
+    struct dir_listing *listing = job->listing;
+
+    for (size_t i = begin; i < end; i++) {
+        if (dir_stat_at(listing->fd, dir_listing_name(listing, i), job->mask, job->flags, &listing->meta[i]) != 0) {
+            listing->meta[i].mode = 0;
+        }
+    }
+}
+
+static int compare_entries_by_name(const void *a, const void *b, void *names) {
+    const char *arena = names;
+    return strcoll(arena + ((const struct dir_entry *) a)->name, arena + ((const struct dir_entry *) b)->name);
+}
@@ -0,0 +1,174 @@
+//
+// Leitura de diretórios com getdents64 e listagens ordenadas em arena.
+//
+
+#ifndef DIR_TOOLS_H
+#define DIR_TOOLS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Buffer de cada chamada a getdents64 (lotes grandes = menos syscalls)
+#define DIR_READ_BUF_SIZE (256 * 1024)
+
+// Campos de statx usados pelo `lf -l`
+#define DIR_DETAIL_STATX_MASK (STATX_TYPE | STATX_MODE | STATX_UID | STATX_GID | STATX_SIZE | STATX_MTIME)
+
+/*****************************************************************************/
+
+/**
+ * @brief Metadados de uma entrada, só com os campos pedidos em `dir_stat_at`.
+ */
+struct file_meta {
+    mode_t mode;        // Tipo + permissões
+    uid_t uid;
+    gid_t gid;
+    off_t size;
+    time_t mtime;
+};
+
+/**
+ * @brief Contadores de syscalls de diretório (para medir o custo do `lf`).
+ */
+struct dir_counters {
+    atomic_size_t getdents;  // Chamadas a getdents64
+    atomic_size_t stats;     // Chamadas a statx/fstatat
+};
+
+extern struct dir_counters dir_counters;
+
+/**
+ * @brief Leitor de diretório em lotes: um único buffer reaproveitado por todo o diretório.
+ */
+struct dir_reader {
+    int fd;
+    char *buf;
+    size_t len;
+    size_t pos;
+    int error;          // errno da última falha de leitura (0 = sem erro)
+};
+
+/**
+ * @brief Entrada de uma listagem: nome (offset na arena) e tipo vindo do getdents64.
+ */
+struct dir_entry {
+    size_t name;        // Offset do nome em `dir_listing.names`
+    unsigned char type; // DT_* (DT_UNKNOWN se o sistema de arquivos não informar)
+};
+
+/**
+ * @brief Listagem completa de um diretório.
+ *
+ * Os nomes ficam todos em uma única arena (terminados em '\0'), e `entries`
+ * funciona como vetor de índices ordenado sobre ela, então a memória é
+ * proporcional ao total de bytes dos nomes.
+ */
+struct dir_listing {
+    int fd;             // Diretório aberto (para chamadas relativas, ex.: `dir_stat_at`)
+
+    char *names;
+    size_t names_len;
+    size_t names_cap;
+
+    struct dir_entry *entries;
+    size_t count;
+    size_t capacity;
+
+    struct file_meta *meta;  // Preenchido por `dir_listing_stat` (mode == 0 = falhou)
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Abre um diretório para leitura em lotes.
+ * @param reader Leitor a ser inicializado.
+ * @param path Caminho do diretório.
+ * @return 0 em caso de sucesso, -1 em caso de erro (errno preservado).
+ */
+int dir_reader_open(struct dir_reader *reader, const char *path);
+
+/**
+ * @brief Prepara a leitura em lotes de um diretório já aberto (o leitor passa a ser dono de `fd`).
+ * @param reader Leitor a ser inicializado.
+ * @param fd Descritor do diretório (fechado por `dir_reader_close`, mesmo em caso de erro).
+ * @return 0 em caso de sucesso, -1 em caso de erro (errno preservado).
+ */
+int dir_reader_open_fd(struct dir_reader *reader, int fd);
+
+/**
+ * @brief Próxima entrada do diretório (inclusive "." e "..").
+ * @param reader Leitor aberto.
+ * @return Entrada (válida até a próxima chamada), ou NULL no fim ou em erro (ver `reader->error`).
+ */
+const struct dirent64 *dir_reader_next(struct dir_reader *reader);
+
+/**
+ * @brief Fecha o leitor e libera o buffer.
+ * @param reader Leitor a ser fechado.
+ */
+void dir_reader_close(struct dir_reader *reader);
+
+/**
+ * @brief Lê metadados de `name` relativo a `dir_fd` com `statx`, pedindo só os campos de `mask`.
+ *
+ * Evita montar o caminho completo e percorrê-lo a cada entrada. Se o kernel
+ * não tiver `statx`, usa `fstatat`.
+ * @param dir_fd Descritor do diretório.
+ * @param name Nome da entrada.
+ * @param mask Campos desejados (STATX_TYPE, STATX_MODE, STATX_UID, ...).
+ * @param flags 0 para seguir links simbólicos, AT_SYMLINK_NOFOLLOW para não seguir.
+ * @param meta Metadados de saída.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int dir_stat_at(int dir_fd, const char *name, unsigned int mask, int flags, struct file_meta *meta);
+
+/**
+ * @brief Lê o diretório inteiro e ordena os nomes com `strcoll` (ordem do locale).
+ * O diretório continua aberto em `listing->fd` até `dir_listing_free`.
+ * @param listing Listagem a ser preenchida (liberar com `dir_listing_free`).
+ * @param path Caminho do diretório.
+ * @param show_all Se false, ignora nomes iniciados por '.'.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int dir_listing_read(struct dir_listing *listing, const char *path, bool show_all);
+
+/**
+ * @brief Como `dir_listing_read`, mas sobre um diretório já aberto (a listagem passa a ser dona de `fd`).
+ * @param listing Listagem a ser preenchida (liberar com `dir_listing_free`).
+ * @param fd Descritor do diretório (fechado em caso de erro).
+ * @param show_all Se false, ignora nomes iniciados por '.'.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int dir_listing_read_fd(struct dir_listing *listing, int fd, bool show_all);
+
+/**
+ * @brief Lê os metadados de todas as entradas, em paralelo, para `listing->meta`.
+ *
+ * Em sistemas de arquivos remotos (NFS, FUSE) cada stat é uma ida e volta na
+ * rede; com várias threads as requisições ficam em voo ao mesmo tempo. Os
+ * resultados ficam na mesma ordem da listagem.
+ * @param listing Listagem lida com `dir_listing_read`.
+ * @param mask Campos desejados (ver `dir_stat_at`).
+ * @param flags 0 ou AT_SYMLINK_NOFOLLOW.
+ * @param threads Quantidade de threads (1 = sequencial na thread atual).
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+int dir_listing_stat(struct dir_listing *listing, unsigned int mask, int flags, unsigned threads);
+
+/**
+ * @brief Nome da i-ésima entrada da listagem.
+ */
+static inline const char *dir_listing_name(const struct dir_listing *listing, const size_t i) {
+    return listing->names + listing->entries[i].name;
+}
+
+/**
+ * @brief Libera a memória de uma listagem.
+ * @param listing Listagem a ser liberada.
+ */
+void dir_listing_free(struct dir_listing *listing);
+
+#endif //DIR_TOOLS_H
@@ -0,0 +1,715 @@
+#include "exec.h"
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+#include "path_cache.h"
+#include "jobs.h"
+#include "stats.h"
+
+// Bytes pedidos por chamada a splice e tamanho do buffer da cópia comum
+#define PUMP_CHUNK (64 * 1024)
+
+/*****************************************************************************/
+
+/**
+ * @brief Estágio só de redirecionamento: copia `in` para todos os `outs`.
+ */
+struct pump {
+    int in;                                  // -1 = nenhuma entrada (só cria os arquivos)
+    int outs[EXEC_MAX_REDIRECTS + 1];
+    size_t out_count;
+    int status;
+    pthread_t thread;
+    atomic_int refs;    // Thread + shell: o último a soltar libera (o shell solta sem esperar se o job parar)
+};
+
+// Descritor salvo antes de um comando interno redirecionar o próprio shell
+struct saved_fd {
+    int fd;
+    int copy;   // -1 = `fd` estava fechado
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Aplica os redirecionamentos de um comando aos descritores do processo atual.
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida em stderr).
+ */
+static int apply_redirects(const struct command *cmd);
+
+/**
+ * @brief Abre o arquivo de um redirecionamento com O_CLOEXEC.
+ * @return Descritor aberto, ou -1 em caso de erro (mensagem já exibida em stderr).
+ */
+static int open_redirect(const struct redirect *redirect);
+
+/**
+ * @brief Executa um comando interno no próprio shell com a entrada/saída do estágio.
+ * @param fn Comando interno.
+ * @param cmd Comando com argv e redirecionamentos.
+ * @param in Descritor para a entrada padrão (-1 = manter).
+ * @param out Descritor para a saída padrão (-1 = manter).
+ * @return Código de saída do comando.
+ */
+static int run_inline(builtin_fn fn, const struct command *cmd, int in, int out);
+
+/**
+ * @brief Cria o processo de um estágio: externo com `posix_spawn`, interno ou bomba com fork.
+ * @param pgid Grupo do job (0 = grupo novo com o PID do filho; -1 = sem controle de jobs).
+ * @param take_terminal Se true, o grupo do filho recebe o terminal (primeiro estágio em primeiro plano).
+ * @return PID do filho, ou -1 em caso de erro (mensagem já exibida em stderr).
+ */
+static pid_t spawn_stage(const struct command *cmd, builtin_fn fn, int in, int out,
+                         const int (*pipes)[2], size_t pipe_count, pid_t pgid, bool take_terminal);
+
+/**
+ * @brief Cria o processo de um comando externo com `posix_spawn` e os redirecionamentos como file actions.
+ *
+ * O executável vem do cache do PATH (`path_cache_lookup`), sem as tentativas de
+ * execve em cada diretório que o `execvp` faria. Grupo de processos, terminal
+ * e sinais padrão também são ajustados pelo `posix_spawn`, antes do exec.
+ * @return PID do filho, ou -1 em caso de erro (mensagem já exibida em stderr).
+ */
+static pid_t spawn_external(const struct command *cmd, int in, int out, pid_t pgid, bool take_terminal);
+
+/**
+ * @brief Prepara os sinais do filho: nenhum bloqueado e o padrão nos que o shell ignora.
+ * @param attr Atributos do posix_spawn.
+ * @return Flags a acrescentar em `posix_spawnattr_setflags`.
+ */
+static short child_signals(posix_spawnattr_t *attr);
+
+/**
+ * @brief posix_spawn de `argv[0]` resolvido pelo cache do PATH, procurando de novo se a entrada estiver velha.
+ * @param pid Recebe o PID do filho.
+ * @param argv Comando terminado em NULL.
+ * @param actions Redirecionamentos do filho.
+ * @param attr Atributos do filho.
+ * @return 0 em caso de sucesso, ou o código de erro (ENOENT se o comando não existe).
+ */
+static int spawn_path(pid_t *pid, char **argv, const posix_spawn_file_actions_t *actions,
+                      const posix_spawnattr_t *attr);
+
+/**
+ * @brief Prepara um estágio só de redirecionamento (abre os arquivos e duplica os pipes).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int pump_prepare(struct pump *pump, const struct command *cmd, int in, int out, bool last);
+
+/**
+ * @brief Bombeia os dados de um estágio só de redirecionamento (no processo/thread atual).
+ */
+static void *pump_thread(void *arg);
+
+/**
+ * @brief Corpo da thread de bombeamento: bombeia e solta a sua referência.
+ */
+static void *pump_main(void *arg);
+
+/**
+ * @brief Solta uma referência da bomba, liberando-a na última.
+ */
+static void pump_release(struct pump *pump);
+
+/**
+ * @brief Copia `in` para `outs` até o fim da entrada, com splice (um destino) ou tee (vários).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int pump_data(int in, const int *outs, size_t out_count);
+
+/**
+ * @brief Move exatamente `len` bytes do pipe `from` para `to` (splice, ou read/write se não suportado).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int move_bytes(int from, int to, size_t len);
+
+/**
+ * @brief Copia `in` para `out` até o fim da entrada (splice, ou read/write se não suportado).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int copy_all(int in, int out);
+
+/**
+ * @brief Indica se o descritor é um pipe (requisito do tee).
+ */
+static bool is_pipe(int fd);
+
+/*****************************************************************************/
+
+builtin_fn find_builtin(const struct builtin *builtins, const char *name) {
+    for (const struct builtin *b = builtins; b->name; b++) {
+        if (strcmp(b->name, name) == 0) return b->run;
+    }
+    return NULL;
+}
+
+int exec_spawn(char **argv, const int in, const int out, const int err, pid_t *pid) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, child_signals(&attr));
+
+    if (in >= 0) posix_spawn_file_actions_adddup2(&actions, in, STDIN_FILENO);
+    if (out >= 0) posix_spawn_file_actions_adddup2(&actions, out, STDOUT_FILENO);
+    if (err >= 0) posix_spawn_file_actions_adddup2(&actions, err, STDERR_FILENO);
+
+    const int error = spawn_path(pid, argv, &actions, &attr);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return error;
+}
+
+int pipeline_run(const struct pipeline *pipeline, const struct builtin *builtins, struct rusage *usage) {
+    const size_t count = pipeline->count;
+    if (usage) memset(usage, 0, sizeof(*usage));
+    if (count == 0) return 0;
+
+    // Um único comando interno roda no shell; os demais viram processos
+    size_t inline_stage = SIZE_MAX;
+    if (!pipeline->background) {
+        for (size_t i = 0; i < count; i++) {
+            const struct command *cmd = &pipeline->commands[i];
+            if (cmd->argc > 0 && find_builtin(builtins, cmd->argv[0])) inline_stage = i;
+        }
+    }
+
+    // Pipe i liga o estágio i ao estágio i + 1
+    int pipes[EXEC_MAX_COMMANDS - 1][2];
+    size_t pipe_count = 0;
+    for (; pipe_count + 1 < count; pipe_count++) {
+        if (pipe2(pipes[pipe_count], O_CLOEXEC) != 0) {
+            fprintf(stderr, "%sErro ao criar pipe%s\n", TERM_RED_BOLD, TERM_RESET);
+            for (size_t i = 0; i < pipe_count; i++) {
+                close(pipes[i][0]);
+                close(pipes[i][1]);
+            }
+            return 1;
+        }
+    }
+
+    // Saída pendente antes da saída dos filhos (um comando interno sozinho continua no buffer)
+    if (inline_stage == SIZE_MAX || count > 1) term_out_flush();
+
+    pid_t pids[EXEC_MAX_COMMANDS];
+    struct pump *pumps[EXEC_MAX_COMMANDS] = {0};
+    int statuses[EXEC_MAX_COMMANDS];
+
+    // Com terminal, o job inteiro fica no grupo do primeiro processo criado
+    const bool job_control = jobs_interactive();
+    pid_t pgid = job_control ? 0 : -1;
+    pid_t job_pids[EXEC_MAX_COMMANDS];
+    size_t job_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct command *cmd = &pipeline->commands[i];
+        const int in = i > 0 ? pipes[i - 1][0] : -1;
+        const int out = i + 1 < count ? pipes[i][1] : -1;
+        pids[i] = -1;
+        statuses[i] = 1;
+        if (i == inline_stage) continue;
+
+        if (cmd->argc == 0 && !pipeline->background) {
+            // Bombeado por uma thread, sem fork
+            struct pump *pump = malloc(sizeof(struct pump));
+            if (!pump || pump_prepare(pump, cmd, in, out, i + 1 == count) != 0) {
+                free(pump);
+                continue;
+            }
+            atomic_init(&pump->refs, 2);
+            if (pthread_create(&pump->thread, NULL, pump_main, pump) != 0) {
+                pump_thread(pump); // Sem thread: bombeia aqui mesmo
+                statuses[i] = pump->status;
+                free(pump);
+                continue;
+            }
+            pumps[i] = pump;
+            continue;
+        }
+
+        const builtin_fn fn = cmd->argc > 0 ? find_builtin(builtins, cmd->argv[0]) : NULL;
+        const bool take_terminal = job_control && !pipeline->background && pgid == 0;
+        pids[i] = spawn_stage(cmd, fn, in, out, (const int (*)[2]) pipes, pipe_count, pgid, take_terminal);
+        if (pids[i] < 0) {
+            statuses[i] = 127;
+            continue;
+        }
+        if (job_control) {
+            // Também no pai: o grupo existe antes de qualquer kill/tcsetpgrp, seja quem for mais rápido
+            setpgid(pids[i], pgid > 0 ? pgid : pids[i]);
+            if (pgid == 0) {
+                pgid = pids[i];
+                if (take_terminal) tcsetpgrp(STDIN_FILENO, pgid);
+            }
+        }
+        job_pids[job_count++] = pids[i];
+    }
+
+    // Fechar as pontas do shell: cada leitor só recebe EOF (e cada escritor EPIPE) depois disso.
+    // O comando interno mantém só as suas duas pontas enquanto roda.
+    const int inline_in = inline_stage != SIZE_MAX && inline_stage > 0 ? pipes[inline_stage - 1][0] : -1;
+    const int inline_out = inline_stage != SIZE_MAX && inline_stage + 1 < count ? pipes[inline_stage][1] : -1;
+    for (size_t i = 0; i < pipe_count; i++) {
+        if (pipes[i][0] != inline_in) close(pipes[i][0]);
+        if (pipes[i][1] != inline_out) close(pipes[i][1]);
+    }
+
+    if (inline_stage != SIZE_MAX) {
+        const struct command *cmd = &pipeline->commands[inline_stage];
+        // getrusage só em volta do comando interno: pipelines só de externos não pagam as duas chamadas
+        struct rusage before, after;
+        if (usage) getrusage(RUSAGE_THREAD, &before);
+        statuses[inline_stage] = run_inline(find_builtin(builtins, cmd->argv[0]), cmd, inline_in, inline_out);
+        if (usage) {
+            getrusage(RUSAGE_THREAD, &after);
+            stats_usage_delta(usage, &before, &after);
+        }
+        if (inline_in >= 0) close(inline_in);
+        if (inline_out >= 0) close(inline_out);
+    }
+
+    struct job *job = job_count > 0 ? jobs_add(pgid > 0 ? pgid : 0, job_pids, job_count, pipeline->text) : NULL;
+    if (pipeline->background) {
+        if (job && jobs_interactive()) term_out_printf("[%d] %d\n", job->id, job_pids[job_count - 1]);
+        return 0;
+    }
+
+    bool stopped = false;
+    if (job) {
+        const int id = job->id;
+        struct rusage children;
+        const int status = jobs_wait(job, true, &children);
+        if (usage) stats_usage_add(usage, &children);
+        // O job só continua na tabela se parou (Ctrl-Z); terminado, já foi liberado
+        stopped = jobs_get(id) != NULL;
+        if (pids[count - 1] > 0 || stopped) statuses[count - 1] = status;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!pumps[i]) continue;
+        if (stopped) {
+            // Job parado com Ctrl-Z: a bomba segue sozinha e se libera ao terminar
+            pthread_detach(pumps[i]->thread);
+        } else {
+            pthread_join(pumps[i]->thread, NULL);
+            statuses[i] = pumps[i]->status;
+        }
+        pump_release(pumps[i]);
+    }
+    return statuses[count - 1];
+}
+
+/*****************************************************************************/
+
+static int open_redirect(const struct redirect *redirect) {
+    int flags = O_CLOEXEC;
+    if (redirect->kind == REDIRECT_IN) flags |= O_RDONLY;
+    else if (redirect->kind == REDIRECT_OUT) flags |= O_WRONLY | O_CREAT | O_TRUNC;
+    else flags |= O_WRONLY | O_CREAT | O_APPEND;
+
+    const int fd = open(redirect->path, flags, 0666);
+    if (fd < 0) fprintf(stderr, "%sErro ao abrir %s: %s%s\n", TERM_RED_BOLD, redirect->path, strerror(errno), TERM_RESET);
+    return fd;
+}
+
+static int apply_redirects(const struct command *cmd) {
+    for (size_t i = 0; i < cmd->redirect_count; i++) {
+        const struct redirect *redirect = &cmd->redirects[i];
+        if (redirect->kind == REDIRECT_DUP) {
+            if (redirect->target != redirect->fd && dup2(redirect->target, redirect->fd) < 0) {
+                fprintf(stderr, "%sDescritor inválido: %d%s\n", TERM_RED_BOLD, redirect->target, TERM_RESET);
+                return -1;
+            }
+            continue;
+        }
+
+        const int fd = open_redirect(redirect);
+        if (fd < 0) return -1;
+        if (fd != redirect->fd) {
+            const int result = dup2(fd, redirect->fd);
+            close(fd);
+            if (result < 0) return -1;
+        } else {
+            fcntl(fd, F_SETFD, 0); // Já caiu no descritor certo: tirar o O_CLOEXEC
+        }
+    }
+    return 0;
+}
+
+static int run_inline(const builtin_fn fn, const struct command *cmd, const int in, const int out) {
+    // Sem pipe nem redirecionamento (`cd`, `lf` em um script): nada a trocar, e a saída
+    // continua no buffer do term_out junto com a dos comandos seguintes
+    if (in < 0 && out < 0 && cmd->redirect_count == 0) return fn(cmd->argc, cmd->argv);
+    term_out_flush(); // O que já está no buffer vai para a saída de antes dos redirecionamentos
+
+    // Salvar todo descritor que o comando vai trocar (0, 1, 2 e os dos redirecionamentos)
+    struct saved_fd saved[3 + EXEC_MAX_REDIRECTS];
+    size_t saved_count = 0;
+    for (size_t i = 0; i < 3 + cmd->redirect_count; i++) {
+        const int fd = i < 3 ? (int) i : cmd->redirects[i - 3].fd;
+        bool seen = false;
+        for (size_t j = 0; j < saved_count && !seen; j++) seen = saved[j].fd == fd;
+        if (seen) continue;
+        saved[saved_count].fd = fd;
+        saved[saved_count].copy = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+        saved_count++;
+    }
+
+    int status = 1;
+    if ((in < 0 || dup2(in, STDIN_FILENO) >= 0) && (out < 0 || dup2(out, STDOUT_FILENO) >= 0) &&
+        apply_redirects(cmd) == 0) {
+        // Leitor do pipe encerrado (ex.: `tree 1 | head`): EPIPE no write em vez de SIGPIPE no shell
+        sigset_t pipe_set, old_set;
+        sigemptyset(&pipe_set);
+        sigaddset(&pipe_set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+        status = fn(cmd->argc, cmd->argv);
+        term_out_flush();
+
+        const struct timespec no_wait = {0};
+        while (sigtimedwait(&pipe_set, NULL, &no_wait) > 0) {}
+        pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+    }
+
+    for (size_t i = 0; i < saved_count; i++) {
+        if (saved[i].copy >= 0) {
+            dup2(saved[i].copy, saved[i].fd);
+            close(saved[i].copy);
+        } else {
+            close(saved[i].fd);
+        }
+    }
+    return status;
+}
+
+static pid_t spawn_stage(const struct command *cmd, const builtin_fn fn, const int in, const int out,
+                         const int (*pipes)[2], const size_t pipe_count, const pid_t pgid, const bool take_terminal) {
+    if (cmd->argc > 0 && !fn) return spawn_external(cmd, in, out, pgid, take_terminal);
+
+    // Comandos internos e bombas precisam do código do shell no filho: aqui o fork é inevitável
+    const pid_t pid = fork();
+    if (pid < 0) fprintf(stderr, "%sErro ao criar processo%s\n", TERM_RED_BOLD, TERM_RESET);
+    if (pid != 0) return pid;
+
+    jobs_child_setup(pgid);
+
+    if (in >= 0) dup2(in, STDIN_FILENO);
+    if (out >= 0) dup2(out, STDOUT_FILENO);
+    // Comandos internos não passam por exec: fechar as demais pontas para não segurar o EOF dos vizinhos
+    for (size_t i = 0; i < pipe_count; i++) {
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+    }
+
+    if (cmd->argc == 0) {
+        // Estágio só de redirecionamento em segundo plano: bombeia neste processo
+        struct pump pump;
+        const bool last = out < 0;
+        if (pump_prepare(&pump, cmd, in >= 0 ? STDIN_FILENO : -1, last ? -1 : STDOUT_FILENO, last) != 0) {
+            _exit(EXIT_FAILURE);
+        }
+        pump_thread(&pump);
+        _exit(pump.status);
+    }
+    if (apply_redirects(cmd) != 0) _exit(EXIT_FAILURE);
+
+    const int status = fn(cmd->argc, cmd->argv);
+    term_out_flush();
+    _exit(status);
+}
+
+static pid_t spawn_external(const struct command *cmd, const int in, const int out, const pid_t pgid,
+                            const bool take_terminal) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    short flags = child_signals(&attr);
+    if (pgid >= 0) {
+        posix_spawnattr_setpgroup(&attr, pgid);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attr, flags);
+
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 35)
+    // O filho pega o terminal antes do exec: um `vim` não chega a ler o terminal em segundo plano
+    if (take_terminal) posix_spawn_file_actions_addtcsetpgrp_np(&actions, STDIN_FILENO);
+#else
+    (void) take_terminal; // O pai chama tcsetpgrp logo depois
+#endif
+
+    if (in >= 0) posix_spawn_file_actions_adddup2(&actions, in, STDIN_FILENO);
+    if (out >= 0) posix_spawn_file_actions_adddup2(&actions, out, STDOUT_FILENO);
+
+    // Arquivos abertos aqui (O_CLOEXEC) para o erro citar o arquivo, e não o comando
+    int opened[EXEC_MAX_REDIRECTS];
+    size_t opened_count = 0;
+    pid_t pid = -1;
+    for (size_t i = 0; i < cmd->redirect_count; i++) {
+        const struct redirect *redirect = &cmd->redirects[i];
+        if (redirect->kind == REDIRECT_DUP) {
+            posix_spawn_file_actions_adddup2(&actions, redirect->target, redirect->fd);
+            continue;
+        }
+        const int fd = open_redirect(redirect);
+        if (fd < 0) goto done;
+        opened[opened_count++] = fd;
+        posix_spawn_file_actions_adddup2(&actions, fd, redirect->fd);
+    }
+
+    const int error = spawn_path(&pid, cmd->argv, &actions, &attr);
+    if (error != 0) {
+        fprintf(stderr, "%sErro ao executar %s: %s%s\n", TERM_RED_BOLD, cmd->argv[0], strerror(error), TERM_RESET);
+        pid = -1;
+    }
+
+done:
+    for (size_t i = 0; i < opened_count; i++) close(opened[i]);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+static short child_signals(posix_spawnattr_t *attr) {
+    // O filho começa sem sinais bloqueados (o shell bloqueia SIGCHLD, e SIGPIPE durante comandos internos)
+    // e com o padrão nos sinais que o shell interativo ignora
+    sigset_t empty, defaults;
+    sigemptyset(&empty);
+    jobs_child_signals(&defaults);
+    posix_spawnattr_setsigmask(attr, &empty);
+    posix_spawnattr_setsigdefault(attr, &defaults);
+    return POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+}
+
+static int spawn_path(pid_t *pid, char **argv, const posix_spawn_file_actions_t *actions,
+                      const posix_spawnattr_t *attr) {
+    // Caminho resolvido pelo cache do PATH (nomes com '/' são usados como estão)
+    const char *name = argv[0];
+    const bool search = strchr(name, '/') == NULL;
+    const char *file = search ? path_cache_lookup(name) : name;
+
+    // posix_spawn usa clone(CLONE_VM | CLONE_VFORK): nada da memória do shell é copiado
+    extern char **environ;
+    int error = file ? posix_spawn(pid, file, actions, attr, argv, environ) : ENOENT;
+    if (search && file && (error == ENOENT || error == EACCES)) {
+        // Entrada velha (binário removido ou trocado): descartar e procurar de novo
+        path_cache_remove(name);
+        file = path_cache_lookup(name);
+        error = file ? posix_spawn(pid, file, actions, attr, argv, environ) : ENOENT;
+    }
+    return error;
+}
+
+static int pump_prepare(struct pump *pump, const struct command *cmd, const int in, const int out, const bool last) {
+    pump->in = -1;
+    pump->out_count = 0;
+    pump->status = 1;
+
+    // Arquivos de entrada/saída do estágio (`<` substitui o pipe; vários `>` recebem todos a mesma cópia)
+    int file_in = -1;
+    for (size_t i = 0; i < cmd->redirect_count; i++) {
+        const struct redirect *redirect = &cmd->redirects[i];
+        if (redirect->kind == REDIRECT_DUP) continue;
+        const int fd = open_redirect(redirect);
+        if (fd < 0) goto fail;
+        if (redirect->kind == REDIRECT_IN) {
+            if (file_in >= 0) close(file_in);
+            file_in = fd;
+        } else {
+            pump->outs[pump->out_count++] = fd;
+        }
+    }
+
+    if (file_in >= 0) pump->in = file_in;
+    else if (in >= 0 && (pump->in = fcntl(in, F_DUPFD_CLOEXEC, 0)) < 0) goto fail;
+
+    // O próximo estágio também recebe os dados; no fim do pipeline, sem arquivos, vão para a tela
+    const int target = !last ? out : (pump->out_count == 0 ? STDOUT_FILENO : -1);
+    if (target >= 0) {
+        const int fd = fcntl(target, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) goto fail;
+        pump->outs[pump->out_count++] = fd;
+    }
+    return 0;
+
+fail:
+    if (pump->in >= 0) close(pump->in);
+    else if (file_in >= 0) close(file_in);
+    for (size_t i = 0; i < pump->out_count; i++) close(pump->outs[i]);
+    return -1;
+}
+
+static void *pump_main(void *arg) {
+    pump_thread(arg);
+    pump_release(arg);
+    return NULL;
+}
+
+static void pump_release(struct pump *pump) {
+    if (atomic_fetch_sub(&pump->refs, 1) == 1) free(pump);
+}
+
+static void *pump_thread(void *arg) {
+    struct pump *pump = arg;
+
+    // Destino fechado vira EPIPE (e fim do bombeamento), não SIGPIPE no processo
+    sigset_t pipe_set;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, NULL);
+
+    if (pump->in < 0) {
+        pump->status = 0; // `> arquivo` sozinho: só cria/trunca
+    } else {
+        const int result = pump_data(pump->in, pump->outs, pump->out_count);
+        pump->status = result == 0 || errno == EPIPE ? 0 : 1;
+        close(pump->in);
+    }
+    for (size_t i = 0; i < pump->out_count; i++) close(pump->outs[i]);
+    return NULL;
+}
+
+static int pump_data(const int in, const int *outs, const size_t out_count) {
+    if (out_count == 1) return copy_all(in, outs[0]);
+
+    // Vários destinos: os dados passam por um pipe; tee copia para um pipe auxiliar
+    // (vazio, então a cópia sai inteira) que é drenado para cada destino, e o último
+    // destino consome o pipe de origem com splice
+    int source[2] = {-1, -1};
+    int scratch[2];
+    if (pipe2(scratch, O_CLOEXEC) != 0) return -1;
+    const bool in_is_pipe = is_pipe(in);
+    if (!in_is_pipe && pipe2(source, O_CLOEXEC) != 0) {
+        close(scratch[0]);
+        close(scratch[1]);
+        return -1;
+    }
+    const int from = in_is_pipe ? in : source[0];
+
+    int result = 0;
+    while (true) {
+        ssize_t len;
+        if (in_is_pipe) {
+            len = tee(from, scratch[1], PUMP_CHUNK, 0);
+        } else {
+            len = splice(in, NULL, source[1], NULL, PUMP_CHUNK, SPLICE_F_MOVE);
+            if (len < 0 && errno == EINVAL) {
+                char buf[PUMP_CHUNK];
+                len = read(in, buf, sizeof(buf));
+                if (len > 0 && write(source[1], buf, (size_t) len) != len) len = -1;
+            }
+            if (len > 0 && tee(from, scratch[1], (size_t) len, 0) != len) len = -1;
+        }
+        if (len <= 0) {
+            if (len < 0) result = -1;
+            break;
+        }
+
+        if (move_bytes(scratch[0], outs[0], (size_t) len) != 0) {
+            result = -1;
+            break;
+        }
+        for (size_t i = 1; i + 1 < out_count && result == 0; i++) {
+            if (tee(from, scratch[1], (size_t) len, 0) != len || move_bytes(scratch[0], outs[i], (size_t) len) != 0) {
+                result = -1;
+            }
+        }
+        if (result != 0 || move_bytes(from, outs[out_count - 1], (size_t) len) != 0) {
+            result = -1;
+            break;
+        }
+    }
+
+    const int saved_errno = errno;
+    close(scratch[0]);
+    close(scratch[1]);
+    if (source[0] >= 0) {
+        close(source[0]);
+        close(source[1]);
+    }
+    errno = saved_errno;
+    return result;
+}
+
+static int move_bytes(const int from, const int to, size_t len) {
+    while (len > 0) {
+        ssize_t moved = splice(from, NULL, to, NULL, len, SPLICE_F_MOVE);
+        if (moved < 0 && errno == EINVAL) {
+            // Destino sem suporte a splice (terminal, arquivo em O_APPEND)
+            char buf[PUMP_CHUNK];
+            moved = read(from, buf, len < sizeof(buf) ? len : sizeof(buf));
+            for (ssize_t done = 0; moved > 0 && done < moved;) {
+                const ssize_t written = write(to, buf + done, (size_t) (moved - done));
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return -1;
+                }
+                done += written;
+            }
+        }
+        if (moved < 0 && errno == EINTR) continue;
+        if (moved <= 0) return -1;
+        len -= (size_t) moved;
+    }
+    return 0;
+}
+
+static int copy_all(const int in, const int out) {
+    bool use_splice = true;
+    char *buf = NULL;
+    int result = 0;
+
+    while (true) {
+        ssize_t len = -1;
+        if (use_splice) {
+            // splice exige um pipe em uma das pontas; arquivo -> arquivo cai na cópia comum
+            len = splice(in, NULL, out, NULL, PUMP_CHUNK, SPLICE_F_MOVE);
+            if (len < 0 && errno == EINVAL) use_splice = false;
+        }
+        if (!use_splice) {
+            if (!buf && !(buf = malloc(PUMP_CHUNK))) {
+                result = -1;
+                break;
+            }
+            len = read(in, buf, PUMP_CHUNK);
+            for (ssize_t done = 0; len > 0 && done < len;) {
+                const ssize_t written = write(out, buf + done, (size_t) (len - done));
+                if (written < 0 && errno != EINTR) {
+                    len = -1;
+                    break;
+                }
+                if (written > 0) done += written;
+            }
+        }
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) {
+            if (len < 0) result = -1;
+            break;
+        }
+    }
+
+    const int saved_errno = errno;
+    free(buf);
+    errno = saved_errno;
+    return result;
+}
+
+static bool is_pipe(const int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
@@ -0,0 +1,97 @@
+//
+// Pipelines e redirecionamentos: `a | b | c`, `<`, `>`, `>>`, `2>`, `2>&1`, `&`.
+//
+
+#ifndef EXEC_H
+#define EXEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+// Limites de um pipeline (a linha em si não tem limite de palavras)
+#define EXEC_MAX_COMMANDS 64
+#define EXEC_MAX_REDIRECTS 16
+
+/**
+ * @brief Comando interno: recebe argc/argv como um programa e retorna o código de saída.
+ */
+typedef int (*builtin_fn)(int argc, char **argv);
+
+struct builtin {
+    const char *name;
+    builtin_fn run;
+    bool parallel_safe;  // Pode rodar em várias threads ao mesmo tempo (`par`)
+};
+
+enum redirect_kind {
+    REDIRECT_IN,      // N< arquivo (N padrão: 0)
+    REDIRECT_OUT,     // N> arquivo (N padrão: 1)
+    REDIRECT_APPEND,  // N>> arquivo
+    REDIRECT_DUP,     // N>&M
+};
+
+struct redirect {
+    enum redirect_kind kind;
+    int fd;              // Descritor redirecionado
+    int target;          // Descritor copiado (REDIRECT_DUP)
+    const char *path;    // Arquivo (demais tipos)
+};
+
+struct command {
+    char **argv;         // Terminado em NULL; argc == 0 em estágios só de redirecionamento
+    int argc;
+    struct redirect redirects[EXEC_MAX_REDIRECTS];
+    size_t redirect_count;
+};
+
+/**
+ * @brief Pipeline já separado em comandos (ver `parse_line`).
+ */
+struct pipeline {
+    struct command *commands;   // `count` comandos
+    size_t count;
+    bool background;
+    const char *text;    // Linha original (exibida por `jobs`)
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Executa um pipeline e espera por ele (a menos que seja em segundo plano).
+ *
+ * Os estágios externos são criados primeiro; um comando interno do pipeline
+ * roda no próprio shell, escrevendo direto no pipe, sem fork. Estágios só de
+ * redirecionamento (`< arquivo | wc -c`, `cmd | > copia | wc`) copiam os dados,
+ * como no zsh (no sh eles não leem nem escrevem nada): são bombeados por uma
+ * thread com `splice`/`tee`, sem cópia para o espaço de usuário.
+ * @param pipeline Pipeline de `parse_line`/`parse_expand`.
+ * @param builtins Tabela de comandos internos, terminada por `{NULL, NULL}`.
+ * @param usage Recebe o uso de recursos do pipeline: processos terminados (wait4)
+ *              mais a thread do shell durante o comando interno (pode ser NULL).
+ * @return Código de saída do último estágio.
+ */
+int pipeline_run(const struct pipeline *pipeline, const struct builtin *builtins, struct rusage *usage);
+
+/**
+ * @brief Procura um comando interno pelo nome.
+ * @param builtins Tabela terminada por `{NULL, NULL}`.
+ * @param name Nome do comando.
+ * @return A função do comando, ou NULL se não for interno.
+ */
+builtin_fn find_builtin(const struct builtin *builtins, const char *name);
+
+/**
+ * @brief Cria um processo externo fora do controle de jobs, com os descritores dados em 0, 1 e 2.
+ *
+ * Usado pelo `par`: o filho fica no grupo do shell, não entra na tabela de jobs
+ * e quem chama espera por ele. `argv[0]` é procurado no cache do PATH.
+ * @param argv Comando terminado em NULL.
+ * @param in, out, err Descritores para a entrada, a saída e o erro (-1 = herdar).
+ * @param pid Recebe o PID do filho.
+ * @return 0 em caso de sucesso, ou o código de erro do posix_spawn (nada é exibido).
+ */
+int exec_spawn(char **argv, int in, int out, int err, pid_t *pid);
+
+#endif //EXEC_H
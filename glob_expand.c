@@ -0,0 +1,577 @@
+#include "glob_expand.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "dir_tools.h"
+
+// Capacidade inicial da tabela de diretórios e dos vetores de caminhos
+#define GLOB_INITIAL_SLOTS 64
+#define GLOB_INITIAL_PATHS 64
+
+/*****************************************************************************/
+
+enum glob_atom_kind {
+    ATOM_CHAR,   // Caractere literal
+    ATOM_ANY,    // `?`
+    ATOM_CLASS,  // `[...]`
+    ATOM_STAR,   // `*` (vários seguidos viram um)
+};
+
+struct glob_atom {
+    unsigned char kind;
+    unsigned char ch;        // ATOM_CHAR
+    unsigned short cls;      // ATOM_CLASS: índice em `classes`
+};
+
+// Classe `[...]` já resolvida: um bit por byte (negação aplicada na compilação)
+struct glob_class {
+    uint64_t bits[4];
+};
+
+/**
+ * @brief Uma parte do padrão (entre '/') compilada.
+ */
+struct glob_component {
+    struct glob_atom *atoms;
+    size_t count;
+    struct glob_class *classes;
+    const char *literal;     // Sem metacaracteres: o nome exato, sem escapes (NULL se há)
+    bool globstar;           // A parte é exatamente `**`
+    bool dot;                // Começa com '.' literal: pode casar nomes ocultos
+};
+
+struct glob_entry {
+    const char *name;
+    unsigned char type;      // DT_* (DT_UNKNOWN já resolvido com fstatat; links não seguidos)
+};
+
+/**
+ * @brief Diretório lido, com as entradas na ordem do getdents64 (sem "." e "..").
+ */
+struct glob_dir {
+    const char *path;
+    uint64_t hash;
+    struct glob_entry *entries;
+    size_t count;
+};
+
+// Lista de caminhos intermediários (bases da próxima parte do padrão)
+struct glob_list {
+    const char **items;
+    size_t count;
+    size_t capacity;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Compila uma parte do padrão.
+ * @return A parte compilada (na arena), ou NULL se faltar memória.
+ */
+static struct glob_component *compile_component(struct arena *arena, const char *pattern, size_t len);
+
+/**
+ * @brief Lê uma classe `[...]` a partir do '[' em `pattern[start]`.
+ * @return Posição depois do ']', ou 0 se não há ']' (o '[' é literal).
+ */
+static size_t compile_class(const char *pattern, size_t start, size_t len, struct glob_class *cls);
+
+/**
+ * @brief Acrescenta a uma classe os bytes de `[:nome:]`.
+ * @return false se o nome não é conhecido.
+ */
+static bool add_named_class(struct glob_class *cls, const char *name, size_t len);
+
+/**
+ * @brief Casa um nome com uma parte compilada (um único ponto de retomada: sem retrocesso exponencial).
+ */
+static bool match_component(const struct glob_component *component, const char *name);
+
+/**
+ * @brief Lê um diretório (ou o devolve do cache).
+ * @param path Caminho ("" = diretório atual).
+ * @return Listagem (vazia se o diretório não puder ser lido), ou NULL se faltar memória.
+ */
+static const struct glob_dir *read_dir(struct glob_cache *cache, const char *path);
+
+/**
+ * @brief Se a entrada é um diretório; com `follow`, links simbólicos para diretórios também contam.
+ */
+static bool entry_is_dir(const char *base, const struct glob_entry *entry, bool follow);
+
+/**
+ * @brief `base` + '/' + `name` (sem '/' repetida; `base` vazio dá só `name`), com `suffix` no fim.
+ * @return Caminho na arena, ou NULL se faltar memória.
+ */
+static char *join_path(struct arena *arena, const char *base, const char *name, const char *suffix);
+
+/**
+ * @brief Acrescenta um caminho à lista.
+ * @return 0 em caso de sucesso, -1 se faltar memória.
+ */
+static int list_push(struct glob_list *list, const char *path);
+
+/**
+ * @brief Hash FNV-1a de um caminho.
+ */
+static uint64_t hash_path(const char *path);
+
+/**
+ * @brief Função de comparação de caminhos (`strcoll`).
+ */
+static int compare_paths(const void *a, const void *b);
+
+/*****************************************************************************/
+
+void glob_cache_init(struct glob_cache *cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+void glob_cache_free(struct glob_cache *cache) {
+    free(cache->slots);
+    arena_free(&cache->arena);
+    memset(cache, 0, sizeof(*cache));
+}
+
+long glob_expand(struct glob_cache *cache, struct arena *arena, const char *pattern, struct glob_paths *out) {
+    // Partes entre '/' (vazias ignoradas); '/' no início = caminho absoluto, no fim = só diretórios
+    const size_t len = strlen(pattern);
+    const bool absolute = pattern[0] == '/';
+    const bool trailing = len > 1 && pattern[len - 1] == '/';
+
+    size_t part_count = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (pattern[i] != '/' && (i == 0 || pattern[i - 1] == '/')) part_count++;
+    }
+    if (part_count == 0) return 0;
+
+    struct glob_component **parts = arena_alloc(&cache->arena, part_count * sizeof(struct glob_component *));
+    if (!parts) return -1;
+    size_t part = 0;
+    for (size_t i = 0; i < len;) {
+        if (pattern[i] == '/') {
+            i++;
+            continue;
+        }
+        const char *slash = memchr(pattern + i, '/', len - i);
+        const size_t end = slash ? (size_t) (slash - pattern) : len;
+        parts[part] = compile_component(&cache->arena, pattern + i, end - i);
+        if (!parts[part++]) return -1;
+        i = end;
+    }
+
+    struct glob_list bases = {0};
+    struct glob_list next = {0};
+    long result = -1;
+    if (list_push(&bases, absolute ? "/" : "") != 0) goto done;
+
+    for (part = 0; part < part_count; part++) {
+        const struct glob_component *component = parts[part];
+        const bool last = part + 1 == part_count;
+        // Os caminhos finais vão direto para a arena do comando; os intermediários ficam na do cache
+        struct arena *dest = last ? arena : &cache->arena;
+        const char *suffix = last && trailing ? "/" : "";
+        next.count = 0;
+
+        for (size_t b = 0; b < bases.count; b++) {
+            const char *base = bases.items[b];
+
+            if (component->literal) {
+                // Sem metacaracteres: nada a ler; só a última parte precisa existir
+                char *path = join_path(dest, base, component->literal, suffix);
+                if (!path) goto done;
+                struct stat st;
+                if (last && (trailing ? stat(path, &st) != 0 || !S_ISDIR(st.st_mode)
+                                      : fstatat(AT_FDCWD, path, &st, AT_SYMLINK_NOFOLLOW) != 0)) continue;
+                if (list_push(&next, path) != 0) goto done;
+                continue;
+            }
+
+            if (component->globstar) {
+                // `**`: a própria base e todos os subdiretórios (no meio) ou tudo abaixo dela (no fim)
+                struct glob_list stack = {0};
+                if (list_push(&stack, base) != 0) goto done;
+                if (last && base[0] != '\0') {
+                    // `src/**` também inclui `src/`, como no bash
+                    char *path = join_path(dest, base, "", "");
+                    if (!path || list_push(&next, path) != 0) {
+                        free(stack.items);
+                        goto done;
+                    }
+                }
+                while (stack.count > 0) {
+                    const char *dir_path = stack.items[--stack.count];
+                    if (!last && list_push(&next, dir_path) != 0) {
+                        free(stack.items);
+                        goto done;
+                    }
+                    const struct glob_dir *dir = read_dir(cache, dir_path);
+                    if (!dir) {
+                        free(stack.items);
+                        goto done;
+                    }
+                    for (size_t i = 0; i < dir->count; i++) {
+                        const struct glob_entry *entry = &dir->entries[i];
+                        if (entry->name[0] == '.') continue;
+                        const bool is_dir = entry->type == DT_DIR;
+                        if (!is_dir && !(last && !trailing)) continue;
+                        if (is_dir) {
+                            const char *child = join_path(&cache->arena, dir_path, entry->name, "");
+                            if (!child || list_push(&stack, child) != 0) {
+                                free(stack.items);
+                                goto done;
+                            }
+                        }
+                        if (last) {
+                            char *path = join_path(dest, dir_path, entry->name, suffix);
+                            if (!path || list_push(&next, path) != 0) {
+                                free(stack.items);
+                                goto done;
+                            }
+                        }
+                    }
+                }
+                free(stack.items);
+                continue;
+            }
+
+            const struct glob_dir *dir = read_dir(cache, base);
+            if (!dir) goto done;
+            for (size_t i = 0; i < dir->count; i++) {
+                const struct glob_entry *entry = &dir->entries[i];
+                if (entry->name[0] == '.' && !component->dot) continue;
+                if (!match_component(component, entry->name)) continue;
+                if ((!last || trailing) && !entry_is_dir(base, entry, true)) continue;
+                char *path = join_path(dest, base, entry->name, suffix);
+                if (!path || list_push(&next, path) != 0) goto done;
+            }
+        }
+
+        const struct glob_list swap = bases;
+        bases = next;
+        next = swap;
+        if (bases.count == 0) break;
+    }
+
+    // Resultado em ordem, como o bash (`strcoll`)
+    if (out->count + bases.count > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity : GLOB_INITIAL_PATHS;
+        while (capacity < out->count + bases.count) capacity *= 2;
+        char **paths = realloc(out->paths, capacity * sizeof(char *));
+        if (!paths) goto done;
+        out->paths = paths;
+        out->capacity = capacity;
+    }
+    memcpy(out->paths + out->count, bases.items, bases.count * sizeof(char *));
+    if (bases.count > 1) qsort(out->paths + out->count, bases.count, sizeof(char *), compare_paths);
+    out->count += bases.count;
+    result = (long) bases.count;
+
+done:
+    free(bases.items);
+    free(next.items);
+    return result;
+}
+
+bool glob_match(const char *pattern, const char *name) {
+    struct arena arena = {0};
+    const struct glob_component *component = compile_component(&arena, pattern, strlen(pattern));
+    bool matched = false;
+    if (component && (name[0] != '.' || component->dot)) {
+        matched = component->literal ? strcmp(component->literal, name) == 0 : match_component(component, name);
+    }
+    arena_free(&arena);
+    return matched;
+}
+
+/*****************************************************************************/
+
+static struct glob_component *compile_component(struct arena *arena, const char *pattern, const size_t len) {
+    struct glob_component *component = arena_alloc(arena, sizeof(struct glob_component));
+    if (!component) return NULL;
+    // Nunca há mais átomos que bytes, nem mais classes que metade dos bytes
+    component->atoms = arena_alloc(arena, (len + 1) * sizeof(struct glob_atom));
+    component->classes = arena_alloc(arena, (len / 2 + 1) * sizeof(struct glob_class));
+    char *literal = arena_alloc(arena, len + 1);
+    if (!component->atoms || !component->classes || !literal) return NULL;
+
+    size_t count = 0, classes = 0, literal_len = 0;
+    bool magic = false;
+    for (size_t i = 0; i < len;) {
+        struct glob_atom *atom = &component->atoms[count];
+        const char c = pattern[i];
+        if (c == '\\' && i + 1 < len) {
+            *atom = (struct glob_atom) {.kind = ATOM_CHAR, .ch = (unsigned char) pattern[i + 1]};
+            i += 2;
+        } else if (c == '*') {
+            i++;
+            magic = true;
+            if (count > 0 && component->atoms[count - 1].kind == ATOM_STAR) continue;
+            *atom = (struct glob_atom) {.kind = ATOM_STAR};
+        } else if (c == '?') {
+            *atom = (struct glob_atom) {.kind = ATOM_ANY};
+            magic = true;
+            i++;
+        } else if (c == '[') {
+            struct glob_class *cls = &component->classes[classes];
+            const size_t end = compile_class(pattern, i, len, cls);
+            if (end) {
+                *atom = (struct glob_atom) {.kind = ATOM_CLASS, .cls = (unsigned short) classes++};
+                magic = true;
+                i = end;
+            } else {
+                *atom = (struct glob_atom) {.kind = ATOM_CHAR, .ch = '['};
+                i++;
+            }
+        } else {
+            *atom = (struct glob_atom) {.kind = ATOM_CHAR, .ch = (unsigned char) c};
+            i++;
+        }
+        if (atom->kind == ATOM_CHAR) literal[literal_len++] = (char) atom->ch;
+        count++;
+    }
+    literal[literal_len] = '\0';
+
+    component->count = count;
+    component->literal = magic ? NULL : literal;
+    component->globstar = len == 2 && pattern[0] == '*' && pattern[1] == '*';
+    component->dot = count > 0 && component->atoms[0].kind == ATOM_CHAR && component->atoms[0].ch == '.';
+    return component;
+}
+
+static size_t compile_class(const char *pattern, const size_t start, const size_t len, struct glob_class *cls) {
+    memset(cls, 0, sizeof(*cls));
+    size_t i = start + 1;
+    bool negate = false;
+    if (i < len && (pattern[i] == '!' || pattern[i] == '^')) {
+        negate = true;
+        i++;
+    }
+
+    // ']' logo no início é literal
+    for (bool first = true; i < len; first = false) {
+        unsigned char c = (unsigned char) pattern[i];
+        if (c == ']' && !first) {
+            if (negate) {
+                for (size_t w = 0; w < 4; w++) cls->bits[w] = ~cls->bits[w];
+            }
+            return i + 1;
+        }
+
+        if (c == '[' && i + 1 < len && pattern[i + 1] == ':') {
+            const char *close = memmem(pattern + i + 2, len - i - 2, ":]", 2);
+            if (close && add_named_class(cls, pattern + i + 2, (size_t) (close - (pattern + i + 2)))) {
+                i = (size_t) (close - pattern) + 2;
+                continue;
+            }
+        }
+        if (c == '\\' && i + 1 < len) c = (unsigned char) pattern[++i];
+        i++;
+
+        unsigned char high = c;
+        if (i + 1 < len && pattern[i] == '-' && pattern[i + 1] != ']') {
+            i++;
+            if (pattern[i] == '\\' && i + 1 < len) i++;
+            high = (unsigned char) pattern[i++];
+        }
+        for (unsigned b = c; b <= high; b++) cls->bits[b >> 6] |= 1ull << (b & 63);
+    }
+    return 0;
+}
+
+static bool add_named_class(struct glob_class *cls, const char *name, const size_t len) {
+    static const struct {
+        const char *name;
+        int (*test)(int);
+    } named[] = {
+        {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank}, {"cntrl", iscntrl},
+        {"digit", isdigit}, {"graph", isgraph}, {"lower", islower}, {"print", isprint},
+        {"punct", ispunct}, {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit},
+    };
+    for (size_t i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+        if (strlen(named[i].name) != len || memcmp(named[i].name, name, len) != 0) continue;
+        for (unsigned b = 0; b < 256; b++) {
+            if (named[i].test((int) b)) cls->bits[b >> 6] |= 1ull << (b & 63);
+        }
+        return true;
+    }
+    return false;
+}
+
+static bool match_component(const struct glob_component *component, const char *name) {
+    const struct glob_atom *atoms = component->atoms;
+    const size_t count = component->count;
+    size_t p = 0, n = 0;
+    size_t star = SIZE_MAX, star_n = 0;
+
+    // Ao falhar, só o último `*` é retomado (um caractere adiante): os anteriores já casaram
+    // o menor trecho possível e nunca precisam ser revistos
+    while (name[n]) {
+        if (p < count) {
+            const struct glob_atom *atom = &atoms[p];
+            const unsigned char c = (unsigned char) name[n];
+            if (atom->kind == ATOM_STAR) {
+                star = p++;
+                star_n = n;
+                continue;
+            }
+            if ((atom->kind == ATOM_CHAR && atom->ch == c) || atom->kind == ATOM_ANY ||
+                (atom->kind == ATOM_CLASS && component->classes[atom->cls].bits[c >> 6] >> (c & 63) & 1)) {
+                p++;
+                n++;
+                continue;
+            }
+        }
+        if (star == SIZE_MAX) return false;
+        p = star + 1;
+        n = ++star_n;
+    }
+    while (p < count && atoms[p].kind == ATOM_STAR) p++;
+    return p == count;
+}
+
+static const struct glob_dir *read_dir(struct glob_cache *cache, const char *path) {
+    const uint64_t hash = hash_path(path);
+    if (cache->capacity) {
+        for (size_t slot = hash & (cache->capacity - 1);; slot = (slot + 1) & (cache->capacity - 1)) {
+            const struct glob_dir *dir = cache->slots[slot];
+            if (!dir) break;
+            if (dir->hash == hash && strcmp(dir->path, path) == 0) {
+                cache->hits++;
+                return dir;
+            }
+        }
+    }
+
+    // Crescer antes de passar de 70% de ocupação
+    if ((cache->count + 1) * 10 > cache->capacity * 7) {
+        const size_t capacity = cache->capacity ? cache->capacity * 2 : GLOB_INITIAL_SLOTS;
+        struct glob_dir **slots = calloc(capacity, sizeof(struct glob_dir *));
+        if (!slots) return NULL;
+        for (size_t i = 0; i < cache->capacity; i++) {
+            struct glob_dir *dir = cache->slots[i];
+            if (!dir) continue;
+            size_t slot = dir->hash & (capacity - 1);
+            while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+            slots[slot] = dir;
+        }
+        free(cache->slots);
+        cache->slots = slots;
+        cache->capacity = capacity;
+    }
+
+    struct glob_dir *dir = arena_alloc(&cache->arena, sizeof(struct glob_dir));
+    if (!dir) return NULL;
+    *dir = (struct glob_dir) {.path = path, .hash = hash};
+    cache->reads++;
+
+    // Diretório ilegível ou inexistente: listagem vazia (guardada também, para não tentar de novo)
+    struct dir_reader reader;
+    if (dir_reader_open(&reader, path[0] ? path : ".") == 0) {
+        struct glob_entry *entries = NULL;
+        size_t capacity = 0;
+        const struct dirent64 *entry;
+        while ((entry = dir_reader_next(&reader))) {
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            if (dir->count == capacity) {
+                capacity = capacity ? capacity * 2 : GLOB_INITIAL_PATHS;
+                struct glob_entry *grown = realloc(entries, capacity * sizeof(struct glob_entry));
+                if (!grown) break;
+                entries = grown;
+            }
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                if (fstatat(reader.fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) type = IFTODT(st.st_mode);
+            }
+            const char *copy = arena_strndup(&cache->arena, name, strlen(name));
+            if (!copy) break;
+            entries[dir->count++] = (struct glob_entry) {.name = copy, .type = type};
+        }
+        dir_reader_close(&reader);
+
+        dir->entries = arena_alloc(&cache->arena, (dir->count ? dir->count : 1) * sizeof(struct glob_entry));
+        if (dir->entries && dir->count) memcpy(dir->entries, entries, dir->count * sizeof(struct glob_entry));
+        free(entries);
+        if (!dir->entries) return NULL;
+    }
+
+    size_t slot = hash & (cache->capacity - 1);
+    while (cache->slots[slot]) slot = (slot + 1) & (cache->capacity - 1);
+    cache->slots[slot] = dir;
+    cache->count++;
+    return dir;
+}
+
+static bool entry_is_dir(const char *base, const struct glob_entry *entry, const bool follow) {
+    if (entry->type == DT_DIR) return true;
+    if (!follow || entry->type != DT_LNK) return false;
+
+    char local[4096];
+    struct arena arena = {0};
+    const size_t needed = strlen(base) + strlen(entry->name) + 2;
+    char *path = needed <= sizeof(local) ? local : arena_alloc(&arena, needed);
+    bool is_dir = false;
+    if (path) {
+        if (!base[0]) {
+            strcpy(path, entry->name);
+        } else {
+            const size_t base_len = strlen(base);
+            memcpy(path, base, base_len);
+            size_t len = base_len;
+            if (base[base_len - 1] != '/') path[len++] = '/';
+            strcpy(path + len, entry->name);
+        }
+        struct stat st;
+        is_dir = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+    }
+    arena_free(&arena);
+    return is_dir;
+}
+
+static char *join_path(struct arena *arena, const char *base, const char *name, const char *suffix) {
+    const size_t base_len = strlen(base);
+    const size_t name_len = strlen(name);
+    const size_t suffix_len = strlen(suffix);
+    const bool separator = base_len > 0 && base[base_len - 1] != '/';
+
+    char *path = arena_alloc(arena, base_len + separator + name_len + suffix_len + 1);
+    if (!path) return NULL;
+    memcpy(path, base, base_len);
+    size_t len = base_len;
+    if (separator) path[len++] = '/';
+    memcpy(path + len, name, name_len);
+    memcpy(path + len + name_len, suffix, suffix_len + 1);
+    return path;
+}
+
+static int list_push(struct glob_list *list, const char *path) {
+    if (list->count == list->capacity) {
+        const size_t capacity = list->capacity ? list->capacity * 2 : GLOB_INITIAL_PATHS;
+        const char **items = realloc(list->items, capacity * sizeof(const char *));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = path;
+    return 0;
+}
+
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char *p = (const unsigned char *) path; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcoll(*(char *const *) a, *(char *const *) b);
+}
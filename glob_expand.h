@@ -0,0 +1,77 @@
+//
+// Expansão de padrões de nomes de arquivo (`*`, `?`, `[...]`, `**`) nos argumentos dos comandos.
+//
+
+#ifndef GLOB_EXPAND_H
+#define GLOB_EXPAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+/**
+ * @brief Diretórios já lidos durante a expansão de um comando.
+ *
+ * Vários padrões do mesmo comando (ou `**` seguido de `*.c`) que passam pelo
+ * mesmo diretório o leem uma única vez. Os nomes ficam na arena do cache,
+ * descartada com `glob_cache_free` ao fim da expansão.
+ */
+struct glob_cache {
+    struct glob_dir **slots;  // Tabela aberta por caminho
+    size_t capacity;          // Potência de 2 (0 = vazia)
+    size_t count;
+    struct arena arena;       // Nomes, listagens, padrões compilados e caminhos intermediários
+    size_t reads;             // Diretórios lidos
+    size_t hits;              // Leituras evitadas pelo cache
+};
+
+/**
+ * @brief Caminhos resultantes da expansão (vetor com malloc, reaproveitado entre chamadas).
+ */
+struct glob_paths {
+    char **paths;             // Strings na arena dada a `glob_expand`
+    size_t count;
+    size_t capacity;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Prepara um cache vazio.
+ * @param cache Cache.
+ */
+void glob_cache_init(struct glob_cache *cache);
+
+/**
+ * @brief Libera as listagens e a arena do cache.
+ * @param cache Cache.
+ */
+void glob_cache_free(struct glob_cache *cache);
+
+/**
+ * @brief Acrescenta a `out` os caminhos que casam com `pattern`, em ordem (`strcoll`).
+ *
+ * Cada parte do caminho é compilada em uma sequência de átomos (caractere,
+ * `?`, classe `[...]` como mapa de 256 bits, `*`) e casada com um único ponto
+ * de retomada no último `*`: tempo O(padrão × nome), sem a explosão
+ * exponencial do retrocesso ingênuo em padrões como `*a*a*a*b`. Nomes
+ * iniciados por '.' só casam com uma parte que começa com '.', e `**` (parte
+ * inteira) desce por todos os subdiretórios sem seguir links simbólicos.
+ * @param cache Diretórios já lidos neste comando.
+ * @param arena Arena dos caminhos resultantes.
+ * @param pattern Padrão; `\` protege o caractere seguinte (trechos entre aspas na linha).
+ * @param out Vetor ao qual os caminhos são acrescentados.
+ * @return Quantidade de caminhos acrescentados (0 = nenhum casou), ou -1 se faltar memória.
+ */
+long glob_expand(struct glob_cache *cache, struct arena *arena, const char *pattern, struct glob_paths *out);
+
+/**
+ * @brief Se um nome casa com um padrão de uma parte só (sem '/'), como o `fnmatch`.
+ * @param pattern Padrão (`*`, `?`, `[...]`, `\`).
+ * @param name Nome.
+ * @return true se casa (nomes ocultos seguem a mesma regra de `glob_expand`).
+ */
+bool glob_match(const char *pattern, const char *name);
+
+#endif //GLOB_EXPAND_H
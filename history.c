@@ -0,0 +1,427 @@
+#include "history.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HISTORY_INITIAL_CAPACITY 256
+
+/*****************************************************************************/
+
+struct entry {
+    const char *text;   // No mapeamento do arquivo ou alocada (entradas desta sessão)
+    uint32_t len;
+};
+
+/**
+ * @brief Índice invertido: balde do trigrama -> blocos (crescentes) com o trigrama, em formato CSR.
+ *
+ * Trigramas diferentes podem cair no mesmo balde; o memmem final descarta os falsos candidatos.
+ */
+struct trigram_index {
+    uint32_t *offsets;      // HISTORY_BUCKETS + 1
+    uint16_t *postings;
+    size_t indexed;         // Entradas cobertas (as primeiras)
+    double ms;
+};
+
+// Construção inicial em segundo plano, sobre uma cópia do vetor de entradas
+struct index_build {
+    struct entry *snapshot;
+    size_t count;
+    struct trigram_index index;
+    int result;
+    atomic_bool done;
+    pthread_t thread;
+};
+
+/*****************************************************************************/
+
+static struct entry *entries = NULL;
+static size_t count = 0;
+static size_t capacity = 0;
+
+static int history_fd = -1;
+static char *map = NULL;
+static size_t map_size = 0;
+
+static struct trigram_index trigrams = {0};
+static struct index_build *pending = NULL;
+
+/*****************************************************************************/
+
+/**
+ * @brief Acrescenta uma entrada ao vetor.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int push(const char *text, size_t len);
+
+/**
+ * @brief Separa o arquivo mapeado em entradas, mantendo as HISTORY_MAX_ENTRIES mais recentes.
+ */
+static void load_entries(void);
+
+/**
+ * @brief Constrói o índice de trigramas das entradas `list[0..n)`.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação (ou entradas demais).
+ */
+static int build_index(const struct entry *list, size_t n, struct trigram_index *out);
+
+/**
+ * @brief Corpo da thread que constrói o índice inicial.
+ */
+static void *build_thread(void *arg);
+
+/**
+ * @brief Instala o índice da thread, se ela já terminou (ou esperando por ela, se `wait`).
+ * @return true se não há mais construção pendente.
+ */
+static bool collect_build(bool wait);
+
+/**
+ * @brief Troca o índice atual por `next` (liberando o anterior).
+ */
+static void install_index(struct trigram_index *next);
+
+/**
+ * @brief Balde do trigrama que começa em `p`.
+ */
+static uint32_t bucket_of(const char *p);
+
+/**
+ * @brief Procura `query` nas entradas [low, high), das mais novas para as mais antigas.
+ */
+static bool scan(const char *query, size_t query_len, size_t low, size_t high, size_t *index);
+
+/**
+ * @brief Indica se a lista `[first, last)` contém `block` (busca binária).
+ */
+static bool contains(const uint16_t *first, const uint16_t *last, uint16_t block);
+
+/**
+ * @brief Indica se a entrada pertence ao mapeamento do arquivo (e não deve ser liberada).
+ */
+static bool is_mapped(const char *text);
+
+/*****************************************************************************/
+
+int history_init(const char *path) {
+    char default_path[PATH_MAX];
+    if (!path) path = getenv(HISTORY_FILE_ENV);
+    if (!path) {
+        const char *home = getenv("HOME");
+        if (!home) return -1;
+        snprintf(default_path, sizeof(default_path), "%s/%s", home, HISTORY_FILE_NAME);
+        path = default_path;
+    }
+
+    history_fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (history_fd < 0) return -1;
+
+    // Mapeamento privado e só de leitura: as linhas que outros shells acrescentarem não o alteram
+    struct stat st;
+    if (fstat(history_fd, &st) != 0) return -1;
+    if (st.st_size > 0) {
+        map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, history_fd, 0);
+        if (map == MAP_FAILED) {
+            map = NULL;
+            return -1;
+        }
+        map_size = (size_t) st.st_size;
+        load_entries();
+    }
+
+    // Um histórico grande leva centenas de ms para indexar: isso não pode atrasar o primeiro prompt
+    if (count > HISTORY_TAIL_MAX) {
+        struct index_build *build = calloc(1, sizeof(struct index_build));
+        if (build) build->snapshot = malloc(count * sizeof(struct entry));
+        if (build && build->snapshot) {
+            memcpy(build->snapshot, entries, count * sizeof(struct entry));
+            build->count = count;
+            atomic_init(&build->done, false);
+            if (pthread_create(&build->thread, NULL, build_thread, build) == 0) {
+                pending = build;
+                return 0;
+            }
+        }
+        if (build) free(build->snapshot);
+        free(build);
+    }
+    return 0;
+}
+
+void history_add(const char *line) {
+    const size_t len = strlen(line);
+    if (len == 0 || len > UINT32_MAX - 1) return;
+    if (count > 0 && entries[count - 1].len == len && memcmp(entries[count - 1].text, line, len) == 0) return;
+
+    char *text = malloc(len + 1);
+    if (!text) return;
+    memcpy(text, line, len);
+    text[len] = '\n';
+
+    // Uma única escrita em O_APPEND: a linha inteira vai para o fim, mesmo com outros shells escrevendo
+    if (history_fd >= 0) {
+        ssize_t written;
+        do {
+            written = write(history_fd, text, len + 1);
+        } while (written < 0 && errno == EINTR);
+    }
+    if (push(text, len) != 0) free(text);
+}
+
+size_t history_count(void) {
+    return count;
+}
+
+const char *history_get(const size_t index, size_t *len) {
+    if (index >= count) return NULL;
+    *len = entries[index].len;
+    return entries[index].text;
+}
+
+bool history_search(const char *query, size_t before, size_t *found) {
+    const size_t query_len = strlen(query);
+    if (query_len == 0) return false;
+    if (before > count) before = count;
+
+    // Índice ainda em construção: percorrer tudo (a busca não espera a thread)
+    if (query_len < 3 || !collect_build(false)) return scan(query, query_len, 0, before, found);
+
+    // Entradas novas demais fora do índice: refazer (custa uma passada pelo texto)
+    if (count - trigrams.indexed > HISTORY_TAIL_MAX || (!trigrams.postings && count > 0)) {
+        struct trigram_index next;
+        if (build_index(entries, count, &next) != 0) return scan(query, query_len, 0, before, found);
+        install_index(&next);
+    }
+
+    // Entradas acrescentadas depois do índice: as mais novas, buscadas direto
+    const size_t indexed = trigrams.indexed;
+    if (before > indexed && scan(query, query_len, indexed, before, found)) return true;
+    const size_t limit = before < indexed ? before : indexed;
+    if (limit == 0) return false;
+
+    // Listas dos trigramas da consulta (sem repetição), da menor para a maior
+    uint32_t buckets[64];
+    const uint16_t *firsts[64];
+    const uint16_t *lasts[64];
+    size_t lists = 0;
+    for (size_t i = 0; i + 3 <= query_len && lists < 64; i++) {
+        const uint32_t bucket = bucket_of(query + i);
+        bool seen = false;
+        for (size_t j = 0; j < lists && !seen; j++) seen = buckets[j] == bucket;
+        if (seen) continue;
+
+        const uint16_t *first = trigrams.postings + trigrams.offsets[bucket];
+        const uint16_t *last = trigrams.postings + trigrams.offsets[bucket + 1];
+        size_t j = lists++;
+        for (; j > 0 && lasts[j - 1] - firsts[j - 1] > last - first; j--) {
+            buckets[j] = buckets[j - 1];
+            firsts[j] = firsts[j - 1];
+            lasts[j] = lasts[j - 1];
+        }
+        buckets[j] = bucket;
+        firsts[j] = first;
+        lasts[j] = last;
+    }
+
+    // Percorre a menor lista do bloco mais novo para o mais antigo; as demais só confirmam
+    const uint16_t last_block = (uint16_t) ((limit - 1) / HISTORY_BLOCK);
+    const uint16_t *cursor = firsts[0];
+    for (const uint16_t *high = lasts[0]; cursor < high;) {
+        const uint16_t *middle = cursor + (high - cursor) / 2;
+        if (*middle <= last_block) cursor = middle + 1;
+        else high = middle;
+    }
+    while (cursor > firsts[0]) {
+        const uint16_t block = *--cursor;
+        bool candidate = true;
+        for (size_t j = 1; j < lists && candidate; j++) candidate = contains(firsts[j], lasts[j], block);
+        if (!candidate) continue;
+
+        const size_t low = (size_t) block * HISTORY_BLOCK;
+        const size_t high = low + HISTORY_BLOCK < limit ? low + HISTORY_BLOCK : limit;
+        if (scan(query, query_len, low, high, found)) return true;
+    }
+    return false;
+}
+
+struct history_stats history_get_stats(void) {
+    collect_build(false);
+    struct history_stats stats = {
+        .entries = count,
+        .indexed = trigrams.indexed,
+        .postings = trigrams.offsets ? trigrams.offsets[HISTORY_BUCKETS] : 0,
+        .index_ms = trigrams.ms,
+    };
+    return stats;
+}
+
+void history_free(void) {
+    collect_build(true);
+    for (size_t i = 0; i < count; i++) {
+        if (!is_mapped(entries[i].text)) free((char *) entries[i].text);
+    }
+    free(entries);
+    install_index(&(struct trigram_index) {0});
+    if (map) munmap(map, map_size);
+    if (history_fd >= 0) close(history_fd);
+    entries = NULL;
+    map = NULL;
+    count = capacity = map_size = 0;
+    history_fd = -1;
+}
+
+/*****************************************************************************/
+
+static int push(const char *text, const size_t len) {
+    if (count == capacity) {
+        const size_t new_capacity = capacity ? capacity * 2 : HISTORY_INITIAL_CAPACITY;
+        struct entry *new_entries = realloc(entries, new_capacity * sizeof(struct entry));
+        if (!new_entries) return -1;
+        entries = new_entries;
+        capacity = new_capacity;
+    }
+    entries[count].text = text;
+    entries[count].len = (uint32_t) len;
+    count++;
+    return 0;
+}
+
+static void load_entries(void) {
+    const char *p = map;
+    const char *end = map + map_size;
+    while (p < end) {
+        const char *newline = memchr(p, '\n', (size_t) (end - p));
+        const char *line_end = newline ? newline : end;
+        if (line_end > p && line_end - p <= UINT32_MAX && push(p, (size_t) (line_end - p)) != 0) break;
+        p = line_end + 1;
+    }
+
+    if (count > HISTORY_MAX_ENTRIES) {
+        memmove(entries, entries + count - HISTORY_MAX_ENTRIES, HISTORY_MAX_ENTRIES * sizeof(struct entry));
+        count = HISTORY_MAX_ENTRIES;
+    }
+}
+
+static int build_index(const struct entry *list, const size_t n, struct trigram_index *out) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    const size_t blocks = (n + HISTORY_BLOCK - 1) / HISTORY_BLOCK;
+    if (blocks > UINT16_MAX + 1) return -1;
+
+    uint32_t *offsets = calloc(HISTORY_BUCKETS + 1, sizeof(uint32_t));
+    uint32_t *seen = malloc(HISTORY_BUCKETS * sizeof(uint32_t));
+    uint16_t *postings = NULL;
+    if (!offsets || !seen) goto fail;
+
+    // Duas passadas: contar os pares (balde, bloco) distintos e depois preencher as listas,
+    // já em ordem crescente de bloco. `seen` guarda o último bloco visto em cada balde.
+    for (int pass = 0; pass < 2; pass++) {
+        memset(seen, 0xff, HISTORY_BUCKETS * sizeof(uint32_t));
+        for (size_t block = 0; block < blocks; block++) {
+            const size_t last = (block + 1) * HISTORY_BLOCK < n ? (block + 1) * HISTORY_BLOCK : n;
+            for (size_t i = block * HISTORY_BLOCK; i < last; i++) {
+                const char *text = list[i].text;
+                for (size_t j = 0; j + 3 <= list[i].len; j++) {
+                    const uint32_t bucket = bucket_of(text + j);
+                    if (seen[bucket] == block) continue;
+                    seen[bucket] = (uint32_t) block;
+                    if (pass == 0) offsets[bucket + 1]++;
+                    else postings[offsets[bucket]++] = (uint16_t) block;
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (size_t i = 0; i < HISTORY_BUCKETS; i++) offsets[i + 1] += offsets[i];
+            postings = malloc(((size_t) offsets[HISTORY_BUCKETS] + 1) * sizeof(uint16_t));
+            if (!postings) goto fail;
+        }
+    }
+    free(seen);
+
+    // A segunda passada avançou cada início até o início do balde seguinte: voltar uma posição
+    memmove(offsets + 1, offsets, HISTORY_BUCKETS * sizeof(uint32_t));
+    offsets[0] = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    out->offsets = offsets;
+    out->postings = postings;
+    out->indexed = n;
+    out->ms = (double) (end.tv_sec - start.tv_sec) * 1e3 + (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+    return 0;
+
+fail:
+    free(offsets);
+    free(seen);
+    free(postings);
+    return -1;
+}
+
+static void *build_thread(void *arg) {
+    struct index_build *build = arg;
+    build->result = build_index(build->snapshot, build->count, &build->index);
+    atomic_store_explicit(&build->done, true, memory_order_release);
+    return NULL;
+}
+
+static bool collect_build(const bool wait) {
+    if (!pending) return true;
+    if (!wait && !atomic_load_explicit(&pending->done, memory_order_acquire)) return false;
+
+    pthread_join(pending->thread, NULL);
+    if (pending->result == 0) install_index(&pending->index);
+    free(pending->snapshot);
+    free(pending);
+    pending = NULL;
+    return true;
+}
+
+static void install_index(struct trigram_index *next) {
+    free(trigrams.offsets);
+    free(trigrams.postings);
+    trigrams = *next;
+}
+
+static uint32_t bucket_of(const char *p) {
+    const uint32_t key = (uint32_t) (unsigned char) p[0] << 16 | (uint32_t) (unsigned char) p[1] << 8 |
+                         (uint32_t) (unsigned char) p[2];
+    return (key * 2654435761u) >> (32 - HISTORY_BUCKET_BITS);
+}
+
+static bool scan(const char *query, const size_t query_len, const size_t low, size_t high, size_t *index) {
+    while (high > low) {
+        high--;
+        if (entries[high].len >= query_len && memmem(entries[high].text, entries[high].len, query, query_len)) {
+            *index = high;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool contains(const uint16_t *first, const uint16_t *last, const uint16_t block) {
+    while (first < last) {
+        const uint16_t *middle = first + (last - first) / 2;
+        if (*middle < block) first = middle + 1;
+        else if (*middle > block) last = middle;
+        else return true;
+    }
+    return false;
+}
+
+static bool is_mapped(const char *text) {
+    return map && text >= map && text < map + map_size;
+}
@@ -0,0 +1,88 @@
+//
+// Histórico de comandos persistente (arquivo só de acréscimo, lido com mmap) com busca reversa indexada.
+//
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Arquivo do histórico: $T1_HISTFILE, ou ~/.t1_history
+#define HISTORY_FILE_ENV "T1_HISTFILE"
+#define HISTORY_FILE_NAME ".t1_history"
+
+// Entradas carregadas do arquivo (as mais recentes)
+#define HISTORY_MAX_ENTRIES (1 << 20)
+
+// Entradas por bloco do índice de trigramas e quantidade de baldes do índice.
+// Os blocos são numerados em 16 bits: o índice cobre até 65536 * HISTORY_BLOCK entradas.
+#define HISTORY_BLOCK 64
+#define HISTORY_BUCKET_BITS 17
+#define HISTORY_BUCKETS (1 << HISTORY_BUCKET_BITS)
+
+// Entradas novas buscadas sem índice antes de o índice ser refeito
+#define HISTORY_TAIL_MAX 4096
+
+struct history_stats {
+    size_t entries;
+    size_t indexed;         // Entradas cobertas pelo índice
+    size_t postings;        // Pares (balde, bloco) no índice
+    double index_ms;        // Duração da última construção do índice
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Carrega o histórico do arquivo (mmap) e abre o arquivo para acréscimos.
+ *
+ * O índice de busca é construído em uma thread; até ficar pronto, a busca percorre as entradas.
+ * @param path Arquivo (NULL = $T1_HISTFILE ou ~/.t1_history).
+ * @return 0 em caso de sucesso, -1 em caso de erro (o histórico fica só na memória).
+ */
+int history_init(const char *path);
+
+/**
+ * @brief Acrescenta uma linha ao histórico (e ao arquivo, com um único write em O_APPEND).
+ *
+ * Vários shells podem acrescentar ao mesmo arquivo ao mesmo tempo: cada linha é
+ * escrita inteira no fim do arquivo. Linhas vazias e repetições da anterior são ignoradas.
+ * @param line Linha sem '\n'.
+ */
+void history_add(const char *line);
+
+/**
+ * @brief Quantidade de entradas.
+ */
+size_t history_count(void);
+
+/**
+ * @brief Entrada `index` (0 = mais antiga).
+ * @param len Recebe o tamanho (a entrada não termina em '\0').
+ * @return Texto da entrada, ou NULL se `index` for inválido.
+ */
+const char *history_get(size_t index, size_t *len);
+
+/**
+ * @brief Procura, das mais novas para as mais antigas, a entrada que contém `query`.
+ *
+ * Consultas com 3 bytes ou mais usam o índice de trigramas: só os blocos que têm
+ * todos os trigramas da consulta são verificados com memmem.
+ * @param query Texto procurado.
+ * @param before Procura só entradas com índice menor que este (history_count() = todas).
+ * @param index Recebe o índice da entrada encontrada.
+ * @return true se encontrou.
+ */
+bool history_search(const char *query, size_t before, size_t *index);
+
+/**
+ * @brief Contadores do histórico e do índice.
+ */
+struct history_stats history_get_stats(void);
+
+/**
+ * @brief Libera o histórico e fecha o arquivo.
+ */
+void history_free(void);
+
+#endif //HISTORY_H
@@ -0,0 +1,121 @@
+#include "input.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "jobs.h"
+
+/*****************************************************************************/
+
+static int input_fd = STDIN_FILENO;
+static char *buffer = NULL;
+static size_t capacity = 0;
+static size_t start = 0;
+static size_t end = 0;
+static size_t scanned = 0;    // Bytes a partir de `start` já verificados (sem '\n')
+static bool at_eof = false;
+
+/*****************************************************************************/
+
+/**
+ * @brief Lê mais dados da entrada para o fim do buffer (crescendo se estiver cheio).
+ * @param timeout_ms Espera máxima (negativo = sem limite, atendendo os jobs enquanto isso).
+ * @return 1 se leu algo, 0 no fim da entrada, INPUT_TIMEOUT se o tempo acabou.
+ */
+static int fill(int timeout_ms);
+
+/*****************************************************************************/
+
+void input_set_fd(const int fd) {
+    input_fd = fd;
+    start = end = scanned = 0;
+    at_eof = false;
+}
+
+char *input_next_line(size_t *len) {
+    while (true) {
+        // Só procura o '\n' nos bytes novos: uma linha longa chega em vários reads
+        char *line = buffer + start;
+        const char *newline = end > start ? memchr(line + scanned, '\n', end - start - scanned) : NULL;
+        if (newline) {
+            *len = (size_t) (newline - line);
+            line[*len] = '\0';
+            start += *len + 1;
+            scanned = 0;
+            return line;
+        }
+        scanned = end - start;
+
+        if (fill(-1) == 0) {
+            if (end == start) return NULL;
+            // Última linha sem '\n': fill deixou um byte livre para o terminador
+            line = buffer + start;
+            *len = end - start;
+            line[*len] = '\0';
+            start = end;
+            scanned = 0;
+            return line;
+        }
+    }
+}
+
+int input_read_byte(const int timeout_ms) {
+    while (start == end) {
+        const int result = fill(timeout_ms);
+        if (result == 0) return INPUT_EOF;
+        if (result == INPUT_TIMEOUT) return INPUT_TIMEOUT;
+    }
+    if (scanned > 0) scanned--;
+    return (unsigned char) buffer[start++];
+}
+
+/*****************************************************************************/
+
+static int fill(const int timeout_ms) {
+    if (at_eof) return 0;
+
+    // Espaço no fim do buffer: descartar o que já foi consumido e, se ainda faltar, crescer
+    if (start > 0) {
+        memmove(buffer, buffer + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (capacity - end < INPUT_CHUNK / 2) {
+        const size_t new_capacity = capacity ? capacity * 2 : INPUT_CHUNK;
+        char *new_buffer = realloc(buffer, new_capacity);
+        if (!new_buffer) {
+            at_eof = true;
+            return 0;
+        }
+        buffer = new_buffer;
+        capacity = new_capacity;
+    }
+
+    while (true) {
+        if (timeout_ms < 0) {
+            if (jobs_wait_readable(input_fd) != 0) {
+                at_eof = true;
+                return 0;
+            }
+        } else {
+            struct pollfd pfd = {.fd = input_fd, .events = POLLIN};
+            const int ready = poll(&pfd, 1, timeout_ms);
+            if (ready == 0) return INPUT_TIMEOUT;
+            if (ready < 0 && errno == EINTR) continue;
+        }
+
+        // Um byte fica livre para o '\0' da última linha sem '\n'
+        const ssize_t len = read(input_fd, buffer + end, capacity - end - 1);
+        if (len < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (len <= 0) {
+            at_eof = true;
+            return 0;
+        }
+        end += (size_t) len;
+        return 1;
+    }
+}
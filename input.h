@@ -0,0 +1,43 @@
+//
+// Leitura de linhas da entrada (terminal, pipe ou script), atendendo os eventos de jobs enquanto espera.
+//
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+
+// Bytes pedidos por read (o buffer cresce além disso para caber uma linha longa)
+#define INPUT_CHUNK (64 * 1024)
+
+// Retornos de `input_read_byte` além do próprio byte
+#define INPUT_EOF (-1)
+#define INPUT_TIMEOUT (-2)
+
+/**
+ * @brief Troca o descritor de entrada (padrão: STDIN_FILENO), descartando o que estava no buffer.
+ * @param fd Descritor aberto (ex.: o arquivo do script).
+ */
+void input_set_fd(int fd);
+
+/**
+ * @brief Próxima linha da entrada, sem limite de tamanho.
+ *
+ * Enquanto não há uma linha completa, espera a entrada com `jobs_wait_readable`,
+ * então jobs em segundo plano são recolhidos mesmo com o shell parado no prompt.
+ * @param len Recebe o tamanho da linha (sem o '\n').
+ * @return A linha, terminada em '\0' no próprio buffer (válida até a próxima leitura),
+ * ou NULL no fim da entrada (ou erro).
+ */
+char *input_next_line(size_t *len);
+
+/**
+ * @brief Lê um byte da entrada (usado pelo editor de linha, em modo raw).
+ *
+ * Divide o buffer com `input_next_line`: nada digitado antes de trocar de modo se perde.
+ * @param timeout_ms Espera máxima em ms (negativo = sem limite, atendendo os jobs enquanto espera).
+ * @return O byte (0 a 255), INPUT_EOF ou INPUT_TIMEOUT.
+ */
+int input_read_byte(int timeout_ms);
+
+#endif //INPUT_H
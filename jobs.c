@@ -0,0 +1,663 @@
+#include "jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+#include "stats.h"
+
+#define JOBS_INITIAL_CAPACITY 16
+
+/*****************************************************************************/
+
+static struct job **table = NULL;
+static size_t count = 0;
+static size_t capacity = 0;
+static unsigned long sequence = 0;
+
+static int signal_fd = -1;
+static int epoll_fd = -1;
+static int epoll_input = -1;      // Descritor de entrada registrado no epoll
+static bool interactive = false;
+static pid_t shell_pgid = 0;
+static struct termios shell_tmodes;
+static struct job *foreground = NULL;
+
+/**
+ * @brief Status de um filho recolhido antes de o seu job ser registrado.
+ *
+ * Um comando interno no fim do pipeline (`true | wait`) roda antes do
+ * `jobs_add` dos irmãos; o wait4(-1) dele pode recolhê-los nesse intervalo.
+ */
+struct pending {
+    pid_t pid;
+    int status;
+    struct rusage usage;
+};
+
+static struct pending *pending = NULL;
+static size_t pending_count = 0;
+static size_t pending_capacity = 0;
+
+/*****************************************************************************/
+
+/**
+ * @brief Atualiza o job dono de `pid` com um status de wait4 (e soma o uso de recursos se terminou).
+ */
+static void update(pid_t pid, int status, const struct rusage *usage);
+
+/**
+ * @brief Recalcula o estado do job a partir dos estados dos processos.
+ */
+static void update_state(struct job *job);
+
+/**
+ * @brief Guarda o status de um PID sem job até o `jobs_add` dele (o último status vale).
+ */
+static void keep_pending(pid_t pid, int status, const struct rusage *usage);
+
+/**
+ * @brief Remove o job da tabela e libera a memória.
+ */
+static void remove_job(struct job *job);
+
+/**
+ * @brief Envia um sinal ao grupo do job (ou a cada processo, sem controle de jobs).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int signal_job(const struct job *job, int sig);
+
+/**
+ * @brief Marca os processos parados como em execução e envia SIGCONT.
+ */
+static void continue_job(struct job *job);
+
+/**
+ * @brief Procura um job por especificação: `%N`, `N`, `%%`, `%+` (atual) ou `%-` (anterior).
+ * @param spec Especificação (NULL = job atual).
+ * @return O job, ou NULL se não existir.
+ */
+static struct job *find_job(const char *spec);
+
+/**
+ * @brief Procura o job que contém `pid`.
+ */
+static struct job *find_pid(pid_t pid);
+
+/**
+ * @brief Job atual (`+`) ou anterior (`-`): os dois mais recentes em segundo plano.
+ */
+static struct job *current_job(bool previous);
+
+/**
+ * @brief Exibe uma linha do `jobs` / aviso de mudança de estado.
+ */
+static void print_job(const struct job *job, bool show_pids);
+
+/**
+ * @brief Converte um status de waitpid em código de saída (128 + sinal se morto ou parado).
+ */
+static int exit_code(int status);
+
+/**
+ * @brief Converte um nome (TERM, SIGTERM) ou número em sinal.
+ * @return Número do sinal, ou -1 se inválido.
+ */
+static int parse_signal(const char *name);
+
+/*****************************************************************************/
+
+int jobs_init(const bool want_terminal) {
+    // SIGCHLD chega pelo signalfd: nada roda em handler, nenhum status se perde
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &set, NULL) != 0) return -1;
+    signal_fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || epoll_fd < 0) return -1;
+
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = signal_fd};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &event) != 0) return -1;
+
+    shell_pgid = getpgrp();
+    interactive = want_terminal && isatty(STDIN_FILENO);
+    if (!interactive) return 0;
+
+    // Esperar o shell estar em primeiro plano antes de tomar o terminal
+    while (tcgetpgrp(STDIN_FILENO) != (shell_pgid = getpgrp())) kill(-shell_pgid, SIGTTIN);
+
+    signal(SIGINT, SIG_IGN);
+    signal(SIGQUIT, SIG_IGN);
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);
+
+    // Grupo próprio (falha com EPERM se o shell já lidera a sessão, e aí já lidera o grupo)
+    if (setpgid(0, 0) == 0) shell_pgid = getpid();
+    tcsetpgrp(STDIN_FILENO, shell_pgid);
+    tcgetattr(STDIN_FILENO, &shell_tmodes);
+    return 0;
+}
+
+bool jobs_interactive(void) {
+    return interactive;
+}
+
+pid_t jobs_shell_pgid(void) {
+    return shell_pgid;
+}
+
+void jobs_child_signals(sigset_t *set) {
+    sigemptyset(set);
+    sigaddset(set, SIGINT);
+    sigaddset(set, SIGQUIT);
+    sigaddset(set, SIGTSTP);
+    sigaddset(set, SIGTTIN);
+    sigaddset(set, SIGTTOU);
+    sigaddset(set, SIGCHLD);
+    sigaddset(set, SIGPIPE);
+}
+
+void jobs_child_setup(const pid_t pgid) {
+    if (interactive && pgid >= 0) setpgid(0, pgid);
+
+    sigset_t set;
+    jobs_child_signals(&set);
+    for (int sig = 1; sig < NSIG; sig++) {
+        if (sigismember(&set, sig) == 1) signal(sig, SIG_DFL);
+    }
+    sigemptyset(&set);
+    sigprocmask(SIG_SETMASK, &set, NULL);
+}
+
+struct job *jobs_add(const pid_t pgid, const pid_t *pids, const size_t proc_count, const char *command) {
+    if (count == capacity) {
+        const size_t new_capacity = capacity ? capacity * 2 : JOBS_INITIAL_CAPACITY;
+        struct job **new_table = realloc(table, new_capacity * sizeof(struct job *));
+        if (!new_table) return NULL;
+        table = new_table;
+        capacity = new_capacity;
+    }
+
+    struct job *job = calloc(1, sizeof(struct job));
+    if (!job) return NULL;
+    job->pids = malloc(proc_count * sizeof(pid_t));
+    job->statuses = calloc(proc_count, sizeof(int));
+    job->states = calloc(proc_count, sizeof(enum job_state));
+    job->command = strdup(command ? command : "");
+    if (job->command) {
+        // O `&` final não faz parte do comando: `jobs`/`bg` o exibem conforme o estado
+        size_t len = strlen(job->command);
+        while (len > 0 && (job->command[len - 1] == ' ' || job->command[len - 1] == '\t')) len--;
+        if (len > 0 && job->command[len - 1] == '&') len--;
+        while (len > 0 && (job->command[len - 1] == ' ' || job->command[len - 1] == '\t')) len--;
+        job->command[len] = '\0';
+    }
+    if (!job->pids || !job->statuses || !job->states || !job->command) {
+        free(job->pids);
+        free(job->statuses);
+        free(job->states);
+        free(job->command);
+        free(job);
+        return NULL;
+    }
+    memcpy(job->pids, pids, proc_count * sizeof(pid_t));
+
+    // Número do job: um a mais que o maior em uso (como no bash)
+    int id = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (table[i]->id > id) id = table[i]->id;
+    }
+    job->id = id + 1;
+    job->pgid = pgid;
+    job->count = job->running = proc_count;
+    job->state = JOB_RUNNING;
+    job->order = ++sequence;
+    table[count++] = job;
+
+    // Irmãos recolhidos por um comando interno antes do registro
+    for (size_t i = 0; i < pending_count;) {
+        if (find_pid(pending[i].pid) == job) {
+            update(pending[i].pid, pending[i].status, &pending[i].usage);
+            pending[i] = pending[--pending_count];
+        } else {
+            i++;
+        }
+    }
+    return job;
+}
+
+int jobs_wait(struct job *job, const bool in_foreground, struct rusage *usage) {
+    if (in_foreground) {
+        foreground = job;
+        if (interactive && job->pgid > 0) {
+            tcsetpgrp(STDIN_FILENO, job->pgid);
+            if (job->has_tmodes) tcsetattr(STDIN_FILENO, TCSADRAIN, &job->tmodes);
+        }
+    }
+
+    while (true) {
+        jobs_reap();
+        if (job->state != JOB_RUNNING) break;
+
+        struct pollfd pfd = {.fd = signal_fd, .events = POLLIN};
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR) break;
+    }
+
+    int result = 0;
+    if (job->state == JOB_STOPPED) {
+        result = 128 + SIGTSTP;
+        for (size_t i = 0; i < job->count; i++) {
+            if (job->states[i] == JOB_STOPPED) result = exit_code(job->statuses[i]);
+        }
+    } else if (job->state == JOB_DONE) {
+        result = exit_code(job->statuses[job->count - 1]);
+        // Ctrl-C: o prompt começa na linha seguinte ao "^C"
+        if (in_foreground && result == 128 + SIGINT) term_out_char('\n');
+    }
+
+    if (in_foreground) {
+        foreground = NULL;
+        if (interactive && job->pgid > 0) {
+            if (job->state == JOB_STOPPED) job->has_tmodes = tcgetattr(STDIN_FILENO, &job->tmodes) == 0;
+            tcsetpgrp(STDIN_FILENO, shell_pgid);
+            tcsetattr(STDIN_FILENO, TCSADRAIN, &shell_tmodes);
+        }
+        if (job->state == JOB_STOPPED) {
+            // Ctrl-Z: o job vira o atual e o aviso sai já
+            job->order = ++sequence;
+            term_out_char('\n');
+            print_job(job, false);
+        }
+    }
+
+    if (usage) *usage = job->usage;
+    if (job->state == JOB_DONE) remove_job(job);
+    return result;
+}
+
+int jobs_wait_readable(const int fd) {
+    if (epoll_fd < 0) return 0;
+    if (epoll_input != fd) {
+        if (epoll_input >= 0) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, epoll_input, NULL);
+        struct epoll_event event = {.events = EPOLLIN, .data.fd = fd};
+        // Arquivos comuns não entram no epoll (EPERM), mas estão sempre prontos para leitura
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) return 0;
+        epoll_input = fd;
+    }
+
+    while (true) {
+        struct epoll_event events[2];
+        const int ready = epoll_wait(epoll_fd, events, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        bool readable = false;
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.fd == signal_fd) jobs_reap();
+            else readable = true;
+        }
+        if (readable) return 0;
+    }
+}
+
+void jobs_reap(void) {
+    if (signal_fd >= 0) {
+        struct signalfd_siginfo info;
+        while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {}
+    }
+
+    // Um SIGCHLD pode representar vários filhos: recolher até não sobrar nenhum.
+    // wait4 traz o uso de recursos do filho sem custo extra (para o `stats`/`time`).
+    int status;
+    pid_t pid;
+    struct rusage usage;
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0) update(pid, status, &usage);
+}
+
+void jobs_notify(void) {
+    // Sem prompt (script, `-c`) a entrada não espera no epoll: recolher aqui
+    if (count > 0) jobs_reap();
+    for (size_t i = 0; i < count;) {
+        struct job *job = table[i];
+        if (!job->notify) {
+            i++;
+            continue;
+        }
+        job->notify = false;
+        if (interactive) print_job(job, false);
+        if (job->state == JOB_DONE) remove_job(job);
+        else i++;
+    }
+}
+
+size_t jobs_count(void) {
+    return count;
+}
+
+struct job *jobs_get(const int id) {
+    for (size_t i = 0; i < count; i++) {
+        if (table[i]->id == id) return table[i];
+    }
+    return NULL;
+}
+
+/*****************************************************************************/
+
+int builtin_jobs(const int argc, char **argv) {
+    const bool show_pids = argc > 1 && strcmp(argv[1], "-l") == 0;
+    jobs_reap();
+    for (size_t i = 0; i < count;) {
+        struct job *job = table[i];
+        print_job(job, show_pids);
+        job->notify = false;
+        if (job->state == JOB_DONE) remove_job(job);
+        else i++;
+    }
+    return 0;
+}
+
+int builtin_fg(const int argc, char **argv) {
+    jobs_reap();
+    struct job *job = find_job(argc > 1 ? argv[1] : NULL);
+    if (!job) {
+        term_out_printf("%sfg: job não existe%s\n", TERM_RED_BOLD, TERM_RESET);
+        return 1;
+    }
+    term_out_str(job->command);
+    term_out_char('\n');
+    term_out_flush();
+
+    job->notify = false;
+    continue_job(job);
+    return jobs_wait(job, true, NULL);
+}
+
+int builtin_bg(const int argc, char **argv) {
+    jobs_reap();
+    struct job *job = find_job(argc > 1 ? argv[1] : NULL);
+    if (!job) {
+        term_out_printf("%sbg: job não existe%s\n", TERM_RED_BOLD, TERM_RESET);
+        return 1;
+    }
+    continue_job(job);
+    job->notify = false;
+    term_out_printf("[%d]+ %s &\n", job->id, job->command);
+    return 0;
+}
+
+int builtin_wait(const int argc, char **argv) {
+    if (argc == 1) {
+        // Sem argumentos: esperar todos os jobs em execução
+        while (true) {
+            jobs_reap();
+            struct job *running = NULL;
+            for (size_t i = 0; i < count && !running; i++) {
+                if (table[i]->state == JOB_RUNNING) running = table[i];
+            }
+            if (!running) break;
+            jobs_wait(running, false, NULL);
+        }
+        // Os terminados já foram esperados: não avisar de novo
+        for (size_t i = 0; i < count;) {
+            if (table[i]->state == JOB_DONE) remove_job(table[i]);
+            else i++;
+        }
+        return 0;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        jobs_reap();
+        struct job *job = argv[i][0] == '%' ? find_job(argv[i]) : find_pid((pid_t) atoi(argv[i]));
+        if (!job) {
+            term_out_printf("%swait: %s não é um job deste shell%s\n", TERM_RED_BOLD, argv[i], TERM_RESET);
+            status = 127;
+            continue;
+        }
+        status = jobs_wait(job, false, NULL);
+    }
+    return status;
+}
+
+int builtin_kill(const int argc, char **argv) {
+    int sig = SIGTERM;
+    int first = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
+        for (int s = 1; s < SIGRTMIN; s++) {
+            const char *name = sigabbrev_np(s);
+            if (name) term_out_printf("%2d) SIG%s\n", s, name);
+        }
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        sig = parse_signal(argv[2]);
+        first = 3;
+    } else if (argc > 1 && argv[1][0] == '-') {
+        sig = parse_signal(argv[1] + 1);
+        first = 2;
+    }
+    if (sig < 0) {
+        term_out_printf("%skill: sinal inválido (veja kill -l)%s\n", TERM_RED_BOLD, TERM_RESET);
+        return 1;
+    }
+    if (first >= argc) {
+        term_out_str(TERM_RED_BOLD "Uso: kill [-s SINAL | -SINAL] %JOB|PID..." TERM_RESET "\n");
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = first; i < argc; i++) {
+        int result;
+        if (argv[i][0] == '%') {
+            struct job *job = find_job(argv[i]);
+            if (!job) {
+                term_out_printf("%skill: %s: job não existe%s\n", TERM_RED_BOLD, argv[i], TERM_RESET);
+                status = 1;
+                continue;
+            }
+            result = signal_job(job, sig);
+            // Um job parado só recebe TERM/HUP depois de continuar
+            if (result == 0 && job->state == JOB_STOPPED && (sig == SIGTERM || sig == SIGHUP)) {
+                signal_job(job, SIGCONT);
+            }
+        } else {
+            result = kill((pid_t) atoi(argv[i]), sig);
+        }
+        if (result != 0) {
+            term_out_printf("%skill: %s: %s%s\n", TERM_RED_BOLD, argv[i], strerror(errno), TERM_RESET);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/*****************************************************************************/
+
+static void update(const pid_t pid, const int status, const struct rusage *usage) {
+    struct job *job = find_pid(pid);
+    if (!job) {
+        keep_pending(pid, status, usage);
+        return;
+    }
+
+    size_t i = 0;
+    while (job->pids[i] != pid) i++;
+
+    if (WIFSTOPPED(status)) {
+        if (job->states[i] == JOB_RUNNING) {
+            job->states[i] = JOB_STOPPED;
+            job->stopped++;
+        }
+        job->statuses[i] = status;
+    } else if (WIFCONTINUED(status)) {
+        if (job->states[i] == JOB_STOPPED) {
+            job->states[i] = JOB_RUNNING;
+            job->stopped--;
+        }
+    } else if (job->states[i] != JOB_DONE) {
+        if (job->states[i] == JOB_STOPPED) job->stopped--;
+        job->states[i] = JOB_DONE;
+        job->statuses[i] = status;
+        job->running--;
+        stats_usage_add(&job->usage, usage);
+    }
+    update_state(job);
+}
+
+static void update_state(struct job *job) {
+    enum job_state state = JOB_RUNNING;
+    if (job->running == 0) state = JOB_DONE;
+    else if (job->stopped == job->running) state = JOB_STOPPED;
+
+    if (state != job->state) {
+        job->state = state;
+        if (job != foreground) job->notify = true;
+    }
+}
+
+static void keep_pending(const pid_t pid, const int status, const struct rusage *usage) {
+    size_t i = 0;
+    while (i < pending_count && pending[i].pid != pid) i++;
+    if (i == pending_count) {
+        if (pending_count == pending_capacity) {
+            const size_t new_capacity = pending_capacity ? pending_capacity * 2 : JOBS_INITIAL_CAPACITY;
+            struct pending *new_pending = realloc(pending, new_capacity * sizeof(struct pending));
+            if (!new_pending) return;
+            pending = new_pending;
+            pending_capacity = new_capacity;
+        }
+        pending[pending_count++] = (struct pending) {.pid = pid};
+    }
+    pending[i].status = status;
+    pending[i].usage = *usage;
+}
+
+static void remove_job(struct job *job) {
+    for (size_t i = 0; i < count; i++) {
+        if (table[i] != job) continue;
+        memmove(&table[i], &table[i + 1], (count - i - 1) * sizeof(struct job *));
+        count--;
+        break;
+    }
+    free(job->pids);
+    free(job->statuses);
+    free(job->states);
+    free(job->command);
+    free(job);
+}
+
+static int signal_job(const struct job *job, const int sig) {
+    if (job->pgid > 0) return kill(-job->pgid, sig);
+
+    int result = 0;
+    for (size_t i = 0; i < job->count; i++) {
+        if (job->states[i] != JOB_DONE && kill(job->pids[i], sig) != 0) result = -1;
+    }
+    return result;
+}
+
+static void continue_job(struct job *job) {
+    for (size_t i = 0; i < job->count; i++) {
+        if (job->states[i] == JOB_STOPPED) job->states[i] = JOB_RUNNING;
+    }
+    job->stopped = 0;
+    if (job->state == JOB_STOPPED) job->state = JOB_RUNNING;
+    job->order = ++sequence;
+    signal_job(job, SIGCONT);
+}
+
+static struct job *find_job(const char *spec) {
+    if (!spec || strcmp(spec, "%") == 0 || strcmp(spec, "%%") == 0 || strcmp(spec, "%+") == 0) {
+        return current_job(false);
+    }
+    if (strcmp(spec, "%-") == 0) return current_job(true);
+
+    if (spec[0] == '%') spec++;
+    char *end;
+    const long id = strtol(spec, &end, 10);
+    if (*end || end == spec || id <= 0 || id > INT_MAX) return NULL;
+    return jobs_get((int) id);
+}
+
+static struct job *find_pid(const pid_t pid) {
+    // Os jobs mais novos terminam primeiro na maioria dos casos: procurar do fim
+    for (size_t i = count; i-- > 0;) {
+        const struct job *job = table[i];
+        for (size_t j = 0; j < job->count; j++) {
+            if (job->pids[j] == pid) return table[i];
+        }
+    }
+    return NULL;
+}
+
+static struct job *current_job(const bool previous) {
+    struct job *first = NULL;
+    struct job *second = NULL;
+    for (size_t i = 0; i < count; i++) {
+        struct job *job = table[i];
+        if (!first || job->order > first->order) {
+            second = first;
+            first = job;
+        } else if (!second || job->order > second->order) {
+            second = job;
+        }
+    }
+    return previous ? second : first;
+}
+
+static void print_job(const struct job *job, const bool show_pids) {
+    const struct job *current = current_job(false);
+    const struct job *previous = current_job(true);
+    const char marker = job == current ? '+' : job == previous ? '-' : ' ';
+
+    char state[48];
+    if (job->state == JOB_RUNNING) {
+        snprintf(state, sizeof(state), "Executando");
+    } else if (job->state == JOB_STOPPED) {
+        snprintf(state, sizeof(state), "Parado");
+    } else {
+        const int status = job->statuses[job->count - 1];
+        if (WIFSIGNALED(status)) snprintf(state, sizeof(state), "Morto (%s)", sigabbrev_np(WTERMSIG(status)));
+        else if (WEXITSTATUS(status) != 0) snprintf(state, sizeof(state), "Saída %d", WEXITSTATUS(status));
+        else snprintf(state, sizeof(state), "Concluído");
+    }
+
+    term_out_printf("[%d]%c  ", job->id, marker);
+    if (show_pids) {
+        for (size_t i = 0; i < job->count; i++) term_out_printf("%d ", job->pids[i]);
+    }
+    term_out_printf("%-12s %s%s\n", state, job->command, job->state == JOB_RUNNING ? " &" : "");
+}
+
+static int exit_code(const int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    if (WIFSTOPPED(status)) return 128 + WSTOPSIG(status);
+    return 1;
+}
+
+static int parse_signal(const char *name) {
+    char *end;
+    const long number = strtol(name, &end, 10);
+    if (*name && !*end) return number > 0 && number < NSIG ? (int) number : -1;
+
+    if (strncmp(name, "SIG", 3) == 0) name += 3;
+    for (int sig = 1; sig < NSIG; sig++) {
+        const char *abbrev = sigabbrev_np(sig);
+        if (abbrev && strcasecmp(abbrev, name) == 0) return sig;
+    }
+    return -1;
+}
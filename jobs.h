@@ -0,0 +1,141 @@
+//
+// Controle de jobs: tabela de jobs, grupos de processos e eventos de filhos via signalfd.
+//
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <termios.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+enum job_state {
+    JOB_RUNNING,
+    JOB_STOPPED,
+    JOB_DONE,
+};
+
+/**
+ * @brief Um pipeline lançado pelo shell (um ou mais processos).
+ *
+ * Com o terminal interativo, cada job tem o seu grupo de processos (`pgid`)
+ * e só o job em primeiro plano fica com o terminal; sem terminal, `pgid` é 0
+ * e os sinais vão para cada processo.
+ */
+struct job {
+    int id;             // Número exibido (%N)
+    pid_t pgid;
+    pid_t *pids;
+    int *statuses;      // Último status de waitpid de cada processo
+    enum job_state *states;
+    size_t count;
+    size_t running;     // Processos ainda não terminados
+    size_t stopped;     // Processos parados (SIGTSTP/SIGSTOP)
+    enum job_state state;
+    bool notify;        // Mudou de estado em segundo plano e ainda não foi avisado
+    char *command;
+    unsigned long order;  // Momento da última ida para segundo plano (define o job atual, `%+`)
+    struct termios tmodes; // Modo do terminal quando o job parou (restaurado no `fg`)
+    bool has_tmodes;
+    struct rusage usage;   // Soma dos processos já terminados (wait4)
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Prepara o controle de jobs: bloqueia SIGCHLD (lido por signalfd) e, se interativo,
+ * coloca o shell no seu próprio grupo de processos com o terminal.
+ *
+ * Deve ser chamado antes de criar qualquer thread, para todas herdarem o SIGCHLD bloqueado.
+ * @param interactive Se true (e a entrada for um terminal), o shell toma o terminal; scripts
+ * e `-c` passam false e rodam no grupo e com os sinais que herdaram.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int jobs_init(bool interactive);
+
+/**
+ * @brief Indica se o shell controla o terminal (grupos de processos e `fg`/Ctrl-Z ativos).
+ */
+bool jobs_interactive(void);
+
+/**
+ * @brief Grupo de processos do shell.
+ */
+pid_t jobs_shell_pgid(void);
+
+/**
+ * @brief Sinais que o shell ignora/bloqueia e que os filhos devem ter no padrão.
+ * @param set Conjunto de saída.
+ */
+void jobs_child_signals(sigset_t *set);
+
+/**
+ * @brief Restaura, em um filho criado com fork, os sinais e o grupo de processos do job.
+ * @param pgid Grupo do job (0 = criar um grupo novo com o PID do filho; -1 = não mudar).
+ */
+void jobs_child_setup(pid_t pgid);
+
+/**
+ * @brief Registra um pipeline recém-criado.
+ * @param pgid Grupo de processos (0 se não há controle de jobs).
+ * @param pids PIDs dos processos, na ordem do pipeline.
+ * @param count Quantidade de processos.
+ * @param command Texto do comando (copiado).
+ * @return O job criado, ou NULL em caso de erro de alocação.
+ */
+struct job *jobs_add(pid_t pgid, const pid_t *pids, size_t count, const char *command);
+
+/**
+ * @brief Espera o job terminar (ou parar), dando o terminal a ele se `foreground`.
+ * @param job Job a esperar (removido da tabela se terminar).
+ * @param foreground Se true, o job recebe o terminal enquanto roda.
+ * @param usage Recebe o uso de recursos dos processos que terminaram (pode ser NULL).
+ * @return Código de saída do último processo (128 + sinal se morto ou parado).
+ */
+int jobs_wait(struct job *job, bool foreground, struct rusage *usage);
+
+/**
+ * @brief Espera `fd` ter dados para ler, tratando os eventos de filhos enquanto isso (epoll).
+ * @param fd Descritor de entrada.
+ * @return 0 quando `fd` pode ser lido, -1 em caso de erro.
+ */
+int jobs_wait_readable(int fd);
+
+/**
+ * @brief Recolhe os filhos que mudaram de estado (sem bloquear).
+ */
+void jobs_reap(void);
+
+/**
+ * @brief Recolhe os filhos e avisa os jobs em segundo plano que terminaram ou pararam,
+ * descartando os terminados (sem controle de jobs, só descarta).
+ */
+void jobs_notify(void);
+
+/**
+ * @brief Quantidade de jobs na tabela.
+ */
+size_t jobs_count(void);
+
+/**
+ * @brief Procura um job pelo número.
+ * @return O job, ou NULL se não existir (ou já tiver terminado e sido removido).
+ */
+struct job *jobs_get(int id);
+
+/**
+ * @brief Comandos internos de controle de jobs.
+ * @param argc Quantidade de argumentos.
+ * @param argv Argumentos (argv[0] é o nome do comando).
+ * @return 0 em caso de sucesso, diferente de 0 em caso de erro.
+ */
+int builtin_jobs(int argc, char **argv);
+int builtin_fg(int argc, char **argv);
+int builtin_bg(int argc, char **argv);
+int builtin_wait(int argc, char **argv);
+int builtin_kill(int argc, char **argv);
+
+#endif //JOBS_H
@@ -0,0 +1,477 @@
+#include "line_edit.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+#include "input.h"
+#include "history.h"
+
+// Espera pelos bytes seguintes de uma sequência de escape (um ESC sozinho vem sem nada depois)
+#define ESCAPE_TIMEOUT_MS 50
+
+// Tamanho máximo da consulta da busca reversa
+#define SEARCH_MAX 256
+
+// Tamanho inicial do buffer da linha (dobra quando a linha não cabe)
+#define LINE_EDIT_INITIAL_SIZE 1024
+
+/*****************************************************************************/
+
+enum key {
+    KEY_CTRL_A = 1,
+    KEY_CTRL_B = 2,
+    KEY_CTRL_C = 3,
+    KEY_CTRL_D = 4,
+    KEY_CTRL_E = 5,
+    KEY_CTRL_F = 6,
+    KEY_CTRL_G = 7,
+    KEY_CTRL_H = 8,
+    KEY_LINE_FEED = 10,
+    KEY_CTRL_K = 11,
+    KEY_CTRL_L = 12,
+    KEY_ENTER = 13,
+    KEY_CTRL_N = 14,
+    KEY_CTRL_P = 16,
+    KEY_CTRL_R = 18,
+    KEY_CTRL_U = 21,
+    KEY_CTRL_W = 23,
+    KEY_ESC = 27,
+    KEY_BACKSPACE = 127,
+    // Sequências de escape (fora da faixa de um byte)
+    KEY_UP = 256,
+    KEY_DOWN,
+    KEY_RIGHT,
+    KEY_LEFT,
+    KEY_HOME,
+    KEY_END,
+    KEY_DELETE,
+    KEY_NONE,       // Sequência não reconhecida (ignorada)
+};
+
+struct editor {
+    char *buf;              // Buffer da linha (cresce com `reserve`; reaproveitado entre leituras)
+    size_t size;
+    size_t len;
+    size_t pos;             // Posição do cursor em bytes (sempre no início de um caractere)
+    size_t cursor_row;      // Linha do cursor no último desenho, a partir da linha do prompt
+    size_t history_index;   // Entrada exibida (history_count() = linha nova)
+    char *saved;            // Linha nova guardada enquanto se navega no histórico
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Coloca o terminal em modo raw (sem eco, byte a byte, Ctrl-C como tecla).
+ * @param saved Recebe o modo anterior.
+ * @return 0 em caso de sucesso, -1 se a entrada não for um terminal.
+ */
+static int enable_raw(struct termios *saved);
+
+/**
+ * @brief Lê uma tecla, juntando as sequências de escape das teclas especiais.
+ * @return A tecla, ou INPUT_EOF.
+ */
+static int read_key(void);
+
+/**
+ * @brief Redesenha o prompt e a linha, com o cursor na posição de `e->pos`.
+ */
+static void refresh(struct editor *e, const char *prompt);
+
+/**
+ * @brief Largura exibida (colunas) de um texto UTF-8, ignorando as sequências de cor.
+ */
+static size_t display_width(const char *text, size_t len);
+
+/**
+ * @brief Garante espaço para `size` bytes na linha (o buffer dobra até caber).
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int reserve(struct editor *e, size_t size);
+
+/**
+ * @brief Insere um byte na posição do cursor.
+ */
+static void insert(struct editor *e, char c);
+
+/**
+ * @brief Apaga os bytes [from, to) da linha.
+ */
+static void erase(struct editor *e, size_t from, size_t to);
+
+/**
+ * @brief Posição do caractere anterior/seguinte ao cursor (pulando os bytes de continuação UTF-8).
+ */
+static size_t prev_char(const struct editor *e, size_t pos);
+static size_t next_char(const struct editor *e, size_t pos);
+
+/**
+ * @brief Substitui a linha por `text`, com o cursor no fim.
+ */
+static void set_line(struct editor *e, const char *text, size_t len);
+
+/**
+ * @brief Exibe a entrada anterior (`delta` = -1) ou seguinte (+1) do histórico.
+ */
+static void history_move(struct editor *e, int delta);
+
+/**
+ * @brief Modo de busca reversa (Ctrl-R): a linha mostra a entrada mais nova que contém a consulta.
+ * @return Tecla que encerrou a busca e deve ser tratada pelo editor (KEY_NONE se nenhuma).
+ */
+static int reverse_search(struct editor *e, const char *prompt);
+
+/*****************************************************************************/
+
+char *line_edit_read(const char *prompt, size_t *len) {
+    struct termios saved_mode;
+    if (enable_raw(&saved_mode) != 0) {
+        // Sem terminal: leitura comum de linha
+        term_out_str(prompt);
+        term_out_flush();
+        return input_next_line(len);
+    }
+
+    static char *buffer = NULL;
+    static size_t capacity = 0;
+    struct editor e = {.buf = buffer, .size = capacity, .history_index = history_count()};
+    if (reserve(&e, LINE_EDIT_INITIAL_SIZE) != 0) {
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &saved_mode);
+        return NULL;
+    }
+    e.buf[0] = '\0';
+    refresh(&e, prompt);
+
+    bool done = false;
+    bool editing = true;
+    int key = KEY_NONE;
+    while (editing) {
+        if (key == KEY_NONE) key = read_key();
+        const int current = key;
+        key = KEY_NONE;
+
+        switch (current) {
+            case INPUT_EOF:
+                editing = false;
+                break;
+            case KEY_ENTER:
+            case KEY_LINE_FEED:
+                e.pos = e.len;
+                refresh(&e, prompt);
+                term_out_char('\n');
+                done = true;
+                editing = false;
+                break;
+            case KEY_CTRL_C:
+                e.pos = e.len;
+                refresh(&e, prompt);
+                term_out_str("^C\n");
+                e.len = 0;
+                done = true;
+                editing = false;
+                break;
+            case KEY_CTRL_D:
+                // Com a linha vazia é fim da entrada; com texto, apaga o caractere sob o cursor
+                if (e.len == 0) editing = false;
+                else if (e.pos < e.len) erase(&e, e.pos, next_char(&e, e.pos));
+                break;
+            case KEY_DELETE:
+                if (e.pos < e.len) erase(&e, e.pos, next_char(&e, e.pos));
+                break;
+            case KEY_BACKSPACE:
+            case KEY_CTRL_H:
+                if (e.pos > 0) erase(&e, prev_char(&e, e.pos), e.pos);
+                break;
+            case KEY_LEFT:
+            case KEY_CTRL_B:
+                e.pos = prev_char(&e, e.pos);
+                break;
+            case KEY_RIGHT:
+            case KEY_CTRL_F:
+                e.pos = next_char(&e, e.pos);
+                break;
+            case KEY_HOME:
+            case KEY_CTRL_A:
+                e.pos = 0;
+                break;
+            case KEY_END:
+            case KEY_CTRL_E:
+                e.pos = e.len;
+                break;
+            case KEY_UP:
+            case KEY_CTRL_P:
+                history_move(&e, -1);
+                break;
+            case KEY_DOWN:
+            case KEY_CTRL_N:
+                history_move(&e, 1);
+                break;
+            case KEY_CTRL_U:
+                erase(&e, 0, e.pos);
+                break;
+            case KEY_CTRL_K:
+                e.len = e.pos;
+                break;
+            case KEY_CTRL_W: {
+                size_t from = e.pos;
+                while (from > 0 && (e.buf[from - 1] == ' ' || e.buf[from - 1] == '\t')) from--;
+                while (from > 0 && e.buf[from - 1] != ' ' && e.buf[from - 1] != '\t') from--;
+                erase(&e, from, e.pos);
+                break;
+            }
+            case KEY_CTRL_L:
+                term_out_str(TERM_CLEAR_SCREEN);
+                e.cursor_row = 0;
+                break;
+            case KEY_CTRL_R:
+                key = reverse_search(&e, prompt);
+                break;
+            default:
+                // Caracteres imprimíveis e bytes de UTF-8; demais controles são ignorados
+                if (current >= 32 && current < 256 && current != KEY_BACKSPACE) insert(&e, (char) current);
+                break;
+        }
+        if (editing) refresh(&e, prompt);
+    }
+
+    e.buf[e.len] = '\0';
+    buffer = e.buf;
+    capacity = e.size;
+    free(e.saved);
+    term_out_flush();
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &saved_mode);
+    *len = e.len;
+    return done ? e.buf : NULL;
+}
+
+/*****************************************************************************/
+
+static int enable_raw(struct termios *saved) {
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, saved) != 0) return -1;
+
+    // A saída continua processada (OPOST): '\n' segue virando "\r\n"
+    struct termios raw = *saved;
+    raw.c_iflag &= ~(tcflag_t) (BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(tcflag_t) (ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    return tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+}
+
+static int read_key(void) {
+    const int c = input_read_byte(-1);
+    if (c != KEY_ESC) return c;
+
+    int next = input_read_byte(ESCAPE_TIMEOUT_MS);
+    if (next == INPUT_TIMEOUT) return KEY_ESC;
+    if (next == 'O') {
+        next = input_read_byte(ESCAPE_TIMEOUT_MS);
+        return next == 'H' ? KEY_HOME : next == 'F' ? KEY_END : KEY_NONE;
+    }
+    if (next != '[') return KEY_NONE; // Alt+tecla
+
+    // CSI: parâmetros numéricos até o byte final (ex.: "\x1b[3~", "\x1b[1;5C")
+    int param = 0;
+    int final;
+    while (true) {
+        final = input_read_byte(ESCAPE_TIMEOUT_MS);
+        if (final < 0) return KEY_NONE;
+        if (final >= '0' && final <= '9') param = param * 10 + (final - '0');
+        else if (final != ';') break;
+    }
+
+    switch (final) {
+        case 'A': return KEY_UP;
+        case 'B': return KEY_DOWN;
+        case 'C': return KEY_RIGHT;
+        case 'D': return KEY_LEFT;
+        case 'H': return KEY_HOME;
+        case 'F': return KEY_END;
+        case '~':
+            if (param == 1 || param == 7) return KEY_HOME;
+            if (param == 4 || param == 8) return KEY_END;
+            if (param == 3) return KEY_DELETE;
+            return KEY_NONE;
+        default: return KEY_NONE;
+    }
+}
+
+static void refresh(struct editor *e, const char *prompt) {
+    const size_t cols = getTerminalCols() > 0 ? getTerminalCols() : 80;
+    const size_t prompt_width = display_width(prompt, strlen(prompt));
+
+    // Volta à linha do prompt e redesenha tudo (a linha pode ter encolhido ou quebrado)
+    if (e->cursor_row > 0) term_out_printf("\x1b[%zuA", e->cursor_row);
+    term_out_str("\r" TERM_ERASE_SCREEN_END);
+    term_out_str(prompt);
+    term_out_write(e->buf, e->len);
+
+    const size_t total = prompt_width + display_width(e->buf, e->len);
+    const size_t cursor = prompt_width + display_width(e->buf, e->pos);
+    // Texto terminando exatamente na última coluna: o terminal só quebra a linha no próximo caractere
+    if (total > 0 && total % cols == 0) term_out_char('\n');
+
+    const size_t end_row = total / cols;
+    const size_t cursor_row = cursor / cols;
+    if (end_row > cursor_row) term_out_printf("\x1b[%zuA", end_row - cursor_row);
+    term_out_char('\r');
+    if (cursor % cols > 0) term_out_printf("\x1b[%zuC", cursor % cols);
+    e->cursor_row = cursor_row;
+    term_out_flush();
+}
+
+static size_t display_width(const char *text, const size_t len) {
+    size_t width = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\x1b' && i + 1 < len && text[i + 1] == '[') {
+            // Sequência de cor: até o byte final (@ a ~)
+            i += 2;
+            while (i < len && (text[i] < '@' || text[i] > '~')) i++;
+            continue;
+        }
+        if (((unsigned char) text[i] & 0xC0) != 0x80) width++;
+    }
+    return width;
+}
+
+static int reserve(struct editor *e, const size_t size) {
+    if (size <= e->size) return 0;
+    size_t new_size = e->size ? e->size : LINE_EDIT_INITIAL_SIZE;
+    while (new_size < size) new_size *= 2;
+    char *new_buf = realloc(e->buf, new_size);
+    if (!new_buf) return -1;
+    e->buf = new_buf;
+    e->size = new_size;
+    return 0;
+}
+
+static void insert(struct editor *e, const char c) {
+    if (reserve(e, e->len + 2) != 0) return;
+    memmove(e->buf + e->pos + 1, e->buf + e->pos, e->len - e->pos);
+    e->buf[e->pos++] = c;
+    e->len++;
+}
+
+static void erase(struct editor *e, const size_t from, const size_t to) {
+    memmove(e->buf + from, e->buf + to, e->len - to);
+    e->len -= to - from;
+    e->pos = from;
+}
+
+static size_t prev_char(const struct editor *e, size_t pos) {
+    if (pos == 0) return 0;
+    pos--;
+    while (pos > 0 && ((unsigned char) e->buf[pos] & 0xC0) == 0x80) pos--;
+    return pos;
+}
+
+static size_t next_char(const struct editor *e, size_t pos) {
+    if (pos >= e->len) return e->len;
+    pos++;
+    while (pos < e->len && ((unsigned char) e->buf[pos] & 0xC0) == 0x80) pos++;
+    return pos;
+}
+
+static void set_line(struct editor *e, const char *text, const size_t len) {
+    if (reserve(e, len + 1) != 0) return;
+    e->len = len;
+    memmove(e->buf, text, e->len);
+    e->pos = e->len;
+}
+
+static void history_move(struct editor *e, const int delta) {
+    const size_t count = history_count();
+    if (delta < 0 && e->history_index == 0) return;
+    if (delta > 0 && e->history_index >= count) return;
+
+    // Saindo da linha nova: guardá-la para quando o usuário voltar
+    if (e->history_index == count) {
+        free(e->saved);
+        e->saved = strndup(e->buf, e->len);
+    }
+    e->history_index = delta < 0 ? e->history_index - 1 : e->history_index + 1;
+
+    if (e->history_index == count) {
+        set_line(e, e->saved ? e->saved : "", e->saved ? strlen(e->saved) : 0);
+    } else {
+        size_t len;
+        const char *text = history_get(e->history_index, &len);
+        set_line(e, text, len);
+    }
+}
+
+static int reverse_search(struct editor *e, const char *prompt) {
+    char query[SEARCH_MAX];
+    size_t query_len = 0;
+    query[0] = '\0';
+
+    char *original = strndup(e->buf, e->len);
+    const size_t original_pos = e->pos;
+    size_t match = history_count();
+    bool found = true;
+
+    while (true) {
+        char search_prompt[SEARCH_MAX + 64];
+        snprintf(search_prompt, sizeof(search_prompt), TERM_YELLOW "(busca reversa%s)" TERM_RESET "`%s': ",
+                 found ? "" : " sem resultado", query);
+        refresh(e, search_prompt);
+
+        const int key = read_key();
+        size_t before = history_count();
+        if (key == KEY_CTRL_R) {
+            before = match; // Próxima ocorrência, mais antiga
+        } else if (key == KEY_BACKSPACE || key == KEY_CTRL_H) {
+            // Apaga um caractere inteiro (com os bytes de continuação UTF-8)
+            while (query_len > 0 && ((unsigned char) query[--query_len] & 0xC0) == 0x80) {}
+            query[query_len] = '\0';
+        } else if (key >= 32 && key < 256) {
+            if (query_len + 1 < sizeof(query)) {
+                query[query_len++] = (char) key;
+                query[query_len] = '\0';
+            }
+            if (found && match < history_count()) before = match + 1; // A entrada atual ainda pode servir
+        } else if (key == KEY_CTRL_G || key == KEY_CTRL_C) {
+            // Cancelar: volta a linha de antes da busca
+            set_line(e, original ? original : "", original ? strlen(original) : 0);
+            e->pos = original_pos < e->len ? original_pos : e->len;
+            free(original);
+            refresh(e, prompt);
+            return KEY_NONE;
+        } else {
+            // Qualquer outra tecla aceita a entrada e segue para o editor (Enter executa)
+            free(original);
+            e->history_index = found && match < history_count() ? match : history_count();
+            return key == KEY_ESC ? KEY_NONE : key;
+        }
+
+        if (query_len == 0) {
+            found = true;
+            continue;
+        }
+
+        // Procura pulando as entradas iguais à que já está na linha
+        size_t index = match;
+        found = history_search(query, before, &index);
+        while (found && key == KEY_CTRL_R) {
+            size_t len;
+            const char *text = history_get(index, &len);
+            if (len != e->len || memcmp(text, e->buf, len) != 0) break;
+            found = history_search(query, index, &index);
+        }
+        if (!found) continue;
+
+        match = index;
+        size_t len;
+        const char *text = history_get(match, &len);
+        set_line(e, text, len);
+        const char *hit = memmem(e->buf, e->len, query, query_len);
+        e->pos = hit ? (size_t) (hit - e->buf) : e->len;
+    }
+}
@@ -0,0 +1,28 @@
+//
+// Editor de linha em modo raw: setas, Home/End, histórico e busca reversa (Ctrl-R).
+//
+
+#ifndef LINE_EDIT_H
+#define LINE_EDIT_H
+
+#include <stddef.h>
+
+/**
+ * @brief Lê uma linha do terminal com edição.
+ *
+ * O prompt é a última linha do prompt do shell (pode ter cores). Linhas maiores
+ * que a largura do terminal (`getTerminalCols`) quebram e são redesenhadas
+ * inteiras a cada tecla, em um único write.
+ *
+ * Teclas: ←/→, Home/End (Ctrl-A/Ctrl-E), ↑/↓ (histórico), Backspace/Delete,
+ * Ctrl-U/Ctrl-K (apagar até o início/fim), Ctrl-W (apagar palavra), Ctrl-L
+ * (limpar a tela), Ctrl-R (busca reversa no histórico), Ctrl-C (descartar a
+ * linha) e Ctrl-D (fim da entrada, com a linha vazia).
+ * A linha não tem limite de tamanho: o buffer cresce conforme o necessário.
+ * @param prompt Prompt exibido antes da linha.
+ * @param len Recebe o tamanho da linha.
+ * @return A linha, terminada em '\0' (válida até a próxima leitura), ou NULL no fim da entrada.
+ */
+char *line_edit_read(const char *prompt, size_t *len);
+
+#endif //LINE_EDIT_H
@@ -2,10 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <locale.h>
 #include <libgen.h>
 #include <time.h>
-#include <sys/wait.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -17,20 +17,26 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <errno.h>
 
+#include "builtins.h"
 #include "term_tools.h"
-
-#define MAX_PROCESSES 1024
-
-/*****************************************************************************/
-
-struct process_info {
-    pid_t pid;
-    pid_t ppid;
-    char name[256];
-};
-
-/*****************************************************************************/
+#include "term_out.h"
+#include "proc_tools.h"
+#include "mon.h"
+#include "name_cache.h"
+#include "dir_tools.h"
+#include "exec.h"
+#include "path_cache.h"
+#include "jobs.h"
+#include "input.h"
+#include "history.h"
+#include "line_edit.h"
+#include "arena.h"
+#include "parser.h"
+#include "parse_cache.h"
+#include "par.h"
+#include "stats.h"
 
 char *_PATH;
 size_t TERM_HEIGHT = 0;
@@ -44,521 +50,241 @@ size_t TERM_WIDTH = 0;
 void welcome_message();
 
 /**
- * @brief Manipula o sinal SIGCHLD para evitar processos zumbis.
- * @param sig O número do sinal recebido (normalmente SIGCHLD).
- */
-void sigchld_handler(int sig);
-
-/**
- * @brief Obtém informações de um processo a partir do PID.
- * @param pid O PID do processo a ser analisado.
- * @return Estrutura `process_info` preenchida com dados do processo.
+ * @brief Separa (pelo cache de linhas) e executa uma linha: pipelines ligados por `;`, `&`, `&&` e `||`.
+ * @param line Linha (não precisa terminar em '\0').
+ * @param len Tamanho da linha.
+ * @param status Código de saída do último comando (2 em erro de sintaxe; `exit N` coloca N).
+ * @return true se a linha pediu `exit`.
  */
-struct process_info get_process_info(pid_t pid);
+static bool run_line(const char *line, size_t len, int *status);
 
 /**
- * @brief Exibe a árvore de processos recursivamente.
- * @param pid PID do processo inicial.
- * @param depth Nível atual de profundidade na árvore.
- * @param is_last Indica se este é o último processo do nível atual.
- * @param ancestors Vetor booleano para rastrear os níveis da árvore.
+ * @brief Modo não interativo: executa `-c COMANDO`, um script ou a entrada redirecionada.
+ *
+ * Sem prompt, histórico nem modo raw; a entrada é lida em blocos grandes e a saída
+ * dos comandos internos só vai para o stdout quando o buffer do term_out enche.
+ * @param command Texto do `-c` (NULL se não houver).
+ * @param script Caminho do script (NULL = entrada padrão).
+ * @return Código de saída do último comando.
  */
-void print_process_tree(pid_t pid, int depth, bool is_last, const bool *ancestors);
+static int run_batch(const char *command, const char *script);
 
-/**
- * @brief Verifica se uma string representa um número válido.
- * @param str A string a ser analisada.
- * @return true se for um número, false caso contrário.
- */
-bool is_number(const char *str);
-
-/**
- * @brief Exibe os detalhes de arquivos no estilo do comando `ls -l`.
- * @param path Caminho do diretório ou arquivo.
- * @param show_all Se true, também exibe arquivos ocultos.
- */
-void print_lf_details(const char *path, bool show_all);
-
-/**
- * @brief Função de comparação para ordenação de entradas de diretório.
- * @param a Ponteiro para o primeiro elemento.
- * @param b Ponteiro para o segundo elemento.
- * @return Valor < 0 se a < b, 0 se iguais, > 0 se a > b.
- */
-int compare_entries(const void *a, const void *b);
-
-/**
- * @brief Converte um modo de arquivo (bits de permissão) em string legível.
- * @param mode Bits do modo do arquivo (mode_t).
- * @param str String de saída onde será escrita a representação do modo.
- */
-void strmode(mode_t mode, char *str);
-
-/**
- * @brief Função de comparação para ordenação de PIDs.
- * @param a Ponteiro para o primeiro PID.
- * @param b Ponteiro para o segundo PID.
- * @return Valor < 0 se a < b, 0 se iguais, > 0 se a > b.
- */
-int compare_pids(const void *a, const void *b);
-
-/**
- * @brief Converte o modo de arquivo para string no formato `-rwxr-xr--`.
- * @param mode Modo do arquivo.
- * @param str Buffer onde a string será armazenada.
- */
-static void mode_to_str(mode_t mode, char *str);
+/*****************************************************************************/
 
-/**
- * @brief Converte um valor em bytes para uma string com tamanho legível.
- * @param bytes Valor em bytes.
- * @return String com o valor em formato como "1.2K", "3.4M", etc.
- */
-static char *human_readable_size(long bytes);
+// Variáveis substituídas e cópia sem o `time` do comando atual (reiniciada a cada pipeline)
+static struct arena command_arena = {0};
 
 /*****************************************************************************/
 
-int main() {
-    system("clear");
+int main(const int argc, char **argv) {
+    // `T1_Shell -c COMANDO` ou `T1_Shell script.sh`: sem prompt, sem terminal
+    const char *command = NULL;
+    const char *script = NULL;
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "%sUso: %s -c COMANDO | %s SCRIPT%s\n", TERM_RED_BOLD, argv[0], argv[0], TERM_RESET);
+            return 2;
+        }
+        command = argv[2];
+    } else if (argc > 1) {
+        script = argv[1];
+    }
+    // Edição de linha e histórico só quando há alguém digitando
+    const bool interactive = !command && !script && isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+
+    if (interactive) term_out_str(TERM_CLEAR_SCREEN TERM_CLEAR_SCROLLBACK); // Mesmo efeito do `clear`, sem criar processos
+    setlocale(LC_COLLATE, ""); // Ordenação do `lf` segue o locale do usuário
     _PATH = malloc(2048);
-    // Configurar o tratamento de SIGCHLD para evitar processos zumbi
-    signal(SIGCHLD, sigchld_handler);
+    // Filhos recolhidos pelo controle de jobs (signalfd); antes de qualquer thread existir
+    if (jobs_init(interactive) != 0) {
+        term_out_printf("%sMAIN: Erro ao iniciar o controle de jobs %d%s\n", TERM_RED_BOLD, __LINE__, TERM_RESET);
+    }
 
     // Preparar o ambiente
     TERM_WIDTH = (int) getTerminalCols() > 0 ? (int) getTerminalCols() : 80;
     TERM_HEIGHT = (int) getTerminalRows() > 0 ? (int) getTerminalRows() : 24;
-    struct passwd *pw = getpwuid(getuid());
-    char username[256];
-    strcpy(username, pw->pw_name);
 
-    char cwd[2048];
-    if (getcwd(cwd, sizeof(cwd)) == NULL) {
-        printf("%sMAIN: Erro ao obter diretório atual %d\n", TERM_RED_BOLD, __LINE__);
+    if (getcwd(CWD, sizeof(CWD)) == NULL) {
+        term_out_printf("%sMAIN: Erro ao obter diretório atual %d\n", TERM_RED_BOLD, __LINE__);
+        term_out_flush();
         exit(1);
     }
 
+    if (!interactive) {
+        const int status = run_batch(command, script);
+        term_out_flush();
+        stats_stream_close();
+        free(_PATH);
+        return status;
+    }
+
+    struct passwd *pw = getpwuid(getuid());
+    char username[256];
+    strcpy(username, pw->pw_name);
+    history_init(NULL);
+
     welcome_message();
-    bool last_command_exit_error = false;
+    int status = 0;
 
     while (true) {
+        // Jobs em segundo plano que terminaram/pararam desde o último prompt
+        jobs_notify();
+
         // Prompt do usuário
-        printf("%s╭─%s%s%s in %s%s%s\n",
-               TERM_CYAN, TERM_CYAN_BOLD, username, TERM_RESET,
-               TERM_YELLOW_ITALIC, cwd, TERM_RESET);
-        printf("%s╰───%s❭ %s",
-               TERM_CYAN,
-               last_command_exit_error ? TERM_RED_BOLD : TERM_GREEN_BOLD,
-               TERM_RESET);
-
-        char input[2048];
-        if (fgets(input, sizeof(input), stdin) == NULL) {
-            printf("%sMAIN: Erro ao ler entrada %d\n", TERM_RED_BOLD, __LINE__);
-            last_command_exit_error = true;
-            continue;
+        term_out_str(TERM_CYAN "╭─" TERM_CYAN_BOLD);
+        term_out_str(username);
+        term_out_str(TERM_RESET " in " TERM_YELLOW_ITALIC);
+        term_out_str(CWD);
+        term_out_str(TERM_RESET "\n");
+        const char *prompt = status != 0 ? TERM_CYAN "╰───" TERM_RED_BOLD "❭ " TERM_RESET
+                                         : TERM_CYAN "╰───" TERM_GREEN_BOLD "❭ " TERM_RESET;
+
+        // Fim da entrada (Ctrl-D): sair
+        size_t input_len;
+        const char *input = line_edit_read(prompt, &input_len); // Desenha o prompt no mesmo write()
+        if (!input) {
+            term_out_char('\n');
+            break;
         }
 
-        // Remover nova linha
-        input[strcspn(input, "\n")] = '\0';
-
         // Comando vazio
-        if (strlen(input) == 0) continue;
-
-        // Dividir em argumentos
-        char *args[1024];
-        int arg_count = 0;
-        char *token = strtok(input, " \t");
-        while (token != NULL && arg_count < 1023) {
-            args[arg_count++] = token;
-            token = strtok(NULL, " \t");
-        }
-        args[arg_count] = NULL;
-
-        // Verificar se é background
-        bool background = false;
-        if (arg_count > 0 && strcmp(args[arg_count - 1], "&") == 0) {
-            background = true;
-            args[--arg_count] = NULL;
-        }
-
-        // Comandos internos
-        if (arg_count == 0) continue;
-        else if (strcmp(args[0], "exit") == 0) break;
-        else if (strcmp(args[0], "help") == 0) {
-            printf("\n%sComandos disponíveis:%s\n", TERM_CYAN_BOLD, TERM_RESET);
-            printf("%sexit    %s- %sSair do shell%s\n", TERM_CYAN_BOLD, TERM_RESET, TERM_GREEN, TERM_RESET);
-            printf("%shelp    %s- %sMostrar ajuda%s\n", TERM_CYAN_BOLD, TERM_RESET, TERM_GREEN, TERM_RESET);
-            printf("%scd      %s- %sMudar diretório%s\n", TERM_CYAN_BOLD, TERM_RESET, TERM_GREEN, TERM_RESET);
-            printf("%slf      %s- %sListar diretório%s\n", TERM_CYAN_BOLD, TERM_RESET, TERM_GREEN, TERM_RESET);
-            printf("%stree    %s- %sÁrvore de processos%s\n", TERM_CYAN_BOLD, TERM_RESET, TERM_GREEN, TERM_RESET);
-            printf("\n%sUse '%s&%s' no final para executar em segundo plano\n", TERM_WHITE, TERM_YELLOW_ITALIC,
-                   TERM_RESET);
-            last_command_exit_error = false;
-        } else if (strcmp(args[0], "cd") == 0) {
-            char *path = (arg_count > 1) ? args[1] : getenv("HOME");
-            if (chdir(path) != 0) {
-                printf("%sErro ao mudar para %s%s\n", TERM_RED_BOLD, path, TERM_RESET);
-                last_command_exit_error = true;
-            } else {
-                if (!getcwd(cwd, sizeof(cwd))) {
-                    printf("%sErro ao obter diretório%s\n", TERM_RED_BOLD, TERM_RESET);
-                    last_command_exit_error = true;
-                } else last_command_exit_error = false;
-            }
-        } else if (strcmp(args[0], "lf") == 0) {
-            if (arg_count > 1 && (strcmp(args[1], "-h") == 0 || strcmp(args[1], "--help") == 0)) {
-                // Ajuda
-                printf("%sUso: lf [OPÇÕES] [DIRETÓRIO]%s\n", TERM_CYAN_BOLD, TERM_RESET);
-                printf("Listar conteúdo do diretório\n\n");
-                printf("%sOpções:%s\n", TERM_YELLOW_BOLD, TERM_RESET);
-                printf("  -a\t\tMostrar arquivos ocultos\n");
-                printf("  -l\t\tFormato detalhado\n");
-                printf("  --help\t\tExibir esta ajuda\n");
-                last_command_exit_error = false;
-                continue;
-            }
-
-            bool long_format = false;
-            bool show_all = false;
-            const char *path = cwd;
-
-            // Processar flags
-            for (int i = 1; i < arg_count; i++) {
-                if (strcmp(args[i], "-l") == 0) long_format = true;
-                else if (strcmp(args[i], "-a") == 0) show_all = true;
-                else if (strcmp(args[i], "-la") == 0 || strcmp(args[i], "-al") == 0) {
-                    long_format = show_all = true;
-                }
-            }
-
-            // Obter path se especificado
-            for (int i = 1; i < arg_count; i++) {
-                if (args[i][0] != '-') {
-                    path = args[i];
-                    break;
-                }
-            }
-
-            if (long_format) {
-                print_lf_details(path, show_all);
-            } else {
-                DIR *dir = opendir(path);
-                if (!dir) {
-                    printf("%sErro ao abrir %s%s\n", TERM_RED_BOLD, path, TERM_RESET);
-                    last_command_exit_error = true;
-                    continue;
-                }
-
-                struct dirent **entries;
-                int n = scandir(path, &entries, NULL, alphasort);
-
-                for (int i = 0; i < n; i++) {
-                    if (!show_all && entries[i]->d_name[0] == '.') {
-                        free(entries[i]);
-                        continue;
-                    }
-
-                    char full_path[2048 + 257];
-                    snprintf(full_path, sizeof(full_path), "%s/%s", path, entries[i]->d_name);
-                    
-
-                    struct stat st;
-                    if (stat(full_path, &st) == 0) {
-                        const char *color = S_ISDIR(st.st_mode) ? TERM_BLUE : TERM_GREEN;
-                        printf("%s%s%s\n", color, entries[i]->d_name, TERM_RESET);
-                    }
-                    free(entries[i]);
-                }
-                free(entries);
-                closedir(dir);
-            }
-            last_command_exit_error = false;
-        } else if (strcmp(args[0], "tree") == 0) {
-            if (arg_count < 2) {
-                printf("%sPID faltando%s\n", TERM_RED_BOLD, TERM_RESET);
-                last_command_exit_error = true;
-                continue;
-            }
-            char *pid_str = args[1];
-            if (!is_number(pid_str)) {
-                printf("%sPID inválido%s\n", TERM_RED_BOLD, TERM_RESET);
-                last_command_exit_error = true;
-                continue;
-            }
-            pid_t pid = atoi(pid_str);
-            struct process_info info = get_process_info(pid);
-            if (info.pid == 0) {
-                printf("%sProcesso %d não encontrado%s\n", TERM_RED_BOLD, pid, TERM_RESET);
-                last_command_exit_error = true;
-                continue;
-            }
-            bool ancestors[16] = {0}; // Assume profundidade máxima de 16
-            printf("Árvore de processos (PID %d):\n", pid);
-            print_process_tree(pid, 0, true, ancestors);
-        } else {
-            // Comando externo
-            pid_t pid = fork();
-            if (pid == 0) {
-                execvp(args[0], args);
-                fprintf(stderr, "%sErro ao executar %s%s\n", TERM_RED_BOLD, args[0], TERM_RESET);
-                exit(EXIT_FAILURE);
-            } else if (pid < 0) {
-                fprintf(stderr, "%sErro ao criar processo%s\n", TERM_RED_BOLD, TERM_RESET);
-                last_command_exit_error = true;
-            } else {
-                if (!background) {
-                    int status;
-                    waitpid(pid, &status, 0);
-                    last_command_exit_error = (WEXITSTATUS(status) != 0);
-                } else {
-                    printf("[%d] Executando em segundo plano\n", pid);
-                    last_command_exit_error = false;
-                }
-            }
-        }
+        if (input_len == 0) continue;
+        history_add(input);
+        if (run_line(input, input_len, &status)) break;
     }
 
+    term_out_flush();
+    stats_stream_close();
+    history_free();
     free(_PATH);
-    return 0;
+    return status;
 }
 
-// Função para obter informações do processo
-struct process_info get_process_info(pid_t pid) {
-    struct process_info info = {0};
-    char stat_path[256];
-    snprintf(stat_path, sizeof(stat_path), "/proc/%d/stat", pid);
-
-    FILE *f = fopen(stat_path, "r");
-    if (!f) return info;
-
-    char line[1024];
-    if (!fgets(line, sizeof(line), f)) {
-        fclose(f);
-        return info;
+static bool run_line(const char *line, const size_t len, int *status) {
+    // Separar em pipelines, `;`, `&&`, `||` e `&` (só na primeira vez que a linha aparece)
+    const struct command_list *list = parse_cache_get(line, len);
+    if (!list) {
+        *status = 2;
+        return false;
     }
-    fclose(f);
-
-    char *start = strchr(line, '(');
-    char *end = strrchr(line, ')');
-    if (!start || !end) return info;
 
-    *end = '\0';
-    info.pid = pid;
-    strncpy(info.name, start + 1, sizeof(info.name) - 1);
+    for (size_t i = 0; i < list->count; i++) {
+        const struct list_item *item = &list->items[i];
+        if (i > 0) {
+            const enum list_op op = list->items[i - 1].next;
+            if ((op == LIST_AND && *status != 0) || (op == LIST_OR && *status == 0)) continue;
+        }
 
-    char *remaining = end + 1;
-    sscanf(remaining, "%*s %d", &info.ppid);
+        // A arena só guarda o pipeline atual: reiniciada sempre, e não só com variáveis (`time cd .` também aloca)
+        arena_reset(&command_arena);
 
-    return info;
-}
+        // Variáveis valem o que valem agora (inclusive o `$?` do item anterior)
+        const struct pipeline *pipeline = &item->pipeline;
+        struct pipeline expanded;
+        if (item->expand) {
+            if (parse_expand(&command_arena, item, *status, &expanded) != 0) {
+                *status = 2;
+                continue;
+            }
+            pipeline = &expanded;
+        }
+        if (pipeline->count == 0) continue;
 
-// Função recursiva para imprimir a árvore de processos
-void print_process_tree(const pid_t pid, const int depth, const bool is_last, const bool *ancestors) {
-    struct process_info info = get_process_info(pid);
-    if (info.pid == 0) return;
-
-    // Cores por nível
-    const char *colors[] = {TERM_CYAN, TERM_GREEN, TERM_MAGENTA, TERM_BLUE, TERM_YELLOW};
-    const char *color = colors[depth % 5];
-
-    // Imprimir indentação
-    for (int i = 0; i < depth; i++) {
-        if (i == depth - 1) {
-            printf(is_last ? "└── " : "├── ");
-        } else {
-            printf(ancestors[i] ? "│   " : "    ");
+        const struct command *first = &pipeline->commands[0];
+        if (pipeline->count == 1 && first->argc > 0 && strcmp(first->argv[0], "exit") == 0) {
+            if (first->argc > 1) *status = atoi(first->argv[1]) & 0xff;
+            return true;
         }
-    }
 
-    // Imprimir processo atual
-    printf("%s%s (PID: %d)%s\n", color, info.name, pid, TERM_RESET);
-
-    // Coletar filhos
-    DIR *proc_dir = opendir("/proc");
-    if (!proc_dir) return;
-
-    pid_t children[MAX_PROCESSES];
-    int count = 0;
-    struct dirent *entry;
-
-    while ((entry = readdir(proc_dir))) {
-        char full_path[2048];
-        snprintf(full_path, sizeof(full_path), "/proc/%s", entry->d_name);
-        struct stat st;
-        if (lstat(full_path, &st) == 0 && S_ISDIR(st.st_mode) && is_number(entry->d_name)) {
-            pid_t child_pid = atoi(entry->d_name);
-            struct process_info child_info = get_process_info(child_pid);
-            if (child_info.ppid == pid) {
-                children[count++] = child_pid;
+        // `time CMD`: a palavra sai do primeiro comando (cópia na arena; a lista pode estar no cache)
+        const bool timed = first->argc > 0 && strcmp(first->argv[0], "time") == 0;
+        if (timed) {
+            struct command *commands = arena_alloc(&command_arena, pipeline->count * sizeof(struct command));
+            if (!commands) {
+                *status = 1;
+                continue;
+            }
+            memcpy(commands, pipeline->commands, pipeline->count * sizeof(struct command));
+            commands[0].argv++;
+            commands[0].argc--;
+            expanded = *pipeline;
+            expanded.commands = commands;
+            pipeline = &expanded;
+            first = &commands[0];
+            if (first->argc == 0 && first->redirect_count == 0 && pipeline->count == 1) {
+                *status = 0;
+                continue;
             }
         }
-    }
-    closedir(proc_dir);
 
-    // Ordenar filhos por PID
-    qsort(children, count, sizeof(pid_t), compare_pids);
-
-    // Imprimir filhos recursivamente
-    bool new_ancestors[depth + 1];
-    memcpy(new_ancestors, ancestors, depth * sizeof(bool));
-
-    for (int i = 0; i < count; i++) {
-        new_ancestors[depth] = (i != count - 1);
-        print_process_tree(children[i], depth + 1, (i == count - 1), new_ancestors);
+        // Cada pipeline em primeiro plano entra no histograma do seu primeiro comando (`stats`)
+        struct timespec start;
+        struct rusage usage;
+        stats_begin(&start);
+        *status = pipeline_run(pipeline, BUILTINS, &usage);
+        if (pipeline->background) continue;
+        struct stats_sample sample;
+        stats_end(&start, &usage, *status, &sample);
+        stats_add(first->argc > 0 ? first->argv[0] : "(redirecionamento)", &sample);
+        if (timed) stats_print_sample(&sample);
     }
+    return false;
 }
 
-// Handler para SIGCHLD (evitar zumbis)
-void sigchld_handler(int sig) {
-    (void) sig;
-    while (waitpid(-1, NULL, WNOHANG) > 0);
-}
+static int run_batch(const char *command, const char *script) {
+    int status = 0;
 
-void welcome_message() {
-    // printf("%s┍%.*s┑%s\n", TERM_CYAN, (int)TERM_WIDTH, "━", TERM_RESET);
-    printf("%s┍", TERM_CYAN);
-    for (size_t i = 0; i < TERM_WIDTH - 2; i++) {
-        printf("━");
+    if (command) {
+        // `-c`: a string inteira é uma lista ('\n' separa como `;`)
+        run_line(command, strlen(command), &status);
+        return status;
     }
-    printf("┑%s\n", TERM_RESET);
-
-    char *msg = "WELCOME TO GREGORIOUS SHELL";
-    const int spaces = (int) (TERM_WIDTH - strlen(msg) - 2) / 2;
-    printf("%s│%*s%s%s%s%*s%s\n", TERM_CYAN, spaces, "", TERM_YELLOW, msg, TERM_CYAN, spaces + 1, "", "│");
-    printf("%s┕", TERM_CYAN);
-    for (size_t i = 0; i < TERM_WIDTH - 2; i++) {
-        printf("━");
-    }
-    printf("┙%s\n", TERM_RESET);
-    printf("%s\n", TERM_GREEN);
-    printf("Type 'help' for a list of commands.\n");
-    printf("Type 'exit' to exit the shell.\n");
-    printf("%s\n", TERM_RESET);
-}
-
-void print_lf_details(const char *path, bool show_all) {
-    DIR *dir = opendir(path);
-    if (!dir) return;
-
-    struct dirent **entries;
-    int n = scandir(path, &entries, NULL, alphasort);
-
-    setlocale(LC_NUMERIC, ""); // Para separadores de milhares
-
-    printf("%s%-13.11s%-12s%-12s%9.8s %-13s%s%s\n",
-           TERM_YELLOW, "Permissões", "Dono", "Grupo", "Tamanho",
-           "Modificado", "Nome", TERM_RESET
-    );
-
-    for (int i = 0; i < n; i++) {
-        if (!show_all && entries[i]->d_name[0] == '.') {
-            free(entries[i]);
-            continue;
-        }
-
-        char full_path[2048 + 257];
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entries[i]->d_name);
 
-        struct stat st;
-        if (lstat(full_path, &st)) {
-            free(entries[i]);
-            continue;
+    int fd = STDIN_FILENO;
+    if (script) {
+        fd = open(script, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "%s%s: %s%s\n", TERM_RED_BOLD, script, strerror(errno), TERM_RESET);
+            return 127;
         }
-
-        // Permissões
-        char perms[11];
-        mode_to_str(st.st_mode, perms);
-
-        // Dono/Grupo
-        struct passwd *pw = getpwuid(st.st_uid);
-        struct group *gr = getgrgid(st.st_gid);
-
-        // Tamanho formatado
-        char size_str[32];
-        strcpy(size_str, human_readable_size(st.st_size));
-
-        // Data
-        char date[20];
-        strftime(date, sizeof(date), "%d %b %H:%M", localtime(&st.st_mtime));
-
-        // Cores
-        const char *file_color = TERM_WHITE;
-        if (S_ISDIR(st.st_mode)) file_color = TERM_BLUE_BOLD;
-        else if (st.st_mode & S_IXUSR) file_color = TERM_GREEN_BOLD;
-        else if (S_ISLNK(st.st_mode)) file_color = TERM_MAGENTA_BOLD;
-
-        const char *owner_color = TERM_WHITE;
-        if (pw && strcmp(pw->pw_name, "root") == 0) owner_color = TERM_RED_BOLD;
-        else if (pw && strcmp(pw->pw_name, "?") != 0) owner_color = TERM_BLUE_BOLD;
-
-        const char *group_color = TERM_WHITE;
-        if (gr && !strcmp(gr->gr_name, "root") == 0) owner_color = TERM_RED_BOLD;
-        else if (gr && strcmp(gr->gr_name, "?") != 0) owner_color = TERM_MAGENTA_BOLD;
-
-
-        // "%s%-13.11s%-12s%-12s%9.8s %-13s%s%s\n",
-        printf("%s%-12.11s%s%-12s%s%-12s%s%9.8s %s%-13s%s%s%s%s\n",
-               TERM_WHITE_BOLD, perms,
-               owner_color, pw ? pw->pw_name : "?",
-               group_color, gr ? gr->gr_name : "?",
-               TERM_RESET, size_str,
-               TERM_CYANBRIGHT, date,
-               file_color, entries[i]->d_name,
-               S_ISLNK(st.st_mode) ? "@" : "",
-               TERM_RESET
-        );
-        free(entries[i]);
+        input_set_fd(fd);
     }
-    free(entries);
-    closedir(dir);
-}
 
-bool is_number(const char *str) {
-    for (size_t i = 0; str[i] != '\0'; ++i) {
-        if (!isdigit(str[i])) return false;
+    // Blocos de INPUT_CHUNK bytes; a linha é usada direto do buffer de entrada
+    char *line;
+    size_t len;
+    while ((line = input_next_line(&len)) != NULL) {
+        jobs_notify();
+        if (run_line(line, len, &status)) break;
     }
-    return true;
-}
 
-void strmode(mode_t mode, char *str) {
-    str[0] = S_ISDIR(mode) ? 'd' : S_ISLNK(mode) ? 'l' : '-';
-    for (int i = 0; i < 9; i++) {
-        const char *chars = "rwxrwxrwx";
-        str[i + 1] = (mode & (1 << (8 - i))) ? chars[i] : '-';
-    }
-    str[10] = '\0';
+    if (script) close(fd);
+    return status;
 }
 
-int compare_pids(const void *a, const void *b) {
-    return (*(pid_t *) a - *(pid_t *) b);
-}
-
-static void mode_to_str(mode_t mode, char *str) {
-    str[0] = (mode & S_IFDIR) ? 'd' : (mode & S_IFLNK) ? 'l' : '-';
-    str[1] = (mode & S_IRUSR) ? 'r' : '-';
-    str[2] = (mode & S_IWUSR) ? 'w' : '-';
-    str[3] = (mode & S_IXUSR) ? 'x' : '-';
-    str[4] = (mode & S_IRGRP) ? 'r' : '-';
-    str[5] = (mode & S_IWGRP) ? 'w' : '-';
-    str[6] = (mode & S_IXGRP) ? 'x' : '-';
-    str[7] = (mode & S_IROTH) ? 'r' : '-';
-    str[8] = (mode & S_IWOTH) ? 'w' : '-';
-    str[9] = (mode & S_IXOTH) ? 'x' : '-';
-    str[10] = '\0';
-}
-
-static char *human_readable_size(long bytes) {
-    static char buf[32];
-    char units[] = "BKMGTP";
-    int i = 0;
-    double size = bytes;
+/*****************************************************************************/
 
-    while (size >= 1024 && units[i + 1]) {
-        size /= 1024;
-        i++;
-    }
+void welcome_message() {
+    term_out_str(TERM_CYAN "┍");
+    term_out_repeat("━", TERM_WIDTH - 2);
+    term_out_str("┑" TERM_RESET "\n");
 
-    snprintf(buf, sizeof(buf), "%.1f%c", size, units[i]);
-    return buf;
+    char *msg = "WELCOME TO GREGORIOUS SHELL";
+    const int spaces = (int) (TERM_WIDTH - strlen(msg) - 2) / 2;
+    term_out_str(TERM_CYAN "│");
+    term_out_repeat(" ", spaces > 0 ? (size_t) spaces : 0);
+    term_out_str(TERM_YELLOW);
+    term_out_str(msg);
+    term_out_str(TERM_CYAN);
+    term_out_repeat(" ", spaces + 1 > 0 ? (size_t) spaces + 1 : 0);
+    term_out_str("│\n");
+    term_out_str(TERM_CYAN "┕");
+    term_out_repeat("━", TERM_WIDTH - 2);
+    term_out_str("┙" TERM_RESET "\n");
+    term_out_str(TERM_GREEN "\n"
+                 "Type 'help' for a list of commands.\n"
+                 "Type 'exit' to exit the shell.\n"
+                 TERM_RESET "\n");
 }
 
 
@@ -583,3 +309,28 @@ static char *human_readable_size(long bytes) {
 // v1.4.1 (Apr 15 2025 - 10:22) - Fix trunk warning at __LINE__ 260
 // v1.4.2 (Apr 22 2025 - 09:48) - Clean the terminal before showing the prompt
 // v1.4.3 (Apr 22 2025 - 09:51) - Fix the warning at __LINE__ 463
+// v1.5.0 (Oct 17 2026 - 09:10) - `tree` now builds a single /proc snapshot (PID index + CSR children) per call
+// v1.5.1 (Oct 17 2026 - 10:05) - /proc/<pid>/stat reader moved to proc_tools (openat + single read(), no stdio)
+// v1.5.2 (Oct 17 2026 - 11:20) - Parallel /proc scan for `tree` (getdents64 + thread pool), `-j N` and `-t` options
+// v1.6.0 (Oct 17 2026 - 14:02) - Creating `mon` command (CPU deltas per PID, redraws only changed lines)
+// v1.6.1 (Oct 17 2026 - 15:30) - uid/gid name cache for `lf -l` and `tree -u`, `idcache` command
+// v1.7.0 (Oct 17 2026 - 16:40) - `lf` reads with getdents64, sorts an arena of names, `lf -U` streams without sorting
+// v1.7.1 (Oct 17 2026 - 17:25) - `lf` stats relative to the directory fd (statx with only the shown fields), short listing trusts d_type
+// v1.7.2 (Oct 17 2026 - 18:10) - `lf -l -j N` fetches metadata with N threads and prints in sorted order
+// v1.8.0 (Oct 17 2026 - 19:00) - Built-ins write through term_out (one write() per screen/64 KB), `lf -l` rows without printf
+// v1.9.0 (Oct 17 2026 - 20:15) - Pipelines (`|`) and redirections (`<`, `>`, `>>`, `2>&1`) in the shell itself; built-ins write straight into the pipe
+// v1.9.1 (Oct 17 2026 - 21:00) - External commands launched with posix_spawnp (no page-table copy), startup clear without `system`
+// v1.9.2 (Oct 17 2026 - 21:40) - PATH lookups cached per session (invalidated by PATH/dir mtime changes), `hash` command
+// v2.0.0 (Oct 17 2026 - 22:30) - Job control: job table, process groups, `jobs`/`fg`/`bg`/`wait`/`kill`, child events via signalfd + epoll
+// v2.1.0 (Oct 17 2026 - 23:20) - Line editor (arrows, Home/End, Ctrl-R) and persistent history in ~/.t1_history with trigram-indexed reverse search
+// v2.2.0 (Oct 17 2026 - 23:50) - `-c CMD` and script modes (no terminal setup, 64 KB input chunks, no line-length cap), parsed lines cached per script line
+// v2.3.0 (Oct 17 2026 - 23:59) - Real lexer/parser (quotes, escapes, `$VAR`, `;`/`&&`/`||`, unspaced operators) into a per-command arena, no line/argument limits
+// v2.4.0 (Oct 18 2026 - 00:40) - `par` command: bounded parallel runs with per-command output, exit codes and timing; thread-safe builtins run in-process with work stealing
+// v2.5.0 (Oct 18 2026 - 01:30) - Per-command accounting (wall, CPU, max RSS, context switches) into HDR-style histograms: `stats`, `time CMD`, NDJSON/binary stream
+// v2.6.0 (Oct 18 2026 - 02:20) - Builtins split into builtins.c and a `shell_core` library; `shell_bench` microbenchmarks over generated fixtures with JSON output
+// v2.7.0 (Oct 18 2026 - 03:10) - Parallel recursive walker (per-thread deques with stealing, bottom-up subtree totals, hardlink dedup): `lf -R` and `usage`
+// v2.8.0 (Oct 18 2026 - 03:50) - Session cache of sorted `lf` listings and statx results keyed by (dev, inode), invalidated via inotify, LRU-capped; `lf --no-cache`, `--cache`, `--cache-clear`
+// v2.9.0 (Oct 18 2026 - 04:45) - `search` built-in: fixed-string search over the parallel walker, read/mmap by size, binary skip, SSE2/AVX2 first/last-byte filter picked at runtime
+// v2.10.0 (Oct 18 2026 - 05:40) - Native glob expansion (`*`, `?`, `[...]`, `**`): compiled non-backtracking matcher, per-command directory read cache, arena-backed argv
+// v2.11.0 (Oct 18 2026 - 06:25) - `tree --rss --cpu --threads --fds`: inclusive subtree totals in one post-order pass, `-s` sibling sorting and `--min` pruning, iterative rendering without the depth-16 ancestors array
+// v2.12.0 (Oct 18 2026 - 07:20) - `tree --watch`: live process tree driven by netlink proc connector events (recvmmsg batches, sibling-list tree with PID hash, exit tombstones), /proc resync on ENOBUFS and /proc polling fallback, fork_storm bench
@@ -0,0 +1,517 @@
+#include "mon.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+#include "proc_tools.h"
+#include "screen.h"
+
+// Linhas fixas da tela: status, cabeçalho e rodapé
+#define MON_HEADER_ROWS 2
+#define MON_FOOTER_ROWS 1
+
+/*****************************************************************************/
+
+enum mon_sort { MON_SORT_CPU, MON_SORT_RSS };
+
+/**
+ * @brief Amostra anterior de um processo, guardada na tabela hash por PID.
+ */
+struct mon_sample {
+    pid_t pid;                     // 0 = posição livre
+    unsigned long long starttime;  // Distingue PIDs reaproveitados
+    unsigned long long ticks;      // utime + stime
+    double sampled_at;             // Relógio do monitor na última leitura real
+    unsigned idle;                 // Leituras seguidas sem consumo de CPU
+    bool skipped;                  // Dispensado de reler neste ciclo
+};
+
+struct mon_hash {
+    struct mon_sample *slots;
+    size_t capacity;               // Potência de 2
+};
+
+struct mon_row {
+    const struct process_info *proc;
+    double cpu;                    // Percentual de uma CPU
+    long rss_kb;
+};
+
+struct mon_state {
+    struct process_table table;
+    struct mon_hash previous;
+    struct mon_hash current;
+    struct mon_row *rows;
+    size_t row_capacity;
+    size_t row_count;
+    struct mon_row *top;
+    size_t top_capacity;
+
+    struct screen scr;
+    size_t term_rows;
+    size_t term_cols;
+
+    double interval;
+    size_t top_n;                  // 0 = o que couber na tela
+    enum mon_sort sort;
+    double clock;                  // Segundos somados das amostras
+    unsigned long cycle;
+    double cycle_ms;               // CPU gasta pelo último ciclo
+    double cpu_share;              // CPU gasta / tempo decorrido, desde o início
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Garante capacidade para `count` processos a 50% de ocupação e zera a tabela.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int hash_reset(struct mon_hash *hash, size_t count);
+
+/**
+ * @brief Procura o slot de `pid` (ou o slot livre onde ele entraria).
+ */
+static struct mon_sample *hash_slot(const struct mon_hash *hash, pid_t pid);
+
+/**
+ * @brief Relê o /proc e calcula CPU% e RSS de cada processo em relação à amostra anterior.
+ * @param st Estado do monitor.
+ * @param elapsed Segundos desde a amostra anterior (0 na primeira).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int sample(struct mon_state *st, double elapsed);
+
+/**
+ * @brief Decide se um processo da amostra anterior precisa ser relido (callback de `refresh`).
+ *
+ * Processos parados há algumas amostras são relidos só a cada MON_IDLE_STRIDE
+ * ciclos, escalonados pelo PID; ao voltarem a usar CPU, são relidos a cada ciclo.
+ * @param previous Leitura anterior do processo.
+ * @param ctx Estado do monitor.
+ * @return true para reler, false para repetir a leitura anterior.
+ */
+static bool refresh_process(const struct process_info *previous, void *ctx);
+
+/**
+ * @brief Seleciona os N maiores processos pelo critério atual (heap de mínimo).
+ * @param st Estado do monitor.
+ * @param n Quantidade desejada.
+ * @return Quantidade selecionada, em ordem decrescente.
+ */
+static size_t select_top(struct mon_state *st, size_t n);
+
+/**
+ * @brief Monta o quadro e redesenha apenas as linhas alteradas.
+ * @param st Estado do monitor.
+ */
+static void render(struct mon_state *st);
+
+/**
+ * @brief Compara duas linhas pelo critério atual (a > b retorna positivo).
+ */
+static int compare_rows(const struct mon_row *a, const struct mon_row *b, enum mon_sort sort);
+
+/**
+ * @brief Segundos de CPU (usuário + sistema) consumidos pelo próprio shell.
+ */
+static double self_cpu_seconds(void);
+
+/**
+ * @brief Segundos do relógio monotônico.
+ */
+static double now_seconds(void);
+
+/*****************************************************************************/
+
+int mon_run(const int argc, char **argv) {
+    struct mon_state st = {.interval = 1.0, .sort = MON_SORT_CPU};
+    st.table.keep_open = true;
+    st.table.refresh = refresh_process;
+    st.table.refresh_ctx = &st;
+    long max_cycles = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            term_out_str(TERM_CYAN_BOLD "Uso: mon [OPÇÕES]" TERM_RESET "\n"
+                         "Monitorar os processos que mais usam CPU ou memória\n\n"
+                         TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                         "  -d SEG\t\tIntervalo de atualização (padrão: 1)\n"
+                         "  -n N\t\tQuantidade de processos (padrão: o que couber na tela)\n"
+                         "  -s cpu|rss\tCritério de ordenação (padrão: cpu)\n"
+                         "  -c N\t\tSair após N atualizações\n"
+                         "  --help\t\tExibir esta ajuda\n"
+                         "\n" TERM_YELLOW_BOLD "Teclas:" TERM_RESET " q sair, c ordenar por CPU, m ordenar por memória\n");
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            term_out_printf("%sOpção inválida: %s%s\n", TERM_RED_BOLD, argv[i], TERM_RESET);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-d") == 0) st.interval = strtod(value, NULL);
+        else if (strcmp(argv[i - 1], "-n") == 0) st.top_n = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i - 1], "-c") == 0) max_cycles = strtol(value, NULL, 10);
+        else if (strcmp(argv[i - 1], "-s") == 0 && strcmp(value, "cpu") == 0) st.sort = MON_SORT_CPU;
+        else if (strcmp(argv[i - 1], "-s") == 0 && strcmp(value, "rss") == 0) st.sort = MON_SORT_RSS;
+        else {
+            term_out_printf("%sOpção inválida: %s %s%s\n", TERM_RED_BOLD, argv[i - 1], value, TERM_RESET);
+            return 1;
+        }
+    }
+    if (st.interval < 0.05) st.interval = 0.05;
+
+    st.term_rows = getTerminalRows() > 0 ? getTerminalRows() : 24;
+    st.term_cols = getTerminalCols() > 0 ? getTerminalCols() : 80;
+
+    // Primeira amostra: base para os deltas de CPU
+    if (sample(&st, 0) != 0) {
+        term_out_str(TERM_RED_BOLD "Erro ao ler /proc" TERM_RESET "\n");
+        free_process_table(&st.table);
+        return 1;
+    }
+
+    // Teclas sem eco e sem esperar Enter (Ctrl-C chega como byte e também encerra)
+    const bool interactive = isatty(STDIN_FILENO);
+    struct termios saved_termios;
+    if (interactive && tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+        struct termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+
+    term_out_flush();
+    static const char enter[] = TERM_ALT_SCREEN_ENTER TERM_CURSOR_HIDE;
+    write(STDOUT_FILENO, enter, sizeof(enter) - 1);
+    screen_init(&st.scr, st.term_rows);
+
+    const double start_wall = now_seconds();
+    const double start_cpu = self_cpu_seconds();
+    double last_sample = start_wall;
+    double next_sample = start_wall + st.interval;
+    bool running = true;
+    bool redraw = true;
+    long cycles = 0;
+
+    while (running) {
+        if (redraw) {
+            render(&st);
+            redraw = false;
+        }
+
+        // Esperar o próximo ciclo atendendo às teclas
+        double remaining = next_sample - now_seconds();
+        if (remaining > 0) {
+            if (interactive) {
+                struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+                if (poll(&pfd, 1, (int) (remaining * 1000) + 1) > 0) {
+                    char keys[16];
+                    const ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+                    for (ssize_t k = 0; k < n; k++) {
+                        if (keys[k] == 'q' || keys[k] == 'Q' || keys[k] == 3) running = false;
+                        else if (keys[k] == 'c') st.sort = MON_SORT_CPU;
+                        else if (keys[k] == 'm') st.sort = MON_SORT_RSS;
+                    }
+                    redraw = true;
+                    continue;
+                }
+            } else {
+                const struct timespec ts = {
+                    .tv_sec = (time_t) remaining,
+                    .tv_nsec = (long) ((remaining - (double) (time_t) remaining) * 1e9)
+                };
+                nanosleep(&ts, NULL);
+            }
+            continue;
+        }
+
+        // Ciclo: reler o /proc, calcular deltas e redesenhar
+        const double cycle_cpu = self_cpu_seconds();
+        const double now = now_seconds();
+        const size_t rows = getTerminalRows() > 0 ? getTerminalRows() : st.term_rows;
+        const size_t cols = getTerminalCols() > 0 ? getTerminalCols() : st.term_cols;
+        if (rows != st.term_rows || cols != st.term_cols) {
+            st.term_rows = rows;
+            st.term_cols = cols;
+            screen_resize(&st.scr, rows);
+        }
+        mon_cycle(&st, now - last_sample);
+        last_sample = now;
+        next_sample = now + st.interval;
+
+        st.cycle_ms = (self_cpu_seconds() - cycle_cpu) * 1e3;
+        st.cpu_share = (self_cpu_seconds() - start_cpu) / (now_seconds() - start_wall) * 100;
+        if (max_cycles > 0 && ++cycles >= max_cycles) running = false;
+    }
+
+    static const char leave[] = TERM_CURSOR_SHOW TERM_ALT_SCREEN_LEAVE;
+    write(STDOUT_FILENO, leave, sizeof(leave) - 1);
+    if (interactive) tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+
+    // Orçamento medido: CPU do shell em relação ao tempo total do monitor
+    const double wall = now_seconds() - start_wall;
+    const double cpu = self_cpu_seconds() - start_cpu;
+    term_out_printf("%smon: %ld ciclos em %.1f s | %.3f s de CPU | %.2f%% de uma CPU%s\n",
+                    TERM_CYANBRIGHT, cycles, wall, cpu, wall > 0 ? cpu / wall * 100 : 0.0, TERM_RESET);
+
+    screen_free(&st.scr);
+    free_process_table(&st.table);
+    free(st.previous.slots);
+    free(st.current.slots);
+    free(st.rows);
+    free(st.top);
+    return 0;
+}
+
+struct mon_state *mon_state_new(const size_t rows, const size_t cols) {
+    struct mon_state *st = calloc(1, sizeof(struct mon_state));
+    if (!st) return NULL;
+    *st = (struct mon_state){.interval = 1.0, .sort = MON_SORT_CPU, .term_rows = rows, .term_cols = cols};
+    st->table.keep_open = true;
+    st->table.refresh = refresh_process;
+    st->table.refresh_ctx = st;
+    if (screen_init(&st->scr, rows) != 0) {
+        free(st);
+        return NULL;
+    }
+    return st;
+}
+
+int mon_cycle(struct mon_state *st, const double elapsed) {
+    if (sample(st, elapsed) != 0) return -1;
+    render(st);
+    return 0;
+}
+
+void mon_state_free(struct mon_state *st) {
+    if (!st) return;
+    screen_free(&st->scr);
+    free_process_table(&st->table);
+    free(st->previous.slots);
+    free(st->current.slots);
+    free(st->rows);
+    free(st->top);
+    free(st);
+}
+
+/*****************************************************************************/
+
+static int hash_reset(struct mon_hash *hash, const size_t count) {
+    size_t capacity = hash->capacity ? hash->capacity : 1024;
+    while (capacity < count * 2) capacity *= 2;
+
+    if (capacity != hash->capacity) {
+        struct mon_sample *slots = realloc(hash->slots, capacity * sizeof(struct mon_sample));
+        if (!slots) return -1;
+        hash->slots = slots;
+        hash->capacity = capacity;
+    }
+    memset(hash->slots, 0, hash->capacity * sizeof(struct mon_sample));
+    return 0;
+}
+
+static struct mon_sample *hash_slot(const struct mon_hash *hash, const pid_t pid) {
+    if (!hash->capacity) return NULL;
+
+    const size_t mask = hash->capacity - 1;
+    size_t i = ((size_t) pid * 2654435761u) & mask;
+    while (hash->slots[i].pid != 0 && hash->slots[i].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return &hash->slots[i];
+}
+
+static int sample(struct mon_state *st, const double elapsed) {
+    st->cycle++;
+    st->clock += elapsed;
+    if (scan_processes(&st->table, 1) != 0) return -1;
+
+    const size_t count = st->table.count;
+    if (hash_reset(&st->current, count) != 0) return -1;
+    if (count > st->row_capacity) {
+        struct mon_row *rows = realloc(st->rows, count * sizeof(struct mon_row));
+        if (!rows) return -1;
+        st->rows = rows;
+        st->row_capacity = count;
+    }
+
+    static long clock_ticks = 0, page_kb = 0;
+    if (!clock_ticks) {
+        clock_ticks = sysconf(_SC_CLK_TCK);
+        page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const struct process_info *proc = &st->table.procs[i];
+        const unsigned long long ticks = proc->utime + proc->stime;
+
+        // Delta em relação à amostra anterior do mesmo processo (mesmo PID e mesmo início)
+        const struct mon_sample *prev = hash_slot(&st->previous, proc->pid);
+        const bool known = prev && prev->pid == proc->pid && prev->starttime == proc->starttime;
+        struct mon_sample *slot = hash_slot(&st->current, proc->pid);
+        double cpu = 0;
+
+        if (known && prev->skipped) {
+            // Não relido: a amostra anterior continua valendo
+            *slot = *prev;
+            slot->skipped = false;
+        } else {
+            const unsigned long long delta = known && ticks >= prev->ticks ? ticks - prev->ticks : 0;
+            *slot = (struct mon_sample){
+                .pid = proc->pid,
+                .starttime = proc->starttime,
+                .ticks = ticks,
+                .sampled_at = st->clock,
+                .idle = known && delta == 0 ? prev->idle + 1 : 0
+            };
+
+            // Um processo relido após alguns ciclos tem o delta dividido pelo intervalo inteiro
+            const double span = known ? st->clock - prev->sampled_at : 0;
+            if (span > 0) cpu = (double) delta / ((double) clock_ticks * span) * 100;
+        }
+
+        st->rows[i] = (struct mon_row){.proc = proc, .cpu = cpu, .rss_kb = proc->rss * page_kb};
+    }
+    st->row_count = count;
+
+    // A amostra atual vira a anterior do próximo ciclo
+    const struct mon_hash swap = st->previous;
+    st->previous = st->current;
+    st->current = swap;
+    return 0;
+}
+
+static bool refresh_process(const struct process_info *previous, void *ctx) {
+    const struct mon_state *st = ctx;
+    struct mon_sample *prev = hash_slot(&st->previous, previous->pid);
+    if (!prev || prev->pid != previous->pid || prev->idle < MON_IDLE_CYCLES) return true;
+
+    // Escalonar pelo PID espalha as releituras entre os ciclos
+    if ((st->cycle + (unsigned long) previous->pid) % MON_IDLE_STRIDE == 0) return true;
+    prev->skipped = true;
+    return false;
+}
+
+static size_t select_top(struct mon_state *st, size_t n) {
+    if (n > st->row_count) n = st->row_count;
+    if (n > st->top_capacity) {
+        struct mon_row *top = realloc(st->top, n * sizeof(struct mon_row));
+        if (!top) return 0;
+        st->top = top;
+        st->top_capacity = n;
+    }
+    if (n == 0) return 0;
+
+    // Heap de mínimo com os N maiores: a raiz é o menor deles
+    size_t size = 0;
+    for (size_t i = 0; i < st->row_count; i++) {
+        const struct mon_row *row = &st->rows[i];
+        size_t pos;
+        if (size < n) {
+            pos = size++;
+            while (pos > 0 && compare_rows(row, &st->top[(pos - 1) / 2], st->sort) < 0) {
+                st->top[pos] = st->top[(pos - 1) / 2];
+                pos = (pos - 1) / 2;
+            }
+        } else {
+            if (compare_rows(row, &st->top[0], st->sort) <= 0) continue;
+            pos = 0;
+            while (true) {
+                size_t child = 2 * pos + 1;
+                if (child >= size) break;
+                if (child + 1 < size && compare_rows(&st->top[child + 1], &st->top[child], st->sort) < 0) child++;
+                if (compare_rows(&st->top[child], row, st->sort) >= 0) break;
+                st->top[pos] = st->top[child];
+                pos = child;
+            }
+        }
+        st->top[pos] = *row;
+    }
+
+    // Retirar o mínimo repetidamente deixa o vetor em ordem decrescente
+    for (size_t end = size; end > 1; end--) {
+        const struct mon_row min = st->top[0];
+        const struct mon_row last = st->top[end - 1];
+        size_t pos = 0;
+        while (true) {
+            size_t child = 2 * pos + 1;
+            if (child >= end - 1) break;
+            if (child + 1 < end - 1 && compare_rows(&st->top[child + 1], &st->top[child], st->sort) < 0) child++;
+            if (compare_rows(&st->top[child], &last, st->sort) >= 0) break;
+            st->top[pos] = st->top[child];
+            pos = child;
+        }
+        st->top[pos] = last;
+        st->top[end - 1] = min;
+    }
+    return size;
+}
+
+static void render(struct mon_state *st) {
+    const size_t body_rows = st->term_rows > MON_HEADER_ROWS + MON_FOOTER_ROWS
+                                 ? st->term_rows - MON_HEADER_ROWS - MON_FOOTER_ROWS
+                                 : 0;
+    const size_t wanted = st->top_n && st->top_n < body_rows ? st->top_n : body_rows;
+    const size_t shown = select_top(st, wanted);
+    const int name_width = st->term_cols > 40 ? (int) st->term_cols - 40 : 8;
+
+    char line[512];
+    int len = snprintf(line, sizeof(line),
+                       "%smon%s  %zu processos | intervalo %.2fs | ordem: %s | custo %.2f ms/ciclo, %.2f%% CPU",
+                       TERM_CYAN_BOLD, TERM_RESET, st->row_count, st->interval,
+                       st->sort == MON_SORT_CPU ? "CPU" : "memória", st->cycle_ms, st->cpu_share);
+    screen_line(&st->scr, 0, line, len < (int) sizeof(line) ? len : (int) (sizeof(line) - 1));
+
+    len = snprintf(line, sizeof(line), "%s%8s %2s %7s %10s %5s  %-*.*s%s", TERM_YELLOW_BOLD,
+                   "PID", "S", "CPU%", "RSS", "THR", name_width, name_width, "NOME", TERM_RESET);
+    screen_line(&st->scr, 1, line, len < (int) sizeof(line) ? len : (int) (sizeof(line) - 1));
+
+    for (size_t i = 0; i < body_rows; i++) {
+        len = 0;
+        if (i < shown) {
+            const struct mon_row *row = &st->top[i];
+            len = snprintf(line, sizeof(line), "%8d %2c %s%7.1f%s %9.1fM %5ld  %s%.*s%s",
+                           row->proc->pid, row->proc->state,
+                           row->cpu >= 50 ? TERM_RED_BOLD : row->cpu >= 5 ? TERM_YELLOW : "",
+                           row->cpu, TERM_RESET, (double) row->rss_kb / 1024, row->proc->num_threads,
+                           TERM_GREEN, name_width, row->proc->name, TERM_RESET);
+        }
+        screen_line(&st->scr, MON_HEADER_ROWS + i, line, len < (int) sizeof(line) ? len : (int) (sizeof(line) - 1));
+    }
+
+    len = snprintf(line, sizeof(line), "%sq%s sair  %sc%s CPU  %sm%s memória", TERM_CYAN_BOLD, TERM_RESET,
+                   TERM_CYAN_BOLD, TERM_RESET, TERM_CYAN_BOLD, TERM_RESET);
+    screen_line(&st->scr, st->term_rows - 1, line, len < (int) sizeof(line) ? len : (int) (sizeof(line) - 1));
+
+    screen_flush(&st->scr, STDOUT_FILENO);
+}
+
+static int compare_rows(const struct mon_row *a, const struct mon_row *b, const enum mon_sort sort) {
+    if (sort == MON_SORT_CPU && a->cpu != b->cpu) return a->cpu > b->cpu ? 1 : -1;
+    if (a->rss_kb != b->rss_kb) return a->rss_kb > b->rss_kb ? 1 : -1;
+    return (a->proc->pid < b->proc->pid) - (a->proc->pid > b->proc->pid);
+}
+
+static double self_cpu_seconds(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           (double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
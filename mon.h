@@ -0,0 +1,54 @@
+//
+// Comando `mon`: monitor de processos no estilo `top`.
+//
+
+#ifndef MON_H
+#define MON_H
+
+#include <stddef.h>
+
+// Processos sem CPU há MON_IDLE_CYCLES amostras só são relidos a cada MON_IDLE_STRIDE ciclos
+#define MON_IDLE_CYCLES 3
+#define MON_IDLE_STRIDE 4
+
+/**
+ * @brief Executa o monitor de processos até o usuário sair (tecla `q`).
+ *
+ * A cada intervalo o /proc é relido, o uso de CPU é calculado pela diferença
+ * em relação à amostra anterior (tabela hash por PID) e só as linhas da tela
+ * que mudaram são redesenhadas. Processos parados não são relidos a cada
+ * ciclo (MON_IDLE_STRIDE), o que mantém o custo baixo em hosts com dezenas
+ * de milhares de processos.
+ * @param argc Quantidade de argumentos (incluindo "mon").
+ * @param argv Argumentos do comando.
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+int mon_run(int argc, char **argv);
+
+/**
+ * @brief Estado do monitor (amostra anterior, linhas e tela).
+ */
+struct mon_state;
+
+/**
+ * @brief Cria o estado de um monitor sem terminal, para medir o ciclo (`shell_bench`).
+ * @param rows Linhas da tela simulada (o top-N é o que couber).
+ * @param cols Colunas da tela simulada.
+ * @return Estado (liberar com `mon_state_free`), ou NULL em caso de erro.
+ */
+struct mon_state *mon_state_new(size_t rows, size_t cols);
+
+/**
+ * @brief Um ciclo do monitor: relê o /proc, calcula os deltas, escolhe o top-N e redesenha na saída padrão.
+ * @param st Estado do monitor.
+ * @param elapsed Segundos desde o ciclo anterior (0 no primeiro).
+ * @return 0 em caso de sucesso, -1 se o /proc não puder ser lido.
+ */
+int mon_cycle(struct mon_state *st, double elapsed);
+
+/**
+ * @brief Libera o estado criado por `mon_state_new`.
+ */
+void mon_state_free(struct mon_state *st);
+
+#endif //MON_H
@@ -0,0 +1,210 @@
+#include "name_cache.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+#include <pthread.h>
+
+#define NAME_CACHE_INITIAL_CAPACITY 256
+#define NAME_ARENA_CHUNK 4096
+
+/*****************************************************************************/
+
+enum name_kind { NAME_USER = 1, NAME_GROUP = 2 };
+
+struct name_entry {
+    uint64_t key;         // (tipo << 32) | id; 0 = posição livre
+    const char *name;     // NULL = não existe (cache negativo)
+    time_t expires;
+};
+
+// Bloco da arena de nomes; os blocos nunca se movem, então os ponteiros continuam válidos
+struct name_chunk {
+    struct name_chunk *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+/*****************************************************************************/
+
+static struct name_entry *table = NULL;
+static size_t capacity = 0;
+static size_t count = 0;
+static struct name_chunk *arena = NULL;
+static struct name_cache_stats stats = {0};
+// `lf` pode rodar em várias threads ao mesmo tempo (`par`); getpwuid também não é reentrante
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*****************************************************************************/
+
+/**
+ * @brief Busca (ou resolve pelo NSS) o nome de um uid/gid.
+ * @param kind Usuário ou grupo.
+ * @param id uid ou gid.
+ * @return Nome internado, ou NULL se não existir.
+ */
+static const char *lookup(enum name_kind kind, uint32_t id);
+
+/**
+ * @brief Procura o slot da chave (ou o slot livre onde ela entraria).
+ */
+static struct name_entry *find_slot(uint64_t key);
+
+/**
+ * @brief Dobra a tabela e reinsere as entradas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int grow(void);
+
+/**
+ * @brief Copia um nome para a arena.
+ * @param name Nome a ser copiado.
+ * @return Cópia internada, ou NULL em caso de erro de alocação.
+ */
+static const char *intern(const char *name);
+
+/**
+ * @brief Segundos do relógio monotônico.
+ */
+static time_t now_seconds(void);
+
+/*****************************************************************************/
+
+const char *name_cache_user(const uid_t uid) {
+    pthread_mutex_lock(&lock);
+    const char *name = lookup(NAME_USER, uid);
+    pthread_mutex_unlock(&lock);
+    return name;
+}
+
+const char *name_cache_group(const gid_t gid) {
+    pthread_mutex_lock(&lock);
+    const char *name = lookup(NAME_GROUP, gid);
+    pthread_mutex_unlock(&lock);
+    return name;
+}
+
+struct name_cache_stats name_cache_get_stats(void) {
+    pthread_mutex_lock(&lock);
+    struct name_cache_stats current = stats;
+    current.entries = count;
+    pthread_mutex_unlock(&lock);
+    return current;
+}
+
+void name_cache_clear(void) {
+    pthread_mutex_lock(&lock);
+    free(table);
+    while (arena) {
+        struct name_chunk *next = arena->next;
+        free(arena);
+        arena = next;
+    }
+    table = NULL;
+    capacity = count = 0;
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&lock);
+}
+
+/*****************************************************************************/
+
+static const char *lookup(const enum name_kind kind, const uint32_t id) {
+    if (!table && grow() != 0) return NULL;
+
+    const uint64_t key = (uint64_t) kind << 32 | id;
+    struct name_entry *slot = find_slot(key);
+    const time_t now = now_seconds();
+
+    if (slot->key == key && slot->expires > now) {
+        stats.hits++;
+        return slot->name;
+    }
+
+    // Falha ou entrada vencida: consultar o NSS
+    stats.misses++;
+    const char *resolved = NULL;
+    if (kind == NAME_USER) {
+        const struct passwd *pw = getpwuid(id);
+        if (pw) resolved = pw->pw_name;
+    } else {
+        const struct group *gr = getgrgid(id);
+        if (gr) resolved = gr->gr_name;
+    }
+
+    const char *name = NULL;
+    if (resolved) {
+        // Renovação com o mesmo nome reaproveita a cópia já internada
+        name = slot->key == key && slot->name && strcmp(slot->name, resolved) == 0 ? slot->name : intern(resolved);
+    }
+
+    if (slot->key != key) {
+        if ((count + 1) * 2 > capacity) {
+            if (grow() != 0) return name;
+            slot = find_slot(key);
+        }
+        count++;
+    } else if (slot->name == NULL) {
+        stats.negative--;
+    }
+    if (!name) stats.negative++;
+
+    slot->key = key;
+    slot->name = name;
+    slot->expires = now + NAME_CACHE_TTL;
+    return name;
+}
+
+static struct name_entry *find_slot(const uint64_t key) {
+    const size_t mask = capacity - 1;
+    size_t i = (size_t) (key * 0x9E3779B97F4A7C15ull >> 32) & mask;
+    while (table[i].key != 0 && table[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static int grow(void) {
+    const size_t new_capacity = capacity ? capacity * 2 : NAME_CACHE_INITIAL_CAPACITY;
+    struct name_entry *new_table = calloc(new_capacity, sizeof(struct name_entry));
+    if (!new_table) return -1;
+
+    struct name_entry *old_table = table;
+    const size_t old_capacity = capacity;
+    table = new_table;
+    capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].key != 0) *find_slot(old_table[i].key) = old_table[i];
+    }
+    free(old_table);
+    return 0;
+}
+
+static const char *intern(const char *name) {
+    const size_t len = strlen(name) + 1;
+    if (!arena || arena->used + len > arena->size) {
+        const size_t size = len > NAME_ARENA_CHUNK ? len : NAME_ARENA_CHUNK;
+        struct name_chunk *chunk = malloc(sizeof(struct name_chunk) + size);
+        if (!chunk) return NULL;
+        chunk->next = arena;
+        chunk->used = 0;
+        chunk->size = size;
+        arena = chunk;
+    }
+
+    char *copy = arena->data + arena->used;
+    memcpy(copy, name, len);
+    arena->used += len;
+    return copy;
+}
+
+static time_t now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
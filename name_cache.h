@@ -0,0 +1,46 @@
+//
+// Cache de nomes de usuário/grupo (uid/gid -> nome) válido por toda a sessão.
+//
+
+#ifndef NAME_CACHE_H
+#define NAME_CACHE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Tempo de vida de cada entrada, em segundos (inclusive das consultas sem resultado)
+#define NAME_CACHE_TTL 300
+
+struct name_cache_stats {
+    size_t hits;
+    size_t misses;    // Consultas que foram ao NSS (getpwuid/getgrgid)
+    size_t entries;
+    size_t negative;  // Entradas de uid/gid sem nome
+};
+
+/**
+ * @brief Nome do usuário de `uid`, consultando o NSS só na primeira vez (ou após o TTL).
+ * @param uid Identificador do usuário.
+ * @return Nome internado (válido até `name_cache_clear`), ou NULL se não existir.
+ */
+const char *name_cache_user(uid_t uid);
+
+/**
+ * @brief Nome do grupo de `gid`, consultando o NSS só na primeira vez (ou após o TTL).
+ * @param gid Identificador do grupo.
+ * @return Nome internado (válido até `name_cache_clear`), ou NULL se não existir.
+ */
+const char *name_cache_group(gid_t gid);
+
+/**
+ * @brief Contadores de acertos e falhas do cache.
+ * @return Estatísticas acumuladas desde o início da sessão (ou do último `name_cache_clear`).
+ */
+struct name_cache_stats name_cache_get_stats(void);
+
+/**
+ * @brief Descarta todas as entradas e zera os contadores.
+ */
+void name_cache_clear(void);
+
+#endif //NAME_CACHE_H
@@ -0,0 +1,606 @@
+#include "par.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "parallel.h"
+#include "term_out.h"
+#include "term_tools.h"
+
+// Bloco de leitura dos pipes dos filhos e da entrada padrão
+#define PAR_READ_CHUNK (64 * 1024)
+// Sem pidfd (kernel < 5.3), intervalo em que os filhos são verificados com waitpid
+#define PAR_POLL_MS 10
+
+/*****************************************************************************/
+
+struct par_result {
+    struct term_out_capture out;  // Saída padrão da execução
+    struct term_out_capture err;  // Erro padrão (só nos comandos externos)
+    int status;                   // Código de saída (128 + sinal se morto por sinal)
+    double wall_ms;               // Tempo de relógio
+    double cpu_ms;                // Tempo de CPU (filho, ou a thread no comando interno)
+    bool done;
+};
+
+struct par_job {
+    char **command;     // Modelo: COMANDO [ARGS...]
+    int command_argc;
+    bool placeholder;   // Algum argumento tem `{}`
+    char **inputs;
+    size_t count;
+    struct par_result *results;
+    builtin_fn builtin; // Comando interno, ou NULL para externo
+    bool keep_order;    // -k: exibir na ordem das entradas
+    bool quiet;         // -q: sem a linha de cada execução
+
+    pthread_mutex_t lock; // Protege a exibição e os contadores abaixo
+    size_t next_shown;    // -k: próxima entrada a exibir
+    size_t failed;
+};
+
+// Processo externo em execução
+struct par_child {
+    pid_t pid;
+    int pidfd;           // -1 sem pidfd: o filho é verificado a cada PAR_POLL_MS
+    int out_fd;          // Pipes de saída e erro (-1 depois do EOF)
+    int err_fd;
+    bool exited;         // Já recolhido com wait4
+    bool ready;          // pidfd sinalizou: o filho terminou
+    size_t index;
+    struct timespec start;
+};
+
+// Qual descritor de um filho gerou o evento do epoll
+enum par_source { PAR_OUT, PAR_ERR, PAR_PIDFD };
+
+/*****************************************************************************/
+
+/**
+ * @brief Lê a entrada padrão até o fim e separa as linhas não vazias.
+ * @param buffer Recebe o texto lido (malloc), onde as entradas apontam.
+ * @param count Recebe a quantidade de linhas.
+ * @return Vetor de entradas (malloc), ou NULL em caso de erro.
+ */
+static char **read_inputs(char **buffer, size_t *count);
+
+/**
+ * @brief Monta o argv de uma execução: `{}` trocado pela entrada, ou a entrada no fim.
+ * @param job Execução em andamento.
+ * @param input Entrada.
+ * @param argc Recebe a quantidade de argumentos.
+ * @return argv terminado em NULL, num único bloco (um free basta), ou NULL sem memória.
+ */
+static char **build_argv(const struct par_job *job, const char *input, int *argc);
+
+/**
+ * @brief Executa uma entrada com o comando interno, na thread atual (função do `parallel_steal`).
+ * @param index Entrada.
+ * @param worker Não usado.
+ * @param ctx Ponteiro para `struct par_job`.
+ */
+static void run_builtin_task(size_t index, unsigned worker, void *ctx);
+
+/**
+ * @brief Executa as entradas como processos externos, até `width` ao mesmo tempo.
+ * @param job Execução em andamento.
+ * @param width Máximo de filhos simultâneos.
+ * @return true se foi interrompido (um filho morreu com SIGINT).
+ */
+static bool run_external(struct par_job *job, unsigned width);
+
+/**
+ * @brief Cria o filho de uma entrada e registra os pipes no epoll.
+ * @param job Execução em andamento.
+ * @param child Posição livre que recebe o filho.
+ * @param epoll_fd epoll do laço.
+ * @param slot Número da posição (vai nos dados do evento).
+ * @param null_fd /dev/null aberto para a entrada do filho.
+ * @param index Entrada.
+ * @return true se o filho foi criado; false se falhou (o resultado já foi exibido).
+ */
+static bool launch(struct par_job *job, struct par_child *child, int epoll_fd, unsigned slot, int null_fd,
+                   size_t index);
+
+/**
+ * @brief Lê o que estiver disponível num pipe do filho; no EOF, fecha e tira do epoll.
+ * @param fd Descritor (vira -1 no EOF).
+ * @param capture Onde guardar os bytes.
+ * @param epoll_fd epoll do laço.
+ */
+static void drain(int *fd, struct term_out_capture *capture, int epoll_fd);
+
+/**
+ * @brief Marca uma entrada como terminada e exibe o que puder (na ordem, com -k).
+ * @param job Execução em andamento.
+ * @param index Entrada terminada.
+ */
+static void finish(struct par_job *job, size_t index);
+
+/**
+ * @brief Exibe a saída, o erro e a linha de resumo de uma entrada e libera os buffers.
+ * @param job Execução em andamento (com `lock` travado).
+ * @param index Entrada.
+ */
+static void show(struct par_job *job, size_t index);
+
+/**
+ * @brief Converte um status de wait4 em código de saída (128 + sinal se morto por sinal).
+ */
+static int exit_code(int status);
+
+/**
+ * @brief Milissegundos entre dois instantes.
+ */
+static double elapsed_ms(const struct timespec *start, const struct timespec *end);
+
+/*****************************************************************************/
+
+int par_run(const int argc, char **argv, const struct builtin *builtins) {
+    unsigned width = 0;
+    bool keep_order = false;
+    bool quiet = false;
+    int first = 1;
+
+    // Opções até o primeiro argumento que não começa com '-' (o comando)
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        const char *arg = argv[first];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            term_out_str(TERM_CYAN_BOLD "Uso: par [OPÇÕES] COMANDO [ARGS...] [::: ENTRADAS...]" TERM_RESET "\n"
+                         "Executar COMANDO para cada entrada, vários ao mesmo tempo\n"
+                         "Sem ':::', as entradas são as linhas da entrada padrão; '{}' nos\n"
+                         "argumentos é trocado pela entrada (sem '{}', ela vai no fim)\n\n"
+                         TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                         "  -j N\t\tAté N execuções simultâneas (padrão: CPUs online)\n"
+                         "  -k\t\tExibir as saídas na ordem das entradas\n"
+                         "  -q\t\tSem a linha de código de saída e tempo de cada execução\n"
+                         "  --help\t\tExibir esta ajuda\n");
+            return 0;
+        }
+        if (strcmp(arg, "-k") == 0) keep_order = true;
+        else if (strcmp(arg, "-q") == 0) quiet = true;
+        else if (strncmp(arg, "-j", 2) == 0) {
+            const char *value = arg[2] ? arg + 2 : first + 1 < argc ? argv[++first] : "";
+            char *end;
+            const unsigned long parsed = strtoul(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || parsed == 0 || parsed > 4096) {
+                term_out_str(TERM_RED_BOLD "par: -j espera um número entre 1 e 4096" TERM_RESET "\n");
+                return 2;
+            }
+            width = (unsigned) parsed;
+        } else {
+            term_out_printf("%spar: opção inválida: %s (veja par --help)%s\n", TERM_RED_BOLD, arg, TERM_RESET);
+            return 2;
+        }
+    }
+
+    // Modelo até ':::'; depois dele, as entradas
+    int separator = first;
+    while (separator < argc && strcmp(argv[separator], ":::") != 0) separator++;
+    if (separator == first) {
+        term_out_str(TERM_RED_BOLD "par: comando faltando (veja par --help)" TERM_RESET "\n");
+        return 2;
+    }
+
+    struct par_job job = {
+        .command = argv + first,
+        .command_argc = separator - first,
+        .keep_order = keep_order,
+        .quiet = quiet,
+    };
+    for (int i = 0; i < job.command_argc; i++) {
+        if (strstr(job.command[i], "{}")) job.placeholder = true;
+    }
+
+    const struct builtin *builtin = NULL;
+    for (const struct builtin *b = builtins; b->name; b++) {
+        if (strcmp(b->name, job.command[0]) == 0) builtin = b;
+    }
+    if (builtin && !builtin->parallel_safe) {
+        term_out_printf("%spar: %s não pode rodar em paralelo%s\n", TERM_RED_BOLD, builtin->name, TERM_RESET);
+        return 2;
+    }
+    job.builtin = builtin ? builtin->run : NULL;
+
+    char *input_buffer = NULL;
+    if (separator < argc) {
+        job.inputs = argv + separator + 1;
+        job.count = (size_t) (argc - separator - 1);
+    } else {
+        // Antes de ler a entrada padrão: o que já foi escrito não pode ficar esperando
+        term_out_flush();
+        job.inputs = read_inputs(&input_buffer, &job.count);
+        if (!job.inputs) {
+            fprintf(stderr, "%spar: erro ao ler a entrada padrão: %s%s\n", TERM_RED_BOLD, strerror(errno),
+                    TERM_RESET);
+            return 1;
+        }
+    }
+    if (job.count == 0) {
+        if (input_buffer) free(job.inputs);
+        free(input_buffer);
+        return 0;
+    }
+
+    job.results = calloc(job.count, sizeof(struct par_result));
+    if (!job.results) {
+        if (input_buffer) free(job.inputs);
+        free(input_buffer);
+        return 1;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    if (width == 0) width = parallel_default_threads();
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t steals = 0;
+    bool interrupted = false;
+    if (job.builtin) {
+        width = parallel_steal(job.count, width, run_builtin_task, &job, &steals);
+    } else {
+        interrupted = run_external(&job, width);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    term_out_flush();
+
+    size_t ran = 0;
+    for (size_t i = 0; i < job.count; i++) {
+        if (job.results[i].done) ran++;
+    }
+    if (!quiet || job.failed > 0 || interrupted) {
+        fprintf(stderr, "%spar: %zu de %zu execuç%s, %s%zu com erro%s, %.3f s (-j %u%s",
+                TERM_CYAN_BOLD, ran, job.count, job.count == 1 ? "ão" : "ões",
+                job.failed > 0 ? TERM_RED_BOLD : "", job.failed, TERM_CYAN_BOLD,
+                elapsed_ms(&start, &end) / 1e3, width, job.builtin ? ", em threads" : "");
+        if (job.builtin) fprintf(stderr, ", %zu roubadas", steals);
+        fprintf(stderr, ")%s%s\n", interrupted ? " — interrompido" : "", TERM_RESET);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(job.results);
+    if (input_buffer) free(job.inputs);
+    free(input_buffer);
+    if (interrupted) return 130;
+    return job.failed > 0 ? 1 : 0;
+}
+
+/*****************************************************************************/
+
+static char **read_inputs(char **buffer, size_t *count) {
+    size_t len = 0;
+    size_t capacity = PAR_READ_CHUNK;
+    char *data = malloc(capacity + 1);
+    if (!data) return NULL;
+
+    while (true) {
+        if (capacity - len < PAR_READ_CHUNK / 2) {
+            char *grown = realloc(data, capacity * 2 + 1);
+            if (!grown) {
+                free(data);
+                errno = ENOMEM;
+                return NULL;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+        const ssize_t got = read(STDIN_FILENO, data + len, capacity - len);
+        if (got == 0) break;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            free(data);
+            return NULL;
+        }
+        len += (size_t) got;
+    }
+    data[len] = '\0';
+
+    // Cada '\n' vira o fim de uma entrada; linhas vazias são ignoradas
+    size_t lines = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\n') lines++;
+    }
+    char **inputs = malloc(lines * sizeof(char *));
+    if (!inputs) {
+        free(data);
+        errno = ENOMEM;
+        return NULL;
+    }
+    size_t n = 0;
+    char *line = data;
+    while (line < data + len) {
+        char *newline = memchr(line, '\n', (size_t) (data + len - line));
+        char *line_end = newline ? newline : data + len;
+        *line_end = '\0';
+        if (line_end > line) inputs[n++] = line;
+        line = line_end + 1;
+    }
+
+    *buffer = data;
+    *count = n;
+    return inputs;
+}
+
+static char **build_argv(const struct par_job *job, const char *input, int *argc) {
+    const size_t input_len = strlen(input);
+    const int total = job->command_argc + (job->placeholder ? 0 : 1);
+
+    // Um bloco só: ponteiros seguidos das strings
+    size_t bytes = (size_t) (total + 1) * sizeof(char *);
+    for (int i = 0; i < job->command_argc; i++) {
+        bytes += strlen(job->command[i]) + 1;
+        for (const char *p = job->command[i]; (p = strstr(p, "{}")); p += 2) bytes += input_len;
+    }
+    if (!job->placeholder) bytes += input_len + 1;
+
+    char **argv = malloc(bytes);
+    if (!argv) return NULL;
+    char *out = (char *) (argv + total + 1);
+    for (int i = 0; i < job->command_argc; i++) {
+        argv[i] = out;
+        const char *p = job->command[i];
+        const char *mark;
+        while ((mark = strstr(p, "{}"))) {
+            memcpy(out, p, (size_t) (mark - p));
+            out += mark - p;
+            memcpy(out, input, input_len);
+            out += input_len;
+            p = mark + 2;
+        }
+        const size_t rest = strlen(p) + 1;
+        memcpy(out, p, rest);
+        out += rest;
+    }
+    if (!job->placeholder) {
+        argv[job->command_argc] = out;
+        memcpy(out, input, input_len + 1);
+    }
+    argv[total] = NULL;
+    *argc = total;
+    return argv;
+}
+
+static void run_builtin_task(const size_t index, const unsigned worker, void *ctx) {
+    (void) worker;
+    struct par_job *job = ctx;
+    struct par_result *result = &job->results[index];
+
+    int argc;
+    char **argv = build_argv(job, job->inputs[index], &argc);
+    if (!argv) {
+        result->status = 1;
+        finish(job, index);
+        return;
+    }
+
+    struct timespec start, end, cpu_start, cpu_end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+    // A saída vai para a captura desta thread, não para o buffer compartilhado
+    struct term_out_capture *previous = term_out_capture(&result->out);
+    result->status = job->builtin(argc, argv);
+    term_out_capture(previous);
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->wall_ms = elapsed_ms(&start, &end);
+    result->cpu_ms = elapsed_ms(&cpu_start, &cpu_end);
+    free(argv);
+    finish(job, index);
+}
+
+static bool run_external(struct par_job *job, const unsigned width) {
+    const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    const int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    struct par_child *children = calloc(width, sizeof(struct par_child));
+    if (epoll_fd < 0 || null_fd < 0 || !children) {
+        fprintf(stderr, "%spar: %s%s\n", TERM_RED_BOLD, strerror(errno), TERM_RESET);
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (null_fd >= 0) close(null_fd);
+        free(children);
+        return false;
+    }
+    for (unsigned i = 0; i < width; i++) children[i].pid = -1;
+
+    size_t next = 0;
+    size_t running = 0;
+    size_t polling = 0; // Filhos sem pidfd
+    bool interrupted = false;
+
+    while (running > 0 || (next < job->count && !interrupted)) {
+        // Completa as posições livres (entradas que nem chegam a rodar já saem exibidas)
+        for (unsigned i = 0; i < width && !interrupted; i++) {
+            while (children[i].pid < 0 && next < job->count) {
+                if (!launch(job, &children[i], epoll_fd, i, null_fd, next++)) continue;
+                running++;
+                if (children[i].pidfd < 0) polling++;
+            }
+        }
+        if (running == 0) break;
+
+        struct epoll_event events[64];
+        const int ready = epoll_wait(epoll_fd, events, 64, polling > 0 ? PAR_POLL_MS : -1);
+        if (ready < 0 && errno != EINTR) break;
+        for (int e = 0; e < ready; e++) {
+            struct par_child *child = &children[events[e].data.u64 >> 2];
+            struct par_result *result = &job->results[child->index];
+            switch ((enum par_source) (events[e].data.u64 & 3)) {
+                case PAR_OUT:
+                    drain(&child->out_fd, &result->out, epoll_fd);
+                    break;
+                case PAR_ERR:
+                    drain(&child->err_fd, &result->err, epoll_fd);
+                    break;
+                case PAR_PIDFD:
+                    child->ready = true;
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, child->pidfd, NULL);
+                    break;
+            }
+        }
+
+        // Recolhe os filhos que terminaram; a execução acaba quando os dois pipes chegam ao EOF
+        for (unsigned i = 0; i < width; i++) {
+            struct par_child *child = &children[i];
+            if (child->pid < 0) continue;
+            struct par_result *result = &job->results[child->index];
+            if (!child->exited && (child->ready || child->pidfd < 0)) {
+                int status;
+                struct rusage usage;
+                if (wait4(child->pid, &status, WNOHANG, &usage) == child->pid) {
+                    child->exited = true;
+                    result->status = exit_code(status);
+                    result->cpu_ms = (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+                                     (double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+                    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) interrupted = true;
+                }
+            }
+            if (!child->exited || child->out_fd >= 0 || child->err_fd >= 0) continue;
+
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            result->wall_ms = elapsed_ms(&child->start, &now);
+            if (child->pidfd >= 0) close(child->pidfd);
+            else polling--;
+            child->pid = -1;
+            running--;
+            finish(job, child->index);
+        }
+    }
+
+    close(null_fd);
+    close(epoll_fd);
+    free(children);
+    return interrupted;
+}
+
+static bool launch(struct par_job *job, struct par_child *child, const int epoll_fd, const unsigned slot,
+                   const int null_fd, const size_t index) {
+    struct par_result *result = &job->results[index];
+    int argc;
+    char **argv = build_argv(job, job->inputs[index], &argc);
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+
+    int error = ENOMEM;
+    if (argv && pipe2(out_pipe, O_CLOEXEC) == 0 && pipe2(err_pipe, O_CLOEXEC) == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &child->start);
+        error = exec_spawn(argv, null_fd, out_pipe[1], err_pipe[1], &child->pid);
+    } else if (argv) {
+        error = errno;
+    }
+    // As pontas de escrita ficam só com o filho: o EOF chega quando ele (e quem herdou) fechar
+    if (out_pipe[1] >= 0) close(out_pipe[1]);
+    if (err_pipe[1] >= 0) close(err_pipe[1]);
+
+    if (error != 0) {
+        if (out_pipe[0] >= 0) close(out_pipe[0]);
+        if (err_pipe[0] >= 0) close(err_pipe[0]);
+        struct term_out_capture *previous = term_out_capture(&result->err);
+        term_out_printf("%sErro ao executar %s: %s%s\n", TERM_RED_BOLD, job->command[0], strerror(error),
+                        TERM_RESET);
+        term_out_capture(previous);
+        result->status = error == ENOENT ? 127 : 126;
+        child->pid = -1;
+        free(argv);
+        finish(job, index);
+        return false;
+    }
+    free(argv);
+
+    child->index = index;
+    child->exited = false;
+    child->ready = false;
+    child->out_fd = out_pipe[0];
+    child->err_fd = err_pipe[0];
+#ifdef SYS_pidfd_open
+    child->pidfd = (int) syscall(SYS_pidfd_open, child->pid, 0);
+#else
+    child->pidfd = -1;
+#endif
+
+    struct epoll_event event = {.events = EPOLLIN};
+    event.data.u64 = (uint64_t) slot << 2 | PAR_OUT;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, child->out_fd, &event);
+    event.data.u64 = (uint64_t) slot << 2 | PAR_ERR;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, child->err_fd, &event);
+    if (child->pidfd >= 0) {
+        event.data.u64 = (uint64_t) slot << 2 | PAR_PIDFD;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, child->pidfd, &event);
+    }
+    return true;
+}
+
+static void drain(int *fd, struct term_out_capture *capture, const int epoll_fd) {
+    char chunk[PAR_READ_CHUNK];
+    const ssize_t got = read(*fd, chunk, sizeof(chunk));
+    if (got < 0 && (errno == EINTR || errno == EAGAIN)) return;
+    if (got > 0) {
+        // A captura do term_out já sabe crescer
+        struct term_out_capture *previous = term_out_capture(capture);
+        term_out_write(chunk, (size_t) got);
+        term_out_capture(previous);
+        return;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, *fd, NULL);
+    close(*fd);
+    *fd = -1;
+}
+
+static void finish(struct par_job *job, const size_t index) {
+    pthread_mutex_lock(&job->lock);
+    job->results[index].done = true;
+    if (job->results[index].status != 0) job->failed++;
+    if (!job->keep_order) {
+        show(job, index);
+    } else {
+        while (job->next_shown < job->count && job->results[job->next_shown].done) show(job, job->next_shown++);
+    }
+    pthread_mutex_unlock(&job->lock);
+}
+
+static void show(struct par_job *job, const size_t index) {
+    struct par_result *result = &job->results[index];
+    if (result->out.len > 0) {
+        term_out_write(result->out.data, result->out.len);
+        term_out_flush();
+    }
+    if (result->err.len > 0) {
+        for (size_t written = 0; written < result->err.len;) {
+            const ssize_t n = write(STDERR_FILENO, result->err.data + written, result->err.len - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            written += (size_t) n;
+        }
+    }
+    free(result->out.data);
+    free(result->err.data);
+    result->out = result->err = (struct term_out_capture){0};
+
+    if (job->quiet) return;
+    const char *color = result->status == 0 ? TERM_GREEN : TERM_RED_BOLD;
+    fprintf(stderr, "%s[%zu/%zu] %s%3d%s %9.1f ms  cpu %9.1f ms  %s%s\n", TERM_CYAN, index + 1, job->count,
+            color, result->status, TERM_CYAN, result->wall_ms, result->cpu_ms, job->inputs[index], TERM_RESET);
+}
+
+static int exit_code(const int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) * 1e3 + (double) (end->tv_nsec - start->tv_nsec) / 1e6;
+}
@@ -0,0 +1,28 @@
+//
+// Comando `par`: um modelo de comando executado para cada entrada, vários ao mesmo tempo.
+//
+
+#ifndef PAR_H
+#define PAR_H
+
+#include "exec.h"
+
+/**
+ * @brief Executa `COMANDO [ARGS...]` uma vez por entrada, com até N execuções simultâneas.
+ *
+ * As entradas vêm depois de `:::` ou, sem ele, das linhas da entrada padrão;
+ * `{}` nos argumentos é trocado pela entrada (sem `{}`, ela vira o último
+ * argumento). Comandos externos viram processos filhos com a saída e o erro
+ * em pipes próprios; comandos internos marcados `parallel_safe` (ex.: `lf`)
+ * rodam em threads do próprio shell, com roubo de trabalho, sem fork. A saída
+ * de cada execução é guardada e exibida inteira quando ela termina, seguida de
+ * uma linha em stderr com o código de saída e os tempos.
+ * @param argc Quantidade de argumentos (incluindo "par").
+ * @param argv Argumentos do comando.
+ * @param builtins Tabela de comandos internos, terminada por `{NULL, NULL}`.
+ * @return 0 se todas as execuções terminaram com 0, 1 se alguma falhou,
+ *         2 em erro de uso, 130 se interrompido por Ctrl-C.
+ */
+int par_run(int argc, char **argv, const struct builtin *builtins);
+
+#endif //PAR_H
@@ -0,0 +1,410 @@
+#include "parallel.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PARALLEL_DEFAULT_CHUNK 256
+
+// Voltas ociosas (sched_yield) antes de uma thread sem trabalho começar a dormir entre tentativas
+#define PARALLEL_IDLE_SPINS 64
+#define PARALLEL_IDLE_SLEEP_NS 50000
+
+/*****************************************************************************/
+
+struct parallel_job {
+    atomic_size_t next;
+    size_t count;
+    size_t chunk;
+    parallel_fn fn;
+    void *ctx;
+};
+
+struct parallel_worker {
+    struct parallel_job *job;
+    unsigned id;
+};
+
+// Fila de uma thread no roubo de trabalho: (início << 32) | fim, uma linha de cache por fila
+struct steal_queue {
+    alignas(64) _Atomic uint64_t range;
+};
+
+struct steal_job {
+    struct steal_queue *queues;
+    unsigned threads;
+    parallel_task_fn fn;
+    void *ctx;
+    atomic_size_t steals;
+};
+
+struct steal_worker {
+    struct steal_job *job;
+    unsigned id;
+};
+
+// Fila dupla de uma thread em `parallel_tasks`: índices crescentes sobre um vetor circular
+struct task_deque {
+    alignas(64) pthread_mutex_t lock;
+    void **items;
+    size_t head;        // Próximo a ser roubado
+    size_t tail;        // Após o último (a dona acrescenta e consome aqui)
+    size_t capacity;    // Potência de 2
+};
+
+struct parallel_pool {
+    struct task_deque *deques;
+    unsigned threads;
+    parallel_item_fn fn;
+    void *ctx;
+    atomic_size_t pending;  // Itens na fila ou em execução
+    atomic_size_t steals;
+};
+
+struct pool_worker {
+    struct parallel_pool *pool;
+    unsigned id;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Consome blocos do contador compartilhado até o laço terminar.
+ * @param job Laço em execução.
+ * @param id Número da thread.
+ */
+static void run_chunks(struct parallel_job *job, unsigned id);
+
+/**
+ * @brief Ponto de entrada das threads auxiliares.
+ * @param arg Ponteiro para `struct parallel_worker`.
+ * @return Sempre NULL.
+ */
+static void *worker_main(void *arg);
+
+/**
+ * @brief Consome a própria fila e depois rouba das outras até todas ficarem vazias.
+ * @param job Execução em andamento.
+ * @param id Número da thread.
+ */
+static void run_steal(struct steal_job *job, unsigned id);
+
+/**
+ * @brief Tira um item da fila: do fim (dona da fila) ou do início (ladra).
+ * @param queue Fila.
+ * @param from_front true para roubar do início.
+ * @param index Recebe o item.
+ * @return true se conseguiu um item, false se a fila está vazia.
+ */
+static bool take(struct steal_queue *queue, bool from_front, size_t *index);
+
+/**
+ * @brief Ponto de entrada das threads auxiliares do roubo de trabalho.
+ * @param arg Ponteiro para `struct steal_worker`.
+ * @return Sempre NULL.
+ */
+static void *steal_main(void *arg);
+
+/**
+ * @brief Executa itens da própria fila e das outras até não haver item pendente.
+ * @param pool Execução em andamento.
+ * @param id Número da thread.
+ */
+static void run_tasks(struct parallel_pool *pool, unsigned id);
+
+/**
+ * @brief Tira um item da fila dupla: do fim (dona da fila) ou do início (ladra).
+ * @return true se conseguiu um item, false se a fila está vazia.
+ */
+static bool deque_take(struct task_deque *deque, bool from_front, void **item);
+
+/**
+ * @brief Ponto de entrada das threads auxiliares de `parallel_tasks`.
+ * @param arg Ponteiro para `struct pool_worker`.
+ * @return Sempre NULL.
+ */
+static void *tasks_main(void *arg);
+
+/*****************************************************************************/
+
+unsigned parallel_default_threads(void) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (unsigned) cpus : 1;
+}
+
+unsigned parallel_for(const size_t count, size_t chunk, unsigned threads, const parallel_fn fn, void *ctx) {
+    if (chunk == 0) chunk = PARALLEL_DEFAULT_CHUNK;
+    if (threads == 0) threads = parallel_default_threads();
+
+    // Não faz sentido ter mais threads que blocos
+    const size_t chunks = (count + chunk - 1) / chunk;
+    if (threads > chunks) threads = chunks > 0 ? (unsigned) chunks : 1;
+
+    struct parallel_job job = {.count = count, .chunk = chunk, .fn = fn, .ctx = ctx};
+    atomic_init(&job.next, 0);
+
+    pthread_t *tids = NULL;
+    struct parallel_worker *workers = NULL;
+    unsigned started = 1;
+    if (threads > 1) {
+        tids = malloc((threads - 1) * sizeof(pthread_t));
+        workers = malloc((threads - 1) * sizeof(struct parallel_worker));
+        if (tids && workers) {
+            for (unsigned i = 0; i < threads - 1; i++) {
+                workers[i] = (struct parallel_worker){.job = &job, .id = i + 1};
+                if (pthread_create(&tids[i], NULL, worker_main, &workers[i]) != 0) break;
+                started++;
+            }
+        }
+    }
+
+    run_chunks(&job, 0);
+
+    for (unsigned i = 0; i + 1 < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+    free(workers);
+    return started;
+}
+
+unsigned parallel_steal(const size_t count, unsigned threads, const parallel_task_fn fn, void *ctx,
+                        size_t *steals) {
+    if (threads == 0) threads = parallel_default_threads();
+    if (threads > count) threads = count > 0 ? (unsigned) count : 1;
+
+    struct steal_job job = {.threads = threads, .fn = fn, .ctx = ctx};
+    atomic_init(&job.steals, 0);
+    job.queues = aligned_alloc(alignof(struct steal_queue), threads * sizeof(struct steal_queue));
+    if (!job.queues) {
+        // Sem memória para as filas: tudo na thread chamadora
+        for (size_t i = 0; i < count; i++) fn(i, 0, ctx);
+        if (steals) *steals = 0;
+        return 1;
+    }
+
+    // Faixas contíguas do mesmo tamanho (as primeiras com um item a mais)
+    size_t begin = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        const size_t size = count / threads + (i < count % threads ? 1 : 0);
+        atomic_init(&job.queues[i].range, (uint64_t) begin << 32 | (uint64_t) (begin + size));
+        begin += size;
+    }
+
+    pthread_t *tids = NULL;
+    struct steal_worker *workers = NULL;
+    unsigned started = 1;
+    if (threads > 1) {
+        tids = malloc((threads - 1) * sizeof(pthread_t));
+        workers = malloc((threads - 1) * sizeof(struct steal_worker));
+        if (tids && workers) {
+            for (unsigned i = 0; i < threads - 1; i++) {
+                workers[i] = (struct steal_worker){.job = &job, .id = i + 1};
+                if (pthread_create(&tids[i], NULL, steal_main, &workers[i]) != 0) break;
+                started++;
+            }
+        }
+    }
+
+    // Filas de threads que não chegaram a ser criadas são roubadas pelas demais
+    run_steal(&job, 0);
+
+    for (unsigned i = 0; i + 1 < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+    free(workers);
+    free(job.queues);
+    if (steals) *steals = atomic_load(&job.steals);
+    return started;
+}
+
+unsigned parallel_tasks(void *first, unsigned threads, const parallel_item_fn fn, void *ctx, size_t *steals) {
+    if (threads == 0) threads = parallel_default_threads();
+
+    struct parallel_pool pool = {.threads = threads, .fn = fn, .ctx = ctx};
+    atomic_init(&pool.pending, 0);
+    atomic_init(&pool.steals, 0);
+    pool.deques = aligned_alloc(alignof(struct task_deque), threads * sizeof(struct task_deque));
+    if (!pool.deques) {
+        // Sem memória para as filas: uma fila só, na thread chamadora
+        pool.threads = threads = 1;
+        pool.deques = aligned_alloc(alignof(struct task_deque), sizeof(struct task_deque));
+        if (!pool.deques) return 0;
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].items = NULL;
+        pool.deques[i].head = pool.deques[i].tail = pool.deques[i].capacity = 0;
+    }
+    if (parallel_tasks_push(&pool, 0, first) != 0) {
+        fn(first, 0, &pool, ctx);
+    }
+
+    pthread_t *tids = NULL;
+    struct pool_worker *workers = NULL;
+    unsigned started = 1;
+    if (threads > 1) {
+        tids = malloc((threads - 1) * sizeof(pthread_t));
+        workers = malloc((threads - 1) * sizeof(struct pool_worker));
+        if (tids && workers) {
+            for (unsigned i = 0; i < threads - 1; i++) {
+                workers[i] = (struct pool_worker){.pool = &pool, .id = i + 1};
+                if (pthread_create(&tids[i], NULL, tasks_main, &workers[i]) != 0) break;
+                started++;
+            }
+        }
+    }
+
+    // Itens empurrados para filas de threads que não chegaram a ser criadas são roubados pelas demais
+    run_tasks(&pool, 0);
+
+    for (unsigned i = 0; i + 1 < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+    free(workers);
+    for (unsigned i = 0; i < threads; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+        free(pool.deques[i].items);
+    }
+    free(pool.deques);
+    if (steals) *steals = atomic_load(&pool.steals);
+    return started;
+}
+
+int parallel_tasks_push(struct parallel_pool *pool, const unsigned worker, void *item) {
+    struct task_deque *deque = &pool->deques[worker];
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail - deque->head == deque->capacity) {
+        const size_t capacity = deque->capacity ? deque->capacity * 2 : 256;
+        void **grown = malloc(capacity * sizeof(void *));
+        if (!grown) {
+            pthread_mutex_unlock(&deque->lock);
+            return -1;
+        }
+        for (size_t i = deque->head; i < deque->tail; i++) {
+            grown[i & (capacity - 1)] = deque->items[i & (deque->capacity - 1)];
+        }
+        free(deque->items);
+        deque->items = grown;
+        deque->capacity = capacity;
+    }
+    deque->items[deque->tail & (deque->capacity - 1)] = item;
+    deque->tail++;
+    // Contado antes de ficar visível a uma ladra (que só o vê depois de pegar a trava)
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+/*****************************************************************************/
+
+static void run_chunks(struct parallel_job *job, const unsigned id) {
+    while (true) {
+        const size_t begin = atomic_fetch_add_explicit(&job->next, job->chunk, memory_order_relaxed);
+        if (begin >= job->count) break;
+        const size_t end = begin + job->chunk < job->count ? begin + job->chunk : job->count;
+        job->fn(begin, end, id, job->ctx);
+    }
+}
+
+static void *worker_main(void *arg) {
+    const struct parallel_worker *worker = arg;
+    run_chunks(worker->job, worker->id);
+    return NULL;
+}
+
+static void run_steal(struct steal_job *job, const unsigned id) {
+    size_t index;
+    while (take(&job->queues[id], false, &index)) job->fn(index, id, job->ctx);
+
+    // Nenhum item novo aparece depois do início: uma volta sem achar nada é o fim
+    bool found = true;
+    while (found) {
+        found = false;
+        for (unsigned i = 1; i < job->threads; i++) {
+            struct steal_queue *victim = &job->queues[(id + i) % job->threads];
+            // Um item por vez e segue para a próxima vítima, espalhando os roubos
+            if (take(victim, true, &index)) {
+                atomic_fetch_add_explicit(&job->steals, 1, memory_order_relaxed);
+                job->fn(index, id, job->ctx);
+                found = true;
+            }
+        }
+    }
+}
+
+static bool take(struct steal_queue *queue, const bool from_front, size_t *index) {
+    uint64_t range = atomic_load_explicit(&queue->range, memory_order_relaxed);
+    while (true) {
+        const uint64_t front = range >> 32;
+        const uint64_t back = range & UINT32_MAX;
+        if (front >= back) return false;
+        const uint64_t next = from_front ? (front + 1) << 32 | back : front << 32 | (back - 1);
+        if (atomic_compare_exchange_weak_explicit(&queue->range, &range, next, memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            *index = from_front ? front : back - 1;
+            return true;
+        }
+    }
+}
+
+static void *steal_main(void *arg) {
+    const struct steal_worker *worker = arg;
+    run_steal(worker->job, worker->id);
+    return NULL;
+}
+
+static void run_tasks(struct parallel_pool *pool, const unsigned id) {
+    unsigned idle = 0;
+    while (true) {
+        void *item;
+        bool found = deque_take(&pool->deques[id], false, &item);
+        for (unsigned i = 1; !found && i < pool->threads; i++) {
+            if (deque_take(&pool->deques[(id + i) % pool->threads], true, &item)) {
+                atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+                found = true;
+            }
+        }
+
+        if (found) {
+            pool->fn(item, id, pool, pool->ctx);
+            atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel);
+            idle = 0;
+            continue;
+        }
+
+        // Filas vazias: ou acabou, ou outra thread ainda pode criar itens
+        if (atomic_load_explicit(&pool->pending, memory_order_acquire) == 0) break;
+        if (++idle < PARALLEL_IDLE_SPINS) {
+            sched_yield();
+        } else {
+            const struct timespec pause = {.tv_sec = 0, .tv_nsec = PARALLEL_IDLE_SLEEP_NS};
+            nanosleep(&pause, NULL);
+        }
+    }
+}
+
+static bool deque_take(struct task_deque *deque, const bool from_front, void **item) {
+    pthread_mutex_lock(&deque->lock);
+    const bool found = deque->head != deque->tail;
+    if (found) {
+        *item = from_front ? deque->items[deque->head++ & (deque->capacity - 1)]
+                           : deque->items[--deque->tail & (deque->capacity - 1)];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void *tasks_main(void *arg) {
+    const struct pool_worker *worker = arg;
+    run_tasks(worker->pool, worker->id);
+    return NULL;
+}
@@ -0,0 +1,106 @@
+//
+// Execução paralela simples: um laço dividido em blocos entre threads.
+//
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Função executada para cada bloco `[begin, end)` do laço.
+ * @param begin Primeiro índice do bloco.
+ * @param end Índice após o último do bloco.
+ * @param worker Número da thread que executa o bloco (0 é a thread chamadora).
+ * @param ctx Contexto repassado por `parallel_for`.
+ */
+typedef void (*parallel_fn)(size_t begin, size_t end, unsigned worker, void *ctx);
+
+/**
+ * @brief Função executada para cada item de `parallel_steal`.
+ * @param index Índice do item.
+ * @param worker Número da thread que executa o item (0 é a thread chamadora).
+ * @param ctx Contexto repassado por `parallel_steal`.
+ */
+typedef void (*parallel_task_fn)(size_t index, unsigned worker, void *ctx);
+
+/**
+ * @brief Execução em andamento de `parallel_tasks` (itens criados durante a própria execução).
+ */
+struct parallel_pool;
+
+/**
+ * @brief Função executada para cada item de `parallel_tasks`.
+ * @param item Item (ponteiro dado a `parallel_tasks` ou a `parallel_tasks_push`).
+ * @param worker Número da thread que executa o item (0 é a thread chamadora).
+ * @param pool Execução em andamento, para acrescentar novos itens.
+ * @param ctx Contexto repassado por `parallel_tasks`.
+ */
+typedef void (*parallel_item_fn)(void *item, unsigned worker, struct parallel_pool *pool, void *ctx);
+
+/**
+ * @brief Número padrão de threads (CPUs online).
+ * @return Quantidade de CPUs online, no mínimo 1.
+ */
+unsigned parallel_default_threads(void);
+
+/**
+ * @brief Executa `fn` sobre `[0, count)` em blocos de `chunk`, usando até `threads` threads.
+ *
+ * Os blocos são distribuídos por um contador atômico, então cada thread só
+ * escreve na sua própria faixa de índices e nenhuma trava é necessária.
+ * A thread chamadora também trabalha e a função só retorna após todos os blocos.
+ * @param count Quantidade de itens.
+ * @param chunk Tamanho de cada bloco (0 usa um padrão).
+ * @param threads Quantidade de threads (0 usa `parallel_default_threads`).
+ * @param fn Função aplicada a cada bloco.
+ * @param ctx Contexto repassado a `fn`.
+ * @return Quantidade de threads efetivamente usadas.
+ */
+unsigned parallel_for(size_t count, size_t chunk, unsigned threads, parallel_fn fn, void *ctx);
+
+/**
+ * @brief Executa `fn` para cada item de `[0, count)`, com uma fila por thread e roubo de trabalho.
+ *
+ * Cada thread começa com uma faixa contígua de itens e consome do fim da sua;
+ * quando ela acaba, rouba do começo da faixa de outra thread. Serve para itens
+ * de duração muito desigual (comandos do `par`), em que blocos fixos deixariam
+ * threads paradas esperando a mais lenta. Um item por vez, sem travas: cada
+ * fila é um par (início, fim) atualizado com compare-and-swap.
+ * @param count Quantidade de itens (até UINT32_MAX).
+ * @param threads Quantidade de threads (0 usa `parallel_default_threads`).
+ * @param fn Função aplicada a cada item.
+ * @param ctx Contexto repassado a `fn`.
+ * @param steals Recebe a quantidade de itens roubados (pode ser NULL).
+ * @return Quantidade de threads efetivamente usadas.
+ */
+unsigned parallel_steal(size_t count, unsigned threads, parallel_task_fn fn, void *ctx, size_t *steals);
+
+/**
+ * @brief Executa `fn` a partir de um item inicial, com itens novos acrescentados pelos próprios itens.
+ *
+ * Para trabalho que se descobre durante a execução (subdiretórios de uma
+ * varredura recursiva). Cada thread tem uma fila dupla: os itens que ela cria
+ * entram no fim e ela mesma os consome do fim (em profundidade, com poucas
+ * entradas pendentes); uma thread sem trabalho rouba do início da fila de outra,
+ * onde ficam os itens mais antigos, em geral as maiores subárvores. Termina
+ * quando nenhum item está na fila nem em execução.
+ * @param first Item inicial.
+ * @param threads Quantidade de threads (0 usa `parallel_default_threads`).
+ * @param fn Função aplicada a cada item.
+ * @param ctx Contexto repassado a `fn`.
+ * @param steals Recebe a quantidade de itens roubados (pode ser NULL).
+ * @return Quantidade de threads efetivamente usadas.
+ */
+unsigned parallel_tasks(void *first, unsigned threads, parallel_item_fn fn, void *ctx, size_t *steals);
+
+/**
+ * @brief Acrescenta um item à fila da thread atual (chamada de dentro de `fn`).
+ * @param pool Execução recebida por `fn`.
+ * @param worker Número da thread recebido por `fn`.
+ * @param item Item novo.
+ * @return 0 em caso de sucesso, -1 se faltar memória (o chamador deve executar o item ele mesmo).
+ */
+int parallel_tasks_push(struct parallel_pool *pool, unsigned worker, void *item);
+
+#endif //PARALLEL_H
@@ -0,0 +1,143 @@
+#include "parse_cache.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define PARSE_CACHE_INITIAL_CAPACITY 64
+
+/*****************************************************************************/
+
+/**
+ * @brief Linha guardada; a entrada, o texto e a lista ficam na arena do cache.
+ */
+struct parse_entry {
+    const char *line;               // Texto original (chave)
+    size_t len;
+    uint64_t hash;
+    const struct command_list *list;
+};
+
+/*****************************************************************************/
+
+static struct parse_entry **table = NULL;   // NULL = posição livre
+static size_t capacity = 0;
+static size_t count = 0;
+static struct parse_cache_stats stats = {0};
+
+static struct arena cache_arena = {0};      // Entradas do cache (reiniciada por `parse_cache_clear`)
+static struct arena line_arena = {0};       // Linha longa demais para o cache (reiniciada a cada linha)
+
+/*****************************************************************************/
+
+/**
+ * @brief Procura o slot da linha (ou o slot livre onde ela entraria).
+ */
+static struct parse_entry **find_slot(const char *line, size_t len, uint64_t hash);
+
+/**
+ * @brief Dobra a tabela e reinsere as entradas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int grow(void);
+
+/**
+ * @brief FNV-1a de 64 bits.
+ */
+static uint64_t hash_line(const char *line, size_t len);
+
+/*****************************************************************************/
+
+const struct command_list *parse_cache_get(const char *line, const size_t len) {
+    if (len > PARSE_CACHE_MAX_LINE) {
+        stats.misses++;
+        arena_reset(&line_arena);
+        return parse_line(&line_arena, line, len);
+    }
+
+    const uint64_t hash = hash_line(line, len);
+    if (table) {
+        struct parse_entry **slot = find_slot(line, len, hash);
+        if (*slot) {
+            stats.hits++;
+            return (*slot)->list;
+        }
+    }
+
+    stats.misses++;
+    if (count + 1 > PARSE_CACHE_MAX_ENTRIES || cache_arena.reserved > PARSE_CACHE_MAX_BYTES) parse_cache_clear();
+    if ((count + 1) * 2 > capacity && grow() != 0) return NULL;
+
+    // Erro de sintaxe não fica no cache: a arena volta para antes da tentativa
+    const struct arena_mark mark = arena_mark(&cache_arena);
+    struct parse_entry *entry = arena_alloc(&cache_arena, sizeof(struct parse_entry));
+    char *copy = entry ? arena_strndup(&cache_arena, line, len) : NULL;
+    const struct command_list *list = copy ? parse_line(&cache_arena, line, len) : NULL;
+    if (!list) {
+        arena_rewind(&cache_arena, mark);
+        return NULL;
+    }
+
+    entry->line = copy;
+    entry->len = len;
+    entry->hash = hash;
+    entry->list = list;
+    *find_slot(line, len, hash) = entry;
+    count++;
+    return list;
+}
+
+void parse_cache_clear(void) {
+    free(table);
+    table = NULL;
+    capacity = count = 0;
+    // Os blocos são reaproveitados, a menos que linhas grandes tenham feito a arena passar do limite
+    if (cache_arena.reserved > PARSE_CACHE_MAX_BYTES) arena_free(&cache_arena);
+    else arena_reset(&cache_arena);
+}
+
+struct parse_cache_stats parse_cache_get_stats(void) {
+    struct parse_cache_stats current = stats;
+    current.entries = count;
+    current.bytes = cache_arena.reserved;
+    return current;
+}
+
+/*****************************************************************************/
+
+static struct parse_entry **find_slot(const char *line, const size_t len, const uint64_t hash) {
+    const size_t mask = capacity - 1;
+    size_t i = (size_t) hash & mask;
+    while (table[i] && (table[i]->hash != hash || table[i]->len != len || memcmp(table[i]->line, line, len) != 0)) {
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static int grow(void) {
+    const size_t new_capacity = capacity ? capacity * 2 : PARSE_CACHE_INITIAL_CAPACITY;
+    struct parse_entry **new_table = calloc(new_capacity, sizeof(struct parse_entry *));
+    if (!new_table) return -1;
+
+    struct parse_entry **old_table = table;
+    const size_t old_capacity = capacity;
+    table = new_table;
+    capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i]) *find_slot(old_table[i]->line, old_table[i]->len, old_table[i]->hash) = old_table[i];
+    }
+    free(old_table);
+    return 0;
+}
+
+static uint64_t hash_line(const char *line, const size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) line[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,50 @@
+//
+// Cache de linhas já separadas: uma linha repetida (script, laço) não é separada de novo.
+//
+
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include <stddef.h>
+
+#include "parser.h"
+
+// Linhas distintas guardadas; ao passar disso o cache é esvaziado
+#define PARSE_CACHE_MAX_ENTRIES 4096
+
+// Memória da arena do cache; ao passar disso o cache é esvaziado
+#define PARSE_CACHE_MAX_BYTES (16 * 1024 * 1024)
+
+// Linhas maiores que isso são separadas sem ir para o cache (ex.: uma linha de 2 MB gerada por script)
+#define PARSE_CACHE_MAX_LINE (64 * 1024)
+
+struct parse_cache_stats {
+    size_t hits;
+    size_t misses;
+    size_t entries;
+    size_t bytes;       // Memória reservada pela arena do cache
+};
+
+/**
+ * @brief Lista de comandos de uma linha, separada (`parse_line`) só na primeira vez.
+ *
+ * A linha não tem limite de tamanho nem de palavras. A lista devolvida é do
+ * cache: não deve ser alterada e vale até a próxima chamada.
+ * @param line Linha (sem '\n' no fim; '\n' no meio separa comandos).
+ * @param len Tamanho da linha.
+ * @return A lista (`count == 0` para linha vazia ou comentário), ou NULL em caso de erro
+ * de sintaxe (mensagem já exibida) ou de alocação.
+ */
+const struct command_list *parse_cache_get(const char *line, size_t len);
+
+/**
+ * @brief Descarta todas as linhas guardadas (a arena é reiniciada; só é liberada se passou do limite).
+ */
+void parse_cache_clear(void);
+
+/**
+ * @brief Contadores de acertos e falhas do cache.
+ */
+struct parse_cache_stats parse_cache_get_stats(void);
+
+#endif //PARSE_CACHE_H
@@ -0,0 +1,731 @@
+#include "parser.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "term_tools.h"
+#include "glob_expand.h"
+
+#define PARSER_INITIAL_TOKENS 64
+#define PARSER_INITIAL_ITEMS 8
+
+/*****************************************************************************/
+
+enum token_kind {
+    TOKEN_WORD,
+    TOKEN_REDIRECT,  // Operador de redirecionamento; o arquivo (se houver) é a palavra seguinte
+    TOKEN_PIPE,      // |
+    TOKEN_OR,        // ||
+    TOKEN_AMP,       // &
+    TOKEN_AND,       // &&
+    TOKEN_SEMI,      // ; ou fim de linha
+    TOKEN_END,
+};
+
+struct token {
+    enum token_kind kind;
+    char *text;                 // TOKEN_WORD: palavra sem aspas, terminada em '\0'
+    size_t len;
+    size_t begin;               // Trecho [begin, end) na linha
+    size_t end;
+    bool quoted;                // A palavra tinha aspas ou escapes (`""` é um argumento vazio)
+    bool expand;                // A palavra tem variáveis
+    bool glob;                  // A palavra tem `*`, `?` ou `[` fora de aspas
+    const char *pattern;        // Com `glob`, em `parse_expand`: a palavra com `\` antes do que veio entre aspas
+    size_t glob_first;          // Caminhos da expansão em `globbed` (glob_count = 0: nenhum casou)
+    size_t glob_count;
+    bool newline;               // TOKEN_SEMI vindo de '\n'
+    struct redirect redirect;   // TOKEN_REDIRECT
+};
+
+/**
+ * @brief Estado da separação de uma linha (ou de um item, em `parse_expand`).
+ */
+struct lexer {
+    char *src;              // Cópia da linha na arena; as palavras são escritas sem aspas no próprio lugar
+    size_t len;
+    size_t pos;
+    struct arena *arena;
+    bool expand;            // Substituir variáveis (palavras montadas em `word`, não no lugar)
+    int last_status;
+};
+
+/*****************************************************************************/
+
+// Tokens da linha sendo separada (reaproveitado entre chamadas)
+static struct token *tokens = NULL;
+static size_t token_count = 0;
+static size_t token_capacity = 0;
+
+// Itens da lista sendo montada (copiados para a arena no fim)
+static struct list_item *items = NULL;
+static size_t item_capacity = 0;
+
+// Palavra sendo montada com variáveis substituídas (só em `parse_expand`)
+static char *word = NULL;
+static size_t word_len = 0;
+static size_t word_capacity = 0;
+
+// A mesma palavra como padrão: o que veio entre aspas (ou de variáveis) protegido com `\`
+static char *pattern = NULL;
+static size_t pattern_len = 0;
+static size_t pattern_capacity = 0;
+
+// Caminhos das palavras com padrões do pipeline sendo expandido
+static struct glob_paths globbed = {0};
+
+// Estágios do pipeline sendo montado
+static struct command stages[EXEC_MAX_COMMANDS];
+
+/*****************************************************************************/
+
+/**
+ * @brief Separa toda a entrada do lexer em `tokens` (terminados por TOKEN_END).
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida).
+ */
+static int tokenize(struct lexer *lx);
+
+/**
+ * @brief Lê uma palavra a partir de `lx->pos`, tirando aspas e escapes.
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida).
+ */
+static int lex_word(struct lexer *lx, struct token *token);
+
+/**
+ * @brief Lê uma referência a variável (`$NOME`, `${NOME}`, `$?`, `$$`) a partir do `$` em `lx->pos`.
+ * @param name Recebe o início do nome (ou do caractere especial).
+ * @param name_len Recebe o tamanho do nome (0 = não é variável: o `$` é literal).
+ * @return 0 em caso de sucesso, -1 em caso de erro de sintaxe (mensagem já exibida).
+ */
+static int lex_variable(struct lexer *lx, const char **name, size_t *name_len);
+
+/**
+ * @brief Acrescenta o valor de uma variável à palavra sendo montada.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int append_variable(struct lexer *lx, const char *name, size_t name_len);
+
+/**
+ * @brief Acrescenta bytes literais (entre aspas, escapes, variáveis) à palavra sendo montada.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int word_append(const char *data, size_t len);
+
+/**
+ * @brief Acrescenta um caractere sem aspas (`*`, `?` e `[` valem como padrão) à palavra sendo montada.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int word_append_unquoted(char c);
+
+/**
+ * @brief Garante espaço para mais `len` bytes em um buffer que cresce em dobro.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int buffer_reserve(char **buf, size_t *capacity, size_t len);
+
+/**
+ * @brief Lê um operador (`|`, `||`, `&`, `&&`, `;`, '\n', redirecionamentos) em `lx->pos`.
+ * @return 1 se leu um operador, 0 se não há operador na posição, -1 em caso de erro de sintaxe.
+ */
+static int lex_operator(struct lexer *lx, struct token *token);
+
+/**
+ * @brief Reserva o próximo token do vetor.
+ * @return O token, ou NULL em caso de erro de alocação.
+ */
+static struct token *new_token(void);
+
+/**
+ * @brief Monta o pipeline que começa em `tokens[*pos]`.
+ * @param glob Diretórios lidos na expansão de padrões (NULL em `parse_line`: os padrões ficam literais).
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida).
+ */
+static int parse_pipeline(struct arena *arena, size_t *pos, struct pipeline *pipeline, bool *expand,
+                          struct glob_cache *glob);
+
+/**
+ * @brief Monta um comando (palavras e redirecionamentos até o próximo operador).
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida).
+ */
+static int parse_command(struct arena *arena, size_t *pos, struct command *cmd, bool *expand,
+                         struct glob_cache *glob);
+
+/**
+ * @brief Exibe um erro de sintaxe perto do token.
+ */
+static void syntax_error(const struct token *token);
+
+/**
+ * @brief Texto de um token para mensagens de erro.
+ */
+static const char *token_name(const struct token *token);
+
+/*****************************************************************************/
+
+struct command_list *parse_line(struct arena *arena, const char *line, const size_t len) {
+    struct lexer lx = {.len = len, .arena = arena};
+    lx.src = arena_strndup(arena, line, len);
+    if (!lx.src || tokenize(&lx) != 0) return NULL;
+
+    size_t count = 0;
+    size_t pos = 0;
+    while (true) {
+        // Linhas em branco entre comandos (`-c` com vários '\n')
+        while (tokens[pos].kind == TOKEN_SEMI && tokens[pos].newline) pos++;
+        if (tokens[pos].kind == TOKEN_END) break;
+
+        if (count == item_capacity) {
+            const size_t new_capacity = item_capacity ? item_capacity * 2 : PARSER_INITIAL_ITEMS;
+            struct list_item *new_items = realloc(items, new_capacity * sizeof(struct list_item));
+            if (!new_items) return NULL;
+            items = new_items;
+            item_capacity = new_capacity;
+        }
+        struct list_item *item = &items[count++];
+        const size_t begin = tokens[pos].begin;
+        item->expand = false;
+        if (parse_pipeline(arena, &pos, &item->pipeline, &item->expand, NULL) != 0) return NULL;
+        const size_t source_end = tokens[pos - 1].end;
+        size_t text_end = source_end;
+
+        item->next = LIST_SEQ;
+        const struct token *op = &tokens[pos];
+        if (op->kind == TOKEN_AMP) {
+            item->pipeline.background = true;
+            text_end = op->end;
+            pos++;
+        } else if (op->kind == TOKEN_SEMI) {
+            pos++;
+        } else if (op->kind == TOKEN_AND || op->kind == TOKEN_OR) {
+            item->next = op->kind == TOKEN_AND ? LIST_AND : LIST_OR;
+            pos++;
+            // `a &&` precisa de outro comando (pode vir na linha seguinte do `-c`)
+            while (tokens[pos].kind == TOKEN_SEMI && tokens[pos].newline) pos++;
+            if (tokens[pos].kind != TOKEN_WORD && tokens[pos].kind != TOKEN_REDIRECT) {
+                syntax_error(&tokens[pos]);
+                return NULL;
+            }
+        } else if (op->kind != TOKEN_END) {
+            syntax_error(op);
+            return NULL;
+        }
+
+        // Texto para o `jobs` (com o `&`) e, para pipelines com variáveis, a origem a separar de novo
+        char *text = arena_strndup(arena, line + begin, text_end - begin);
+        if (!text) return NULL;
+        item->pipeline.text = text;
+        item->source = text;
+        item->source_len = source_end - begin;
+    }
+
+    struct command_list *list = arena_alloc(arena, sizeof(struct command_list));
+    if (!list) return NULL;
+    list->count = count;
+    list->items = NULL;
+    if (count > 0) {
+        list->items = arena_alloc(arena, count * sizeof(struct list_item));
+        if (!list->items) return NULL;
+        memcpy(list->items, items, count * sizeof(struct list_item));
+    }
+    return list;
+}
+
+int parse_expand(struct arena *arena, const struct list_item *item, const int last_status, struct pipeline *pipeline) {
+    struct lexer lx = {.len = item->source_len, .arena = arena, .expand = true, .last_status = last_status};
+    lx.src = arena_strndup(arena, item->source, item->source_len);
+    if (!lx.src || tokenize(&lx) != 0) return -1;
+
+    // Cada diretório é lido uma vez no pipeline inteiro, mesmo com vários padrões passando por ele
+    size_t pos = 0;
+    bool expand = false;
+    struct glob_cache glob;
+    glob_cache_init(&glob);
+    globbed.count = 0;
+    const int result = parse_pipeline(arena, &pos, pipeline, &expand, &glob);
+    glob_cache_free(&glob);
+    if (result != 0) return -1;
+    if (tokens[pos].kind != TOKEN_END) {
+        syntax_error(&tokens[pos]);
+        return -1;
+    }
+
+    // Comando cujas palavras sumiram na substituição (`$NADA`): sozinho, não há nada a rodar
+    for (size_t i = 0; i < pipeline->count; i++) {
+        const struct command *cmd = &pipeline->commands[i];
+        if (cmd->argc > 0 || cmd->redirect_count > 0) continue;
+        if (pipeline->count > 1) {
+            fprintf(stderr, "%sComando vazio no pipeline%s\n", TERM_RED_BOLD, TERM_RESET);
+            return -1;
+        }
+        pipeline->count = 0;
+    }
+    pipeline->background = item->pipeline.background;
+    pipeline->text = item->pipeline.text;
+    return 0;
+}
+
+/*****************************************************************************/
+
+static int tokenize(struct lexer *lx) {
+    token_count = 0;
+    while (true) {
+        // Espaços e comentários
+        while (lx->pos < lx->len && (lx->src[lx->pos] == ' ' || lx->src[lx->pos] == '\t')) lx->pos++;
+        if (lx->pos < lx->len && lx->src[lx->pos] == '#') {
+            const char *newline = memchr(lx->src + lx->pos, '\n', lx->len - lx->pos);
+            lx->pos = newline ? (size_t) (newline - lx->src) : lx->len;
+        }
+
+        struct token *token = new_token();
+        if (!token) return -1;
+        *token = (struct token) {.kind = TOKEN_END, .begin = lx->pos, .end = lx->pos};
+        if (lx->pos >= lx->len) break;
+
+        const int op = lex_operator(lx, token);
+        if (op < 0) return -1;
+        if (op == 0 && lex_word(lx, token) != 0) return -1;
+        token->end = lx->pos;
+    }
+
+    // Só agora, com todos os operadores já lidos, as palavras feitas no lugar ganham o '\0'
+    if (!lx->expand) {
+        for (size_t i = 0; i < token_count; i++) {
+            if (tokens[i].kind == TOKEN_WORD) tokens[i].text[tokens[i].len] = '\0';
+        }
+    }
+    return 0;
+}
+
+static int lex_operator(struct lexer *lx, struct token *token) {
+    const char *p = lx->src + lx->pos;
+    const char *end = lx->src + lx->len;
+
+    // `2>`, `10<`: número colado ao operador é o descritor
+    const char *digits = p;
+    long fd = -1;
+    if (*p >= '0' && *p <= '9') {
+        long value = 0;
+        while (digits < end && *digits >= '0' && *digits <= '9' && value <= INT_MAX) {
+            value = value * 10 + (*digits++ - '0');
+        }
+        if (digits == end || (*digits != '<' && *digits != '>') || value > INT_MAX) return 0;
+        fd = value;
+        p = digits;
+    }
+
+    switch (*p) {
+        case '|':
+            token->kind = p + 1 < end && p[1] == '|' ? TOKEN_OR : TOKEN_PIPE;
+            lx->pos += token->kind == TOKEN_OR ? 2 : 1;
+            return 1;
+        case '&':
+            token->kind = p + 1 < end && p[1] == '&' ? TOKEN_AND : TOKEN_AMP;
+            lx->pos += token->kind == TOKEN_AND ? 2 : 1;
+            return 1;
+        case ';':
+        case '\n':
+            token->kind = TOKEN_SEMI;
+            token->newline = *p == '\n';
+            lx->pos++;
+            return 1;
+        case '<':
+        case '>':
+            break;
+        default:
+            return 0;
+    }
+
+    struct redirect *redirect = &token->redirect;
+    token->kind = TOKEN_REDIRECT;
+    redirect->path = NULL;
+    redirect->target = -1;
+    if (*p == '<') {
+        redirect->kind = REDIRECT_IN;
+        redirect->fd = fd >= 0 ? (int) fd : STDIN_FILENO;
+        p++;
+    } else {
+        p++;
+        redirect->kind = REDIRECT_OUT;
+        if (p < end && *p == '>') {
+            redirect->kind = REDIRECT_APPEND;
+            p++;
+        }
+        redirect->fd = fd >= 0 ? (int) fd : STDOUT_FILENO;
+    }
+
+    // `2>&1`, `<&3`: cópia de descritor, número obrigatório
+    if (p < end && *p == '&' && redirect->kind != REDIRECT_APPEND) {
+        p++;
+        long target = 0;
+        const char *start = p;
+        while (p < end && *p >= '0' && *p <= '9' && target <= INT_MAX) target = target * 10 + (*p++ - '0');
+        if (p == start || target > INT_MAX) {
+            lx->pos = (size_t) (p - lx->src);
+            fprintf(stderr, "%sErro de sintaxe: descritor inválido depois de '&'%s\n", TERM_RED_BOLD, TERM_RESET);
+            return -1;
+        }
+        redirect->kind = REDIRECT_DUP;
+        redirect->target = (int) target;
+    }
+    lx->pos = (size_t) (p - lx->src);
+    return 1;
+}
+
+static int lex_word(struct lexer *lx, struct token *token) {
+    char *src = lx->src;
+    const size_t len = lx->len;
+    size_t pos = lx->pos;
+    size_t out = pos;   // Escrita no lugar: nunca passa de `pos` (aspas e escapes só encolhem)
+
+    token->kind = TOKEN_WORD;
+    word_len = 0;
+    pattern_len = 0;
+
+// Emite um byte da palavra: no lugar, ou no buffer `word` quando há substituição de variáveis
+#define EMIT(c)                                                  \
+    do {                                                         \
+        const char emit_c = (c);                                 \
+        if (lx->expand) {                                        \
+            if (word_append(&emit_c, 1) != 0) return -1;         \
+        } else {                                                 \
+            src[out++] = emit_c;                                 \
+        }                                                        \
+    } while (0)
+
+    while (pos < len) {
+        const char c = src[pos];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '|' || c == '&' || c == ';' || c == '<' || c == '>') break;
+
+        if (c == '\'') {
+            const char *close = memchr(src + pos + 1, '\'', len - pos - 1);
+            if (!close) {
+                fprintf(stderr, "%sErro de sintaxe: aspas simples não fechadas%s\n", TERM_RED_BOLD, TERM_RESET);
+                return -1;
+            }
+            const size_t quoted_len = (size_t) (close - (src + pos + 1));
+            if (lx->expand) {
+                if (word_append(src + pos + 1, quoted_len) != 0) return -1;
+            } else {
+                memmove(src + out, src + pos + 1, quoted_len);
+                out += quoted_len;
+            }
+            pos += quoted_len + 2;
+            token->quoted = true;
+        } else if (c == '"') {
+            pos++;
+            token->quoted = true;
+            bool closed = false;
+            while (pos < len) {
+                const char q = src[pos];
+                if (q == '"') {
+                    pos++;
+                    closed = true;
+                    break;
+                }
+                if (q == '\\' && pos + 1 < len && strchr("$\"\\`\n", src[pos + 1])) {
+                    if (src[pos + 1] != '\n') EMIT(src[pos + 1]);
+                    pos += 2;
+                } else if (q == '$') {
+                    const char *name;
+                    size_t name_len;
+                    const size_t dollar = pos;
+                    lx->pos = pos;
+                    if (lex_variable(lx, &name, &name_len) != 0) return -1;
+                    pos = lx->pos;
+                    if (name_len == 0) {
+                        EMIT('$');
+                    } else if (lx->expand) {
+                        if (append_variable(lx, name, name_len) != 0) return -1;
+                    } else {
+                        token->expand = true;
+                        memmove(src + out, src + dollar, pos - dollar);
+                        out += pos - dollar;
+                    }
+                } else {
+                    EMIT(q);
+                    pos++;
+                }
+            }
+            if (!closed) {
+                fprintf(stderr, "%sErro de sintaxe: aspas duplas não fechadas%s\n", TERM_RED_BOLD, TERM_RESET);
+                return -1;
+            }
+        } else if (c == '\\') {
+            token->quoted = true;
+            if (pos + 1 >= len) {
+                EMIT('\\');
+                pos++;
+            } else {
+                if (src[pos + 1] != '\n') EMIT(src[pos + 1]); // `\` + fim de linha continua a palavra
+                pos += 2;
+            }
+        } else if (c == '$') {
+            const char *name;
+            size_t name_len;
+            const size_t dollar = pos;
+            lx->pos = pos;
+            if (lex_variable(lx, &name, &name_len) != 0) return -1;
+            pos = lx->pos;
+            if (name_len == 0) {
+                EMIT('$');
+            } else if (lx->expand) {
+                if (append_variable(lx, name, name_len) != 0) return -1;
+            } else {
+                token->expand = true;
+                memmove(src + out, src + dollar, pos - dollar);
+                out += pos - dollar;
+            }
+        } else {
+            if (c == '*' || c == '?' || c == '[') token->glob = true;
+            // Trecho comum: sem nada encolhido ainda, a palavra é só um trecho da linha
+            if (lx->expand) {
+                if (word_append_unquoted(c) != 0) return -1;
+            } else if (out == pos) {
+                out++;
+            } else {
+                src[out++] = c;
+            }
+            pos++;
+        }
+    }
+#undef EMIT
+
+    lx->pos = pos;
+    if (lx->expand) {
+        token->text = arena_strndup(lx->arena, word ? word : "", word_len);
+        if (!token->text) return -1;
+        token->len = word_len;
+        if (token->glob) {
+            token->pattern = arena_strndup(lx->arena, pattern, pattern_len);
+            if (!token->pattern) return -1;
+        }
+    } else {
+        token->text = src + token->begin;
+        token->len = out - token->begin;
+    }
+    return 0;
+}
+
+static int lex_variable(struct lexer *lx, const char **name, size_t *name_len) {
+    const char *src = lx->src;
+    size_t pos = lx->pos + 1;   // Depois do `$`
+    *name = src + pos;
+    *name_len = 0;
+
+    if (pos < lx->len && (src[pos] == '?' || src[pos] == '$')) {
+        *name_len = 1;
+        pos++;
+    } else if (pos < lx->len && src[pos] == '{') {
+        const char *close = memchr(src + pos, '}', lx->len - pos);
+        if (!close) {
+            fprintf(stderr, "%sErro de sintaxe: '${' sem '}'%s\n", TERM_RED_BOLD, TERM_RESET);
+            return -1;
+        }
+        *name = src + pos + 1;
+        *name_len = (size_t) (close - *name);
+        bool valid = *name_len > 0;
+        for (size_t i = 0; i < *name_len && valid; i++) {
+            const char n = (*name)[i];
+            valid = n == '_' || (n >= 'A' && n <= 'Z') || (n >= 'a' && n <= 'z') || (n >= '0' && n <= '9');
+        }
+        if (*name_len == 1 && (**name == '?' || **name == '$')) valid = true;
+        if (!valid) {
+            fprintf(stderr, "%sErro de sintaxe: substituição inválida '${%.*s}'%s\n", TERM_RED_BOLD,
+                    (int) *name_len, *name, TERM_RESET);
+            return -1;
+        }
+        pos = (size_t) (close - src) + 1;
+    } else {
+        while (pos < lx->len) {
+            const char n = src[pos];
+            const bool alpha = n == '_' || (n >= 'A' && n <= 'Z') || (n >= 'a' && n <= 'z');
+            if (!alpha && (*name_len == 0 || n < '0' || n > '9')) break;
+            (*name_len)++;
+            pos++;
+        }
+    }
+    lx->pos = *name_len > 0 ? pos : lx->pos + 1;
+    return 0;
+}
+
+static int append_variable(struct lexer *lx, const char *name, const size_t name_len) {
+    char number[24];
+    if (name_len == 1 && (*name == '?' || *name == '$')) {
+        const int length = snprintf(number, sizeof(number), "%d", *name == '?' ? lx->last_status : (int) getpid());
+        return word_append(number, (size_t) length);
+    }
+
+    const char *key = arena_strndup(lx->arena, name, name_len);
+    if (!key) return -1;
+    const char *value = getenv(key);
+    return value ? word_append(value, strlen(value)) : 0;
+}
+
+static int word_append(const char *data, const size_t len) {
+    // No padrão, cada byte pode ganhar um `\` antes
+    if (buffer_reserve(&word, &word_capacity, word_len + len) != 0 ||
+        buffer_reserve(&pattern, &pattern_capacity, pattern_len + 2 * len) != 0) return -1;
+    memcpy(word + word_len, data, len);
+    word_len += len;
+    for (size_t i = 0; i < len; i++) {
+        if (strchr("*?[]\\", data[i]) && data[i] != '\0') pattern[pattern_len++] = '\\';
+        pattern[pattern_len++] = data[i];
+    }
+    return 0;
+}
+
+static int word_append_unquoted(const char c) {
+    if (buffer_reserve(&word, &word_capacity, word_len + 1) != 0 ||
+        buffer_reserve(&pattern, &pattern_capacity, pattern_len + 1) != 0) return -1;
+    word[word_len++] = c;
+    pattern[pattern_len++] = c;
+    return 0;
+}
+
+static int buffer_reserve(char **buf, size_t *capacity, const size_t len) {
+    if (len <= *capacity) return 0;
+    size_t new_capacity = *capacity ? *capacity : 256;
+    while (new_capacity < len) new_capacity *= 2;
+    char *grown = realloc(*buf, new_capacity);
+    if (!grown) return -1;
+    *buf = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static struct token *new_token(void) {
+    if (token_count == token_capacity) {
+        const size_t new_capacity = token_capacity ? token_capacity * 2 : PARSER_INITIAL_TOKENS;
+        struct token *new_tokens = realloc(tokens, new_capacity * sizeof(struct token));
+        if (!new_tokens) return NULL;
+        tokens = new_tokens;
+        token_capacity = new_capacity;
+    }
+    return &tokens[token_count++];
+}
+
+/*****************************************************************************/
+
+static int parse_pipeline(struct arena *arena, size_t *pos, struct pipeline *pipeline, bool *expand,
+                          struct glob_cache *glob) {
+    size_t count = 0;
+    while (true) {
+        if (count == EXEC_MAX_COMMANDS) {
+            fprintf(stderr, "%sPipeline com mais de %d comandos%s\n", TERM_RED_BOLD, EXEC_MAX_COMMANDS, TERM_RESET);
+            return -1;
+        }
+        if (parse_command(arena, pos, &stages[count], expand, glob) != 0) return -1;
+        count++;
+        if (tokens[*pos].kind != TOKEN_PIPE) break;
+        (*pos)++;
+    }
+
+    pipeline->commands = arena_alloc(arena, count * sizeof(struct command));
+    if (!pipeline->commands) return -1;
+    memcpy(pipeline->commands, stages, count * sizeof(struct command));
+    pipeline->count = count;
+    pipeline->background = false;
+    pipeline->text = NULL;
+    return 0;
+}
+
+static int parse_command(struct arena *arena, size_t *pos, struct command *cmd, bool *expand,
+                         struct glob_cache *glob) {
+    // Primeiro contar as palavras (já com os padrões expandidos), para o argv sair com o tamanho exato
+    size_t argc = 0;
+    size_t end = *pos;
+    for (; tokens[end].kind == TOKEN_WORD || tokens[end].kind == TOKEN_REDIRECT; end++) {
+        struct token *token = &tokens[end];
+        if (token->kind == TOKEN_REDIRECT) {
+            if (token->redirect.kind != REDIRECT_DUP && tokens[end + 1].kind == TOKEN_WORD) end++;
+            continue;
+        }
+        token->glob_count = 0;
+        if (glob && token->pattern) {
+            token->glob_first = globbed.count;
+            const long matches = glob_expand(glob, arena, token->pattern, &globbed);
+            if (matches < 0) {
+                fprintf(stderr, "%sMemória insuficiente para expandir '%s'%s\n", TERM_RED_BOLD, token->text,
+                        TERM_RESET);
+                return -1;
+            }
+            token->glob_count = (size_t) matches;
+        }
+        // Padrão sem nenhum caminho fica como está (como no bash sem `nullglob`)
+        if (token->glob_count > 0) argc += token->glob_count;
+        else if (token->len > 0 || token->quoted) argc++;
+    }
+    if (end == *pos) {
+        syntax_error(&tokens[end]);
+        return -1;
+    }
+    if (argc > INT_MAX - 1) {
+        fprintf(stderr, "%sComando com argumentos demais%s\n", TERM_RED_BOLD, TERM_RESET);
+        return -1;
+    }
+
+    cmd->argv = arena_alloc(arena, (argc + 1) * sizeof(char *));
+    if (!cmd->argv) return -1;
+    cmd->argc = 0;
+    cmd->redirect_count = 0;
+
+    for (size_t i = *pos; i < end; i++) {
+        const struct token *token = &tokens[i];
+        *expand = *expand || token->expand || token->glob;
+        if (token->kind == TOKEN_WORD) {
+            if (token->glob_count > 0) {
+                memcpy(cmd->argv + cmd->argc, globbed.paths + token->glob_first, token->glob_count * sizeof(char *));
+                cmd->argc += (int) token->glob_count;
+                continue;
+            }
+            // `$NADA` sem aspas some da linha de comando
+            if (token->len > 0 || token->quoted) cmd->argv[cmd->argc++] = token->text;
+            continue;
+        }
+
+        if (cmd->redirect_count == EXEC_MAX_REDIRECTS) {
+            fprintf(stderr, "%sMais de %d redirecionamentos%s\n", TERM_RED_BOLD, EXEC_MAX_REDIRECTS, TERM_RESET);
+            return -1;
+        }
+        struct redirect *redirect = &cmd->redirects[cmd->redirect_count++];
+        *redirect = token->redirect;
+        if (redirect->kind == REDIRECT_DUP) continue;
+        if (tokens[i + 1].kind != TOKEN_WORD) {
+            syntax_error(&tokens[i + 1]);
+            return -1;
+        }
+        redirect->path = tokens[++i].text;
+        *expand = *expand || tokens[i].expand;
+    }
+    cmd->argv[cmd->argc] = NULL;
+    *pos = end;
+    return 0;
+}
+
+static void syntax_error(const struct token *token) {
+    fprintf(stderr, "%sErro de sintaxe perto de '%s'%s\n", TERM_RED_BOLD, token_name(token), TERM_RESET);
+}
+
+static const char *token_name(const struct token *token) {
+    switch (token->kind) {
+        case TOKEN_WORD: return token->text;
+        case TOKEN_PIPE: return "|";
+        case TOKEN_OR: return "||";
+        case TOKEN_AMP: return "&";
+        case TOKEN_AND: return "&&";
+        case TOKEN_SEMI: return token->newline ? "fim de linha" : ";";
+        case TOKEN_END: return "fim da linha";
+        case TOKEN_REDIRECT:
+            switch (token->redirect.kind) {
+                case REDIRECT_IN: return "<";
+                case REDIRECT_OUT: return ">";
+                case REDIRECT_APPEND: return ">>";
+                case REDIRECT_DUP: return ">&";
+            }
+    }
+    return "?";
+}
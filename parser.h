@@ -0,0 +1,81 @@
+//
+// Analisador da linha de comando: aspas, escapes, variáveis, `;`, `&&`, `||`, `|`, `&` e redirecionamentos.
+//
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "exec.h"
+
+/**
+ * @brief Como um item da lista se liga ao seguinte.
+ */
+enum list_op {
+    LIST_SEQ,   // `;`, `&`, fim de linha: o seguinte roda sempre
+    LIST_AND,   // `&&`: o seguinte só roda se este terminar com 0
+    LIST_OR,    // `||`: o seguinte só roda se este falhar
+};
+
+/**
+ * @brief Pipeline da lista, já separado em comandos.
+ *
+ * Um pipeline com variáveis (`$HOME`, `${X}`, `$?`, `$$`) ou padrões (`*.c`) é separado
+ * de novo, com os valores e os arquivos do momento, por `parse_expand` logo antes de rodar.
+ */
+struct list_item {
+    struct pipeline pipeline;
+    enum list_op next;
+    bool expand;             // Tem variáveis ou padrões: rodar o resultado de `parse_expand`
+    const char *source;      // Trecho da linha com o pipeline (sem o `&`)
+    size_t source_len;
+};
+
+/**
+ * @brief Linha inteira: itens separados por `;`, `&`, `&&` e `||`.
+ */
+struct command_list {
+    struct list_item *items;
+    size_t count;            // 0 para linha vazia ou só comentário
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Separa uma linha em lista de pipelines, em tempo linear no tamanho da linha.
+ *
+ * Aspas simples preservam tudo; aspas duplas preservam tudo menos `$` e `\`; fora
+ * das aspas, `\` protege o caractere seguinte e `#` no início de uma palavra
+ * começa um comentário. Os operadores não precisam de espaços (`a|b&&c;d`), e
+ * `&` coloca em segundo plano o pipeline antes dele. `\n` separa comandos como `;`.
+ *
+ * A linha é copiada para a arena uma vez; as palavras são trechos dessa cópia
+ * (sem aspas, terminados em '\0' no próprio lugar). Tudo, inclusive os argv e
+ * os textos exibidos pelo `jobs`, fica na arena.
+ * @param arena Arena do resultado.
+ * @param line Linha (não precisa terminar em '\0').
+ * @param len Tamanho da linha.
+ * @return A lista, ou NULL em caso de erro de sintaxe (mensagem já exibida) ou de alocação.
+ */
+struct command_list *parse_line(struct arena *arena, const char *line, size_t len);
+
+/**
+ * @brief Separa de novo um item com variáveis ou padrões, substituindo-os pelos valores atuais.
+ *
+ * Cada variável vira texto dentro da palavra, sem nova divisão em palavras; uma
+ * palavra sem aspas que fica vazia (`$NADA`) é removida. Uma palavra com `*`, `?`
+ * ou `[` fora de aspas vira os caminhos que casam (`glob_expand`, com um cache de
+ * diretórios por pipeline), ou fica como está se nenhum casar; o valor de uma
+ * variável e os destinos de redirecionamento não são expandidos.
+ * @param arena Arena do resultado (normalmente descartada após o comando).
+ * @param item Item de `parse_line` com `expand`.
+ * @param last_status Valor de `$?`.
+ * @param pipeline Saída (com `background` e `text` do item).
+ * @return 0 em caso de sucesso, -1 em caso de erro (mensagem já exibida).
+ */
+int parse_expand(struct arena *arena, const struct list_item *item, int last_status, struct pipeline *pipeline);
+
+#endif //PARSER_H
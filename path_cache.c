@@ -0,0 +1,354 @@
+#include "path_cache.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define PATH_CACHE_INITIAL_CAPACITY 64
+
+// PATH usado quando a variável não existe (o mesmo do execvp)
+#define PATH_CACHE_DEFAULT_PATH "/bin:/usr/bin"
+
+// Entradas do `hash -p` não pertencem a nenhum diretório do PATH
+#define DIR_NONE SIZE_MAX
+
+/*****************************************************************************/
+
+struct path_entry {
+    char *name;         // NULL = posição livre
+    char *path;
+    uint64_t hash;
+    size_t hits;
+    size_t dir;         // Índice em `dirs` onde o comando foi achado
+};
+
+struct path_dir {
+    const char *path;   // Aponta para `path_value`
+    struct timespec mtime;
+};
+
+/*****************************************************************************/
+
+static struct path_entry *table = NULL;
+static size_t capacity = 0;
+static size_t count = 0;
+static struct path_cache_stats stats = {0};
+
+static char *path_value = NULL;   // Cópia do PATH (separada em diretórios no próprio buffer)
+static char *path_original = NULL;
+static struct path_dir *dirs = NULL;
+static size_t dir_count = 0;
+static time_t checked_at = 0;
+
+/*****************************************************************************/
+
+/**
+ * @brief Descarta o cache se o PATH mudou e revalida o mtime dos diretórios.
+ */
+static void refresh(void);
+
+/**
+ * @brief Separa o PATH atual em diretórios e registra o mtime de cada um.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int load_path(const char *path);
+
+/**
+ * @brief Procura `name` nos diretórios do PATH.
+ * @param name Nome do comando.
+ * @param buf Buffer de saída com o caminho completo.
+ * @param dir Recebe o índice do diretório.
+ * @return true se um executável foi encontrado.
+ */
+static bool resolve(const char *name, char *buf, size_t *dir);
+
+/**
+ * @brief Insere ou substitui uma entrada.
+ * @return Entrada inserida, ou NULL em caso de erro de alocação.
+ */
+static struct path_entry *insert(const char *name, const char *path, size_t dir);
+
+/**
+ * @brief Procura o slot do nome (ou o slot livre onde ele entraria).
+ */
+static struct path_entry *find_slot(const char *name, uint64_t hash);
+
+/**
+ * @brief Reconstrói a tabela mantendo só as entradas de diretórios antes de `first_stale`.
+ */
+static void drop_from(size_t first_stale);
+
+/**
+ * @brief Dobra a tabela e reinsere as entradas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int grow(void);
+
+/**
+ * @brief FNV-1a de 64 bits.
+ */
+static uint64_t hash_name(const char *name);
+
+/**
+ * @brief Segundos do relógio monotônico.
+ */
+static time_t now_seconds(void);
+
+/*****************************************************************************/
+
+const char *path_cache_lookup(const char *name) {
+    refresh();
+
+    const uint64_t hash = hash_name(name);
+    if (table) {
+        struct path_entry *slot = find_slot(name, hash);
+        if (slot->name) {
+            slot->hits++;
+            stats.hits++;
+            return slot->path;
+        }
+    }
+
+    stats.misses++;
+    static char resolved[PATH_MAX];
+    size_t dir;
+    if (!resolve(name, resolved, &dir)) return NULL;
+
+    // Diretórios relativos do PATH (ex.: "." ou vazio) dependem do diretório atual: não guardar
+    if (resolved[0] != '/') return resolved;
+    struct path_entry *entry = insert(name, resolved, dir);
+    if (!entry) return resolved;
+    entry->hits = 1;
+    return entry->path;
+}
+
+int path_cache_add(const char *name) {
+    refresh();
+    char resolved[PATH_MAX];
+    size_t dir;
+    if (!resolve(name, resolved, &dir)) return -1;
+    return insert(name, resolved, dir) ? 0 : -1;
+}
+
+int path_cache_set(const char *name, const char *path) {
+    refresh();
+    return insert(name, path, DIR_NONE) ? 0 : -1;
+}
+
+bool path_cache_remove(const char *name) {
+    if (!table) return false;
+    struct path_entry *slot = find_slot(name, hash_name(name));
+    if (!slot->name) return false;
+
+    free(slot->name);
+    free(slot->path);
+    slot->name = slot->path = NULL;
+    count--;
+
+    // Remoção com deslocamento para trás: as entradas seguintes do mesmo grupo voltam uma posição
+    const size_t mask = capacity - 1;
+    size_t hole = (size_t) (slot - table);
+    for (size_t i = (hole + 1) & mask; table[i].name; i = (i + 1) & mask) {
+        const size_t home = (size_t) table[i].hash & mask;
+        // Move se a posição ideal da entrada não está entre o buraco e ela (circularmente)
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            table[hole] = table[i];
+            table[i].name = table[i].path = NULL;
+            hole = i;
+        }
+    }
+    return true;
+}
+
+void path_cache_clear(void) {
+    for (size_t i = 0; i < capacity; i++) {
+        if (!table[i].name) continue;
+        free(table[i].name);
+        free(table[i].path);
+    }
+    free(table);
+    table = NULL;
+    capacity = count = 0;
+}
+
+void path_cache_foreach(const path_cache_fn fn, void *ctx) {
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].name) fn(table[i].name, table[i].path, table[i].hits, ctx);
+    }
+}
+
+struct path_cache_stats path_cache_get_stats(void) {
+    struct path_cache_stats current = stats;
+    current.entries = count;
+    return current;
+}
+
+/*****************************************************************************/
+
+static void refresh(void) {
+    const char *path = getenv("PATH");
+    if (!path) path = PATH_CACHE_DEFAULT_PATH;
+
+    if (!path_original || strcmp(path, path_original) != 0) {
+        path_cache_clear();
+        load_path(path);
+        return;
+    }
+
+    const time_t now = now_seconds();
+    if (now - checked_at < PATH_CACHE_CHECK_INTERVAL) return;
+    checked_at = now;
+
+    size_t first_stale = SIZE_MAX;
+    for (size_t i = 0; i < dir_count; i++) {
+        struct stat st;
+        const struct timespec mtime = stat(dirs[i].path, &st) == 0 ? st.st_mtim : (struct timespec) {0};
+        if (mtime.tv_sec != dirs[i].mtime.tv_sec || mtime.tv_nsec != dirs[i].mtime.tv_nsec) {
+            dirs[i].mtime = mtime;
+            if (first_stale == SIZE_MAX) first_stale = i;
+        }
+    }
+    if (first_stale != SIZE_MAX) drop_from(first_stale);
+}
+
+static int load_path(const char *path) {
+    free(path_value);
+    free(path_original);
+    free(dirs);
+    dirs = NULL;
+    dir_count = 0;
+    path_value = strdup(path);
+    path_original = strdup(path);
+    if (!path_value || !path_original) return -1;
+
+    size_t separators = 0;
+    for (const char *p = path; *p; p++) separators += *p == ':';
+    dirs = calloc(separators + 1, sizeof(struct path_dir));
+    if (!dirs) return -1;
+
+    // Elemento vazio equivale ao diretório atual
+    char *cursor = path_value;
+    while (true) {
+        char *end = strchr(cursor, ':');
+        if (end) *end = '\0';
+        struct stat st;
+        dirs[dir_count].path = *cursor ? cursor : ".";
+        if (stat(dirs[dir_count].path, &st) == 0) dirs[dir_count].mtime = st.st_mtim;
+        dir_count++;
+        if (!end) break;
+        cursor = end + 1;
+    }
+    checked_at = now_seconds();
+    return 0;
+}
+
+static bool resolve(const char *name, char *buf, size_t *dir) {
+    for (size_t i = 0; i < dir_count; i++) {
+        const int len = snprintf(buf, PATH_MAX, "%s/%s", dirs[i].path, name);
+        if (len < 0 || len >= PATH_MAX) continue;
+
+        struct stat st;
+        if (stat(buf, &st) == 0 && S_ISREG(st.st_mode) && access(buf, X_OK) == 0) {
+            *dir = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct path_entry *insert(const char *name, const char *path, const size_t dir) {
+    if ((count + 1) * 2 > capacity && grow() != 0) return NULL;
+
+    const uint64_t hash = hash_name(name);
+    struct path_entry *slot = find_slot(name, hash);
+    char *path_copy = strdup(path);
+    if (!path_copy) return NULL;
+
+    if (slot->name) {
+        free(slot->path);
+    } else {
+        slot->name = strdup(name);
+        if (!slot->name) {
+            free(path_copy);
+            return NULL;
+        }
+        slot->hash = hash;
+        slot->hits = 0;
+        count++;
+    }
+    slot->path = path_copy;
+    slot->dir = dir;
+    return slot;
+}
+
+static struct path_entry *find_slot(const char *name, const uint64_t hash) {
+    const size_t mask = capacity - 1;
+    size_t i = (size_t) hash & mask;
+    while (table[i].name && (table[i].hash != hash || strcmp(table[i].name, name) != 0)) {
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static void drop_from(const size_t first_stale) {
+    if (!table) return;
+    struct path_entry *old_table = table;
+    const size_t old_capacity = capacity;
+    table = calloc(old_capacity, sizeof(struct path_entry));
+    if (!table) {
+        // Sem memória para reconstruir: descartar tudo é sempre correto
+        table = old_table;
+        path_cache_clear();
+        return;
+    }
+
+    count = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (!old_table[i].name) continue;
+        if (old_table[i].dir != DIR_NONE && old_table[i].dir >= first_stale) {
+            free(old_table[i].name);
+            free(old_table[i].path);
+            continue;
+        }
+        *find_slot(old_table[i].name, old_table[i].hash) = old_table[i];
+        count++;
+    }
+    free(old_table);
+}
+
+static int grow(void) {
+    const size_t new_capacity = capacity ? capacity * 2 : PATH_CACHE_INITIAL_CAPACITY;
+    struct path_entry *new_table = calloc(new_capacity, sizeof(struct path_entry));
+    if (!new_table) return -1;
+
+    struct path_entry *old_table = table;
+    const size_t old_capacity = capacity;
+    table = new_table;
+    capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].name) *find_slot(old_table[i].name, old_table[i].hash) = old_table[i];
+    }
+    free(old_table);
+    return 0;
+}
+
+static uint64_t hash_name(const char *name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char *p = (const unsigned char *) name; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static time_t now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
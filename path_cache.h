@@ -0,0 +1,80 @@
+//
+// Cache de comandos do PATH (nome -> caminho absoluto), como o `hash` do bash.
+//
+
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Intervalo mínimo, em segundos, entre verificações do mtime dos diretórios do PATH
+#define PATH_CACHE_CHECK_INTERVAL 1
+
+struct path_cache_stats {
+    size_t hits;
+    size_t misses;    // Buscas que percorreram os diretórios do PATH
+    size_t entries;
+};
+
+/**
+ * @brief Função chamada para cada entrada por `path_cache_foreach`.
+ * @param name Nome do comando.
+ * @param path Caminho resolvido.
+ * @param hits Vezes que a entrada foi usada.
+ * @param ctx Contexto repassado por `path_cache_foreach`.
+ */
+typedef void (*path_cache_fn)(const char *name, const char *path, size_t hits, void *ctx);
+
+/**
+ * @brief Caminho do comando `name`, percorrendo o PATH só na primeira vez.
+ *
+ * O cache é descartado quando o PATH muda. Quando o mtime de um diretório do
+ * PATH muda (um binário foi criado ou removido), caem as entradas daquele
+ * diretório e dos seguintes, que podem ter passado a ser encobertas.
+ * @param name Nome do comando (sem '/').
+ * @return Caminho do executável (válido até a próxima alteração do cache), ou NULL se não existir.
+ */
+const char *path_cache_lookup(const char *name);
+
+/**
+ * @brief Resolve `name` no PATH agora e guarda o resultado (`hash nome`).
+ * @param name Nome do comando.
+ * @return 0 em caso de sucesso, -1 se o comando não for encontrado.
+ */
+int path_cache_add(const char *name);
+
+/**
+ * @brief Associa `name` a um caminho escolhido pelo usuário (`hash -p caminho nome`).
+ * @param name Nome do comando.
+ * @param path Caminho do executável.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+int path_cache_set(const char *name, const char *path);
+
+/**
+ * @brief Remove uma entrada (`hash -d nome`).
+ * @param name Nome do comando.
+ * @return true se a entrada existia.
+ */
+bool path_cache_remove(const char *name);
+
+/**
+ * @brief Descarta todas as entradas (`hash -r`).
+ */
+void path_cache_clear(void);
+
+/**
+ * @brief Percorre as entradas do cache.
+ * @param fn Função chamada para cada entrada.
+ * @param ctx Contexto repassado para `fn`.
+ */
+void path_cache_foreach(path_cache_fn fn, void *ctx);
+
+/**
+ * @brief Contadores de acertos e falhas do cache.
+ * @return Estatísticas acumuladas desde o início da sessão.
+ */
+struct path_cache_stats path_cache_get_stats(void);
+
+#endif //PATH_CACHE_H
@@ -0,0 +1,140 @@
+#include "proc_events.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <linux/cn_proc.h>
+
+// Espaço de cada mensagem no lote (cabeçalho netlink + cn_msg + proc_event, com folga)
+#define PROC_EVENTS_MSG_SIZE 256
+
+/*****************************************************************************/
+
+/**
+ * @brief Envia ao conector a operação de assinatura (LISTEN) ou de cancelamento (IGNORE).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int send_mcast_op(int fd, enum proc_cn_mcast_op op);
+
+/**
+ * @brief Converte uma mensagem do conector em um evento de processo.
+ * @return true se a mensagem é um evento de interesse (de processo, não de thread).
+ */
+static bool decode_message(const char *data, size_t len, struct proc_change *change);
+
+/*****************************************************************************/
+
+int proc_events_open(void) {
+    const int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0) return -1;
+
+    // Um buffer grande evita ENOBUFS em rajadas de fork; sem privilégio vale o limite do sistema
+    const int rcvbuf = PROC_EVENTS_RCVBUF;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    const struct sockaddr_nl addr = {.nl_family = AF_NETLINK, .nl_groups = CN_IDX_PROC, .nl_pid = 0};
+    if (bind(fd, (const struct sockaddr *) &addr, sizeof(addr)) != 0 || send_mcast_op(fd, PROC_CN_MCAST_LISTEN) != 0) {
+        const int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+long proc_events_read(const int fd, struct proc_change *changes, const size_t max, bool *lost) {
+    char buffers[PROC_EVENTS_BATCH][PROC_EVENTS_MSG_SIZE];
+    struct iovec iov[PROC_EVENTS_BATCH];
+    struct sockaddr_nl senders[PROC_EVENTS_BATCH];
+    struct mmsghdr msgs[PROC_EVENTS_BATCH];
+
+    size_t count = 0;
+    while (count + PROC_EVENTS_BATCH <= max) {
+        for (size_t i = 0; i < PROC_EVENTS_BATCH; i++) {
+            iov[i] = (struct iovec){.iov_base = buffers[i], .iov_len = PROC_EVENTS_MSG_SIZE};
+            msgs[i] = (struct mmsghdr){.msg_hdr = {.msg_name = &senders[i], .msg_namelen = sizeof(senders[i]),
+                                                   .msg_iov = &iov[i], .msg_iovlen = 1}};
+        }
+        const int received = recvmmsg(fd, msgs, PROC_EVENTS_BATCH, 0, NULL);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // O kernel descartou mensagens; as que ainda estão na fila continuam válidas
+                *lost = true;
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return count > 0 ? (long) count : -1;
+        }
+        for (int i = 0; i < received; i++) {
+            // Só o kernel (nl_pid 0) publica eventos de processos
+            if (msgs[i].msg_hdr.msg_namelen < sizeof(struct sockaddr_nl) || senders[i].nl_pid != 0) continue;
+            if (decode_message(buffers[i], msgs[i].msg_len, &changes[count])) count++;
+        }
+        if (received < PROC_EVENTS_BATCH) break;
+    }
+    return (long) count;
+}
+
+void proc_events_close(const int fd) {
+    if (fd < 0) return;
+    send_mcast_op(fd, PROC_CN_MCAST_IGNORE);
+    close(fd);
+}
+
+/*****************************************************************************/
+
+static int send_mcast_op(const int fd, const enum proc_cn_mcast_op op) {
+    struct {
+        struct nlmsghdr header;
+        struct cn_msg msg;
+        enum proc_cn_mcast_op op;
+    } __attribute__((packed)) request = {
+        .header = {.nlmsg_len = sizeof(request), .nlmsg_type = NLMSG_DONE, .nlmsg_pid = (uint32_t) getpid()},
+        .msg = {.id = {.idx = CN_IDX_PROC, .val = CN_VAL_PROC}, .len = sizeof(enum proc_cn_mcast_op)},
+        .op = op,
+    };
+    return send(fd, &request, sizeof(request), 0) == (ssize_t) sizeof(request) ? 0 : -1;
+}
+
+static bool decode_message(const char *data, const size_t len, struct proc_change *change) {
+    if (len < NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(struct proc_event))) return false;
+    const struct nlmsghdr *header = (const struct nlmsghdr *) data;
+    if (header->nlmsg_type != NLMSG_DONE) return false;
+
+    const struct cn_msg *msg = NLMSG_DATA(header);
+    if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) return false;
+
+    struct proc_event event;
+    memcpy(&event, msg->data, sizeof(event));
+    switch (event.what) {
+        case PROC_EVENT_FORK:
+            // Fork de thread: mesmo processo, nada muda na árvore
+            if (event.event_data.fork.child_pid != event.event_data.fork.child_tgid) return false;
+            *change = (struct proc_change){.kind = PROC_CHANGE_FORK, .pid = event.event_data.fork.child_tgid,
+                                           .ppid = event.event_data.fork.parent_tgid};
+            return true;
+        case PROC_EVENT_EXEC:
+            *change = (struct proc_change){.kind = PROC_CHANGE_EXEC, .pid = event.event_data.exec.process_tgid};
+            return true;
+        case PROC_EVENT_EXIT:
+            if (event.event_data.exit.process_pid != event.event_data.exit.process_tgid) return false;
+            *change = (struct proc_change){.kind = PROC_CHANGE_EXIT, .pid = event.event_data.exit.process_tgid};
+            return true;
+        case PROC_EVENT_COMM:
+            // O nome de uma thread que não é a principal não aparece na árvore
+            if (event.event_data.comm.process_pid != event.event_data.comm.process_tgid) return false;
+            *change = (struct proc_change){.kind = PROC_CHANGE_COMM, .pid = event.event_data.comm.process_tgid};
+            memcpy(change->comm, event.event_data.comm.comm, sizeof(change->comm));
+            change->comm[sizeof(change->comm) - 1] = '\0';
+            return true;
+        default:
+            return false;
+    }
+}
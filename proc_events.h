@@ -0,0 +1,69 @@
+//
+// Eventos de processos do kernel (fork, exec, exit, comm) pelo conector de processos do netlink.
+//
+
+#ifndef PROC_EVENTS_H
+#define PROC_EVENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Mensagens lidas por chamada de recvmmsg
+#define PROC_EVENTS_BATCH 64
+
+// Buffer de recepção pedido ao kernel: absorve picos de eventos entre duas leituras
+#define PROC_EVENTS_RCVBUF (8 * 1024 * 1024)
+
+/**
+ * @brief Tipo de mudança em um processo.
+ */
+enum proc_change_kind {
+    PROC_CHANGE_FORK,  // Processo novo (`pid`, filho de `ppid`)
+    PROC_CHANGE_EXEC,  // `pid` trocou de programa
+    PROC_CHANGE_EXIT,  // `pid` terminou
+    PROC_CHANGE_COMM,  // `pid` trocou de nome (`comm`)
+};
+
+/**
+ * @brief Evento de um processo (as threads são filtradas: `pid` é sempre o do processo).
+ */
+struct proc_change {
+    enum proc_change_kind kind;
+    pid_t pid;
+    pid_t ppid;     // Somente em PROC_CHANGE_FORK
+    char comm[16];  // Somente em PROC_CHANGE_COMM (terminado em '\0')
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Abre um socket do conector de processos e assina os eventos.
+ *
+ * Antes do Linux 6.6 exige CAP_NET_ADMIN; sem ela a assinatura falha com EPERM
+ * e o chamador deve recorrer à releitura do /proc. O socket é não bloqueante.
+ * @return Descritor do socket, ou -1 em caso de erro (errno preservado).
+ */
+int proc_events_open(void);
+
+/**
+ * @brief Lê os eventos pendentes, em lotes de PROC_EVENTS_BATCH mensagens por recvmmsg.
+ *
+ * Mensagens que não vêm do kernel são descartadas. Se o buffer de recepção
+ * transbordou (ENOBUFS), eventos foram perdidos: `*lost` vira true e o
+ * chamador deve ressincronizar pelo /proc.
+ * @param fd Socket de `proc_events_open`.
+ * @param changes Vetor de saída.
+ * @param max Capacidade de `changes` (ao menos PROC_EVENTS_BATCH).
+ * @param lost Marcado como true se houve perda de eventos.
+ * @return Quantidade de eventos (0 = nada pendente), ou -1 em caso de erro.
+ */
+long proc_events_read(int fd, struct proc_change *changes, size_t max, bool *lost);
+
+/**
+ * @brief Cancela a assinatura e fecha o socket.
+ * @param fd Socket de `proc_events_open`.
+ */
+void proc_events_close(int fd);
+
+#endif //PROC_EVENTS_H
@@ -0,0 +1,727 @@
+#include "proc_tools.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "parallel.h"
+
+// Blocos de PIDs entregues a cada thread na leitura do /proc
+#define PROC_SCAN_CHUNK 128
+
+// Buffer de cada chamada a getdents64
+#define PROC_DENTS_BUF_SIZE (64 * 1024)
+
+// Buffer de getdents64 de cada thread ao contar /proc/<pid>/fd
+#define PROC_FD_DENTS_BUF_SIZE 4096
+
+// Descritores reservados ao resto do shell quando a tabela mantém os stat abertos
+#define PROC_RESERVED_FDS 256
+
+// Marcadores de `process_table.fds` (valores >= 0 são descritores abertos)
+#define PROC_FD_NONE (-1)   // Abrir, ler e fechar
+#define PROC_FD_KEEP (-2)   // Abrir e manter aberto para a próxima varredura
+
+/*****************************************************************************/
+
+static atomic_int proc_fd_cache = -1;
+
+struct proc_scan_job {
+    int proc_fd;
+    unsigned flags;
+    const pid_t *pids;
+    int *fds;
+    const unsigned char *reused;  // NULL = reler todos
+    struct process_info *procs;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Escreve "<pid>/stat" em `out` sem passar por printf.
+ * @param pid PID do processo.
+ * @param out Buffer de saída (ao menos 24 bytes).
+ */
+static void format_stat_path(pid_t pid, char *out);
+
+/**
+ * @brief Conta os descritores abertos de um processo (entradas de `/proc/<pid>/fd`).
+ * @param proc_fd Descritor do /proc.
+ * @param pid PID do processo.
+ * @param buf Buffer de getdents64 do chamador.
+ * @param buf_size Tamanho do buffer.
+ * @return Quantidade de descritores, ou -1 se o diretório não puder ser lido (outro dono).
+ */
+static long count_fds(int proc_fd, pid_t pid, char *buf, size_t buf_size);
+
+/**
+ * @brief Avança o cursor sobre espaços e um campo numérico sem sinal.
+ * @param p Cursor atual.
+ * @param end Fim do buffer.
+ * @param value Valor lido (pode ser NULL para apenas pular o campo).
+ * @return Cursor após o campo, ou NULL se o buffer acabou.
+ */
+static const char *scan_ull(const char *p, const char *end, unsigned long long *value);
+
+/**
+ * @brief Igual a `scan_ull`, mas aceita sinal negativo.
+ */
+static const char *scan_ll(const char *p, const char *end, long long *value);
+
+/**
+ * @brief Lista os PIDs do /proc com `getdents64` em lotes grandes.
+ * @param proc_fd Descritor do /proc.
+ * @param table Tabela cujos buffers `pids`/`dents` recebem o resultado.
+ * @return Quantidade de PIDs encontrados, ou -1 em caso de erro.
+ */
+static long list_pids(int proc_fd, struct process_table *table);
+
+/**
+ * @brief Interpreta o conteúdo de um `/proc/<pid>/stat`.
+ * @param buf Conteúdo lido.
+ * @param len Tamanho do conteúdo.
+ * @param pid PID do processo.
+ * @param info Estrutura de saída.
+ * @return 0 em caso de sucesso, -1 se o conteúdo for inválido.
+ */
+static int parse_stat(const char *buf, size_t len, pid_t pid, struct process_info *info);
+
+/**
+ * @brief Associa a cada PID listado o descritor mantido da varredura anterior.
+ *
+ * As duas listas estão ordenadas, então basta uma intercalação; descritores
+ * de processos que sumiram são fechados.
+ * @param table Tabela com `keep_open` ativo.
+ * @param count Quantidade de PIDs listados.
+ */
+static void reuse_open_fds(struct process_table *table, size_t count);
+
+/**
+ * @brief Guarda os descritores abertos nesta varredura para a próxima.
+ * @param table Tabela com `keep_open` ativo.
+ * @param count Quantidade de PIDs listados.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int save_open_fds(struct process_table *table, size_t count);
+
+/**
+ * @brief Copia da leitura anterior os processos que `refresh` dispensa de reler.
+ *
+ * `previous` e `pids` estão ordenados por PID, então basta uma intercalação.
+ * @param table Tabela com `refresh` definido.
+ * @param previous_count Processos da leitura anterior.
+ * @param count Quantidade de PIDs listados.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int mark_reused(struct process_table *table, size_t previous_count, size_t count);
+
+/**
+ * @brief Função de comparação para ordenação de PIDs.
+ */
+static int compare_pid_values(const void *a, const void *b);
+
+/**
+ * @brief Lê os stat de um bloco de PIDs (executado por `parallel_for`).
+ *
+ * Processos que terminaram durante a varredura ficam com `pid == 0`.
+ */
+static void scan_chunk(size_t begin, size_t end, unsigned worker, void *ctx);
+
+/**
+ * @brief Monta o índice pai -> filhos (CSR) de um snapshot já ordenado.
+ * @param snap Snapshot com `procs` e `count` preenchidos.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int index_children(struct process_snapshot *snap);
+
+/**
+ * @brief Milissegundos entre dois instantes.
+ */
+static double elapsed_ms(const struct timespec *start, const struct timespec *end);
+
+/**
+ * @brief Função de comparação para ordenação de `process_info` por PID.
+ * @param a Ponteiro para o primeiro processo.
+ * @param b Ponteiro para o segundo processo.
+ * @return Valor < 0 se a < b, 0 se iguais, > 0 se a > b.
+ */
+static int compare_process_pids(const void *a, const void *b);
+
+/*****************************************************************************/
+
+int proc_root_fd(void) {
+    int fd = atomic_load(&proc_fd_cache);
+    if (fd >= 0) return fd;
+
+    // Duas threads (`par tree`) podem abrir ao mesmo tempo: fica o primeiro, o outro é fechado
+    fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int expected = -1;
+    if (!atomic_compare_exchange_strong(&proc_fd_cache, &expected, fd)) {
+        close(fd);
+        fd = expected;
+    }
+    return fd;
+}
+
+int proc_set_root(const char *path) {
+    const int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    const int old = atomic_exchange(&proc_fd_cache, fd);
+    if (old >= 0) close(old);
+    return 0;
+}
+
+int proc_read_stat(const int proc_fd, const pid_t pid, char *buf, const size_t buf_size,
+                   struct process_info *info) {
+    char path[24];
+    format_stat_path(pid, path);
+
+    const int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    const int result = proc_read_stat_fd(fd, pid, buf, buf_size, info);
+    close(fd);
+    return result;
+}
+
+int proc_read_stat_fd(const int fd, const pid_t pid, char *buf, const size_t buf_size,
+                      struct process_info *info) {
+    ssize_t len;
+    do {
+        len = pread(fd, buf, buf_size, 0);
+    } while (len < 0 && errno == EINTR);
+    if (len <= 0) return -1;
+
+    return parse_stat(buf, (size_t) len, pid, info);
+}
+
+// Função para obter informações do processo
+struct process_info get_process_info(const pid_t pid) {
+    struct process_info info = {0};
+    char buf[PROC_STAT_BUF_SIZE];
+
+    const int proc_fd = proc_root_fd();
+    if (proc_fd < 0 || proc_read_stat(proc_fd, pid, buf, sizeof(buf), &info) != 0) {
+        memset(&info, 0, sizeof(info));
+    }
+    return info;
+}
+
+int scan_processes(struct process_table *table, const unsigned threads) {
+    const size_t previous_count = table->count;
+    table->count = 0;
+
+    const int proc_fd = proc_root_fd();
+    if (proc_fd < 0) return -1;
+
+    const long pid_count = list_pids(proc_fd, table);
+    if (pid_count < 0) return -1;
+
+    if (table->keep_open) {
+        // Na primeira varredura, subir o limite de descritores até o máximo permitido
+        if (table->max_open == 0 && getrlimit(RLIMIT_NOFILE, &table->saved_nofile) == 0) {
+            struct rlimit raised = table->saved_nofile;
+            raised.rlim_cur = raised.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &raised) != 0) raised = table->saved_nofile;
+            table->max_open = raised.rlim_cur > PROC_RESERVED_FDS ? raised.rlim_cur - PROC_RESERVED_FDS : 0;
+        }
+        reuse_open_fds(table, pid_count);
+    } else {
+        for (size_t i = 0; i < (size_t) pid_count; i++) table->fds[i] = PROC_FD_NONE;
+    }
+
+    // A leitura anterior passa para `previous` antes de ser sobrescrita
+    if (table->refresh) {
+        struct process_info *swap = table->previous;
+        const size_t swap_capacity = table->previous_capacity;
+        table->previous = table->procs;
+        table->previous_capacity = table->capacity;
+        table->procs = swap;
+        table->capacity = swap_capacity;
+    }
+
+    if ((size_t) pid_count > table->capacity || !table->procs) {
+        const size_t capacity = pid_count > 0 ? (size_t) pid_count : 1;
+        struct process_info *grown = realloc(table->procs, capacity * sizeof(struct process_info));
+        if (!grown) return -1;
+        table->procs = grown;
+        table->capacity = capacity;
+    }
+
+    if (table->refresh && mark_reused(table, previous_count, pid_count) != 0) return -1;
+
+    struct proc_scan_job job = {.proc_fd = proc_fd, .flags = table->flags, .pids = table->pids, .fds = table->fds,
+                                .reused = table->refresh ? table->reused : NULL, .procs = table->procs};
+    table->threads = parallel_for(pid_count, PROC_SCAN_CHUNK, threads, scan_chunk, &job);
+    if (table->keep_open && save_open_fds(table, pid_count) != 0) return -1;
+
+    // Compactar, descartando processos que terminaram durante a varredura
+    for (size_t i = 0; i < (size_t) pid_count; i++) {
+        if (table->procs[i].pid != 0) table->procs[table->count++] = table->procs[i];
+    }
+    return 0;
+}
+
+void free_process_table(struct process_table *table) {
+    for (size_t i = 0; i < table->open_count; i++) {
+        close(table->open_fds[i]);
+    }
+    if (table->max_open) setrlimit(RLIMIT_NOFILE, &table->saved_nofile);
+
+    free(table->procs);
+    free(table->pids);
+    free(table->fds);
+    free(table->open_pids);
+    free(table->open_fds);
+    free(table->dents);
+    free(table->previous);
+    free(table->reused);
+    memset(table, 0, sizeof(*table));
+}
+
+// Varredura única do /proc: tabela ordenada por PID + listas de filhos em CSR
+int build_process_snapshot(struct process_snapshot *snap, const unsigned threads, const unsigned flags) {
+    memset(snap, 0, sizeof(*snap));
+
+    struct timespec t_start, t_scanned, t_indexed;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    struct process_table table = {.flags = flags};
+    const int scanned = scan_processes(&table, threads);
+
+    // O snapshot herda a tabela de processos; o resto dos buffers é descartado
+    snap->procs = table.procs;
+    snap->count = table.count;
+    snap->threads = table.threads;
+    snap->flags = flags;
+    table.procs = NULL;
+    free_process_table(&table);
+    if (scanned != 0) {
+        free_process_snapshot(snap);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_scanned);
+
+    if (index_children(snap) != 0) {
+        free_process_snapshot(snap);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_indexed);
+
+    snap->scan_ms = elapsed_ms(&t_start, &t_scanned);
+    snap->index_ms = elapsed_ms(&t_scanned, &t_indexed);
+    return 0;
+}
+
+void free_process_snapshot(struct process_snapshot *snap) {
+    free(snap->procs);
+    free(snap->child_start);
+    free(snap->children);
+    memset(snap, 0, sizeof(*snap));
+}
+
+int process_subtree_totals(const struct process_snapshot *snap, const size_t root, struct process_totals *totals) {
+    // Pilha de (processo, próximo filho a visitar); cada processo entra uma única vez
+    size_t *stack = malloc((snap->count ? snap->count : 1) * sizeof(size_t));
+    size_t *cursor = malloc((snap->count ? snap->count : 1) * sizeof(size_t));
+    if (!stack || !cursor) {
+        free(stack);
+        free(cursor);
+        return -1;
+    }
+
+    size_t depth = 0;
+    size_t index = root;
+    for (;;) {
+        // Entrada: o total começa com os recursos do próprio processo
+        const struct process_info *info = &snap->procs[index];
+        totals[index] = (struct process_totals){
+            .cpu = info->utime + info->stime,
+            .rss = info->rss > 0 ? (unsigned long long) info->rss : 0,
+            .threads = info->num_threads > 0 ? (unsigned long long) info->num_threads : 0,
+            .fds = info->fds > 0 ? (unsigned long long) info->fds : 0,
+            .procs = 1
+        };
+        stack[depth] = index;
+        cursor[depth++] = snap->child_start[index];
+
+        // Saída (pós-ordem): somar ao pai até achar um processo com filhos ainda não visitados
+        while (depth > 0 && cursor[depth - 1] == snap->child_start[stack[depth - 1] + 1]) {
+            const struct process_totals *done = &totals[stack[--depth]];
+            if (depth == 0) break;
+            struct process_totals *parent = &totals[stack[depth - 1]];
+            parent->cpu += done->cpu;
+            parent->rss += done->rss;
+            parent->threads += done->threads;
+            parent->fds += done->fds;
+            parent->procs += done->procs;
+        }
+        if (depth == 0) break;
+        index = snap->children[cursor[depth - 1]++];
+    }
+
+    free(stack);
+    free(cursor);
+    return 0;
+}
+
+long find_process(const struct process_snapshot *snap, const pid_t pid) {
+    size_t low = 0, high = snap->count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (snap->procs[mid].pid == pid) return (long) mid;
+        if (snap->procs[mid].pid < pid) low = mid + 1;
+        else high = mid;
+    }
+    return -1;
+}
+
+/*****************************************************************************/
+
+static int parse_stat(const char *buf, const size_t len, const pid_t pid, struct process_info *info) {
+    const char *end = buf + len;
+    const char *open_paren = memchr(buf, '(', len);
+    const char *close_paren = memrchr(buf, ')', len);
+    if (!open_paren || !close_paren || close_paren < open_paren) return -1;
+
+    size_t name_len = close_paren - open_paren - 1;
+    if (name_len >= sizeof(info->name)) name_len = sizeof(info->name) - 1;
+    memcpy(info->name, open_paren + 1, name_len);
+    info->name[name_len] = '\0';
+    info->pid = pid;
+
+    // Campo 3: estado
+    const char *p = close_paren + 1;
+    while (p < end && *p == ' ') p++;
+    if (p >= end) return -1;
+    info->state = *p++;
+
+    // Campos 4 a 24 (ppid ... rss)
+    long long ppid, num_threads, rss;
+    unsigned long long utime, stime, starttime;
+    p = scan_ll(p, end, &ppid);                      // 4  ppid
+    for (int field = 5; p && field <= 13; field++) { // 5  pgrp ... 13 cmajflt (tpgid pode ser -1)
+        p = scan_ll(p, end, NULL);
+    }
+    if (p) p = scan_ull(p, end, &utime);             // 14 utime
+    if (p) p = scan_ull(p, end, &stime);             // 15 stime
+    for (int field = 16; p && field <= 19; field++) { // 16 cutime ... 19 nice
+        p = scan_ll(p, end, NULL);
+    }
+    if (p) p = scan_ll(p, end, &num_threads);        // 20 num_threads
+    if (p) p = scan_ll(p, end, NULL);                // 21 itrealvalue
+    if (p) p = scan_ull(p, end, &starttime);         // 22 starttime
+    if (p) p = scan_ull(p, end, NULL);               // 23 vsize
+    if (p) p = scan_ll(p, end, &rss);                // 24 rss
+    if (!p) return -1;
+
+    info->ppid = (pid_t) ppid;
+    info->utime = utime;
+    info->stime = stime;
+    info->num_threads = (long) num_threads;
+    info->starttime = starttime;
+    info->rss = (long) rss;
+    info->fds = -1;  // Contados à parte (PROC_SCAN_FDS)
+    return 0;
+}
+
+static void format_stat_path(pid_t pid, char *out) {
+    char digits[16];
+    int n = 0;
+    do {
+        digits[n++] = (char) ('0' + pid % 10);
+        pid /= 10;
+    } while (pid > 0);
+
+    int i = 0;
+    while (n > 0) out[i++] = digits[--n];
+    memcpy(out + i, "/stat", sizeof("/stat"));
+}
+
+static long count_fds(const int proc_fd, const pid_t pid, char *buf, const size_t buf_size) {
+    char path[24];
+    format_stat_path(pid, path);
+    memcpy(strchr(path, '/'), "/fd", sizeof("/fd"));
+    const int dir_fd = openat(proc_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return -1;
+
+    long count = 0;
+    ssize_t len;
+    while ((len = getdents64(dir_fd, buf, buf_size)) > 0) {
+        for (ssize_t offset = 0; offset < len;) {
+            const struct dirent64 *entry = (const struct dirent64 *) (buf + offset);
+            offset += entry->d_reclen;
+            if (entry->d_name[0] != '.') count++;
+        }
+    }
+    close(dir_fd);
+    return len < 0 ? -1 : count;
+}
+
+static const char *scan_ull(const char *p, const char *end, unsigned long long *value) {
+    while (p < end && *p == ' ') p++;
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+
+    unsigned long long result = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (unsigned) (*p++ - '0');
+    }
+    if (value) *value = result;
+    return p;
+}
+
+static const char *scan_ll(const char *p, const char *end, long long *value) {
+    while (p < end && *p == ' ') p++;
+    const bool negative = p < end && *p == '-';
+    if (negative) p++;
+
+    unsigned long long magnitude;
+    p = scan_ull(p, end, &magnitude);
+    if (p && value) *value = negative ? -(long long) magnitude : (long long) magnitude;
+    return p;
+}
+
+static long list_pids(const int proc_fd, struct process_table *table) {
+    // Descritor próprio para não disputar o offset do descritor compartilhado
+    const int dir_fd = openat(proc_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return -1;
+
+    if (!table->dents) table->dents = malloc(PROC_DENTS_BUF_SIZE);
+    if (!table->pids) {
+        table->pid_capacity = 1024;
+        table->pids = malloc(table->pid_capacity * sizeof(pid_t));
+        table->fds = malloc(table->pid_capacity * sizeof(int));
+    }
+    if (!table->dents || !table->pids || !table->fds) {
+        close(dir_fd);
+        return -1;
+    }
+
+    size_t count = 0;
+    ssize_t len;
+    while ((len = getdents64(dir_fd, table->dents, PROC_DENTS_BUF_SIZE)) > 0) {
+        for (ssize_t offset = 0; offset < len;) {
+            const struct dirent64 *entry = (const struct dirent64 *) (table->dents + offset);
+            offset += entry->d_reclen;
+
+            if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+
+            // Somente diretórios numéricos são processos
+            pid_t pid = 0;
+            const char *c = entry->d_name;
+            for (; *c >= '0' && *c <= '9'; c++) pid = pid * 10 + (*c - '0');
+            if (*c != '\0' || pid <= 0) continue;
+
+            if (count == table->pid_capacity) {
+                pid_t *grown = realloc(table->pids, 2 * table->pid_capacity * sizeof(pid_t));
+                if (grown) table->pids = grown;
+                int *grown_fds = realloc(table->fds, 2 * table->pid_capacity * sizeof(int));
+                if (grown_fds) table->fds = grown_fds;
+                if (!grown || !grown_fds) {
+                    close(dir_fd);
+                    return -1;
+                }
+                table->pid_capacity *= 2;
+            }
+            table->pids[count++] = pid;
+        }
+    }
+
+    close(dir_fd);
+    if (len < 0) return -1;
+
+    // getdents64 costuma devolver o /proc em ordem de PID, mas isso não é garantido
+    bool sorted = true;
+    for (size_t i = 1; i < count && sorted; i++) {
+        sorted = table->pids[i - 1] < table->pids[i];
+    }
+    if (!sorted) qsort(table->pids, count, sizeof(pid_t), compare_pid_values);
+    return (long) count;
+}
+
+static void scan_chunk(const size_t begin, const size_t end, const unsigned worker, void *ctx) {
+    (void) worker;
+    const struct proc_scan_job *job = ctx;
+    char buf[PROC_STAT_BUF_SIZE];
+
+    for (size_t i = begin; i < end; i++) {
+        if (job->reused && job->reused[i]) continue;
+        int fd = job->fds[i];
+
+        // Descritor mantido da varredura anterior: basta reler
+        if (fd >= 0) {
+            if (proc_read_stat_fd(fd, job->pids[i], buf, sizeof(buf), &job->procs[i]) == 0) continue;
+            close(fd);
+            fd = job->fds[i] = PROC_FD_KEEP;
+        }
+
+        if (fd == PROC_FD_NONE) {
+            if (proc_read_stat(job->proc_fd, job->pids[i], buf, sizeof(buf), &job->procs[i]) != 0) {
+                job->procs[i].pid = 0;
+            }
+            continue;
+        }
+
+        char path[24];
+        format_stat_path(job->pids[i], path);
+        fd = openat(job->proc_fd, path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 && proc_read_stat_fd(fd, job->pids[i], buf, sizeof(buf), &job->procs[i]) == 0) {
+            job->fds[i] = fd;
+            continue;
+        }
+        if (fd >= 0) close(fd);
+        job->fds[i] = PROC_FD_NONE;
+        job->procs[i].pid = 0;
+    }
+
+    if (job->flags & PROC_SCAN_FDS) {
+        char dents[PROC_FD_DENTS_BUF_SIZE];
+        for (size_t i = begin; i < end; i++) {
+            if (job->procs[i].pid != 0 && !(job->reused && job->reused[i])) job->procs[i].fds = count_fds(job->proc_fd, job->pids[i], dents, sizeof(dents));
+        }
+    }
+
+    // O dono do processo é o dono do diretório /proc/<pid>
+    if (job->flags & PROC_SCAN_OWNER) {
+        for (size_t i = begin; i < end; i++) {
+            if (job->procs[i].pid == 0 || (job->reused && job->reused[i])) continue;
+
+            char path[24];
+            format_stat_path(job->pids[i], path);
+            *strchr(path, '/') = '\0';
+
+            struct stat st;
+            job->procs[i].uid = fstatat(job->proc_fd, path, &st, 0) == 0 ? st.st_uid : (uid_t) -1;
+        }
+    }
+}
+
+static void reuse_open_fds(struct process_table *table, const size_t count) {
+    size_t kept = 0, j = 0;
+    for (size_t i = 0; i < count; i++) {
+        const pid_t pid = table->pids[i];
+        while (j < table->open_count && table->open_pids[j] < pid) {
+            close(table->open_fds[j++]); // Processo terminou
+        }
+        if (j < table->open_count && table->open_pids[j] == pid) {
+            table->fds[i] = table->open_fds[j++];
+            kept++;
+        } else {
+            table->fds[i] = PROC_FD_NONE;
+        }
+    }
+    while (j < table->open_count) close(table->open_fds[j++]);
+    table->open_count = 0;
+
+    // Processos novos: abrir e manter enquanto houver descritores disponíveis
+    for (size_t i = 0; i < count && kept < table->max_open; i++) {
+        if (table->fds[i] == PROC_FD_NONE) {
+            table->fds[i] = PROC_FD_KEEP;
+            kept++;
+        }
+    }
+}
+
+static int save_open_fds(struct process_table *table, const size_t count) {
+    if (count > table->open_capacity) {
+        pid_t *pids = realloc(table->open_pids, count * sizeof(pid_t));
+        if (pids) table->open_pids = pids;
+        int *fds = realloc(table->open_fds, count * sizeof(int));
+        if (fds) table->open_fds = fds;
+        if (!pids || !fds) {
+            for (size_t i = 0; i < count; i++) {
+                if (table->fds[i] >= 0) close(table->fds[i]);
+            }
+            return -1;
+        }
+        table->open_capacity = count;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (table->fds[i] < 0) continue;
+        table->open_pids[table->open_count] = table->pids[i];
+        table->open_fds[table->open_count++] = table->fds[i];
+    }
+    return 0;
+}
+
+static int mark_reused(struct process_table *table, const size_t previous_count, const size_t count) {
+    if (count > table->reused_capacity) {
+        unsigned char *reused = realloc(table->reused, count);
+        if (!reused) return -1;
+        table->reused = reused;
+        table->reused_capacity = count;
+    }
+
+    size_t j = 0;
+    for (size_t i = 0; i < count; i++) {
+        const pid_t pid = table->pids[i];
+        while (j < previous_count && table->previous[j].pid < pid) j++;
+        const bool reuse = j < previous_count && table->previous[j].pid == pid &&
+                           !table->refresh(&table->previous[j], table->refresh_ctx);
+        if (reuse) table->procs[i] = table->previous[j];
+        table->reused[i] = reuse;
+    }
+    return 0;
+}
+
+static int index_children(struct process_snapshot *snap) {
+    // getdents64 costuma devolver o /proc em ordem de PID, mas isso não é garantido
+    bool sorted = true;
+    for (size_t i = 1; i < snap->count && sorted; i++) {
+        sorted = snap->procs[i - 1].pid < snap->procs[i].pid;
+    }
+    if (!sorted) qsort(snap->procs, snap->count, sizeof(struct process_info), compare_process_pids);
+
+    snap->child_start = calloc(snap->count + 1, sizeof(size_t));
+    snap->children = malloc((snap->count ? snap->count : 1) * sizeof(size_t));
+    long *parent = malloc((snap->count ? snap->count : 1) * sizeof(long));
+    size_t *cursor = malloc((snap->count ? snap->count : 1) * sizeof(size_t));
+    if (!snap->child_start || !snap->children || !parent || !cursor) {
+        free(parent);
+        free(cursor);
+        return -1;
+    }
+
+    // Contar filhos de cada processo
+    for (size_t i = 0; i < snap->count; i++) {
+        parent[i] = find_process(snap, snap->procs[i].ppid);
+        if (parent[i] >= 0) snap->child_start[parent[i] + 1]++;
+    }
+    for (size_t i = 0; i < snap->count; i++) {
+        snap->child_start[i + 1] += snap->child_start[i];
+    }
+
+    // Preencher as listas (já saem ordenadas por PID)
+    memcpy(cursor, snap->child_start, snap->count * sizeof(size_t));
+    for (size_t i = 0; i < snap->count; i++) {
+        if (parent[i] >= 0) snap->children[cursor[parent[i]]++] = i;
+    }
+    free(cursor);
+    free(parent);
+    return 0;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) * 1e3 + (double) (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static int compare_pid_values(const void *a, const void *b) {
+    const pid_t pa = *(const pid_t *) a;
+    const pid_t pb = *(const pid_t *) b;
+    return (pa > pb) - (pa < pb);
+}
+
+static int compare_process_pids(const void *a, const void *b) {
+    const pid_t pa = ((const struct process_info *) a)->pid;
+    const pid_t pb = ((const struct process_info *) b)->pid;
+    return (pa > pb) - (pa < pb);
+}
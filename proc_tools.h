@@ -0,0 +1,214 @@
+//
+// Leitura do /proc compartilhada pelos comandos de processos (`tree`, ...).
+//
+
+#ifndef PROC_TOOLS_H
+#define PROC_TOOLS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Tamanho recomendado do buffer de `proc_read_stat` (a linha do stat tem ~52 campos)
+#define PROC_STAT_BUF_SIZE 2048
+
+// Campos opcionais de `scan_processes` (custam uma syscall extra por processo)
+#define PROC_SCAN_OWNER 0x1   // Preencher `process_info.uid` (dono de /proc/<pid>)
+#define PROC_SCAN_FDS 0x2     // Preencher `process_info.fds` (entradas de /proc/<pid>/fd)
+
+// O kernel limita o comm a 16 bytes, mas workers do kernel anexam a descrição da workqueue
+#define PROC_NAME_MAX 64
+
+/*****************************************************************************/
+
+struct process_info {
+    pid_t pid;
+    pid_t ppid;
+    uid_t uid;                     // Somente com PROC_SCAN_OWNER
+    char state;
+    long num_threads;
+    long rss;                      // Em páginas
+    unsigned long long utime;      // Em clock ticks
+    unsigned long long stime;      // Em clock ticks
+    unsigned long long starttime;  // Em clock ticks desde o boot
+    long fds;                      // Somente com PROC_SCAN_FDS (-1 = sem permissão para listar)
+    char name[PROC_NAME_MAX];
+};
+
+/**
+ * @brief Recursos de um processo somados aos de todos os seus descendentes.
+ */
+struct process_totals {
+    unsigned long long cpu;      // utime + stime, em clock ticks
+    unsigned long long rss;      // Em páginas
+    unsigned long long threads;
+    unsigned long long fds;      // Só os processos cujos descritores puderam ser contados
+    size_t procs;                // Processos na subárvore (incluindo a raiz)
+};
+
+/**
+ * @brief Tabela reutilizável com o stat de todos os processos (sem índice).
+ *
+ * Os buffers são mantidos entre chamadas de `scan_processes`, então uma
+ * varredura periódica não aloca memória depois que a tabela se estabiliza.
+ * Com `keep_open`, os `stat` ficam abertos entre varreduras e são relidos com
+ * `pread`, evitando o `openat`/`close` por processo (útil para monitores).
+ * Com `refresh`, a função é consultada (na thread chamadora) para cada processo
+ * que já estava na varredura anterior; os recusados não são relidos e repetem
+ * a leitura anterior.
+ */
+struct process_table {
+    struct process_info *procs;
+    size_t count;
+    size_t capacity;
+
+    pid_t *pids;          // PIDs listados na última varredura (ordenados)
+    int *fds;             // Descritor do stat de cada PID de `pids`
+    size_t pid_capacity;
+    char *dents;          // Buffer do getdents64
+
+    unsigned flags;       // Campos opcionais (PROC_SCAN_*)
+    bool keep_open;       // Manter os stat abertos entre varreduras
+    pid_t *open_pids;     // PIDs com stat aberto (ordenados) e seus descritores
+    int *open_fds;
+    size_t open_count;
+    size_t open_capacity;
+    size_t max_open;      // Limite de descritores mantidos abertos
+    struct rlimit saved_nofile;
+
+    // Releitura seletiva: processos recusados por `refresh` repetem a leitura anterior
+    bool (*refresh)(const struct process_info *previous, void *ctx);
+    void *refresh_ctx;
+    struct process_info *previous;  // Leitura anterior (ordenada), só com `refresh`
+    size_t previous_capacity;
+    unsigned char *reused;          // 1 = entrada de `pids` copiada de `previous`
+    size_t reused_capacity;
+
+    unsigned threads;     // Threads usadas na última varredura
+};
+
+/**
+ * @brief Snapshot da tabela de processos, montado com uma única varredura do /proc.
+ *
+ * `procs` fica ordenado por PID. Os filhos de `procs[i]` são os índices
+ * `children[child_start[i]]` até `children[child_start[i + 1] - 1]` (layout CSR),
+ * já em ordem crescente de PID.
+ */
+struct process_snapshot {
+    struct process_info *procs;
+    size_t count;
+    size_t *child_start;
+    size_t *children;
+    unsigned flags;     // Campos opcionais lidos (PROC_SCAN_*)
+
+    // Estatísticas da última montagem
+    unsigned threads;   // Threads usadas na leitura dos stat
+    double scan_ms;     // Listagem do /proc + leitura dos stat
+    double index_ms;    // Ordenação + montagem do CSR
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Retorna o descritor do diretório /proc, aberto uma única vez por sessão.
+ * @return Descritor do /proc, ou -1 em caso de erro.
+ */
+int proc_root_fd(void);
+
+/**
+ * @brief Troca o diretório usado como /proc (ex.: uma árvore falsa nos benchmarks).
+ *
+ * Não deve ser chamada com uma varredura em andamento em outra thread.
+ * @param path Diretório com subdiretórios `<pid>/stat`.
+ * @return 0 em caso de sucesso, -1 se o diretório não puder ser aberto.
+ */
+int proc_set_root(const char *path);
+
+/**
+ * @brief Lê e interpreta `/proc/<pid>/stat` sem stdio e sem alocação.
+ *
+ * Faz um `openat` relativo a `proc_fd`, um único `read()` para `buf` e extrai
+ * os campos a partir do último `)`, já que o nome do processo pode conter
+ * espaços e parênteses.
+ * @param proc_fd Descritor do /proc (ver `proc_root_fd`).
+ * @param pid PID do processo.
+ * @param buf Buffer de trabalho do chamador (reutilizável entre chamadas).
+ * @param buf_size Tamanho do buffer (`PROC_STAT_BUF_SIZE` é suficiente).
+ * @param info Estrutura de saída.
+ * @return 0 em caso de sucesso, -1 se o processo não existir ou o stat for inválido.
+ */
+int proc_read_stat(int proc_fd, pid_t pid, char *buf, size_t buf_size, struct process_info *info);
+
+/**
+ * @brief Igual a `proc_read_stat`, mas relê um `stat` já aberto com `pread`.
+ * @param fd Descritor de `/proc/<pid>/stat`.
+ * @param pid PID do processo.
+ * @param buf Buffer de trabalho do chamador.
+ * @param buf_size Tamanho do buffer.
+ * @param info Estrutura de saída.
+ * @return 0 em caso de sucesso, -1 se o processo terminou ou o stat for inválido.
+ */
+int proc_read_stat_fd(int fd, pid_t pid, char *buf, size_t buf_size, struct process_info *info);
+
+/**
+ * @brief Obtém informações de um processo a partir do PID.
+ * @param pid O PID do processo a ser analisado.
+ * @return Estrutura `process_info` preenchida (com `pid == 0` se o processo não existir).
+ */
+struct process_info get_process_info(pid_t pid);
+
+/**
+ * @brief Lê o stat de todos os processos para `table`, reaproveitando seus buffers.
+ *
+ * Os PIDs são listados com `getdents64` e os `stat` são lidos em paralelo,
+ * cada thread preenchendo a sua faixa de uma tabela pré-alocada.
+ * @param table Tabela zerada na primeira chamada (liberar com `free_process_table`).
+ * @param threads Threads para a leitura (0 usa as CPUs online).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int scan_processes(struct process_table *table, unsigned threads);
+
+/**
+ * @brief Libera os buffers de uma tabela de processos.
+ * @param table Tabela a ser liberada.
+ */
+void free_process_table(struct process_table *table);
+
+/**
+ * @brief Lê o /proc uma única vez e monta o índice PID -> processo e pai -> filhos.
+ * @param snap Snapshot a ser preenchido (liberar com `free_process_snapshot`).
+ * @param threads Threads para a leitura (0 usa as CPUs online).
+ * @param flags Campos opcionais (PROC_SCAN_*).
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int build_process_snapshot(struct process_snapshot *snap, unsigned threads, unsigned flags);
+
+/**
+ * @brief Libera a memória de um snapshot de processos.
+ * @param snap Snapshot a ser liberado.
+ */
+void free_process_snapshot(struct process_snapshot *snap);
+
+/**
+ * @brief Soma os recursos de cada processo da subárvore de `root` com os dos seus descendentes.
+ *
+ * Uma única passada em pós-ordem sobre o CSR do snapshot, com pilha explícita
+ * (sem recursão, então a profundidade não é limitada): ao sair de um processo,
+ * o seu total é somado ao do pai. Nada do /proc é relido.
+ * @param snap Snapshot de processos.
+ * @param root Índice da raiz em `snap->procs`.
+ * @param totals Vetor com `snap->count` posições; só as da subárvore são preenchidas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+int process_subtree_totals(const struct process_snapshot *snap, size_t root, struct process_totals *totals);
+
+/**
+ * @brief Procura um processo no snapshot por busca binária.
+ * @param snap Snapshot de processos.
+ * @param pid PID procurado.
+ * @return Índice do processo em `snap->procs`, ou -1 se não existir.
+ */
+long find_process(const struct process_snapshot *snap, pid_t pid);
+
+#endif //PROC_TOOLS_H
@@ -0,0 +1,119 @@
+#include "screen.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "term_tools.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief Acrescenta bytes ao buffer de saída pendente.
+ * @param scr Tela.
+ * @param data Bytes a acrescentar.
+ * @param len Quantidade de bytes.
+ */
+static void append(struct screen *scr, const char *data, size_t len);
+
+/*****************************************************************************/
+
+int screen_init(struct screen *scr, const size_t rows) {
+    memset(scr, 0, sizeof(*scr));
+    return screen_resize(scr, rows);
+}
+
+int screen_resize(struct screen *scr, const size_t rows) {
+    if (rows > scr->rows) {
+        char **lines = realloc(scr->lines, rows * sizeof(char *));
+        if (!lines) return -1;
+        scr->lines = lines;
+
+        size_t *lengths = realloc(scr->lengths, rows * sizeof(size_t));
+        if (!lengths) return -1;
+        scr->lengths = lengths;
+
+        size_t *capacities = realloc(scr->capacities, rows * sizeof(size_t));
+        if (!capacities) return -1;
+        scr->capacities = capacities;
+
+        for (size_t i = scr->rows; i < rows; i++) {
+            scr->lines[i] = NULL;
+            scr->capacities[i] = 0;
+        }
+    } else {
+        for (size_t i = rows; i < scr->rows; i++) {
+            free(scr->lines[i]);
+        }
+    }
+    scr->rows = rows;
+
+    // Conteúdo desconhecido: o próximo quadro reescreve todas as linhas
+    for (size_t i = 0; i < rows; i++) {
+        scr->lengths[i] = SIZE_MAX;
+    }
+    append(scr, TERM_CLEAR_SCREEN, strlen(TERM_CLEAR_SCREEN));
+    return 0;
+}
+
+void screen_line(struct screen *scr, const size_t row, const char *text, const size_t len) {
+    if (row >= scr->rows) return;
+    if (scr->lengths[row] == len && memcmp(scr->lines[row], text, len) == 0) return;
+
+    if (scr->capacities[row] < len) {
+        char *grown = realloc(scr->lines[row], len);
+        if (!grown) return;
+        scr->lines[row] = grown;
+        scr->capacities[row] = len;
+    }
+    if (len) memcpy(scr->lines[row], text, len);
+    scr->lengths[row] = len;
+
+    char cursor[32];
+    const int cursor_len = snprintf(cursor, sizeof(cursor), TERM_CURSOR_POS, row + 1, (size_t) 1);
+    append(scr, cursor, cursor_len);
+    append(scr, text, len);
+    append(scr, TERM_RESET TERM_ERASE_LINE_END, strlen(TERM_RESET TERM_ERASE_LINE_END));
+    scr->redrawn++;
+}
+
+void screen_flush(struct screen *scr, const int fd) {
+    size_t written = 0;
+    while (written < scr->out_len) {
+        const ssize_t n = write(fd, scr->out + written, scr->out_len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    scr->out_len = 0;
+    scr->redrawn = 0;
+}
+
+void screen_free(struct screen *scr) {
+    for (size_t i = 0; i < scr->rows; i++) {
+        free(scr->lines[i]);
+    }
+    free(scr->lines);
+    free(scr->lengths);
+    free(scr->capacities);
+    free(scr->out);
+    memset(scr, 0, sizeof(*scr));
+}
+
+/*****************************************************************************/
+
+static void append(struct screen *scr, const char *data, const size_t len) {
+    if (scr->out_len + len > scr->out_cap) {
+        size_t capacity = scr->out_cap ? scr->out_cap : 4096;
+        while (capacity < scr->out_len + len) capacity *= 2;
+        char *grown = realloc(scr->out, capacity);
+        if (!grown) return;
+        scr->out = grown;
+        scr->out_cap = capacity;
+    }
+    memcpy(scr->out + scr->out_len, data, len);
+    scr->out_len += len;
+}
@@ -0,0 +1,68 @@
+//
+// Redesenho incremental de tela: só as linhas que mudaram são reescritas.
+//
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <stddef.h>
+
+/**
+ * @brief Quadro exibido no terminal e sequências pendentes de escrita.
+ *
+ * Cada chamada a `screen_line` compara o novo conteúdo com o da linha na
+ * tela; se for igual nada é emitido, senão o cursor é posicionado na linha
+ * e o texto é reescrito. `screen_flush` envia tudo em um único `write()`.
+ */
+struct screen {
+    char **lines;        // Conteúdo exibido em cada linha
+    size_t *lengths;     // Tamanho de cada linha (SIZE_MAX = desconhecido)
+    size_t *capacities;
+    size_t rows;
+
+    char *out;           // Sequências pendentes até o próximo flush
+    size_t out_len;
+    size_t out_cap;
+
+    size_t redrawn;      // Linhas reescritas desde o último flush
+};
+
+/**
+ * @brief Inicializa uma tela com `rows` linhas; o primeiro quadro é desenhado por inteiro.
+ * @param scr Tela a ser inicializada.
+ * @param rows Quantidade de linhas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+int screen_init(struct screen *scr, size_t rows);
+
+/**
+ * @brief Ajusta a quantidade de linhas, limpa o terminal e força o redesenho completo.
+ * @param scr Tela.
+ * @param rows Nova quantidade de linhas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+int screen_resize(struct screen *scr, size_t rows);
+
+/**
+ * @brief Define o conteúdo da linha `row` (a partir de 0) no próximo quadro.
+ * @param scr Tela.
+ * @param row Linha a ser atualizada (linhas fora da tela são ignoradas).
+ * @param text Conteúdo da linha (pode conter sequências de cor, sem '\n').
+ * @param len Tamanho de `text` em bytes.
+ */
+void screen_line(struct screen *scr, size_t row, const char *text, size_t len);
+
+/**
+ * @brief Escreve as alterações pendentes em `fd` com um único `write()`.
+ * @param scr Tela.
+ * @param fd Descritor de saída (normalmente STDOUT_FILENO).
+ */
+void screen_flush(struct screen *scr, int fd);
+
+/**
+ * @brief Libera a memória da tela.
+ * @param scr Tela.
+ */
+void screen_free(struct screen *scr);
+
+#endif //SCREEN_H
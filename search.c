@@ -0,0 +1,521 @@
+#include "search.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCH_HAS_X86 1
+#else
+#define SEARCH_HAS_X86 0
+#endif
+
+#include "parallel.h"
+#include "term_out.h"
+#include "term_tools.h"
+#include "walk.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief Estado de uma thread da busca (só ela escreve aqui; sem atomics).
+ */
+struct search_worker {
+    alignas(64) char *block;          // Buffer de leitura (SEARCH_READ_BLOCK bytes, alocado no primeiro uso)
+    struct term_out_capture out;      // Saída acumulada
+    char *path;                       // Caminho do arquivo atual (montado na primeira ocorrência)
+    size_t path_cap;
+    struct search_stats stats;
+};
+
+struct search_ctx {
+    const struct search_matcher *matcher;
+    const struct search_options *options;
+    struct search_worker *workers;
+    struct term_out_capture *dest;    // Destino da saída do comando (NULL = buffer compartilhado)
+    pthread_mutex_t lock;             // Entrega da saída das threads em `dest`
+};
+
+// Retorno da varredura de um arquivo mapeado que encolheu (SIGBUS) nesta thread (NULL = fora de uma)
+static _Thread_local sigjmp_buf *bus_guard = NULL;
+static pthread_once_t bus_handler_once = PTHREAD_ONCE_INIT;
+
+/*****************************************************************************/
+
+/**
+ * @brief Busca em um arquivo da varredura (chamada por `walk_run_files`).
+ */
+static void visit_file(const struct walk_dir *dir, int dir_fd, const char *name, unsigned worker, void *ctx);
+
+/**
+ * @brief Lê (ou mapeia) um arquivo e procura o padrão.
+ * @param dir Diretório do arquivo (NULL: `name` é o caminho dado pelo usuário).
+ */
+static void search_file(const struct search_ctx *ctx, struct search_worker *worker, int dir_fd, const char *name,
+                        const struct walk_dir *dir);
+
+/**
+ * @brief `scan_text` sobre um arquivo mapeado, protegida contra o SIGBUS de um arquivo que encolheu.
+ */
+static void scan_mapped(const struct search_ctx *ctx, struct search_worker *worker, const char *text, size_t len,
+                        const struct walk_dir *dir, const char *name);
+
+/**
+ * @brief Instala o tratador de SIGBUS (uma vez por processo).
+ */
+static void install_bus_handler(void);
+
+/**
+ * @brief SIGBUS: volta para `search_file` se a thread está varrendo um mapeamento, senão a ação padrão.
+ */
+static void bus_handler(int sig);
+
+/**
+ * @brief Procura o padrão no conteúdo de um arquivo e escreve as linhas com ocorrência.
+ */
+static void scan_text(const struct search_ctx *ctx, struct search_worker *worker, const char *text, size_t len,
+                      const struct walk_dir *dir, const char *name);
+
+/**
+ * @brief Escreve uma linha com ocorrência (`caminho:linha:texto`, com as ocorrências destacadas).
+ */
+static void print_match(const struct search_ctx *ctx, const char *line, const char *line_end, size_t line_no,
+                        const char *path, size_t path_len);
+
+/**
+ * @brief Monta o caminho de um arquivo em `worker->path` (diretório por `walk_path` + nome).
+ * @return Tamanho do caminho (0 se faltar memória).
+ */
+static size_t build_path(struct search_worker *worker, const struct walk_dir *dir, const char *name);
+
+/**
+ * @brief Entrega a saída acumulada de uma thread na saída do comando.
+ */
+static void flush_worker(struct search_ctx *ctx, struct search_worker *worker);
+
+/**
+ * @brief Lê até `size` bytes, repetindo em leituras parciais e EINTR.
+ * @return Bytes lidos (menos que `size` só no fim do arquivo), ou -1 em caso de erro.
+ */
+static ssize_t read_block(int fd, char *buf, size_t size);
+
+/**
+ * @brief Quantidade de '\n' em [start, end).
+ */
+static size_t count_lines(const char *start, const char *end);
+
+/**
+ * @brief Se a CPU suporta a implementação.
+ */
+static bool impl_supported(enum search_impl impl);
+
+/**
+ * @brief Casamento escalar: memchr no primeiro byte, depois o último e o meio.
+ */
+static const char *find_scalar(const struct search_matcher *matcher, const char *text, size_t len);
+
+#if SEARCH_HAS_X86
+/**
+ * @brief Filtro do primeiro e do último byte em 16 posições por vez.
+ */
+static const char *find_sse2(const struct search_matcher *matcher, const char *text, size_t len);
+
+/**
+ * @brief Filtro do primeiro e do último byte em 32 posições por vez.
+ */
+static const char *find_avx2(const struct search_matcher *matcher, const char *text, size_t len);
+#endif
+
+/*****************************************************************************/
+
+int search_matcher_init(struct search_matcher *matcher, const char *pattern, const size_t len,
+                        enum search_impl impl) {
+    if (len == 0) return -1;
+    if (impl == SEARCH_IMPL_AUTO) {
+        if (impl_supported(SEARCH_IMPL_AVX2)) impl = SEARCH_IMPL_AVX2;
+        else if (impl_supported(SEARCH_IMPL_SSE2)) impl = SEARCH_IMPL_SSE2;
+        else impl = SEARCH_IMPL_SCALAR;
+    }
+    if (!impl_supported(impl)) return -1;
+
+    matcher->pattern = pattern;
+    matcher->len = len;
+    matcher->impl = impl;
+    matcher->find = find_scalar;
+#if SEARCH_HAS_X86
+    if (impl == SEARCH_IMPL_SSE2) matcher->find = find_sse2;
+    else if (impl == SEARCH_IMPL_AVX2) matcher->find = find_avx2;
+#endif
+    return 0;
+}
+
+const char *search_impl_name(const enum search_impl impl) {
+    switch (impl) {
+        case SEARCH_IMPL_SCALAR: return "scalar";
+        case SEARCH_IMPL_SSE2: return "sse2";
+        case SEARCH_IMPL_AVX2: return "avx2";
+        default: return "auto";
+    }
+}
+
+int search_run(const char *path, const struct search_matcher *matcher, const struct search_options *options,
+               struct search_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+
+    const unsigned threads = S_ISDIR(st.st_mode)
+                                 ? (options->threads ? options->threads : parallel_default_threads())
+                                 : 1;
+    struct search_ctx ctx = {.matcher = matcher, .options = options};
+    ctx.workers = aligned_alloc(alignof(struct search_worker), threads * sizeof(struct search_worker));
+    if (!ctx.workers) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset(ctx.workers, 0, threads * sizeof(struct search_worker));
+    pthread_mutex_init(&ctx.lock, NULL);
+    pthread_once(&bus_handler_once, install_bus_handler);
+
+    // Destino atual da thread chamadora (captura do `par`, ou o buffer compartilhado)
+    ctx.dest = term_out_capture(NULL);
+    term_out_capture(ctx.dest);
+
+    int result = 0;
+    if (!S_ISDIR(st.st_mode)) {
+        search_file(&ctx, &ctx.workers[0], AT_FDCWD, path, NULL);
+        stats->threads = 1;
+    } else {
+        struct walk walk;
+        if (walk_run_files(&walk, path, options->all ? WALK_ALL : 0, threads, visit_file, &ctx) == 0) {
+            stats->threads = walk.threads;
+            stats->steals = walk.steals;
+            stats->errors = atomic_load(&walk.errors);
+            walk_free(&walk);
+        } else {
+            result = -1;
+        }
+    }
+
+    const int error = errno;
+    for (unsigned i = 0; i < threads; i++) {
+        struct search_worker *worker = &ctx.workers[i];
+        if (result == 0) flush_worker(&ctx, worker);
+        stats->files += worker->stats.files;
+        stats->binary += worker->stats.binary;
+        stats->bytes += worker->stats.bytes;
+        stats->lines += worker->stats.lines;
+        stats->matched_files += worker->stats.matched_files;
+        stats->errors += worker->stats.errors;
+        free(worker->block);
+        free(worker->path);
+        free(worker->out.data);
+    }
+    pthread_mutex_destroy(&ctx.lock);
+    free(ctx.workers);
+    errno = error;
+    return result;
+}
+
+/*****************************************************************************/
+
+static void visit_file(const struct walk_dir *dir, const int dir_fd, const char *name, const unsigned worker,
+                       void *ctx) {
+    struct search_ctx *search = ctx;
+    struct search_worker *state = &search->workers[worker];
+    search_file(search, state, dir_fd, name, dir);
+    if (state->out.len >= SEARCH_FLUSH_BYTES) flush_worker(search, state);
+}
+
+static void search_file(const struct search_ctx *ctx, struct search_worker *worker, const int dir_fd,
+                        const char *name, const struct walk_dir *dir) {
+    const int fd = openat(dir_fd, name, O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) {
+        worker->stats.errors++;
+        return;
+    }
+    if (!worker->block) worker->block = malloc(SEARCH_READ_BLOCK);
+    const ssize_t n = worker->block ? read_block(fd, worker->block, SEARCH_READ_BLOCK) : -1;
+    if (n < 0) {
+        worker->stats.errors++;
+        close(fd);
+        return;
+    }
+    worker->stats.files++;
+
+    // Binário: descartado antes de mapear o resto ou procurar o padrão
+    if (memchr(worker->block, '\0', (size_t) n < SEARCH_BINARY_PROBE ? (size_t) n : SEARCH_BINARY_PROBE)) {
+        worker->stats.binary++;
+        close(fd);
+        return;
+    }
+
+    const char *text = worker->block;
+    size_t len = (size_t) n;
+    void *map = MAP_FAILED;
+    struct stat st;
+    if (len == SEARCH_READ_BLOCK && fstat(fd, &st) == 0 && (size_t) st.st_size > len) {
+        // Maior que o bloco: o arquivo inteiro é mapeado (já com as páginas, MAP_POPULATE), sem cópias
+        map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (map == MAP_FAILED) {
+            worker->stats.errors++;
+            close(fd);
+            return;
+        }
+        text = map;
+        len = (size_t) st.st_size;
+    }
+    close(fd);
+
+    struct term_out_capture *previous = term_out_capture(&worker->out);
+    if (map != MAP_FAILED) {
+        scan_mapped(ctx, worker, map, len, dir, name);
+        munmap(map, len);
+    } else {
+        scan_text(ctx, worker, text, len, dir, name);
+    }
+    term_out_capture(previous);
+}
+
+static void scan_mapped(const struct search_ctx *ctx, struct search_worker *worker, const char *text,
+                        const size_t len, const struct walk_dir *dir, const char *name) {
+    // Arquivo truncado por outro processo durante a varredura: as páginas além do novo fim dão SIGBUS.
+    // O arquivo conta como erro e a saída dele é descartada, como se não tivesse sido lido.
+    const size_t out_len = worker->out.len;
+    const struct search_stats saved = worker->stats;
+    sigjmp_buf guard;
+    if (sigsetjmp(guard, 0) != 0) {
+        bus_guard = NULL;
+        worker->out.len = out_len;
+        worker->stats = saved;
+        worker->stats.errors++;
+        return;
+    }
+    bus_guard = &guard;
+    scan_text(ctx, worker, text, len, dir, name);
+    bus_guard = NULL;
+}
+
+static void install_bus_handler(void) {
+    // SA_NODEFER: o siglongjmp sai do tratador sem deixar o SIGBUS bloqueado (sigsetjmp sem salvar a máscara)
+    struct sigaction action = {.sa_handler = bus_handler, .sa_flags = SA_NODEFER};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGBUS, &action, NULL);
+}
+
+static void bus_handler(const int sig) {
+    if (bus_guard) siglongjmp(*bus_guard, 1);
+    // SIGBUS fora de uma varredura: a instrução se repete com a ação padrão e o processo termina
+    signal(sig, SIG_DFL);
+}
+
+static void scan_text(const struct search_ctx *ctx, struct search_worker *worker, const char *text,
+                      const size_t len, const struct walk_dir *dir, const char *name) {
+    const char *end = text + len;
+    const char *pos = text;      // Sempre no início de uma linha
+    const char *counted = text;  // Até onde as linhas já foram contadas
+    size_t line_no = 1;
+    size_t path_len = 0;
+    bool matched = false;
+
+    const char *hit;
+    while (pos < end && (hit = search_find(ctx->matcher, pos, (size_t) (end - pos)))) {
+        if (!matched) {
+            matched = true;
+            worker->stats.matched_files++;
+            path_len = build_path(worker, dir, name);
+            if (ctx->options->names_only) {
+                if (ctx->options->color) term_out_str(TERM_MAGENTA);
+                term_out_write(worker->path, path_len);
+                if (ctx->options->color) term_out_str(TERM_RESET);
+                term_out_char('\n');
+                break;
+            }
+        }
+
+        const char *line = memrchr(pos, '\n', (size_t) (hit - pos));
+        line = line ? line + 1 : pos;
+        const char *line_end = memchr(hit, '\n', (size_t) (end - hit));
+        if (!line_end) line_end = end;
+
+        // As linhas só são contadas entre uma ocorrência e a seguinte
+        line_no += count_lines(counted, line);
+        counted = line;
+        print_match(ctx, line, line_end, line_no, worker->path, path_len);
+        worker->stats.lines++;
+        pos = line_end + 1;
+    }
+    worker->stats.bytes += len;
+}
+
+static void print_match(const struct search_ctx *ctx, const char *line, const char *line_end, const size_t line_no,
+                        const char *path, const size_t path_len) {
+    if (!ctx->options->color) {
+        term_out_write(path, path_len);
+        term_out_char(':');
+        term_out_uint(line_no);
+        term_out_char(':');
+        term_out_write(line, (size_t) (line_end - line));
+        term_out_char('\n');
+        return;
+    }
+
+    // Mesmas cores do `grep --color`: caminho, número da linha e ocorrências
+    term_out_str(TERM_MAGENTA);
+    term_out_write(path, path_len);
+    term_out_str(TERM_CYAN ":" TERM_GREEN);
+    term_out_uint(line_no);
+    term_out_str(TERM_CYAN ":" TERM_RESET);
+    const char *pos = line;
+    const char *hit;
+    while (pos < line_end && (hit = search_find(ctx->matcher, pos, (size_t) (line_end - pos)))) {
+        term_out_write(pos, (size_t) (hit - pos));
+        term_out_str(TERM_RED_BOLD);
+        term_out_write(hit, ctx->matcher->len);
+        term_out_str(TERM_RESET);
+        pos = hit + ctx->matcher->len;
+    }
+    term_out_write(pos, (size_t) (line_end - pos));
+    term_out_char('\n');
+}
+
+static size_t build_path(struct search_worker *worker, const struct walk_dir *dir, const char *name) {
+    const size_t name_len = strlen(name);
+    const long dir_len = dir ? walk_path(dir, worker->path, worker->path_cap) : 0;
+    const size_t needed = (size_t) dir_len + 1 + name_len + 1;
+    if (needed > worker->path_cap || (size_t) dir_len >= worker->path_cap) {
+        char *path = realloc(worker->path, needed < 4096 ? 4096 : needed);
+        if (!path) return 0;
+        worker->path = path;
+        worker->path_cap = needed < 4096 ? 4096 : needed;
+        if (dir) walk_path(dir, worker->path, worker->path_cap);
+    }
+
+    size_t len = (size_t) dir_len;
+    if (dir && (len == 0 || worker->path[len - 1] != '/')) worker->path[len++] = '/';
+    memcpy(worker->path + len, name, name_len + 1);
+    return len + name_len;
+}
+
+static void flush_worker(struct search_ctx *ctx, struct search_worker *worker) {
+    if (worker->out.len == 0) return;
+    pthread_mutex_lock(&ctx->lock);
+    struct term_out_capture *previous = term_out_capture(ctx->dest);
+    term_out_write(worker->out.data, worker->out.len);
+    term_out_capture(previous);
+    pthread_mutex_unlock(&ctx->lock);
+    worker->out.len = 0;
+}
+
+static ssize_t read_block(const int fd, char *buf, const size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = read(fd, buf + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += (size_t) n;
+    }
+    return (ssize_t) done;
+}
+
+static size_t count_lines(const char *start, const char *end) {
+    size_t count = 0;
+    while (start < end && (start = memchr(start, '\n', (size_t) (end - start)))) {
+        count++;
+        start++;
+    }
+    return count;
+}
+
+static bool impl_supported(const enum search_impl impl) {
+    switch (impl) {
+        case SEARCH_IMPL_SCALAR:
+            return true;
+#if SEARCH_HAS_X86
+        case SEARCH_IMPL_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case SEARCH_IMPL_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static const char *find_scalar(const struct search_matcher *matcher, const char *text, const size_t len) {
+    const size_t k = matcher->len;
+    if (len < k) return NULL;
+    const char first = matcher->pattern[0];
+    const char last = matcher->pattern[k - 1];
+    const char *pos = text;
+    const char *stop = text + len - k + 1;  // Depois da última posição inicial possível
+
+    while (pos < stop && (pos = memchr(pos, first, (size_t) (stop - pos)))) {
+        if (pos[k - 1] == last && (k <= 2 || memcmp(pos + 1, matcher->pattern + 1, k - 2) == 0)) return pos;
+        pos++;
+    }
+    return NULL;
+}
+
+#if SEARCH_HAS_X86
+__attribute__((target("sse2")))
+static const char *find_sse2(const struct search_matcher *matcher, const char *text, const size_t len) {
+    const size_t k = matcher->len;
+    if (k == 1) return memchr(text, matcher->pattern[0], len);
+
+    const __m128i first = _mm_set1_epi8(matcher->pattern[0]);
+    const __m128i last = _mm_set1_epi8(matcher->pattern[k - 1]);
+    size_t i = 0;
+    // Posições iniciais i..i+15: um bloco no começo do padrão e outro deslocado até o último byte
+    for (; i + k + 15 <= len; i += 16) {
+        const __m128i block_first = _mm_loadu_si128((const __m128i *) (text + i));
+        const __m128i block_last = _mm_loadu_si128((const __m128i *) (text + i + k - 1));
+        unsigned mask = (unsigned) _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+        while (mask) {
+            const unsigned bit = (unsigned) __builtin_ctz(mask);
+            if (k <= 2 || memcmp(text + i + bit + 1, matcher->pattern + 1, k - 2) == 0) return text + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return i < len ? find_scalar(matcher, text + i, len - i) : NULL;
+}
+
+__attribute__((target("avx2")))
+static const char *find_avx2(const struct search_matcher *matcher, const char *text, const size_t len) {
+    const size_t k = matcher->len;
+    if (k == 1) return memchr(text, matcher->pattern[0], len);
+
+    const __m256i first = _mm256_set1_epi8(matcher->pattern[0]);
+    const __m256i last = _mm256_set1_epi8(matcher->pattern[k - 1]);
+    size_t i = 0;
+    for (; i + k + 31 <= len; i += 32) {
+        const __m256i block_first = _mm256_loadu_si256((const __m256i *) (text + i));
+        const __m256i block_last = _mm256_loadu_si256((const __m256i *) (text + i + k - 1));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last)));
+        while (mask) {
+            const unsigned bit = (unsigned) __builtin_ctz(mask);
+            if (k <= 2 || memcmp(text + i + bit + 1, matcher->pattern + 1, k - 2) == 0) return text + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    // O resto (menos de 32 posições) passa pelo SSE2 e, no fim, pelo escalar
+    return i < len ? find_sse2(matcher, text + i, len - i) : NULL;
+}
+#endif
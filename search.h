@@ -0,0 +1,108 @@
+//
+// Busca de texto em arquivos (`search`): casamento com SIMD e varredura em paralelo.
+//
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Arquivos até este tamanho são lidos com um único read(); os maiores são mapeados (mmap)
+#define SEARCH_READ_BLOCK (128 * 1024)
+
+// Bytes iniciais verificados à procura de '\0' (arquivo binário, ignorado)
+#define SEARCH_BINARY_PROBE 8192
+
+// Saída acumulada por thread antes de ir para a saída do comando
+#define SEARCH_FLUSH_BYTES (64 * 1024)
+
+/**
+ * @brief Implementação do casamento.
+ */
+enum search_impl {
+    SEARCH_IMPL_AUTO,    // A melhor suportada pela CPU (escolhida em tempo de execução)
+    SEARCH_IMPL_SCALAR,  // memchr no primeiro byte + comparação
+    SEARCH_IMPL_SSE2,    // 16 posições por vez
+    SEARCH_IMPL_AVX2,    // 32 posições por vez
+};
+
+/**
+ * @brief Padrão (texto fixo) preparado para a busca.
+ */
+struct search_matcher {
+    const char *pattern;
+    size_t len;
+    enum search_impl impl;  // Implementação escolhida (nunca SEARCH_IMPL_AUTO)
+    const char *(*find)(const struct search_matcher *matcher, const char *text, size_t len);
+};
+
+struct search_options {
+    unsigned threads;  // 0 usa as CPUs online
+    bool all;          // Incluir arquivos e diretórios iniciados por '.'
+    bool names_only;   // Só o caminho de cada arquivo com ocorrência (`-l`)
+    bool color;        // Cores TERM_* (saída em um terminal)
+};
+
+struct search_stats {
+    size_t files;          // Arquivos lidos
+    size_t binary;         // Arquivos ignorados por serem binários
+    size_t bytes;          // Bytes examinados
+    size_t lines;          // Linhas com ocorrência
+    size_t matched_files;  // Arquivos com ocorrência
+    size_t errors;         // Arquivos e diretórios que não puderam ser lidos
+    unsigned threads;      // Threads usadas
+    size_t steals;         // Diretórios roubados da fila de outra thread
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Prepara um padrão para a busca.
+ *
+ * O filtro vetorizado compara o primeiro e o último byte do padrão em 16 (SSE2)
+ * ou 32 (AVX2) posições de uma vez; só as posições em que os dois batem são
+ * comparadas por inteiro. A CPU é consultada uma vez (`__builtin_cpu_supports`);
+ * fora do x86 só há a versão escalar.
+ * @param matcher Padrão a preencher (guarda `pattern`, que deve continuar válido).
+ * @param pattern Texto procurado.
+ * @param len Tamanho do texto.
+ * @param impl Implementação (SEARCH_IMPL_AUTO escolhe a melhor).
+ * @return 0 em caso de sucesso, -1 se o padrão é vazio ou a CPU não suporta `impl`.
+ */
+int search_matcher_init(struct search_matcher *matcher, const char *pattern, size_t len, enum search_impl impl);
+
+/**
+ * @brief Primeira ocorrência do padrão em `text`.
+ * @param matcher Padrão preparado.
+ * @param text Texto (não precisa terminar em '\0').
+ * @param len Tamanho do texto.
+ * @return Início da ocorrência, ou NULL se não houver.
+ */
+static inline const char *search_find(const struct search_matcher *matcher, const char *text, const size_t len) {
+    return matcher->find(matcher, text, len);
+}
+
+/**
+ * @brief Nome de uma implementação ("scalar", "sse2", "avx2").
+ */
+const char *search_impl_name(enum search_impl impl);
+
+/**
+ * @brief Procura o padrão em `path` (arquivo, ou diretório percorrido com `walk_run_files`).
+ *
+ * Cada linha com ocorrência é escrita como `caminho:linha:texto`. Arquivos
+ * pequenos são lidos com um read() em um buffer da thread; os maiores, com
+ * mmap. Um '\0' nos primeiros SEARCH_BINARY_PROBE bytes marca o arquivo como
+ * binário e ele é ignorado. Cada thread acumula a sua saída e a entrega
+ * inteira por arquivo, então linhas de arquivos diferentes não se misturam.
+ * @param path Arquivo ou diretório.
+ * @param matcher Padrão preparado.
+ * @param options Opções.
+ * @param stats Contadores da busca.
+ * @return 0 em caso de sucesso, -1 se `path` não puder ser aberto (errno preservado).
+ */
+int search_run(const char *path, const struct search_matcher *matcher, const struct search_options *options,
+               struct search_stats *stats);
+
+#endif //SEARCH_H
@@ -0,0 +1,641 @@
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+
+// Histograma log-linear (estilo HDR): 64 faixas por potência de 2, erro relativo abaixo de 1,6%
+#define STATS_SUB_BITS 6
+#define STATS_SUB (1u << STATS_SUB_BITS)
+// Tempos a partir de 2^44 ns (~4,9 horas) caem na última faixa
+#define STATS_MAX_EXP 44
+#define STATS_BUCKETS ((STATS_MAX_EXP - STATS_SUB_BITS + 1) * STATS_SUB)
+
+#define STATS_INITIAL_CAPACITY 64
+// Acima disso, nomes novos vão para uma entrada só (cada entrada tem ~10 KB de histograma)
+#define STATS_MAX_NAMES 1024
+#define STATS_OTHERS_NAME "(outros)"
+
+#define STATS_STREAM_BUF_SIZE (64 * 1024)
+_Static_assert(STATS_STREAM_NAME_MAX * 6 + 320 <= STATS_STREAM_BUF_SIZE, "registro maior que o buffer do fluxo");
+
+/*****************************************************************************/
+
+struct stats_entry {
+    uint64_t hash;
+    char *name;
+    uint64_t count;
+    uint64_t failures;
+    uint64_t wall_total;
+    uint64_t wall_max;
+    uint64_t user_total;
+    uint64_t sys_total;
+    uint64_t voluntary;
+    uint64_t involuntary;
+    long max_rss_kb;
+    uint32_t wall[STATS_BUCKETS];
+};
+
+enum stats_format { STATS_NDJSON, STATS_BINARY };
+
+/*****************************************************************************/
+
+static struct stats_entry **table = NULL;
+static size_t capacity = 0;
+static size_t count = 0;
+static int64_t realtime_offset = 0;
+static bool realtime_known = false;
+
+static int stream_fd = -1;
+static enum stats_format stream_format = STATS_NDJSON;
+static char *stream_path = NULL;
+static char stream_buffer[STATS_STREAM_BUF_SIZE];
+static size_t stream_length = 0;
+static uint64_t stream_records = 0;
+
+/*****************************************************************************/
+
+/**
+ * @brief Faixa do histograma de um valor.
+ */
+static size_t bucket_of(uint64_t value);
+
+/**
+ * @brief Valor representativo de uma faixa (o meio dela).
+ */
+static uint64_t bucket_value(size_t bucket);
+
+/**
+ * @brief Valor abaixo do qual está a fração `quantile` das medidas.
+ * @param entry Entrada com pelo menos uma medida.
+ * @param quantile Fração entre 0 e 1.
+ */
+static uint64_t percentile(const struct stats_entry *entry, double quantile);
+
+/**
+ * @brief Procura (ou cria) a entrada de um comando.
+ * @return A entrada, ou NULL sem memória.
+ */
+static struct stats_entry *find_entry(const char *name);
+
+/**
+ * @brief Dobra a tabela e reinsere as entradas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int grow(void);
+
+/**
+ * @brief Acrescenta uma medida ao buffer do fluxo (enviado ao encher).
+ */
+static void stream_record(const char *name, const struct stats_sample *sample);
+
+/**
+ * @brief Garante `len` bytes livres no buffer do fluxo.
+ */
+static void stream_reserve(size_t len);
+
+/**
+ * @brief Envia o buffer do fluxo ao arquivo.
+ */
+static void stream_flush(void);
+
+/**
+ * @brief Copia `len` bytes para `out`.
+ * @return Posição após o último byte.
+ */
+static char *put_bytes(char *out, const char *data, size_t len);
+
+/**
+ * @brief Escreve `value` em decimal em `out`.
+ * @return Posição após o último dígito.
+ */
+static char *put_uint(char *out, uint64_t value);
+
+/**
+ * @brief Formata uma duração (`850 ns`, `12.3 µs`, `1.23 ms`, `1.234 s`).
+ */
+static void format_duration(uint64_t ns, char *buf, size_t size);
+
+/**
+ * @brief Formata um tamanho em KB (`812K`, `3.1M`, `1.2G`).
+ */
+static void format_kb(long kb, char *buf, size_t size);
+
+/**
+ * @brief Exibe um espaço e `str` alinhada à direita em `width` colunas (contando caracteres UTF-8, não bytes).
+ */
+static void print_cell(const char *str, int width);
+
+/**
+ * @brief Tabela com uma linha por comando, do maior tempo total para o menor.
+ */
+static void print_table(void);
+
+/**
+ * @brief Percentis e distribuição de um comando.
+ * @return 0 se o comando tem medidas, 1 se não.
+ */
+static int print_command(const char *name);
+
+/**
+ * @brief Abre (ou troca) o arquivo do fluxo.
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+static int stream_open(const char *path, enum stats_format format);
+
+/**
+ * @brief Libera todas as entradas.
+ */
+static void clear(void);
+
+/**
+ * @brief Ordena entradas pelo tempo total, decrescente.
+ */
+static int compare_total(const void *a, const void *b);
+
+/**
+ * @brief Tempo de um timeval em nanossegundos.
+ */
+static uint64_t timeval_ns(struct timeval tv);
+
+/*****************************************************************************/
+
+void stats_end(const struct timespec *start, const struct rusage *usage, const int status,
+               struct stats_sample *sample) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!realtime_known) {
+        // Diferença entre os relógios lida uma vez: o fluxo não paga um CLOCK_REALTIME por comando
+        struct timespec real;
+        clock_gettime(CLOCK_REALTIME, &real);
+        realtime_offset = ((int64_t) real.tv_sec - now.tv_sec) * 1000000000 + (real.tv_nsec - now.tv_nsec);
+        realtime_known = true;
+    }
+
+    const int64_t start_ns = (int64_t) start->tv_sec * 1000000000 + start->tv_nsec;
+    const int64_t end_ns = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+    sample->start_ns = (uint64_t) (start_ns + realtime_offset);
+    sample->wall_ns = (uint64_t) (end_ns - start_ns);
+    sample->user_ns = timeval_ns(usage->ru_utime);
+    sample->sys_ns = timeval_ns(usage->ru_stime);
+    sample->max_rss_kb = usage->ru_maxrss;
+    sample->voluntary = usage->ru_nvcsw;
+    sample->involuntary = usage->ru_nivcsw;
+    sample->status = status;
+}
+
+void stats_add(const char *name, const struct stats_sample *sample) {
+    struct stats_entry *entry = find_entry(name);
+    if (entry) {
+        entry->count++;
+        if (sample->status != 0) entry->failures++;
+        entry->wall_total += sample->wall_ns;
+        if (sample->wall_ns > entry->wall_max) entry->wall_max = sample->wall_ns;
+        entry->user_total += sample->user_ns;
+        entry->sys_total += sample->sys_ns;
+        entry->voluntary += (uint64_t) sample->voluntary;
+        entry->involuntary += (uint64_t) sample->involuntary;
+        if (sample->max_rss_kb > entry->max_rss_kb) entry->max_rss_kb = sample->max_rss_kb;
+        entry->wall[bucket_of(sample->wall_ns)]++;
+    }
+    if (stream_fd >= 0) stream_record(name, sample);
+}
+
+void stats_print_sample(const struct stats_sample *sample) {
+    char wall[16], user[16], sys[16], rss[16];
+    format_duration(sample->wall_ns, wall, sizeof(wall));
+    format_duration(sample->user_ns, user, sizeof(user));
+    format_duration(sample->sys_ns, sys, sizeof(sys));
+    format_kb(sample->max_rss_kb, rss, sizeof(rss));
+
+    // Depois da saída do próprio comando
+    term_out_flush();
+    fprintf(stderr, "%sreal %s  usuário %s  sistema %s  RSS máx %s  trocas %ld/%ld%s\n", TERM_CYAN, wall, user,
+            sys, rss, sample->voluntary, sample->involuntary, TERM_RESET);
+}
+
+void stats_usage_add(struct rusage *total, const struct rusage *add) {
+    timeradd(&total->ru_utime, &add->ru_utime, &total->ru_utime);
+    timeradd(&total->ru_stime, &add->ru_stime, &total->ru_stime);
+    if (add->ru_maxrss > total->ru_maxrss) total->ru_maxrss = add->ru_maxrss;
+    total->ru_nvcsw += add->ru_nvcsw;
+    total->ru_nivcsw += add->ru_nivcsw;
+}
+
+void stats_usage_delta(struct rusage *total, const struct rusage *before, const struct rusage *after) {
+    struct timeval diff;
+    timersub(&after->ru_utime, &before->ru_utime, &diff);
+    timeradd(&total->ru_utime, &diff, &total->ru_utime);
+    timersub(&after->ru_stime, &before->ru_stime, &diff);
+    timeradd(&total->ru_stime, &diff, &total->ru_stime);
+    // O RSS máximo da thread é o do shell inteiro: não há diferença a tirar
+    if (after->ru_maxrss > total->ru_maxrss) total->ru_maxrss = after->ru_maxrss;
+    total->ru_nvcsw += after->ru_nvcsw - before->ru_nvcsw;
+    total->ru_nivcsw += after->ru_nivcsw - before->ru_nivcsw;
+}
+
+void stats_stream_close(void) {
+    if (stream_fd < 0) return;
+    stream_flush();
+    close(stream_fd);
+    stream_fd = -1;
+    free(stream_path);
+    stream_path = NULL;
+}
+
+int builtin_stats(const int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        term_out_str(TERM_CYAN_BOLD "Uso: stats [-c] [-o ARQUIVO [-b]] [-x] [COMANDO]" TERM_RESET "\n"
+                     "Tempo, CPU, memória e trocas de contexto de cada comando da sessão\n"
+                     "(prefixe um comando com " TERM_YELLOW_ITALIC "time" TERM_RESET " para ver só ele)\n\n"
+                     TERM_YELLOW_BOLD "Opções:" TERM_RESET "\n"
+                     "  COMANDO\tPercentis e distribuição do tempo de COMANDO\n"
+                     "  -c\t\tApagar as medidas\n"
+                     "  -o ARQUIVO\tGravar cada medida em ARQUIVO (NDJSON, uma por linha)\n"
+                     "  -b\t\tCom -o, registros binários (struct stats_wire) em vez de NDJSON\n"
+                     "  -x\t\tParar de gravar\n"
+                     "  --help\t\tExibir esta ajuda\n");
+        return 0;
+    }
+
+    const char *path = NULL;
+    const char *name = NULL;
+    enum stats_format format = STATS_NDJSON;
+    bool clear_all = false;
+    bool stop = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) clear_all = true;
+        else if (strcmp(argv[i], "-b") == 0) format = STATS_BINARY;
+        else if (strcmp(argv[i], "-x") == 0) stop = true;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) path = argv[++i];
+        else if (argv[i][0] == '-') {
+            term_out_str(TERM_RED_BOLD "Opção inválida (veja stats --help)" TERM_RESET "\n");
+            return 1;
+        } else name = argv[i];
+    }
+
+    if (stop) stats_stream_close();
+    if (path) return stream_open(path, format);
+    if (clear_all) {
+        clear();
+        return 0;
+    }
+    if (stop) return 0;
+    if (name) return print_command(name);
+    print_table();
+    return 0;
+}
+
+/*****************************************************************************/
+
+static size_t bucket_of(uint64_t value) {
+    if (value >= 1ull << STATS_MAX_EXP) value = (1ull << STATS_MAX_EXP) - 1;
+    if (value < STATS_SUB) return (size_t) value;
+    const unsigned exponent = 63u - (unsigned) __builtin_clzll(value);
+    return (size_t) (exponent - STATS_SUB_BITS + 1) * STATS_SUB + (size_t) (value >> (exponent - STATS_SUB_BITS)) -
+           STATS_SUB;
+}
+
+static uint64_t bucket_value(const size_t bucket) {
+    if (bucket < STATS_SUB) return bucket;
+    const unsigned shift = (unsigned) (bucket / STATS_SUB) - 1;
+    const uint64_t lower = (uint64_t) (bucket % STATS_SUB + STATS_SUB) << shift;
+    return lower + ((1ull << shift) >> 1);
+}
+
+static uint64_t percentile(const struct stats_entry *entry, const double quantile) {
+    uint64_t target = (uint64_t) (quantile * (double) entry->count + 0.5);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        seen += entry->wall[i];
+        if (seen >= target) {
+            // O meio da faixa pode passar do máximo real
+            const uint64_t value = bucket_value(i);
+            return value < entry->wall_max ? value : entry->wall_max;
+        }
+    }
+    return entry->wall_max;
+}
+
+static struct stats_entry *find_entry(const char *name) {
+    if (!table && grow() != 0) return NULL;
+
+    // FNV-1a: nomes de comando são curtos
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char *p = name; *p; p++) hash = (hash ^ (unsigned char) *p) * 0x100000001b3ull;
+
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (table[i]) {
+        if (table[i]->hash == hash && strcmp(table[i]->name, name) == 0) return table[i];
+        i = (i + 1) & mask;
+    }
+
+    if (count >= STATS_MAX_NAMES && strcmp(name, STATS_OTHERS_NAME) != 0) return find_entry(STATS_OTHERS_NAME);
+    if ((count + 1) * 2 > capacity) {
+        if (grow() != 0) return NULL;
+        mask = capacity - 1;
+        i = hash & mask;
+        while (table[i]) i = (i + 1) & mask;
+    }
+
+    struct stats_entry *entry = calloc(1, sizeof(struct stats_entry));
+    if (!entry) return NULL;
+    entry->name = strdup(name);
+    if (!entry->name) {
+        free(entry);
+        return NULL;
+    }
+    entry->hash = hash;
+    table[i] = entry;
+    count++;
+    return entry;
+}
+
+static int grow(void) {
+    const size_t new_capacity = capacity ? capacity * 2 : STATS_INITIAL_CAPACITY;
+    struct stats_entry **new_table = calloc(new_capacity, sizeof(struct stats_entry *));
+    if (!new_table) return -1;
+
+    for (size_t i = 0; i < capacity; i++) {
+        if (!table[i]) continue;
+        size_t j = table[i]->hash & (new_capacity - 1);
+        while (new_table[j]) j = (j + 1) & (new_capacity - 1);
+        new_table[j] = table[i];
+    }
+    free(table);
+    table = new_table;
+    capacity = new_capacity;
+    return 0;
+}
+
+static void stream_record(const char *name, const struct stats_sample *sample) {
+    size_t name_len = strnlen(name, STATS_STREAM_NAME_MAX + 1);
+    if (name_len > STATS_STREAM_NAME_MAX) {
+        // Corte no início de um caractere UTF-8: o NDJSON continua válido
+        name_len = STATS_STREAM_NAME_MAX;
+        while (name_len > 0 && ((unsigned char) name[name_len] & 0xc0) == 0x80) name_len--;
+    }
+    stream_records++;
+
+    if (stream_format == STATS_BINARY) {
+        const struct stats_wire wire = {
+            .start_ns = sample->start_ns,
+            .wall_ns = sample->wall_ns,
+            .user_ns = sample->user_ns,
+            .sys_ns = sample->sys_ns,
+            .max_rss_kb = (uint64_t) sample->max_rss_kb,
+            .voluntary = (uint32_t) sample->voluntary,
+            .involuntary = (uint32_t) sample->involuntary,
+            .status = sample->status,
+            .name_len = (uint16_t) name_len,
+        };
+        stream_reserve(sizeof(wire) + name_len);
+        memcpy(stream_buffer + stream_length, &wire, sizeof(wire));
+        memcpy(stream_buffer + stream_length + sizeof(wire), name, name_len);
+        stream_length += sizeof(wire) + name_len;
+        return;
+    }
+
+    // NDJSON montado à mão: snprintf com nove campos custaria mais que o resto da contabilidade.
+    // Pior caso: nome todo escapado (\u00XX) mais 9 números de até 20 dígitos e as chaves.
+    stream_reserve(name_len * 6 + 320);
+    char *out = stream_buffer + stream_length;
+    out = memcpy(out, "{\"cmd\":\"", 8) + 8;
+    for (size_t i = 0; i < name_len; i++) {
+        const unsigned char c = (unsigned char) name[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char) c;
+        } else if (c < 0x20) {
+            out += sprintf(out, "\\u%04x", c);
+        } else {
+            *out++ = (char) c;
+        }
+    }
+    out = memcpy(out, "\",\"start_ns\":", 13) + 13;
+    out = put_uint(out, sample->start_ns);
+    out = memcpy(out, ",\"wall_ns\":", 11) + 11;
+    out = put_uint(out, sample->wall_ns);
+    out = memcpy(out, ",\"user_ns\":", 11) + 11;
+    out = put_uint(out, sample->user_ns);
+    out = memcpy(out, ",\"sys_ns\":", 10) + 10;
+    out = put_uint(out, sample->sys_ns);
+    out = memcpy(out, ",\"max_rss_kb\":", 14) + 14;
+    out = put_uint(out, (uint64_t) sample->max_rss_kb);
+    out = memcpy(out, ",\"nvcsw\":", 9) + 9;
+    out = put_uint(out, (uint64_t) sample->voluntary);
+    out = memcpy(out, ",\"nivcsw\":", 10) + 10;
+    out = put_uint(out, (uint64_t) sample->involuntary);
+    out = memcpy(out, ",\"status\":", 10) + 10;
+    out = put_uint(out, (uint64_t) (sample->status < 0 ? 0 : sample->status));
+    out = put_bytes(out, "}\n", 2);
+    stream_length = (size_t) (out - stream_buffer);
+}
+
+static void stream_reserve(const size_t len) {
+    if (STATS_STREAM_BUF_SIZE - stream_length < len) stream_flush();
+}
+
+static void stream_flush(void) {
+    const char *data = stream_buffer;
+    size_t len = stream_length;
+    while (len > 0) {
+        const ssize_t written = write(stream_fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        data += written;
+        len -= (size_t) written;
+    }
+    stream_length = 0;
+}
+
+static char *put_bytes(char *out, const char *data, const size_t len) {
+    memcpy(out, data, len);
+    return out + len;
+}
+
+static char *put_uint(char *out, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n > 0) *out++ = digits[--n];
+    return out;
+}
+
+static void format_duration(const uint64_t ns, char *buf, const size_t size) {
+    if (ns < 1000) snprintf(buf, size, "%lu ns", (unsigned long) ns);
+    else if (ns < 1000000) snprintf(buf, size, "%.1f µs", (double) ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, size, "%.2f ms", (double) ns / 1e6);
+    else snprintf(buf, size, "%.3f s", (double) ns / 1e9);
+}
+
+static void format_kb(const long kb, char *buf, const size_t size) {
+    if (kb < 1024) snprintf(buf, size, "%ldK", kb);
+    else if (kb < 1024 * 1024) snprintf(buf, size, "%.1fM", (double) kb / 1024);
+    else snprintf(buf, size, "%.1fG", (double) kb / (1024 * 1024));
+}
+
+static void print_cell(const char *str, const int width) {
+    int columns = 0;
+    for (const char *p = str; *p; p++) {
+        if (((unsigned char) *p & 0xC0) != 0x80) columns++;
+    }
+    term_out_char(' ');
+    if (columns < width) term_out_repeat(" ", (size_t) (width - columns));
+    term_out_str(str);
+}
+
+static void print_table(void) {
+    struct stats_entry **sorted = malloc((count ? count : 1) * sizeof(struct stats_entry *));
+    if (!sorted) return;
+    size_t n = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i]) sorted[n++] = table[i];
+    }
+    qsort(sorted, n, sizeof(struct stats_entry *), compare_total);
+
+    static const char *const headers[] = {"n", "erros", "p50", "p99", "máx", "usuário", "sistema", "RSS máx",
+                                          "trocas v/i"};
+    static const int widths[] = {8, 6, 10, 10, 10, 10, 10, 8, 14};
+    term_out_str(TERM_CYAN_BOLD);
+    term_out_field("comando", 16, -16);
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) print_cell(headers[i], widths[i]);
+    term_out_str(TERM_RESET "\n");
+
+    for (size_t i = 0; i < n; i++) {
+        const struct stats_entry *entry = sorted[i];
+        char cells[9][32];
+        snprintf(cells[0], sizeof(cells[0]), "%lu", (unsigned long) entry->count);
+        snprintf(cells[1], sizeof(cells[1]), "%lu", (unsigned long) entry->failures);
+        format_duration(percentile(entry, 0.50), cells[2], sizeof(cells[2]));
+        format_duration(percentile(entry, 0.99), cells[3], sizeof(cells[3]));
+        format_duration(entry->wall_max, cells[4], sizeof(cells[4]));
+        // CPU por execução (média)
+        format_duration(entry->user_total / entry->count, cells[5], sizeof(cells[5]));
+        format_duration(entry->sys_total / entry->count, cells[6], sizeof(cells[6]));
+        format_kb(entry->max_rss_kb, cells[7], sizeof(cells[7]));
+        snprintf(cells[8], sizeof(cells[8]), "%lu/%lu", (unsigned long) entry->voluntary,
+                 (unsigned long) entry->involuntary);
+
+        term_out_field(entry->name, 16, -16);
+        for (size_t j = 0; j < sizeof(widths) / sizeof(widths[0]); j++) {
+            if (j == 1 && entry->failures) term_out_str(TERM_RED);
+            print_cell(cells[j], widths[j]);
+            if (j == 1 && entry->failures) term_out_str(TERM_RESET);
+        }
+        term_out_char('\n');
+    }
+    if (n == 0) term_out_str("Nenhum comando medido ainda\n");
+    if (stream_fd >= 0) {
+        term_out_printf(TERM_WHITE "Gravando em %s (%s, %lu registros)" TERM_RESET "\n", stream_path,
+                        stream_format == STATS_BINARY ? "binário" : "NDJSON", (unsigned long) stream_records);
+    }
+    free(sorted);
+}
+
+static int print_command(const char *name) {
+    struct stats_entry *entry = NULL;
+    for (size_t i = 0; i < capacity && !entry; i++) {
+        if (table[i] && strcmp(table[i]->name, name) == 0) entry = table[i];
+    }
+    if (!entry) {
+        term_out_printf("%s%s: nenhuma medida%s\n", TERM_RED_BOLD, name, TERM_RESET);
+        return 1;
+    }
+
+    term_out_printf(TERM_CYAN_BOLD "%s" TERM_RESET ": %lu execuções, %lu com erro\n", entry->name,
+                    (unsigned long) entry->count, (unsigned long) entry->failures);
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    static const char *const labels[] = {"p50", "p90", "p99", "p99.9"};
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        char value[16];
+        format_duration(percentile(entry, quantiles[i]), value, sizeof(value));
+        term_out_printf("  %-6s", labels[i]);
+        print_cell(value, 12);
+        term_out_char('\n');
+    }
+    char value[16];
+    format_duration(entry->wall_max, value, sizeof(value));
+    term_out_str("  máx   ");
+    print_cell(value, 12);
+    term_out_str("\n\n");
+
+    // Distribuição por potência de 2, com barra proporcional à maior
+    uint64_t groups[STATS_MAX_EXP + 1] = {0};
+    uint64_t largest = 0;
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        if (!entry->wall[i]) continue;
+        const uint64_t value_ns = bucket_value(i);
+        const unsigned group = value_ns ? 63u - (unsigned) __builtin_clzll(value_ns) : 0;
+        groups[group] += entry->wall[i];
+        if (groups[group] > largest) largest = groups[group];
+    }
+    for (unsigned group = 0; group <= STATS_MAX_EXP; group++) {
+        if (!groups[group]) continue;
+        char lower[16];
+        format_duration(1ull << group, lower, sizeof(lower));
+        const size_t bar = (size_t) (groups[group] * 40 / largest);
+        term_out_str("  ≥");
+        print_cell(lower, 10);
+        term_out_printf(" %8lu ", (unsigned long) groups[group]);
+        term_out_str(TERM_GREEN);
+        term_out_repeat("█", bar ? bar : 1);
+        term_out_str(TERM_RESET "\n");
+    }
+    return 0;
+}
+
+static int stream_open(const char *path, const enum stats_format format) {
+    const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        term_out_printf("%sErro ao abrir %s: %s%s\n", TERM_RED_BOLD, path, strerror(errno), TERM_RESET);
+        return 1;
+    }
+    char *copy = strdup(path);
+    if (!copy) {
+        close(fd);
+        return 1;
+    }
+    stats_stream_close();
+    stream_fd = fd;
+    stream_path = copy;
+    stream_format = format;
+    stream_records = 0;
+    return 0;
+}
+
+static void clear(void) {
+    for (size_t i = 0; i < capacity; i++) {
+        if (!table[i]) continue;
+        free(table[i]->name);
+        free(table[i]);
+    }
+    free(table);
+    table = NULL;
+    capacity = count = 0;
+}
+
+static int compare_total(const void *a, const void *b) {
+    const struct stats_entry *x = *(struct stats_entry *const *) a;
+    const struct stats_entry *y = *(struct stats_entry *const *) b;
+    return (x->wall_total < y->wall_total) - (x->wall_total > y->wall_total);
+}
+
+static uint64_t timeval_ns(const struct timeval tv) {
+    return (uint64_t) tv.tv_sec * 1000000000u + (uint64_t) tv.tv_usec * 1000u;
+}
@@ -0,0 +1,105 @@
+//
+// Contabilidade por comando: tempo, CPU, memória e trocas de contexto em histogramas por nome.
+//
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// Bytes do nome gravados em cada registro do fluxo (o resto é cortado): o pior caso,
+// um nome todo escapado em NDJSON (\u00XX), cabe no buffer do fluxo
+#define STATS_STREAM_NAME_MAX 4096
+
+/**
+ * @brief Medida de uma execução (um pipeline em primeiro plano).
+ */
+struct stats_sample {
+    uint64_t start_ns;     // Início (CLOCK_REALTIME, para o fluxo)
+    uint64_t wall_ns;      // Tempo de relógio (CLOCK_MONOTONIC)
+    uint64_t user_ns;      // CPU em modo usuário
+    uint64_t sys_ns;       // CPU em modo kernel
+    long max_rss_kb;       // Maior RSS entre os processos
+    long voluntary;        // Trocas de contexto voluntárias (esperas)
+    long involuntary;      // Trocas de contexto forçadas (fatia de tempo esgotada)
+    int status;            // Código de saída
+};
+
+/**
+ * @brief Registro do fluxo binário (`stats -o ARQUIVO -b`), seguido de `name_len` bytes do nome
+ * (no máximo STATS_STREAM_NAME_MAX).
+ *
+ * Campos na ordem de bytes da máquina, sem preenchimento entre eles (56 bytes).
+ */
+struct stats_wire {
+    uint64_t start_ns;
+    uint64_t wall_ns;
+    uint64_t user_ns;
+    uint64_t sys_ns;
+    uint64_t max_rss_kb;
+    uint32_t voluntary;
+    uint32_t involuntary;
+    int32_t status;
+    uint16_t name_len;
+    uint16_t reserved;
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Marca o início de uma execução.
+ * @param start Recebe o instante (CLOCK_MONOTONIC).
+ */
+static inline void stats_begin(struct timespec *start) {
+    clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+/**
+ * @brief Fecha a medida de uma execução.
+ * @param start Instante de `stats_begin`.
+ * @param usage Uso de recursos do pipeline (`pipeline_run`).
+ * @param status Código de saída.
+ * @param sample Recebe a medida.
+ */
+void stats_end(const struct timespec *start, const struct rusage *usage, int status, struct stats_sample *sample);
+
+/**
+ * @brief Acrescenta uma medida ao histograma do comando (e ao fluxo, se aberto).
+ * @param name Nome do comando (argv[0] do primeiro estágio).
+ * @param sample Medida.
+ */
+void stats_add(const char *name, const struct stats_sample *sample);
+
+/**
+ * @brief Exibe uma medida em stderr (prefixo `time`).
+ * @param sample Medida.
+ */
+void stats_print_sample(const struct stats_sample *sample);
+
+/**
+ * @brief Soma `add` em `total` (tempos e trocas somados, RSS pelo maior).
+ */
+void stats_usage_add(struct rusage *total, const struct rusage *add);
+
+/**
+ * @brief Soma em `total` o uso entre duas leituras de getrusage.
+ */
+void stats_usage_delta(struct rusage *total, const struct rusage *before, const struct rusage *after);
+
+/**
+ * @brief Envia ao arquivo o que falta do fluxo e o fecha.
+ */
+void stats_stream_close(void);
+
+/**
+ * @brief Comando `stats`: tabela por comando (p50/p99/máximo), limpeza e fluxo para arquivo.
+ * @param argc Quantidade de argumentos.
+ * @param argv Argumentos (argv[0] é o nome do comando).
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+int builtin_stats(int argc, char **argv);
+
+#endif //STATS_H
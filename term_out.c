@@ -0,0 +1,194 @@
+#include "term_out.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Maior inteiro de 64 bits em decimal, com sinal
+#define INT_DIGITS_MAX 20
+
+/*****************************************************************************/
+
+static char buffer[TERM_OUT_BUF_SIZE];
+static size_t length = 0;
+static struct term_out_stats stats = {0};
+static _Thread_local struct term_out_capture *capture = NULL;
+
+/*****************************************************************************/
+
+/**
+ * @brief Escreve tudo em STDOUT_FILENO, repetindo em escritas parciais e EINTR.
+ * @param data Bytes a escrever.
+ * @param len Quantidade de bytes.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int write_all(const char *data, size_t len);
+
+/**
+ * @brief Escreve os dígitos de `value` no fim de `end` (de trás para frente).
+ * @param value Valor.
+ * @param end Posição logo após o último dígito.
+ * @return Ponteiro para o primeiro dígito.
+ */
+static char *format_uint(unsigned long long value, char *end);
+
+/**
+ * @brief Garante espaço para mais `len` bytes na captura da thread.
+ * @param len Bytes a acrescentar.
+ * @return true se há espaço (sem memória, a saída é descartada).
+ */
+static bool capture_reserve(size_t len);
+
+/*****************************************************************************/
+
+void term_out_write(const char *data, const size_t len) {
+    if (capture) {
+        if (capture_reserve(len)) {
+            memcpy(capture->data + capture->len, data, len);
+            capture->len += len;
+        }
+        return;
+    }
+    if (len > sizeof(buffer) - length) {
+        term_out_flush();
+        // Blocos maiores que o buffer vão direto, sem cópia
+        if (len >= sizeof(buffer)) {
+            write_all(data, len);
+            return;
+        }
+    }
+    memcpy(buffer + length, data, len);
+    length += len;
+}
+
+void term_out_char(const char c) {
+    if (capture) {
+        term_out_write(&c, 1);
+        return;
+    }
+    if (length == sizeof(buffer)) term_out_flush();
+    buffer[length++] = c;
+}
+
+void term_out_repeat(const char *str, const size_t times) {
+    const size_t len = strlen(str);
+    for (size_t i = 0; i < times; i++) term_out_write(str, len);
+}
+
+void term_out_int(const long long value) {
+    char digits[INT_DIGITS_MAX + 1];
+    char *end = digits + sizeof(digits);
+    // Negação em unsigned para não estourar com LLONG_MIN
+    char *start = format_uint(value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value, end);
+    if (value < 0) *--start = '-';
+    term_out_write(start, (size_t) (end - start));
+}
+
+void term_out_uint(const unsigned long long value) {
+    char digits[INT_DIGITS_MAX];
+    char *end = digits + sizeof(digits);
+    const char *start = format_uint(value, end);
+    term_out_write(start, (size_t) (end - start));
+}
+
+void term_out_field(const char *str, const size_t max, const int width) {
+    size_t len = strlen(str);
+    if (len > max) len = max;
+
+    const size_t field = width < 0 ? (size_t) -width : (size_t) width;
+    const size_t padding = field > len ? field - len : 0;
+    if (width > 0) term_out_repeat(" ", padding);
+    term_out_write(str, len);
+    if (width < 0) term_out_repeat(" ", padding);
+}
+
+void term_out_printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list retry;
+    va_copy(retry, args);
+
+    if (capture) {
+        const int needed = vsnprintf(NULL, 0, fmt, args);
+        if (needed > 0 && capture_reserve((size_t) needed + 1)) {
+            vsnprintf(capture->data + capture->len, (size_t) needed + 1, fmt, retry);
+            capture->len += (size_t) needed;
+        }
+        va_end(retry);
+        va_end(args);
+        return;
+    }
+
+    // Formata direto no espaço livre; se não couber, esvazia o buffer e tenta de novo
+    int len = vsnprintf(buffer + length, sizeof(buffer) - length, fmt, args);
+    if (len >= 0 && (size_t) len >= sizeof(buffer) - length) {
+        term_out_flush();
+        if ((size_t) len < sizeof(buffer)) {
+            len = vsnprintf(buffer, sizeof(buffer), fmt, retry);
+        } else {
+            vdprintf(STDOUT_FILENO, fmt, retry);
+            len = -1;
+        }
+    }
+    if (len > 0) length += (size_t) len;
+
+    va_end(retry);
+    va_end(args);
+}
+
+int term_out_flush(void) {
+    if (capture || length == 0) return 0;
+    const int result = write_all(buffer, length);
+    length = 0;
+    return result;
+}
+
+struct term_out_capture *term_out_capture(struct term_out_capture *target) {
+    struct term_out_capture *previous = capture;
+    capture = target;
+    return previous;
+}
+
+struct term_out_stats term_out_get_stats(void) {
+    return stats;
+}
+
+/*****************************************************************************/
+
+static int write_all(const char *data, size_t len) {
+    while (len > 0) {
+        const ssize_t written = write(STDOUT_FILENO, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        stats.writes++;
+        stats.bytes += (size_t) written;
+        data += written;
+        len -= (size_t) written;
+    }
+    return 0;
+}
+
+static char *format_uint(unsigned long long value, char *end) {
+    do {
+        *--end = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static bool capture_reserve(const size_t len) {
+    if (capture->capacity - capture->len >= len) return true;
+    size_t capacity = capture->capacity ? capture->capacity : 4096;
+    while (capacity - capture->len < len) capacity *= 2;
+    char *data = realloc(capture->data, capacity);
+    if (!data) return false;
+    capture->data = data;
+    capture->capacity = capacity;
+    return true;
+}
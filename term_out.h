@@ -0,0 +1,113 @@
+//
+// Saída bufferizada dos comandos internos: tudo é acumulado e enviado com write().
+//
+
+#ifndef TERM_OUT_H
+#define TERM_OUT_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Tamanho do buffer; ao encher, o conteúdo é enviado com um único write()
+#define TERM_OUT_BUF_SIZE (64 * 1024)
+
+/**
+ * @brief Contadores da saída desde o início da sessão.
+ */
+struct term_out_stats {
+    size_t bytes;   // Bytes enviados
+    size_t writes;  // Chamadas a write()
+};
+
+/**
+ * @brief Saída de um comando guardada em memória em vez de ir para o buffer compartilhado.
+ */
+struct term_out_capture {
+    char *data;       // Bytes capturados (malloc; liberados por quem capturou)
+    size_t len;       // Bytes usados
+    size_t capacity;  // Bytes alocados
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Acrescenta bytes ao buffer (envia o buffer antes se não couberem).
+ * @param data Bytes a acrescentar.
+ * @param len Quantidade de bytes.
+ */
+void term_out_write(const char *data, size_t len);
+
+/**
+ * @brief Acrescenta uma string (com literais, o strlen é resolvido na compilação).
+ * @param str String terminada em '\0'.
+ */
+static inline void term_out_str(const char *str) {
+    term_out_write(str, strlen(str));
+}
+
+/**
+ * @brief Acrescenta um caractere.
+ * @param c Caractere.
+ */
+void term_out_char(char c);
+
+/**
+ * @brief Acrescenta `str` repetida `times` vezes (bordas, indentação).
+ * @param str String a repetir.
+ * @param times Quantidade de repetições.
+ */
+void term_out_repeat(const char *str, size_t times);
+
+/**
+ * @brief Acrescenta um inteiro em decimal, sem printf.
+ * @param value Valor.
+ */
+void term_out_int(long long value);
+
+/**
+ * @brief Acrescenta um inteiro sem sinal em decimal, sem printf.
+ * @param value Valor.
+ */
+void term_out_uint(unsigned long long value);
+
+/**
+ * @brief Acrescenta uma string truncada e alinhada, como `%<width>.<max>s`.
+ * @param str String.
+ * @param max Máximo de bytes de `str` (SIZE_MAX = sem limite).
+ * @param width Largura do campo; negativa alinha à esquerda, como no printf.
+ */
+void term_out_field(const char *str, size_t max, int width);
+
+/**
+ * @brief Acrescenta texto formatado (para os casos raros: números reais, ajuda).
+ * @param fmt Formato do printf.
+ */
+void term_out_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Envia o conteúdo do buffer para a saída padrão.
+ *
+ * Deve ser chamado antes de ler do terminal, de criar processos filhos e de
+ * escrever diretamente no descritor (ex.: `mon`).
+ * @return 0 em caso de sucesso, -1 se a escrita falhar (o conteúdo é descartado).
+ */
+int term_out_flush(void);
+
+/**
+ * @brief Desvia a saída da thread atual para `capture` (NULL volta ao buffer compartilhado).
+ *
+ * O destino é por thread: comandos internos executados em threads diferentes
+ * (`par`) escrevem cada um na sua captura, sem travas e sem misturar linhas.
+ * Durante a captura `term_out_flush` não escreve nada.
+ * @param capture Captura a preencher, ou NULL.
+ * @return O destino anterior.
+ */
+struct term_out_capture *term_out_capture(struct term_out_capture *capture);
+
+/**
+ * @brief Retorna os contadores da saída.
+ * @return Bytes e chamadas a write() desde o início da sessão.
+ */
+struct term_out_stats term_out_get_stats(void);
+
+#endif //TERM_OUT_H
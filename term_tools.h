@@ -46,10 +46,22 @@
 // Terminal Reset
 #define TERM_RESET "\x1b[0m"
 
+// Terminal Cursor / Screen
+#define TERM_CURSOR_HOME "\x1b[H"
+#define TERM_CURSOR_POS "\x1b[%zu;%zuH" // Formato printf: linha, coluna (a partir de 1)
+#define TERM_CURSOR_HIDE "\x1b[?25l"
+#define TERM_CURSOR_SHOW "\x1b[?25h"
+#define TERM_CLEAR_SCREEN "\x1b[H\x1b[2J"
+#define TERM_CLEAR_SCROLLBACK "\x1b[3J"
+#define TERM_ERASE_LINE_END "\x1b[K"
+#define TERM_ERASE_SCREEN_END "\x1b[J"
+#define TERM_ALT_SCREEN_ENTER "\x1b[?1049h"
+#define TERM_ALT_SCREEN_LEAVE "\x1b[?1049l"
+
 
 static inline size_t getTerminalRows() {
     #ifdef __linux__
-        struct winsize _;
+        struct winsize _ = {0};
         ioctl(0, TIOCGWINSZ, &_);
         return _.ws_row;
     #elif defined(_WIN32)
@@ -63,7 +75,7 @@ static inline size_t getTerminalRows() {
 
 static inline size_t getTerminalCols() {
     #ifdef __linux__
-        struct winsize _;
+        struct winsize _ = {0};
         ioctl(0, TIOCGWINSZ, &_);
         return _.ws_col;
     #elif defined(_WIN32)
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Cache de listagens do `lf`: num diretório local a segunda listagem é um
+# acerto e uma mudança feita por outro processo aparece na seguinte (inotify);
+# no /proc, cujas mudanças o inotify não vê, nada é guardado.
+#
+# Uso: lf_cache_test.sh SHELL
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+: > "$WORK/a"
+
+failures=0
+
+# check DESCRIÇÃO ESPERADO OBTIDO
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FALHA: $1: esperado '$2', obtido '$3'" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+# counter NOME: valor de uma linha do `lf --cache` na saída guardada em $out
+counter() {
+    printf '%s\n' "$out" | sed 's/\x1b\[[0-9;]*m//g' | awk -v name="$1" '$1 == name { print $2; exit }'
+}
+
+out=$("$SHELL_BIN" -c "lf $WORK; lf $WORK; touch $WORK/b; lf $WORK; lf --cache")
+check "nomes depois do touch" "a
+a
+a
+b" "$(printf '%s\n' "$out" | sed 's/\x1b\[[0-9;]*m//g' | grep -x '[ab]')"
+check "acertos no diretório local" 1 "$(counter Acertos)"
+check "invalidações no diretório local" 1 "$(counter Invalidadas)"
+
+out=$("$SHELL_BIN" -c 'lf /proc > /dev/null; lf /proc > /dev/null; lf --cache')
+check "acertos no /proc" 0 "$(counter Acertos)"
+check "diretórios guardados do /proc" 0 "$(counter Diretórios)"
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "cache de listagens: ok"
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# `lf -l -j N` em um sistema de arquivos lento simulado: cada stat dorme
+# DELAY_US microssegundos (libslow_stat via LD_PRELOAD). Confere que a saída
+# com N threads é a mesma da serial, que está em ordem de nome e que a
+# listagem paralela é ao menos MIN_SPEEDUP vezes mais rápida.
+#
+# Uso: lf_jobs_test.sh SHELL LIBSLOW_STAT [ENTRIES] [DELAY_US] [JOBS] [MIN_SPEEDUP]
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+SLOW_LIB=$(realpath "$2")
+ENTRIES=${3:-400}
+DELAY_US=${4:-2000}
+JOBS=${5:-16}
+MIN_SPEEDUP=${6:-4}
+
+export LC_ALL=C
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Nomes criados fora de ordem, para o getdents não os devolver já ordenados
+mkdir "$WORK/dir"
+awk -v n="$ENTRIES" 'BEGIN { for (i = 0; i < n; i++) printf "e%05d\n", (i * 7919) % n }' |
+    while read -r name; do : > "$WORK/dir/$name"; done
+
+# Tempo de uma listagem, saída em $WORK/out.$1
+list() {
+    start=$(date +%s.%N)
+    SLOW_STAT_US=$DELAY_US LD_PRELOAD=$SLOW_LIB "$SHELL_BIN" -c "lf --no-cache -l -j $1 $WORK/dir" > "$WORK/out.$1"
+    end=$(date +%s.%N)
+    awk -v s="$start" -v e="$end" 'BEGIN { printf "%.3f", e - s }'
+}
+
+serial=$(list 1)
+parallel=$(list "$JOBS")
+
+status=0
+if ! cmp -s "$WORK/out.1" "$WORK/out.$JOBS"; then
+    echo "FALHA: a saída com -j $JOBS difere da serial" >&2
+    status=1
+fi
+
+sed 's/\x1b\[[0-9;]*m//g' "$WORK/out.$JOBS" | awk 'NR > 1 { print $NF }' > "$WORK/names"
+sort "$WORK/names" > "$WORK/sorted"
+if [ "$(wc -l < "$WORK/names")" -ne "$ENTRIES" ] || ! cmp -s "$WORK/names" "$WORK/sorted"; then
+    echo "FALHA: a listagem com -j $JOBS não tem as $ENTRIES entradas em ordem" >&2
+    status=1
+fi
+
+awk -v s="$serial" -v p="$parallel" -v j="$JOBS" -v n="$ENTRIES" -v d="$DELAY_US" -v min="$MIN_SPEEDUP" 'BEGIN {
+    printf "lf -l em %d entradas com %d us por stat: -j 1 %.3f s, -j %d %.3f s (%.1fx)\n", n, d, s, j, p, s / p
+    if (s / p < min) {
+        printf "FALHA: ganho abaixo de %.1fx\n", min > "/dev/stderr"
+        exit 1
+    }
+}' || status=1
+exit $status
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Comando de jobs (`jobs`, `wait`) no fim de um pipeline: ele roda no shell
+# antes de os estágios externos virarem job, e o wait4 dele pode recolher
+# esses irmãos. O status não pode se perder (senão o shell espera para
+# sempre); cada caso tem um prazo.
+#
+# Uso: pipeline_jobs_test.sh SHELL
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+
+failures=0
+
+# check COMANDO ESPERADO
+check() {
+    got=$(timeout 10 "$SHELL_BIN" -c "$1" < /dev/null 2>&1) || true
+    if [ "$got" != "$2" ]; then
+        echo "FALHA: $1: esperado '$2', obtido '$got'" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+check 'true | jobs; echo done' done
+check 'true | wait; echo done' done
+check 'true | jobs -l; echo done' done
+check 'sleep 0.2 | wait; echo done' done
+check 'true | true | wait; echo $?' 0
+# O job anterior em segundo plano continua sendo esperado
+check 'sleep 0.2 & true | wait; echo done; jobs' done
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "comandos de jobs no fim do pipeline: ok"
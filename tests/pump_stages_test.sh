@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# Estágios só de redirecionamento, que no shell (como no zsh, e diferente do
+# sh/bash) copiam dados: `< arquivo | cmd` entrega o arquivo ao próximo estágio
+# e `cmd | > a > b [| cmd]` grava a mesma cópia em cada arquivo e, no meio do
+# pipeline, a repassa adiante; `< arquivo` sozinho mostra o arquivo. Confere o conteúdo com um arquivo de texto e um
+# binário de alguns MB (splice e tee).
+#
+# Uso: pump_stages_test.sh SHELL
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+printf 'a\nb\nc\n' > text
+head -c 5000000 /dev/urandom > bin
+
+failures=0
+
+# check DESCRIÇÃO ESPERADO OBTIDO
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FALHA: $1: esperado '$2', obtido '$3'" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+check "< text | wc -l" 3 "$("$SHELL_BIN" -c '< text | wc -l')"
+check "< bin | wc -c" 5000000 "$("$SHELL_BIN" -c '< bin | wc -c')"
+check "< bin | cat | cksum" "$(cksum < bin)" "$("$SHELL_BIN" -c '< bin | cat | cksum')"
+
+# No fim do pipeline os dados vão só para os arquivos
+check "cat text | > t1 > t2 (saída)" "" "$("$SHELL_BIN" -c 'cat text | > t1 > t2')"
+check "cat text | > t1 > t2 (t1)" "$(cat text)" "$(cat t1)"
+check "cat text | > t1 > t2 (t2)" "$(cat text)" "$(cat t2)"
+
+# No meio do pipeline o próximo estágio também recebe a cópia
+check "cat bin | > b1 >> b2 | wc -c" 5000000 "$("$SHELL_BIN" -c 'cat bin | > b1 >> b2 | wc -c')"
+check "cat bin | > b1 (b1)" "$(cksum < bin)" "$(cksum < b1)"
+check "cat bin | >> b2 (b2)" "$(cksum < bin)" "$(cksum < b2)"
+
+# Comando interno antes do estágio (`names` já existe quando o `lf` lê o diretório)
+out=$("$SHELL_BIN" -c 'lf | > names | wc -l')
+check "lf | > names | wc -l" "$(ls | wc -l)" "$out"
+check "lf | > names (names)" "$(ls | wc -l)" "$(wc -l < names)"
+
+# Estágio sozinho: `<` mostra o arquivo (no sh só o abre); `>` cria o arquivo vazio, como no sh
+check "< text" "$(cat text)" "$("$SHELL_BIN" -c '< text')"
+"$SHELL_BIN" -c '> empty'
+check "> empty" 0 "$(wc -c < empty)"
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "estágios só de redirecionamento: ok"
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# `search` em um arquivo grande (mapeado) que encolhe durante a varredura:
+# a biblioteca shrink_mmap trunca o arquivo pela metade logo antes do mmap,
+# então ler o fim do mapeamento dá SIGBUS. O shell não pode morrer: o arquivo
+# conta como erro (status 2, como no grep) e os outros arquivos saem inteiros.
+#
+# Uso: search_truncate_test.sh SHELL LIBSHRINK_MMAP
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+LIB=$(realpath "$2")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir "$WORK/dir"
+# 4 MB com uma ocorrência no começo e uma no fim (além da metade que sobra)
+{
+    echo "marcador_inicio"
+    awk 'BEGIN { for (i = 0; i < 100000; i++) print "linha de log comum numero " i }'
+    echo "marcador_fim"
+} > "$WORK/dir/big.log"
+awk 'BEGIN { for (i = 0; i < 100000; i++) print "outro arquivo grande " i; print "marcador_fim" }' \
+    > "$WORK/dir/big.txt"
+echo "marcador_fim" > "$WORK/dir/small.txt"
+
+failures=0
+
+# check DESCRIÇÃO ESPERADO OBTIDO
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FALHA: $1: esperado '$2', obtido '$3'" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+out=$(cd "$WORK/dir" && SHRINK_MMAP_NAME=.log LD_PRELOAD="$LIB" timeout 20 "$SHELL_BIN" \
+    -c 'search -j 1 marcador .; echo "status $?"' 2>&1) || true
+check "resultado" "./big.txt:100001:marcador_fim
+./small.txt:1:marcador_fim
+status 2" "$(printf '%s\n' "$out" | LC_ALL=C sort)"
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "search em arquivo truncado: ok"
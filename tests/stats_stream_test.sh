@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Fluxo do `stats -o`: um comando com nome enorme (70 mil bytes, ou 60 mil
+# bytes de controle que viram \u0001 no NDJSON) não pode passar do buffer do
+# fluxo; o nome gravado é cortado em STATS_STREAM_NAME_MAX (4096) bytes.
+#
+# Uso: stats_stream_test.sh SHELL
+#
+
+set -eu
+
+SHELL_BIN=$(realpath "$1")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+failures=0
+
+# check DESCRIÇÃO ESPERADO OBTIDO
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FALHA: $1: esperado '$2', obtido '$3'" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+long=$(awk 'BEGIN { for (i = 0; i < 70000; i++) printf "x" }')
+control=$(awk 'BEGIN { for (i = 0; i < 60000; i++) printf "\001" }')
+
+# Binário: o registro do próprio `stats -o` (56 bytes + "stats") e o do nome cortado (56 + 4096)
+"$SHELL_BIN" -c "stats -o $WORK/bin -b; $long; stats -x" > /dev/null 2>&1 || true
+check "tamanho do fluxo binário" $((56 + 4096 + 56 + 5)) "$(wc -c < "$WORK/bin" | tr -d ' ')"
+
+# NDJSON: 4096 bytes de controle escapados (6 bytes cada) no campo cmd
+"$SHELL_BIN" -c "stats -o $WORK/nd; $control; stats -x" > /dev/null 2>&1 || true
+check "linhas do NDJSON" 2 "$(wc -l < "$WORK/nd" | tr -d ' ')"
+check "escapes no nome" 4096 "$(sed -n 2p "$WORK/nd" | grep -o 'u0001' | wc -l | tr -d ' ')"
+
+if [ "$failures" -ne 0 ]; then
+    exit 1
+fi
+echo "fluxo do stats com nomes enormes: ok"
@@ -0,0 +1,783 @@
+#include "tree_watch.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "term_tools.h"
+#include "term_out.h"
+#include "proc_tools.h"
+#include "proc_events.h"
+#include "screen.h"
+
+// Índice nulo (sem pai, sem irmão, fim da lista de livres)
+#define WATCH_NONE UINT32_MAX
+
+// Linhas fixas da tela: status e rodapé
+#define WATCH_HEADER_ROWS 1
+#define WATCH_FOOTER_ROWS 1
+
+// Colunas reservadas ao nome e ao PID antes de a indentação ser encurtada
+#define WATCH_NAME_COLS 30
+
+/*****************************************************************************/
+
+/**
+ * @brief Processo da árvore ao vivo. Os filhos formam uma lista duplamente ligada, em ordem de chegada.
+ */
+struct watch_node {
+    pid_t pid;                     // 0 = posição livre
+    pid_t ppid;                    // Pai informado pelo kernel (pode não estar na árvore)
+    unsigned long long starttime;  // 0 = ainda não lido (processo criado por evento)
+    uint32_t parent;
+    uint32_t first_child;
+    uint32_t last_child;
+    uint32_t prev;                 // Irmãos; `next` também encadeia a lista de livres
+    uint32_t next;
+    uint32_t gen;                  // Última varredura do /proc em que apareceu
+    double born;                   // Chegada (ou saída, nas lápides), em segundos monotônicos
+    bool dead;                     // Lápide: saída vista antes do fork
+    char name[PROC_NAME_MAX];
+};
+
+struct watch_tree {
+    struct watch_node *nodes;
+    uint32_t capacity;
+    uint32_t used;                 // Posições já usadas alguma vez
+    uint32_t free_head;
+    size_t live;                   // Processos (sem as lápides)
+
+    uint32_t *slots;               // PID -> índice, endereçamento aberto (WATCH_NONE = vazio)
+    size_t slot_capacity;          // Potência de 2
+    size_t slot_count;
+    uint32_t gen;
+};
+
+// Processo a desenhar
+struct watch_frame {
+    uint32_t index;
+    uint32_t depth;
+    bool last;
+};
+
+struct watch_state {
+    const struct tree_watch_options *options;
+    struct watch_tree tree;
+    struct process_table table;
+    struct proc_change *changes;   // Lote de eventos (TREE_WATCH_EVENT_BUDGET)
+    int events_fd;                 // -1 = releitura do /proc
+    int events_errno;              // Por que o netlink não está em uso (0 = pedido com --proc)
+    uint32_t root;
+    bool root_exited;
+
+    struct screen scr;
+    size_t term_rows;
+    size_t term_cols;
+    struct watch_frame *stack;
+    bool *rails;
+    size_t draw_capacity;
+    size_t subtree;                // Processos sob a raiz no último quadro
+
+    size_t forks, execs, exits, comms;
+    size_t resyncs;                // Ressincronizações por eventos perdidos
+    size_t events_at_tick;
+    double rate;                   // Eventos por segundo no último intervalo
+    double peak_rate;
+    double cpu_share;              // CPU gasta / tempo decorrido, desde o início
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Índice do processo `pid` (também as lápides), ou WATCH_NONE.
+ */
+static uint32_t node_find(const struct watch_tree *tree, pid_t pid);
+
+/**
+ * @brief Cria um processo solto (sem pai nem filhos) e o põe na tabela.
+ * @return Índice do processo, ou WATCH_NONE em caso de erro de alocação.
+ */
+static uint32_t node_add(struct watch_tree *tree, pid_t pid);
+
+/**
+ * @brief Tira um processo da árvore e da tabela; os filhos ficam soltos.
+ */
+static void node_drop(struct watch_tree *tree, uint32_t index);
+
+/**
+ * @brief Move um processo para o fim da lista de filhos de `parent` (WATCH_NONE = solto).
+ *
+ * Recusa a mudança se ela criaria um ciclo (dados fora de ordem).
+ * @return true se o pai mudou.
+ */
+static bool node_link(struct watch_tree *tree, uint32_t index, uint32_t parent);
+
+/**
+ * @brief Tira um processo da lista de filhos do seu pai.
+ */
+static void node_unlink(struct watch_tree *tree, uint32_t index);
+
+/**
+ * @brief Dobra a tabela PID -> índice e redistribui as entradas.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int hash_grow(struct watch_tree *tree);
+
+/**
+ * @brief Aplica um evento do kernel à árvore.
+ * @return 0 em caso de sucesso, -1 em caso de erro de alocação.
+ */
+static int apply_change(struct watch_state *st, const struct proc_change *change, double now);
+
+/**
+ * @brief Índice de um processo vivo, lendo o seu stat se ele ainda não está na árvore.
+ * @return Índice, ou WATCH_NONE se o processo não existe mais.
+ */
+static uint32_t live_process(struct watch_state *st, pid_t pid, double now);
+
+/**
+ * @brief Religa os filhos de um processo que terminou ao pai que o kernel deu a eles.
+ */
+static void adopt_children(struct watch_state *st, uint32_t index, double now);
+
+/**
+ * @brief Relê o /proc e corrige a árvore: processos novos, que terminaram ou que mudaram de pai ou de nome.
+ * @return Quantidade de correções, ou -1 em caso de erro.
+ */
+static long sync_with_proc(struct watch_state *st, double now);
+
+/**
+ * @brief Descarta as lápides mais antigas que TREE_WATCH_TOMBSTONE_SECONDS.
+ */
+static void purge_tombstones(struct watch_state *st, double now);
+
+/**
+ * @brief Monta o quadro e redesenha apenas as linhas alteradas.
+ */
+static void render(struct watch_state *st, double now);
+
+/**
+ * @brief Libera a árvore, os buffers e o socket.
+ */
+static void free_state(struct watch_state *st);
+
+/**
+ * @brief Segundos de CPU (usuário + sistema) consumidos pelo próprio shell.
+ */
+static double self_cpu_seconds(void);
+
+/**
+ * @brief Segundos do relógio monotônico.
+ */
+static double now_seconds(void);
+
+/*****************************************************************************/
+
+int tree_watch_run(const struct tree_watch_options *options) {
+    struct watch_state st = {.options = options, .events_fd = -1, .root = WATCH_NONE};
+    st.tree.free_head = WATCH_NONE;
+    st.changes = malloc(TREE_WATCH_EVENT_BUDGET * sizeof(struct proc_change));
+    if (!st.changes) {
+        term_out_str(TERM_RED_BOLD "Memória insuficiente" TERM_RESET "\n");
+        return 1;
+    }
+
+    // Assinar antes da varredura: o que mudar durante ela chega depois como evento
+    if (!options->force_proc) {
+        st.events_fd = proc_events_open();
+        if (st.events_fd < 0) st.events_errno = errno;
+    }
+    double now = now_seconds();
+    if (sync_with_proc(&st, now) < 0) {
+        term_out_str(TERM_RED_BOLD "Erro ao ler /proc" TERM_RESET "\n");
+        free_state(&st);
+        return 1;
+    }
+    if (st.root == WATCH_NONE) {
+        term_out_printf("%sProcesso %d não encontrado%s\n", TERM_RED_BOLD, options->root, TERM_RESET);
+        free_state(&st);
+        return 1;
+    }
+    // Os processos da primeira varredura não são novos
+    for (uint32_t i = 0; i < st.tree.used; i++) st.tree.nodes[i].born = now - TREE_WATCH_NEW_SECONDS;
+
+    st.term_rows = getTerminalRows() > 0 ? getTerminalRows() : 24;
+    st.term_cols = getTerminalCols() > 0 ? getTerminalCols() : 80;
+
+    // Teclas sem eco e sem esperar Enter (Ctrl-C chega como byte e também encerra)
+    const bool interactive = isatty(STDIN_FILENO);
+    struct termios saved_termios;
+    if (interactive && tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+        struct termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+
+    term_out_flush();
+    static const char enter[] = TERM_ALT_SCREEN_ENTER TERM_CURSOR_HIDE;
+    write(STDOUT_FILENO, enter, sizeof(enter) - 1);
+    screen_init(&st.scr, st.term_rows);
+
+    const double start_wall = now_seconds();
+    const double start_cpu = self_cpu_seconds();
+    double last_tick = start_wall;
+    double next_tick = start_wall + options->interval;
+    double last_frame = 0;
+    bool running = true;
+    bool dirty = true;
+    long cycles = 0;
+
+    while (running) {
+        now = now_seconds();
+        if (dirty && now - last_frame >= TREE_WATCH_FRAME_SECONDS) {
+            render(&st, now);
+            last_frame = now;
+            dirty = false;
+        }
+        if (st.root_exited) break;
+
+        if (now >= next_tick) {
+            // Intervalo: varredura (sem netlink), lápides vencidas, taxa de eventos e tamanho do terminal
+            if (st.events_fd < 0) sync_with_proc(&st, now);
+            purge_tombstones(&st, now);
+            const size_t events = st.forks + st.execs + st.exits + st.comms;
+            st.rate = (double) (events - st.events_at_tick) / (now - last_tick);
+            if (st.rate > st.peak_rate) st.peak_rate = st.rate;
+            st.events_at_tick = events;
+            st.cpu_share = (self_cpu_seconds() - start_cpu) / (now - start_wall) * 100;
+            last_tick = now;
+            next_tick = now + options->interval;
+
+            const size_t rows = getTerminalRows() > 0 ? getTerminalRows() : st.term_rows;
+            const size_t cols = getTerminalCols() > 0 ? getTerminalCols() : st.term_cols;
+            if (rows != st.term_rows || cols != st.term_cols) {
+                st.term_rows = rows;
+                st.term_cols = cols;
+                screen_resize(&st.scr, rows);
+            }
+            render(&st, now);
+            last_frame = now;
+            dirty = false;
+            if (options->max_cycles > 0 && ++cycles >= options->max_cycles) running = false;
+            continue;
+        }
+
+        // Esperar eventos, teclas, o próximo quadro ou o próximo intervalo
+        double wait = next_tick - now;
+        if (dirty && last_frame + TREE_WATCH_FRAME_SECONDS - now < wait) {
+            wait = last_frame + TREE_WATCH_FRAME_SECONDS - now;
+        }
+        struct pollfd pfds[2];
+        nfds_t nfds = 0;
+        if (st.events_fd >= 0) pfds[nfds++] = (struct pollfd){.fd = st.events_fd, .events = POLLIN};
+        if (interactive) pfds[nfds++] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
+        if (nfds == 0) {
+            const struct timespec ts = {
+                .tv_sec = (time_t) wait,
+                .tv_nsec = (long) ((wait - (double) (time_t) wait) * 1e9)
+            };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        if (poll(pfds, nfds, wait > 0 ? (int) (wait * 1000) + 1 : 0) <= 0) continue;
+
+        for (nfds_t i = 0; i < nfds; i++) {
+            if (!(pfds[i].revents & POLLIN)) continue;
+            if (pfds[i].fd == st.events_fd) {
+                // Um lote limitado por vez, para o terminal continuar respondendo sob rajadas
+                bool lost = false;
+                const long count = proc_events_read(st.events_fd, st.changes, TREE_WATCH_EVENT_BUDGET, &lost);
+                now = now_seconds();
+                for (long k = 0; k < count; k++) apply_change(&st, &st.changes[k], now);
+                if (lost) {
+                    st.resyncs++;
+                    sync_with_proc(&st, now);
+                }
+                if (count > 0 || lost) dirty = true;
+            } else {
+                char keys[16];
+                const ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+                for (ssize_t k = 0; k < n; k++) {
+                    if (keys[k] == 'q' || keys[k] == 'Q' || keys[k] == 3) running = false;
+                }
+            }
+        }
+    }
+
+    static const char leave[] = TERM_CURSOR_SHOW TERM_ALT_SCREEN_LEAVE;
+    write(STDOUT_FILENO, leave, sizeof(leave) - 1);
+    if (interactive) tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+
+    // Verificação: aplicar o que ainda está na fila e comparar com uma última varredura
+    long divergences = -1;
+    if (st.events_fd >= 0) {
+        bool lost = false;
+        long count;
+        while ((count = proc_events_read(st.events_fd, st.changes, TREE_WATCH_EVENT_BUDGET, &lost)) > 0) {
+            now = now_seconds();
+            for (long k = 0; k < count; k++) apply_change(&st, &st.changes[k], now);
+        }
+        if (lost) st.resyncs++;
+        divergences = sync_with_proc(&st, now_seconds());
+    }
+
+    const double wall = now_seconds() - start_wall;
+    const double cpu = self_cpu_seconds() - start_cpu;
+    if (st.root_exited) term_out_printf("%sProcesso %d terminou%s\n", TERM_YELLOW_BOLD, options->root, TERM_RESET);
+    term_out_printf("%stree --watch: %s | %zu eventos (fork %zu, exec %zu, exit %zu, comm %zu), pico %.0f/s | "
+                    "%zu ressincronizações", TERM_CYANBRIGHT, st.events_fd >= 0 ? "netlink" : "/proc",
+                    st.forks + st.execs + st.exits + st.comms, st.forks, st.execs, st.exits, st.comms,
+                    st.peak_rate, st.resyncs);
+    if (divergences >= 0) {
+        term_out_printf(" | verificação: %zu processos, %ld divergências", st.tree.live, divergences);
+    }
+    term_out_printf(" | %.1f s, %.2f%% de uma CPU%s\n", wall, wall > 0 ? cpu / wall * 100 : 0.0, TERM_RESET);
+
+    free_state(&st);
+    return 0;
+}
+
+/*****************************************************************************/
+
+static uint32_t node_find(const struct watch_tree *tree, const pid_t pid) {
+    if (!tree->slot_capacity) return WATCH_NONE;
+
+    const size_t mask = tree->slot_capacity - 1;
+    size_t i = ((size_t) pid * 2654435761u) & mask;
+    while (tree->slots[i] != WATCH_NONE) {
+        if (tree->nodes[tree->slots[i]].pid == pid) return tree->slots[i];
+        i = (i + 1) & mask;
+    }
+    return WATCH_NONE;
+}
+
+static uint32_t node_add(struct watch_tree *tree, const pid_t pid) {
+    if ((tree->slot_count + 1) * 2 > tree->slot_capacity && hash_grow(tree) != 0) return WATCH_NONE;
+
+    uint32_t index = tree->free_head;
+    if (index != WATCH_NONE) {
+        tree->free_head = tree->nodes[index].next;
+    } else {
+        if (tree->used == tree->capacity) {
+            const uint32_t capacity = tree->capacity ? tree->capacity * 2 : 1024;
+            struct watch_node *nodes = realloc(tree->nodes, capacity * sizeof(struct watch_node));
+            if (!nodes) return WATCH_NONE;
+            tree->nodes = nodes;
+            tree->capacity = capacity;
+        }
+        index = tree->used++;
+    }
+    tree->nodes[index] = (struct watch_node){
+        .pid = pid, .parent = WATCH_NONE, .first_child = WATCH_NONE, .last_child = WATCH_NONE,
+        .prev = WATCH_NONE, .next = WATCH_NONE, .name = "?"
+    };
+
+    const size_t mask = tree->slot_capacity - 1;
+    size_t i = ((size_t) pid * 2654435761u) & mask;
+    while (tree->slots[i] != WATCH_NONE) i = (i + 1) & mask;
+    tree->slots[i] = index;
+    tree->slot_count++;
+    tree->live++;
+    return index;
+}
+
+static void node_drop(struct watch_tree *tree, const uint32_t index) {
+    struct watch_node *node = &tree->nodes[index];
+    node_unlink(tree, index);
+    while (node->first_child != WATCH_NONE) node_unlink(tree, node->first_child);
+    if (!node->dead) tree->live--;
+
+    // Remoção com deslocamento para trás: a sequência de sondagem continua sem buracos
+    const size_t mask = tree->slot_capacity - 1;
+    size_t hole = ((size_t) node->pid * 2654435761u) & mask;
+    while (tree->slots[hole] != index) hole = (hole + 1) & mask;
+    tree->slots[hole] = WATCH_NONE;
+    for (size_t i = (hole + 1) & mask; tree->slots[i] != WATCH_NONE; i = (i + 1) & mask) {
+        const size_t home = ((size_t) tree->nodes[tree->slots[i]].pid * 2654435761u) & mask;
+        // A entrada pode ocupar o buraco se a sua posição ideal não está entre o buraco e ela
+        const bool movable = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+        if (movable) {
+            tree->slots[hole] = tree->slots[i];
+            tree->slots[i] = WATCH_NONE;
+            hole = i;
+        }
+    }
+    tree->slot_count--;
+
+    node->pid = 0;
+    node->next = tree->free_head;
+    tree->free_head = index;
+}
+
+static bool node_link(struct watch_tree *tree, const uint32_t index, const uint32_t parent) {
+    struct watch_node *node = &tree->nodes[index];
+    if (node->parent == parent || parent == index) return false;
+    // Um processo com filhos não pode ir para baixo de um descendente seu
+    if (parent != WATCH_NONE && node->first_child != WATCH_NONE) {
+        for (uint32_t p = tree->nodes[parent].parent; p != WATCH_NONE; p = tree->nodes[p].parent) {
+            if (p == index) return false;
+        }
+    }
+
+    node_unlink(tree, index);
+    if (parent == WATCH_NONE) return true;
+    struct watch_node *up = &tree->nodes[parent];
+    node->parent = parent;
+    node->prev = up->last_child;
+    node->next = WATCH_NONE;
+    if (up->last_child != WATCH_NONE) tree->nodes[up->last_child].next = index;
+    else up->first_child = index;
+    up->last_child = index;
+    return true;
+}
+
+static void node_unlink(struct watch_tree *tree, const uint32_t index) {
+    struct watch_node *node = &tree->nodes[index];
+    if (node->parent == WATCH_NONE) return;
+
+    struct watch_node *up = &tree->nodes[node->parent];
+    if (node->prev != WATCH_NONE) tree->nodes[node->prev].next = node->next;
+    else up->first_child = node->next;
+    if (node->next != WATCH_NONE) tree->nodes[node->next].prev = node->prev;
+    else up->last_child = node->prev;
+    node->parent = node->prev = node->next = WATCH_NONE;
+}
+
+static int hash_grow(struct watch_tree *tree) {
+    const size_t capacity = tree->slot_capacity ? tree->slot_capacity * 2 : 4096;
+    uint32_t *slots = malloc(capacity * sizeof(uint32_t));
+    if (!slots) return -1;
+    memset(slots, 0xff, capacity * sizeof(uint32_t));
+
+    const size_t mask = capacity - 1;
+    for (size_t s = 0; s < tree->slot_capacity; s++) {
+        if (tree->slots[s] == WATCH_NONE) continue;
+        size_t i = ((size_t) tree->nodes[tree->slots[s]].pid * 2654435761u) & mask;
+        while (slots[i] != WATCH_NONE) i = (i + 1) & mask;
+        slots[i] = tree->slots[s];
+    }
+    free(tree->slots);
+    tree->slots = slots;
+    tree->slot_capacity = capacity;
+    return 0;
+}
+
+static int apply_change(struct watch_state *st, const struct proc_change *change, const double now) {
+    struct watch_tree *tree = &st->tree;
+    uint32_t index = node_find(tree, change->pid);
+
+    switch (change->kind) {
+        case PROC_CHANGE_FORK: {
+            st->forks++;
+            if (index != WATCH_NONE && tree->nodes[index].dead) {
+                // A saída chegou antes do fork (o filho rodou em outra CPU): nada a acrescentar
+                node_drop(tree, index);
+                return 0;
+            }
+            uint32_t parent = live_process(st, change->ppid, now);
+            const bool known = index != WATCH_NONE;
+            if (!known && (index = node_add(tree, change->pid)) == WATCH_NONE) return -1;
+            struct watch_node *node = &tree->nodes[index];
+            node->ppid = change->ppid;
+            if (parent == WATCH_NONE) {
+                // O pai já terminou: o filho foi adotado, e o seu stat diz por quem
+                const struct process_info info = get_process_info(change->pid);
+                if (info.pid != 0) {
+                    node->ppid = info.ppid;
+                    memcpy(node->name, info.name, sizeof(node->name));
+                    parent = live_process(st, info.ppid, now);
+                    node = &tree->nodes[index];
+                }
+            } else if (!known) {
+                // O filho começa com o nome do pai, até um exec ou comm
+                memcpy(node->name, tree->nodes[parent].name, sizeof(node->name));
+            }
+            if (!known) node->born = now;
+            node_link(tree, index, parent);
+            return 0;
+        }
+        case PROC_CHANGE_EXEC:
+        case PROC_CHANGE_COMM: {
+            if (change->kind == PROC_CHANGE_EXEC) st->execs++;
+            else st->comms++;
+            if (index == WATCH_NONE) {
+                live_process(st, change->pid, now);
+                return 0;
+            }
+            struct watch_node *node = &tree->nodes[index];
+            if (node->dead) return 0;
+            if (change->kind == PROC_CHANGE_COMM) {
+                memcpy(node->name, change->comm, sizeof(change->comm));
+            } else {
+                // O exec não traz o nome novo; se o processo já terminou, fica o antigo
+                const struct process_info info = get_process_info(change->pid);
+                if (info.pid != 0) {
+                    memcpy(node->name, info.name, sizeof(node->name));
+                    node->starttime = info.starttime;
+                }
+            }
+            return 0;
+        }
+        case PROC_CHANGE_EXIT: {
+            st->exits++;
+            if (index == WATCH_NONE) {
+                // Lápide: se o fork deste PID ainda estiver a caminho, ele será descartado
+                if ((index = node_add(tree, change->pid)) == WATCH_NONE) return -1;
+                tree->nodes[index].dead = true;
+                tree->nodes[index].born = now;
+                tree->live--;
+                return 0;
+            }
+            if (tree->nodes[index].dead) return 0;
+            adopt_children(st, index, now);
+            if (index == st->root) {
+                st->root = WATCH_NONE;
+                st->root_exited = true;
+            }
+            node_drop(tree, index);
+            return 0;
+        }
+    }
+    return 0;
+}
+
+static uint32_t live_process(struct watch_state *st, const pid_t pid, const double now) {
+    struct watch_tree *tree = &st->tree;
+    uint32_t index = node_find(tree, pid);
+    if (index != WATCH_NONE && !tree->nodes[index].dead) return index;
+    if (pid <= 0) return WATCH_NONE;
+
+    // Fora de ordem (exec antes do fork, pai criado em outra CPU) ou PID reaproveitado: ler o stat
+    const struct process_info info = get_process_info(pid);
+    if (info.pid == 0 || info.state == 'Z') return WATCH_NONE;
+    if (index != WATCH_NONE) {
+        tree->nodes[index].dead = false;
+        tree->live++;
+    } else if ((index = node_add(tree, pid)) == WATCH_NONE) {
+        return WATCH_NONE;
+    }
+    struct watch_node *node = &tree->nodes[index];
+    node->ppid = info.ppid;
+    node->starttime = info.starttime;
+    node->born = now;
+    memcpy(node->name, info.name, sizeof(node->name));
+
+    const uint32_t parent = node_find(tree, info.ppid);
+    if (parent != WATCH_NONE && !tree->nodes[parent].dead) node_link(tree, index, parent);
+    return index;
+}
+
+static void adopt_children(struct watch_state *st, const uint32_t index, const double now) {
+    struct watch_tree *tree = &st->tree;
+    uint32_t child = tree->nodes[index].first_child;
+    while (child != WATCH_NONE) {
+        const uint32_t next = tree->nodes[child].next;
+        // O kernel já entregou os órfãos ao novo pai (subreaper ou init) antes de anunciar a saída
+        const struct process_info info = get_process_info(tree->nodes[child].pid);
+        uint32_t parent = WATCH_NONE;
+        if (info.pid != 0 && info.ppid != tree->nodes[index].pid) {
+            parent = live_process(st, info.ppid, now);
+            tree->nodes[child].ppid = info.ppid;
+        }
+        if (parent == WATCH_NONE) node_unlink(tree, child);
+        else node_link(tree, child, parent);
+        child = next;
+    }
+}
+
+static long sync_with_proc(struct watch_state *st, const double now) {
+    struct watch_tree *tree = &st->tree;
+    if (scan_processes(&st->table, 1) != 0) return -1;
+    const uint32_t gen = ++tree->gen;
+    long changes = 0;
+
+    // Processos novos, PIDs reaproveitados e nomes (zumbis já tiveram a saída anunciada e ficam de fora)
+    for (size_t i = 0; i < st->table.count; i++) {
+        const struct process_info *info = &st->table.procs[i];
+        if (info->state == 'Z') continue;
+        uint32_t index = node_find(tree, info->pid);
+        if (index != WATCH_NONE && tree->nodes[index].dead) {
+            tree->nodes[index].dead = false;
+            tree->nodes[index].born = now;
+            tree->live++;
+        } else if (index != WATCH_NONE && tree->nodes[index].starttime != 0 &&
+                   tree->nodes[index].starttime != info->starttime) {
+            // Mesmo PID, outro processo: os filhos do antigo são religados abaixo
+            if (index == st->root) {
+                st->root = WATCH_NONE;
+                st->root_exited = true;
+            }
+            node_drop(tree, index);
+            index = WATCH_NONE;
+        }
+        if (index == WATCH_NONE) {
+            if ((index = node_add(tree, info->pid)) == WATCH_NONE) return -1;
+            tree->nodes[index].born = now;
+            changes++;
+        } else if (strcmp(tree->nodes[index].name, info->name) != 0 && info->ppid != 2 && info->pid != 2) {
+            // Threads do kernel (filhas do kthreadd) trocam a descrição no nome sem evento de comm
+            changes++;
+        }
+        struct watch_node *node = &tree->nodes[index];
+        node->ppid = info->ppid;
+        node->starttime = info->starttime;
+        node->gen = gen;
+        memcpy(node->name, info->name, sizeof(node->name));
+    }
+
+    // Pais (com todos os processos já na tabela), na ordem de PID da varredura
+    for (size_t i = 0; i < st->table.count; i++) {
+        const struct process_info *info = &st->table.procs[i];
+        if (info->state == 'Z') continue;
+        const uint32_t index = node_find(tree, info->pid);
+        uint32_t parent = node_find(tree, info->ppid);
+        if (parent != WATCH_NONE && tree->nodes[parent].gen != gen) parent = WATCH_NONE;
+        if (node_link(tree, index, parent)) changes++;
+    }
+
+    // Processos que terminaram sem que a saída tenha sido vista
+    for (uint32_t index = 0; index < tree->used; index++) {
+        const struct watch_node *node = &tree->nodes[index];
+        if (node->pid == 0 || node->dead || node->gen == gen) continue;
+        if (index == st->root) {
+            st->root = WATCH_NONE;
+            st->root_exited = true;
+        }
+        node_drop(tree, index);
+        changes++;
+    }
+
+    if (st->root == WATCH_NONE && !st->root_exited) st->root = node_find(tree, st->options->root);
+    return changes;
+}
+
+static void purge_tombstones(struct watch_state *st, const double now) {
+    struct watch_tree *tree = &st->tree;
+    for (uint32_t index = 0; index < tree->used; index++) {
+        const struct watch_node *node = &tree->nodes[index];
+        if (node->pid != 0 && node->dead && now - node->born > TREE_WATCH_TOMBSTONE_SECONDS) {
+            node_drop(tree, index);
+        }
+    }
+}
+
+static void render(struct watch_state *st, const double now) {
+    struct watch_tree *tree = &st->tree;
+    const size_t body_rows = st->term_rows > WATCH_HEADER_ROWS + WATCH_FOOTER_ROWS
+                                 ? st->term_rows - WATCH_HEADER_ROWS - WATCH_FOOTER_ROWS
+                                 : 0;
+    // Níveis de indentação que cabem antes do nome; os mais rasos são trocados por "⋯ "
+    const size_t max_levels = st->term_cols > WATCH_NAME_COLS + 4 ? (st->term_cols - WATCH_NAME_COLS) / 4 : 1;
+
+    // Cada processo entra uma vez na pilha, e a profundidade não passa do total de processos
+    if (tree->live + 1 > st->draw_capacity) {
+        const size_t capacity = (tree->live + 1) * 2;
+        struct watch_frame *stack = realloc(st->stack, capacity * sizeof(struct watch_frame));
+        if (stack) st->stack = stack;
+        bool *rails = realloc(st->rails, capacity * sizeof(bool));
+        if (rails) st->rails = rails;
+        if (!stack || !rails) return;
+        st->draw_capacity = capacity;
+    }
+
+    char line[2048];
+    size_t row = 0;
+    st->subtree = 0;
+    size_t top = 0;
+    if (st->root != WATCH_NONE) st->stack[top++] = (struct watch_frame){.index = st->root, .depth = 0, .last = true};
+    while (top > 0) {
+        const struct watch_frame frame = st->stack[--top];
+        const struct watch_node *node = &tree->nodes[frame.index];
+        st->subtree++;
+
+        // Filhos do último ao primeiro, para o primeiro ser desenhado antes
+        uint32_t count = 0;
+        for (uint32_t child = node->last_child; child != WATCH_NONE; child = tree->nodes[child].prev) {
+            st->stack[top++] = (struct watch_frame){.index = child, .depth = frame.depth + 1, .last = count++ == 0};
+        }
+
+        // Além da tela, só a contagem continua
+        if (frame.depth > 0) st->rails[frame.depth - 1] = !frame.last;
+        if (row >= body_rows) continue;
+
+        size_t len = 0;
+        size_t first_level = 0;
+        if (frame.depth > max_levels) {
+            first_level = frame.depth - max_levels;
+            len += (size_t) snprintf(line + len, sizeof(line) - len, "⋯ ");
+        }
+        for (size_t i = first_level; i < frame.depth && len < sizeof(line) / 2; i++) {
+            const char *rail = i == frame.depth - 1 ? (frame.last ? "└── " : "├── ")
+                                                     : (st->rails[i] ? "│   " : "    ");
+            len += (size_t) snprintf(line + len, sizeof(line) - len, "%s", rail);
+        }
+        const size_t indent_cols = (frame.depth - first_level) * 4 + (first_level ? 2 : 0);
+        const int name_cols = st->term_cols > indent_cols + 16 ? (int) (st->term_cols - indent_cols - 16) : 1;
+
+        // Cores por nível; processos recém-criados em destaque
+        const char *colors[] = {TERM_CYAN, TERM_GREEN, TERM_MAGENTA, TERM_BLUE, TERM_YELLOW};
+        const char *color = now - node->born < TREE_WATCH_NEW_SECONDS ? TERM_GREEN_BOLD : colors[frame.depth % 5];
+        const int written = snprintf(line + len, sizeof(line) - len, "%s%.*s (PID: %d)%s", color, name_cols,
+                                     node->name, node->pid, TERM_RESET);
+        if (written > 0) len += (size_t) written;
+        if (len >= sizeof(line)) len = sizeof(line) - 1;
+        screen_line(&st->scr, WATCH_HEADER_ROWS + row++, line, len);
+    }
+    for (; row < body_rows; row++) screen_line(&st->scr, WATCH_HEADER_ROWS + row, "", 0);
+
+    int len;
+    if (st->events_fd >= 0) {
+        len = snprintf(line, sizeof(line), "%stree --watch%s  PID %d | %zu processos | netlink | %.0f eventos/s | "
+                       "fork %zu exec %zu exit %zu | ressincronizações %zu | %.2f%% CPU", TERM_CYAN_BOLD, TERM_RESET,
+                       st->options->root, st->subtree, st->rate, st->forks, st->execs, st->exits, st->resyncs,
+                       st->cpu_share);
+    } else {
+        len = snprintf(line, sizeof(line), "%stree --watch%s  PID %d | %zu processos | /proc a cada %.2fs | %.2f%% CPU",
+                       TERM_CYAN_BOLD, TERM_RESET, st->options->root, st->subtree, st->options->interval,
+                       st->cpu_share);
+    }
+    screen_line(&st->scr, 0, line, len < (int) sizeof(line) ? (size_t) len : sizeof(line) - 1);
+
+    if (st->events_fd < 0 && st->events_errno) {
+        len = snprintf(line, sizeof(line), "%sq%s sair  %s(netlink indisponível: %s)%s", TERM_CYAN_BOLD, TERM_RESET,
+                       TERM_ITALIC, strerror(st->events_errno), TERM_RESET);
+    } else {
+        len = snprintf(line, sizeof(line), "%sq%s sair", TERM_CYAN_BOLD, TERM_RESET);
+    }
+    screen_line(&st->scr, st->term_rows - 1, line, len < (int) sizeof(line) ? (size_t) len : sizeof(line) - 1);
+
+    screen_flush(&st->scr, STDOUT_FILENO);
+}
+
+static void free_state(struct watch_state *st) {
+    proc_events_close(st->events_fd);
+    screen_free(&st->scr);
+    free_process_table(&st->table);
+    free(st->tree.nodes);
+    free(st->tree.slots);
+    free(st->changes);
+    free(st->stack);
+    free(st->rails);
+}
+
+static double self_cpu_seconds(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           (double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
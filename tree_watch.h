@@ -0,0 +1,46 @@
+//
+// `tree --watch`: árvore de processos ao vivo, atualizada por eventos do kernel.
+//
+
+#ifndef TREE_WATCH_H
+#define TREE_WATCH_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+// Intervalo mínimo entre dois quadros quando chegam eventos (segundos)
+#define TREE_WATCH_FRAME_SECONDS 0.05
+
+// Tempo em que um processo novo aparece destacado (segundos)
+#define TREE_WATCH_NEW_SECONDS 1.0
+
+// Tempo em que a saída de um PID desconhecido é lembrada, para descartar um fork que chegue atrasado (segundos)
+#define TREE_WATCH_TOMBSTONE_SECONDS 2.0
+
+// Eventos aplicados antes de atender ao terminal de novo
+#define TREE_WATCH_EVENT_BUDGET 4096
+
+struct tree_watch_options {
+    pid_t root;         // Raiz da árvore exibida
+    double interval;    // Segundos entre atualizações do status (netlink) ou varreduras (/proc)
+    long max_cycles;    // Sair após N intervalos (-1 = até `q`)
+    bool force_proc;    // Usar a releitura do /proc mesmo com o netlink disponível
+};
+
+/**
+ * @brief Exibe a árvore de `options->root` e a mantém atualizada até o usuário sair (tecla `q`).
+ *
+ * A árvore é montada com uma varredura do /proc e depois atualizada por eventos
+ * de fork, exec, exit e troca de nome do conector de processos do netlink
+ * (`proc_events`), sem reler o /proc. Só as linhas que mudaram são
+ * redesenhadas (`screen`). Se o netlink não for permitido (sem CAP_NET_ADMIN
+ * antes do Linux 6.6), o /proc é relido a cada intervalo e comparado com a árvore. Eventos perdidos
+ * por transbordo do buffer do socket disparam uma ressincronização pelo /proc.
+ * Ao sair, a árvore é comparada com uma última varredura e as divergências são
+ * mostradas no resumo.
+ * @param options Opções.
+ * @return 0 em caso de sucesso, 1 em caso de erro.
+ */
+int tree_watch_run(const struct tree_watch_options *options);
+
+#endif //TREE_WATCH_H
@@ -0,0 +1,519 @@
+#include "walk.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "parallel.h"
+
+// Partes independentes do conjunto de inodes (cada uma com a sua trava)
+#define WALK_INODE_SHARDS 64
+
+/*****************************************************************************/
+
+struct inode_key {
+    uint64_t dev;
+    uint64_t ino;        // 0 = posição livre
+};
+
+// Tabela aberta (sondagem linear) de uma parte do conjunto
+struct inode_shard {
+    alignas(64) pthread_mutex_t lock;
+    struct inode_key *keys;
+    size_t count;
+    size_t capacity;     // Potência de 2
+};
+
+// Arquivos com mais de um link já somados, por (dispositivo, inode)
+struct walk_inode_set {
+    struct inode_shard shards[WALK_INODE_SHARDS];
+};
+
+/**
+ * @brief Metadados de uma entrada usados na soma de tamanhos.
+ */
+struct walk_stat {
+    mode_t mode;
+    uint32_t nlink;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t bytes;      // Blocos alocados × 512, ou o tamanho aparente
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Lê um diretório da varredura (executado por `parallel_tasks`).
+ */
+static void visit(void *item, unsigned worker, struct parallel_pool *pool, void *ctx);
+
+/**
+ * @brief Lê as entradas em lotes, sem guardá-las (`usage`).
+ */
+static void read_stream(struct walk *walk, struct walk_dir *dir, int fd, unsigned worker,
+                        struct parallel_pool *pool);
+
+/**
+ * @brief Lê a listagem ordenada (e os metadados, com WALK_DETAILS) e a guarda no nó (`lf -R`).
+ */
+static void read_entries(struct walk *walk, struct walk_dir *dir, int fd, unsigned worker,
+                         struct parallel_pool *pool);
+
+/**
+ * @brief Conta uma entrada no diretório; subdiretórios viram itens novos.
+ * @param type `d_type` da entrada (DT_UNKNOWN força o stat).
+ * @return Tipo da entrada (DT_*), sem seguir links simbólicos.
+ */
+static unsigned char visit_entry(struct walk *walk, struct walk_dir *dir, int dir_fd, const char *name,
+                                 unsigned char type, unsigned worker, struct parallel_pool *pool);
+
+/**
+ * @brief Cria o nó de um subdiretório e o coloca na fila da thread.
+ *
+ * O subdiretório é aberto aqui, relativo ao descritor do pai, enquanto houver
+ * descritores livres (WALK_MAX_OPEN); senão, a thread que o pegar abre pelo caminho.
+ * @param bytes Espaço do próprio subdiretório (com WALK_SIZES).
+ */
+static void add_child(struct walk *walk, struct walk_dir *dir, int dir_fd, const char *name, uint64_t bytes,
+                      unsigned worker, struct parallel_pool *pool);
+
+/**
+ * @brief Marca uma parte do diretório como pronta; o último a terminar soma os filhos e sobe para o pai.
+ */
+static void finish(struct walk_dir *dir);
+
+/**
+ * @brief Ordena os filhos de um nó pelo nome (`strcoll`).
+ */
+static void sort_children(struct walk_dir *dir);
+
+/**
+ * @brief Se há uma '/' entre o nome do nó e o do pai (não há depois de uma raiz como "/" ou "dir/").
+ */
+static bool needs_separator(const struct walk_dir *dir);
+
+/**
+ * @brief Abre um diretório pelo caminho montado a partir da raiz.
+ * @return Descritor, ou -1 em caso de erro (errno preservado).
+ */
+static int open_by_path(const struct walk_dir *dir);
+
+/**
+ * @brief Lê os metadados de uma entrada sem seguir links simbólicos.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+static int walk_stat(int dir_fd, const char *name, unsigned flags, struct walk_stat *st);
+
+/**
+ * @brief Acrescenta (dispositivo, inode) ao conjunto.
+ * @return true se era novo, false se já estava (ou faltou memória: o arquivo é contado).
+ */
+static bool inode_set_insert(struct walk_inode_set *set, uint64_t dev, uint64_t ino);
+
+/**
+ * @brief Espalha (dispositivo, inode) em 64 bits (splitmix64).
+ */
+static uint64_t inode_hash(uint64_t dev, uint64_t ino);
+
+/**
+ * @brief Libera o conjunto de inodes.
+ */
+static void inode_set_free(struct walk_inode_set *set);
+
+/**
+ * @brief Função de comparação de nós pelo nome.
+ */
+static int compare_dirs(const void *a, const void *b);
+
+/*****************************************************************************/
+
+int walk_run(struct walk *walk, const char *path, const unsigned flags, const unsigned threads) {
+    return walk_run_files(walk, path, flags, threads, NULL, NULL);
+}
+
+int walk_run_files(struct walk *walk, const char *path, unsigned flags, const unsigned threads,
+                   const walk_file_fn on_file, void *ctx) {
+    memset(walk, 0, sizeof(*walk));
+    if (flags & WALK_DETAILS) flags |= WALK_ENTRIES;
+    walk->flags = flags;
+    walk->on_file = on_file;
+    walk->ctx = ctx;
+
+    const size_t len = strlen(path) + 1;
+    struct walk_dir *root = calloc(1, sizeof(struct walk_dir) + len);
+    if (!root) return -1;
+    memcpy(root->name, path, len);
+    root->listing.fd = -1;
+    atomic_init(&root->pending, 1);
+
+    root->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root->fd < 0) {
+        free(root);
+        return -1;
+    }
+    atomic_init(&walk->open_fds, 1);
+    walk->root = root;
+
+    if (flags & WALK_SIZES) {
+        struct walk_stat st;
+        if (walk_stat(root->fd, "", flags, &st) == 0) root->bytes = st.bytes;
+        walk->inodes = calloc(1, sizeof(struct walk_inode_set));
+        if (!walk->inodes) {
+            walk_free(walk);
+            errno = ENOMEM;
+            return -1;
+        }
+        for (size_t i = 0; i < WALK_INODE_SHARDS; i++) pthread_mutex_init(&walk->inodes->shards[i].lock, NULL);
+    }
+
+    walk->threads = parallel_tasks(root, threads, visit, walk, &walk->steals);
+    if (walk->threads == 0) {
+        walk_free(walk);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+long walk_path(const struct walk_dir *dir, char *buf, const size_t size) {
+    // Tamanho primeiro (da folha até a raiz), depois os nomes de trás para frente
+    size_t len = 0;
+    for (const struct walk_dir *d = dir; d; d = d->parent) {
+        len += strlen(d->name) + (needs_separator(d) ? 1 : 0);
+    }
+    if (len >= size) return (long) len;
+
+    buf[len] = '\0';
+    size_t end = len;
+    for (const struct walk_dir *d = dir; d; d = d->parent) {
+        const size_t name_len = strlen(d->name);
+        end -= name_len;
+        memcpy(buf + end, d->name, name_len);
+        if (needs_separator(d)) buf[--end] = '/';
+    }
+    return (long) len;
+}
+
+void walk_free(struct walk *walk) {
+    // Pilha explícita pelos ponteiros `next` (árvores profundas não estouram a pilha de chamadas)
+    struct walk_dir *stack = walk->root;
+    while (stack) {
+        struct walk_dir *dir = stack;
+        stack = dir->next;
+        for (struct walk_dir *child = dir->children; child;) {
+            struct walk_dir *next = child->next;
+            child->next = stack;
+            stack = child;
+            child = next;
+        }
+        if (dir->fd >= 0) close(dir->fd);
+        dir_listing_free(&dir->listing);
+        free(dir);
+    }
+    if (walk->inodes) inode_set_free(walk->inodes);
+    free(walk->inodes);
+    walk->root = NULL;
+    walk->inodes = NULL;
+}
+
+/*****************************************************************************/
+
+static void visit(void *item, const unsigned worker, struct parallel_pool *pool, void *ctx) {
+    struct walk *walk = ctx;
+    struct walk_dir *dir = item;
+
+    int fd = dir->fd;
+    if (fd >= 0) {
+        dir->fd = -1;
+        atomic_fetch_sub_explicit(&walk->open_fds, 1, memory_order_relaxed);
+    } else {
+        fd = open_by_path(dir);
+    }
+
+    if (fd < 0) {
+        dir->error = errno;
+        atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+    } else if (walk->flags & WALK_ENTRIES) {
+        read_entries(walk, dir, fd, worker, pool);
+    } else {
+        read_stream(walk, dir, fd, worker, pool);
+    }
+    finish(dir);
+}
+
+static void read_stream(struct walk *walk, struct walk_dir *dir, const int fd, const unsigned worker,
+                        struct parallel_pool *pool) {
+    struct dir_reader reader;
+    if (dir_reader_open_fd(&reader, fd) != 0) {
+        dir->error = errno;
+        atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+        return;
+    }
+
+    const struct dirent64 *entry;
+    while ((entry = dir_reader_next(&reader))) {
+        const char *name = entry->d_name;
+        if (name[0] == '.') {
+            if (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')) continue;
+            if (!(walk->flags & WALK_ALL)) continue;
+        }
+        visit_entry(walk, dir, reader.fd, name, entry->d_type, worker, pool);
+    }
+    if (reader.error) {
+        dir->error = reader.error;
+        atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+    }
+    dir_reader_close(&reader);
+}
+
+static void read_entries(struct walk *walk, struct walk_dir *dir, const int fd, const unsigned worker,
+                         struct parallel_pool *pool) {
+    struct dir_listing *listing = &dir->listing;
+    if (dir_listing_read_fd(listing, fd, walk->flags & WALK_ALL) != 0 ||
+        ((walk->flags & WALK_DETAILS) &&
+         dir_listing_stat(listing, DIR_DETAIL_STATX_MASK, AT_SYMLINK_NOFOLLOW, 1) != 0)) {
+        dir->error = errno ? errno : ENOMEM;
+        atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+        dir_listing_free(listing);
+        return;
+    }
+
+    for (size_t i = 0; i < listing->count; i++) {
+        const char *name = dir_listing_name(listing, i);
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        // Com os metadados já lidos, o tipo sai deles (sem outro stat para DT_UNKNOWN)
+        unsigned char type = listing->entries[i].type;
+        if (listing->meta && listing->meta[i].mode) type = IFTODT(listing->meta[i].mode);
+        listing->entries[i].type = visit_entry(walk, dir, listing->fd, name, type, worker, pool);
+    }
+
+    // Os subdiretórios já foram abertos (ou o serão pelo caminho): o descritor não é mais necessário
+    close(listing->fd);
+    listing->fd = -1;
+}
+
+static unsigned char visit_entry(struct walk *walk, struct walk_dir *dir, const int dir_fd, const char *name,
+                                 unsigned char type, const unsigned worker, struct parallel_pool *pool) {
+    if (walk->flags & WALK_SIZES) {
+        struct walk_stat st;
+        if (walk_stat(dir_fd, name, walk->flags, &st) != 0) return type;  // Removido durante a leitura
+        type = IFTODT(st.mode);
+        if (type == DT_DIR) {
+            add_child(walk, dir, dir_fd, name, st.bytes, worker, pool);
+            return type;
+        }
+
+        dir->files++;
+        if (walk->on_file && type == DT_REG) walk->on_file(dir, dir_fd, name, worker, walk->ctx);
+        if (st.nlink > 1 && !inode_set_insert(walk->inodes, st.dev, st.ino)) {
+            atomic_fetch_add_explicit(&walk->hardlinks, 1, memory_order_relaxed);
+        } else {
+            dir->bytes += st.bytes;
+        }
+        return type;
+    }
+
+    if (type == DT_UNKNOWN) {
+        struct file_meta meta;
+        if (dir_stat_at(dir_fd, name, STATX_TYPE, AT_SYMLINK_NOFOLLOW, &meta) != 0) return type;
+        type = IFTODT(meta.mode);
+    }
+    if (type == DT_DIR) {
+        add_child(walk, dir, dir_fd, name, 0, worker, pool);
+        return type;
+    }
+    dir->files++;
+    if (walk->on_file && type == DT_REG) walk->on_file(dir, dir_fd, name, worker, walk->ctx);
+    return type;
+}
+
+static void add_child(struct walk *walk, struct walk_dir *dir, const int dir_fd, const char *name,
+                      const uint64_t bytes, const unsigned worker, struct parallel_pool *pool) {
+    const size_t len = strlen(name) + 1;
+    struct walk_dir *child = calloc(1, sizeof(struct walk_dir) + len);
+    if (!child) {
+        atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+        return;
+    }
+    memcpy(child->name, name, len);
+    child->parent = dir;
+    child->depth = dir->depth + 1;
+    child->bytes = bytes;
+    child->fd = -1;
+    child->listing.fd = -1;
+    atomic_init(&child->pending, 1);
+
+    // Só esta thread mexe na lista de filhos até o diretório terminar
+    child->next = dir->children;
+    dir->children = child;
+
+    if (atomic_fetch_add_explicit(&walk->open_fds, 1, memory_order_relaxed) < WALK_MAX_OPEN) {
+        child->fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (child->fd < 0) {
+            atomic_fetch_sub_explicit(&walk->open_fds, 1, memory_order_relaxed);
+            if (errno != EMFILE && errno != ENFILE) {
+                // Ilegível: fica na árvore com o erro, sem virar item
+                child->error = errno;
+                atomic_fetch_add_explicit(&walk->errors, 1, memory_order_relaxed);
+                return;
+            }
+        }
+    } else {
+        atomic_fetch_sub_explicit(&walk->open_fds, 1, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&dir->pending, 1, memory_order_relaxed);
+    if (parallel_tasks_push(pool, worker, child) != 0) visit(child, worker, pool, walk);
+}
+
+static void finish(struct walk_dir *dir) {
+    // acq_rel: quem leva o contador a zero enxerga tudo o que as outras threads escreveram na subárvore
+    while (dir && atomic_fetch_sub_explicit(&dir->pending, 1, memory_order_acq_rel) == 1) {
+        sort_children(dir);
+        for (const struct walk_dir *child = dir->children; child; child = child->next) {
+            dir->bytes += child->bytes;
+            dir->files += child->files;
+            dir->dirs += child->dirs + 1;
+        }
+        dir = dir->parent;
+    }
+}
+
+static void sort_children(struct walk_dir *dir) {
+    size_t count = 0;
+    for (const struct walk_dir *child = dir->children; child; child = child->next) count++;
+    if (count < 2) return;
+
+    struct walk_dir **sorted = malloc(count * sizeof(struct walk_dir *));
+    if (!sorted) return;
+    size_t i = 0;
+    for (struct walk_dir *child = dir->children; child; child = child->next) sorted[i++] = child;
+    qsort(sorted, count, sizeof(struct walk_dir *), compare_dirs);
+
+    for (i = 0; i + 1 < count; i++) sorted[i]->next = sorted[i + 1];
+    sorted[count - 1]->next = NULL;
+    dir->children = sorted[0];
+    free(sorted);
+}
+
+static bool needs_separator(const struct walk_dir *dir) {
+    if (!dir->parent) return false;
+    if (dir->parent->parent) return true;
+    const size_t len = strlen(dir->parent->name);
+    return len == 0 || dir->parent->name[len - 1] != '/';
+}
+
+static int open_by_path(const struct walk_dir *dir) {
+    char local[4096];
+    char *path = local;
+    const long len = walk_path(dir, local, sizeof(local));
+    if ((size_t) len >= sizeof(local)) {
+        path = malloc((size_t) len + 1);
+        if (!path) return -1;
+        walk_path(dir, path, (size_t) len + 1);
+    }
+    const int fd = open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    const int error = errno;
+    if (path != local) free(path);
+    errno = error;
+    return fd;
+}
+
+static int walk_stat(const int dir_fd, const char *name, const unsigned flags, struct walk_stat *st) {
+    static atomic_bool has_statx = true;
+    atomic_fetch_add_explicit(&dir_counters.stats, 1, memory_order_relaxed);
+    const int at_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | (name[0] ? 0 : AT_EMPTY_PATH);
+
+    if (has_statx) {
+        struct statx stx;
+        if (statx(dir_fd, name, at_flags, STATX_TYPE | STATX_NLINK | STATX_INO | STATX_SIZE | STATX_BLOCKS,
+                  &stx) == 0) {
+            st->mode = stx.stx_mode;
+            st->nlink = stx.stx_nlink;
+            st->dev = (uint64_t) stx.stx_dev_major << 32 | stx.stx_dev_minor;
+            st->ino = stx.stx_ino;
+            st->bytes = flags & WALK_APPARENT ? stx.stx_size : stx.stx_blocks * 512;
+            return 0;
+        }
+        if (errno != ENOSYS) return -1;
+        has_statx = false;
+    }
+
+    struct stat sb;
+    if (fstatat(dir_fd, name, &sb, at_flags & ~AT_NO_AUTOMOUNT) != 0) return -1;
+    st->mode = sb.st_mode;
+    st->nlink = (uint32_t) sb.st_nlink;
+    st->dev = sb.st_dev;
+    st->ino = sb.st_ino;
+    st->bytes = flags & WALK_APPARENT ? (uint64_t) sb.st_size : (uint64_t) sb.st_blocks * 512;
+    return 0;
+}
+
+static bool inode_set_insert(struct walk_inode_set *set, const uint64_t dev, uint64_t ino) {
+    if (ino == 0) ino = UINT64_MAX;  // 0 marca posição livre
+    const uint64_t hash = inode_hash(dev, ino);
+
+    // Os bits baixos escolhem a parte, os outros a posição dentro dela
+    struct inode_shard *shard = &set->shards[hash % WALK_INODE_SHARDS];
+    pthread_mutex_lock(&shard->lock);
+
+    // Crescer antes de passar de 70% de ocupação
+    if ((shard->count + 1) * 10 > shard->capacity * 7) {
+        const size_t capacity = shard->capacity ? shard->capacity * 2 : 64;
+        struct inode_key *keys = calloc(capacity, sizeof(struct inode_key));
+        if (!keys) {
+            pthread_mutex_unlock(&shard->lock);
+            return true;
+        }
+        for (size_t i = 0; i < shard->capacity; i++) {
+            const struct inode_key key = shard->keys[i];
+            if (!key.ino) continue;
+            size_t slot = (inode_hash(key.dev, key.ino) / WALK_INODE_SHARDS) & (capacity - 1);
+            while (keys[slot].ino) slot = (slot + 1) & (capacity - 1);
+            keys[slot] = key;
+        }
+        free(shard->keys);
+        shard->keys = keys;
+        shard->capacity = capacity;
+    }
+
+    size_t slot = (hash / WALK_INODE_SHARDS) & (shard->capacity - 1);
+    bool inserted = true;
+    while (shard->keys[slot].ino) {
+        if (shard->keys[slot].ino == ino && shard->keys[slot].dev == dev) {
+            inserted = false;
+            break;
+        }
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+    if (inserted) {
+        shard->keys[slot] = (struct inode_key){.dev = dev, .ino = ino};
+        shard->count++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return inserted;
+}
+
+static uint64_t inode_hash(const uint64_t dev, const uint64_t ino) {
+    uint64_t hash = ino ^ (dev * 0x9e3779b97f4a7c15ull);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+static void inode_set_free(struct walk_inode_set *set) {
+    for (size_t i = 0; i < WALK_INODE_SHARDS; i++) {
+        pthread_mutex_destroy(&set->shards[i].lock);
+        free(set->shards[i].keys);
+    }
+}
+
+static int compare_dirs(const void *a, const void *b) {
+    return strcoll((*(struct walk_dir *const *) a)->name, (*(struct walk_dir *const *) b)->name);
+}
@@ -0,0 +1,123 @@
+//
+// Varredura recursiva de diretórios em paralelo (`lf -R`, `usage`).
+//
+
+#ifndef WALK_H
+#define WALK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dir_tools.h"
+
+// Opções de `walk_run`
+#define WALK_ALL      0x1   // Incluir nomes iniciados por '.'
+#define WALK_ENTRIES  0x2   // Guardar a listagem ordenada de cada diretório (`lf -R`)
+#define WALK_DETAILS  0x4   // Metadados de cada entrada em `listing.meta` (`lf -R -l`; implica WALK_ENTRIES)
+#define WALK_SIZES    0x8   // Somar o espaço ocupado por subárvore (hardlinks contados uma vez)
+#define WALK_APPARENT 0x10  // Com WALK_SIZES: tamanho aparente em vez de blocos alocados
+
+// Máximo de diretórios descobertos mantidos abertos à espera de uma thread
+#define WALK_MAX_OPEN 256
+
+/*****************************************************************************/
+
+struct walk_dir;
+
+/**
+ * @brief Função chamada para cada arquivo regular encontrado (ex.: `search`).
+ * @param dir Diretório do arquivo (o caminho sai de `walk_path`).
+ * @param dir_fd Descritor do diretório, para abrir o arquivo com `openat`.
+ * @param name Nome do arquivo.
+ * @param worker Número da thread (0 é a thread chamadora), para estado por thread.
+ * @param ctx Contexto repassado a `walk_run_files`.
+ */
+typedef void (*walk_file_fn)(const struct walk_dir *dir, int dir_fd, const char *name, unsigned worker, void *ctx);
+
+/**
+ * @brief Um diretório da varredura.
+ *
+ * Os nós formam a árvore (pai, primeiro filho, próximo irmão); ao fim de
+ * `walk_run` os filhos de cada nó estão ordenados por nome (`strcoll`) e os
+ * totais incluem a subárvore inteira.
+ */
+struct walk_dir {
+    struct walk_dir *parent;
+    struct walk_dir *children;   // Subdiretórios
+    struct walk_dir *next;       // Próximo irmão
+    int fd;                      // Aberto na descoberta, à espera de uma thread (-1 = abrir pelo caminho)
+    int error;                   // errno se o diretório não pôde ser lido (0 = lido)
+    unsigned depth;              // 0 na raiz
+    uint64_t bytes;              // Espaço da subárvore (com WALK_SIZES), incluindo o próprio diretório
+    uint64_t files;              // Entradas que não são diretório, na subárvore
+    uint64_t dirs;               // Subdiretórios na subárvore
+    struct dir_listing listing;  // Entradas (com WALK_ENTRIES; `listing.fd` já fechado)
+    atomic_uint pending;         // Subdiretórios por terminar + 1 (o próprio diretório)
+    char name[];                 // Nome da entrada (na raiz, o caminho dado)
+};
+
+/**
+ * @brief Varredura: a árvore resultante e contadores.
+ */
+struct walk {
+    struct walk_dir *root;
+    unsigned flags;
+    unsigned threads;            // Threads usadas
+    size_t steals;               // Diretórios roubados da fila de outra thread
+    atomic_size_t errors;        // Diretórios que não puderam ser lidos
+    atomic_size_t hardlinks;     // Arquivos repetidos (mesmo dispositivo e inode) não somados de novo
+    atomic_int open_fds;         // Diretórios abertos à espera (até WALK_MAX_OPEN)
+    struct walk_inode_set *inodes;
+    walk_file_fn on_file;        // Chamada para cada arquivo regular (NULL = nenhuma)
+    void *ctx;                   // Contexto de `on_file`
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief Percorre `path` e todos os subdiretórios, usando até `threads` threads.
+ *
+ * Cada diretório é um item de `parallel_tasks`: a thread lê o diretório com
+ * getdents64 relativo ao descritor aberto pelo pai (`openat`, sem montar o
+ * caminho) e cada subdiretório encontrado vira um item novo na sua fila, que
+ * outras threads ociosas podem roubar. Links simbólicos não são seguidos. Ao
+ * terminar o último item de uma subárvore, a thread soma os totais dos filhos
+ * no pai (de baixo para cima, sem uma segunda passada).
+ * @param walk Varredura a ser preenchida (liberar com `walk_free`).
+ * @param path Diretório inicial.
+ * @param flags Opções (WALK_*).
+ * @param threads Quantidade de threads (0 usa as CPUs online).
+ * @return 0 em caso de sucesso, -1 se `path` não puder ser aberto (errno preservado).
+ */
+int walk_run(struct walk *walk, const char *path, unsigned flags, unsigned threads);
+
+/**
+ * @brief Como `walk_run`, chamando `on_file` para cada arquivo regular, na thread que leu o diretório.
+ *
+ * Links simbólicos não são seguidos (nem para arquivos). As chamadas acontecem
+ * em várias threads ao mesmo tempo e antes de os filhos do diretório estarem
+ * ordenados; `dir` e os seus ancestrais podem ser lidos (nome, pai).
+ * @param on_file Função chamada para cada arquivo.
+ * @param ctx Contexto repassado a `on_file`.
+ */
+int walk_run_files(struct walk *walk, const char *path, unsigned flags, unsigned threads, walk_file_fn on_file,
+                   void *ctx);
+
+/**
+ * @brief Caminho de um nó (a partir do caminho dado a `walk_run`).
+ * @param dir Nó da varredura.
+ * @param buf Buffer de saída.
+ * @param size Tamanho do buffer.
+ * @return Tamanho do caminho, ou -1 se não couber em `buf`.
+ */
+long walk_path(const struct walk_dir *dir, char *buf, size_t size);
+
+/**
+ * @brief Libera a árvore e os contadores de uma varredura.
+ * @param walk Varredura.
+ */
+void walk_free(struct walk *walk);
+
+#endif //WALK_H